@@ -4,10 +4,22 @@
 
 #include <CZICompress_Config.h>
 #include <include/IConsoleio.h>
+#include <include/bufferpoolsite.h>
 #include <include/commandlineoptions.h>
-#include <include/utils/utf8/utf8converter.h>
+#include <include/filecopy.h>
+#include <include/inputstream.h>
+#include <include/outputstream.h>
+#include <include/ratelimiter.h>
+#include <include/segmentreservation.h>
+#include <include/tracer.h>
 
+#include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "commandlineargshelper.h"
 #include "inc_libCZI.h"
@@ -15,6 +27,7 @@
 #if CZICOMPRESS_WIN32_ENVIRONMENT
 #include <Windows.h>
 #endif
+#include <iomanip>
 #include <iostream>
 
 /// This structure is used in the progress-callback (to keep track of the
@@ -27,6 +40,19 @@ struct PrintProgressState
 
 static void PrintProgress(const std::shared_ptr<IConsoleIo>& console_io, PrintProgressState& print_progress_state,
                           const ProgressInfo& info);
+static void PrintStatistics(const std::shared_ptr<IConsoleIo>& console_io, const OperationStatistics& statistics);
+static void PrintByteStatistics(const std::shared_ptr<IConsoleIo>& console_io, const std::vector<SubBlockByteStatistics>& byte_statistics);
+static void PrintSegmentPlacements(const std::shared_ptr<IConsoleIo>& console_io, const SegmentReservations& reservations,
+                                   const SegmentPlacements& placements);
+static void PrintBytesCopiedFromSource(const std::shared_ptr<IConsoleIo>& console_io, std::uint64_t number_of_bytes);
+static void PrintThrottledTime(const std::shared_ptr<IConsoleIo>& console_io, const std::shared_ptr<RateLimiter>& read_rate_limiter,
+                               const std::shared_ptr<RateLimiter>& write_rate_limiter);
+static void WriteTrace(const std::shared_ptr<IConsoleIo>& console_io, const Tracer& tracer, const std::string& file_name);
+static std::unique_ptr<IOperation> CreateOperationForSourceDocument(const CommandLineOptions& command_line_options,
+                                                                   const std::shared_ptr<libCZI::ICZIReader>& reader);
+static bool HandleUnchangedFile(const std::shared_ptr<IConsoleIo>& console_io, const CommandLineOptions& command_line_options,
+                                const std::shared_ptr<libCZI::ICZIReader>& reader, const std::shared_ptr<RateLimiter>& read_rate_limiter,
+                                const std::shared_ptr<RateLimiter>& write_rate_limiter);
 
 int main(int argc, char** argv)
 {
@@ -74,14 +100,32 @@ int main(int argc, char** argv)
 
   // on Windows, we want to use the WIC-JpgXR-decoder - this must be done BEFORE
   // the first call into libCZI
-  SetSiteObject(GetDefaultSiteObject(libCZI::SiteObjectType::WithWICDecoder));
+  InstallPooledBitmapSite(GetDefaultSiteObject(libCZI::SiteObjectType::WithWICDecoder));
+#else
+  // the bitmaps (decoded from the subblocks) are to be allocated from the buffer pool - this must
+  // be done BEFORE the first call into libCZI
+  InstallPooledBitmapSite(libCZI::GetDefaultSiteObject(libCZI::SiteObjectType::Default));
 #endif
 
   int return_code = EXIT_SUCCESS;
   try
   {
+    // the rate limiters are only created if a limit is given
+    std::shared_ptr<RateLimiter> read_rate_limiter;
+    if (command_line_options.GetMaxReadMegabytesPerSecond() > 0)
+    {
+      read_rate_limiter = std::make_shared<RateLimiter>(command_line_options.GetMaxReadMegabytesPerSecond());
+    }
+
+    std::shared_ptr<RateLimiter> write_rate_limiter;
+    if (command_line_options.GetMaxWriteMegabytesPerSecond() > 0)
+    {
+      write_rate_limiter = std::make_shared<RateLimiter>(command_line_options.GetMaxWriteMegabytesPerSecond());
+    }
+
     // create the "input-stream-object"
-    const auto stream = libCZI::CreateStreamFromFile(utils::utf8::WidenUtf8(command_line_options.GetInputFileName()).c_str());
+    const auto stream = CreateInputStreamForFile(command_line_options.GetInputFileName(), command_line_options.GetInputIo(),
+                                                 command_line_options.GetInputCache(), read_rate_limiter);
 
     // create the "CZI-reader"-object
     const auto reader = libCZI::CreateCZIReader();
@@ -93,52 +137,108 @@ int main(int argc, char** argv)
     open_options.ignore_sizem_for_pyramid_subblocks = true;
     reader->Open(stream, &open_options);
 
-    // Create an "output-stream-object"
-    const auto output_stream = libCZI::CreateOutputStreamForFile(utils::utf8::WidenUtf8(command_line_options.GetOutputFileName()).c_str(),
-                                                                 command_line_options.GetOverwriteExistingFile());
-
-    // create (and configure) the "CZI-writer"-object
-    libCZI::CZIWriterOptions czi_writer_options;
-    czi_writer_options.allow_duplicate_subblocks = command_line_options.GetIgnoreDuplicateSubblocks();
-    const auto writer = libCZI::CreateCZIWriter(&czi_writer_options);
-
-    // GUID_NULL here means that a new Guid is created
-    const auto czi_writer_info = std::make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}});
-
-    // TODO(JBL): it might be desirable to make reservations for the
-    //            subblock-directory-/attachments-directory-/metadata-segment
-    //            (so that the end up at the beginning of the file instead of at
-    //            the end), but this shouldn't make a difference in terms of
-    //            proper operation
-    writer->Create(output_stream, czi_writer_info);
-
-    auto operation = CreateOperationUp();
-
-    OperationDescription operation_description;
-    operation_description.reader = reader;
-    operation_description.writer = writer;
-    operation_description.command = command_line_options.GetCommand();
-    operation_description.compression_strategy = command_line_options.GetCompressionStrategy();
-    operation_description.compression_option = command_line_options.GetCompressionOption();
-
-    operation->SetParameters(operation_description);
-    PrintProgressState print_progress_state;
-    std::function<bool(const ProgressInfo&)> progress_callback;
-
-    // if stdout is redirected to a file, we better don't print progress (as it
-    // would flood the file)
-    if (console_io->IsStdOutATerminal())
+    // if the operation would not change anything, we may be able to do without writing the destination file
+    if (!HandleUnchangedFile(console_io, command_line_options, reader, read_rate_limiter, write_rate_limiter))
     {
-      progress_callback = [&console_io, &print_progress_state](const ProgressInfo& info) -> bool
+      // Create an "output-stream-object"
+      OutputStreamOptions output_stream_options;
+      output_stream_options.overwrite_existing_file = command_line_options.GetOverwriteExistingFile();
+      output_stream_options.write_buffer_size = command_line_options.GetWriteBufferMegabytes() * 1024 * 1024;
+      if (command_line_options.GetUseCopyFileRange())
       {
-        PrintProgress(console_io, print_progress_state, info);
-        return true;
-      };
-    }
+        output_stream_options.copy_file_range_source_file_name = command_line_options.GetInputFileName();
+      }
+
+      output_stream_options.direct_io = command_line_options.GetUseDirectIo();
+      output_stream_options.rate_limiter = write_rate_limiter;
+
+      if (command_line_options.GetPreallocate())
+      {
+        output_stream_options.preallocation_size =
+            CreateOperationForSourceDocument(command_line_options, reader)->EstimateSizeOfDestinationDocument();
+      }
+
+      const auto output_stream = CreateOutputStreamForFile(command_line_options.GetOutputFileName(), output_stream_options);
+
+      // create (and configure) the "CZI-writer"-object
+      libCZI::CZIWriterOptions czi_writer_options;
+      czi_writer_options.allow_duplicate_subblocks = command_line_options.GetIgnoreDuplicateSubblocks();
+      const auto writer = libCZI::CreateCZIWriter(&czi_writer_options);
+
+      // GUID_NULL here means that a new Guid is created
+      const auto czi_writer_info = std::make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}});
+
+      // reserve space for the subblock-directory-/attachments-directory-/metadata-segment, so that they end up at the
+      //  beginning of the file instead of at the end - the recorder tells us afterwards whether the reservations were used
+      const auto segment_reservations = ReserveSegmentsForCopy(reader.get(), czi_writer_info.get());
+      const auto segment_placement_recorder = std::make_shared<SegmentPlacementRecorder>(output_stream);
+      writer->Create(segment_placement_recorder, czi_writer_info);
+      segment_placement_recorder->SetEndOfReservedSpace();
+
+      auto operation = CreateOperationUp();
+
+      OperationDescription operation_description;
+      operation_description.reader = reader;
+      operation_description.writer = writer;
+      operation_description.command = command_line_options.GetCommand();
+      operation_description.compression_strategy = command_line_options.GetCompressionStrategy();
+      operation_description.compression_option = command_line_options.GetCompressionOption();
+      operation_description.number_of_threads = command_line_options.GetNumberOfThreads();
+      operation_description.max_inflight_megabytes = command_line_options.GetMaxInflightMegabytes();
+      operation_description.prefetch_depth = command_line_options.GetPrefetchDepth();
+      operation_description.prefetch_megabytes = command_line_options.GetPrefetchMegabytes();
+      operation_description.read_order = command_line_options.GetReadOrder();
+      operation_description.output_order = command_line_options.GetOutputOrder();
+      operation_description.source_stream = stream;
+      operation_description.source_range_copy = GetSourceRangeCopy(output_stream);
+      if (!command_line_options.GetTraceFileName().empty())
+      {
+        operation_description.tracer = std::make_shared<Tracer>();
+      }
+
+      operation->SetParameters(operation_description);
+      PrintProgressState print_progress_state;
+      std::function<bool(const ProgressInfo&)> progress_callback;
+
+      // if stdout is redirected to a file, we better don't print progress (as it
+      // would flood the file)
+      if (console_io->IsStdOutATerminal())
+      {
+        progress_callback = [&console_io, &print_progress_state](const ProgressInfo& info) -> bool
+        {
+          PrintProgress(console_io, print_progress_state, info);
+          return true;
+        };
+      }
+
+      operation->DoOperation(progress_callback);
+      const auto statistics = operation->GetStatistics();
+      operation.reset();
+      if (operation_description.tracer)
+      {
+        WriteTrace(console_io, *operation_description.tracer, command_line_options.GetTraceFileName());
+      }
+
+      writer->Close();
+
+      // wait until all data has been written to the destination file (and report errors which occurred doing so)
+      CloseOutputStream(output_stream.get());
 
-    operation->DoOperation(progress_callback);
-    operation.reset();
-    writer->Close();
+      if (console_io->IsStdOutATerminal())
+      {
+        PrintStatistics(console_io, statistics);
+        PrintSegmentPlacements(console_io, segment_reservations, segment_placement_recorder->GetSegmentPlacements());
+        if (operation_description.source_range_copy)
+        {
+          PrintBytesCopiedFromSource(console_io, operation_description.source_range_copy->GetNumberOfBytesCopiedFromSource());
+        }
+
+        if (read_rate_limiter || write_rate_limiter)
+        {
+          PrintThrottledTime(console_io, read_rate_limiter, write_rate_limiter);
+        }
+      }
+    }
   }
   catch (const std::exception& exception)
   {
@@ -155,6 +255,76 @@ int main(int argc, char** argv)
   return return_code;
 }
 
+std::unique_ptr<IOperation> CreateOperationForSourceDocument(const CommandLineOptions& command_line_options,
+                                                            const std::shared_ptr<libCZI::ICZIReader>& reader)
+{
+  // only the reader and the information about the operation are given here - this is sufficient for examining the
+  // source document, but not for running the operation
+  OperationDescription operation_description;
+  operation_description.reader = reader;
+  operation_description.command = command_line_options.GetCommand();
+  operation_description.compression_strategy = command_line_options.GetCompressionStrategy();
+  operation_description.compression_option = command_line_options.GetCompressionOption();
+  auto operation = CreateOperationUp();
+  operation->SetParameters(operation_description);
+  return operation;
+}
+
+bool HandleUnchangedFile(const std::shared_ptr<IConsoleIo>& console_io, const CommandLineOptions& command_line_options,
+                         const std::shared_ptr<libCZI::ICZIReader>& reader, const std::shared_ptr<RateLimiter>& read_rate_limiter,
+                         const std::shared_ptr<RateLimiter>& write_rate_limiter)
+{
+  const UnchangedFileHandling unchanged_file_handling = command_line_options.GetUnchangedFileHandling();
+  if (unchanged_file_handling != UnchangedFileHandling::kClone && unchanged_file_handling != UnchangedFileHandling::kSkip)
+  {
+    return false;
+  }
+
+  // a source file on an HTTP server cannot be cloned - in this case, the destination file is written as usual
+  if (unchanged_file_handling == UnchangedFileHandling::kClone && IsHttpUrl(command_line_options.GetInputFileName()))
+  {
+    return false;
+  }
+
+  if (!CreateOperationForSourceDocument(command_line_options, reader)->AreAllSubBlocksCopiedVerbatim())
+  {
+    return false;
+  }
+
+  if (unchanged_file_handling == UnchangedFileHandling::kSkip)
+  {
+    console_io->WriteLineStdOut("All subblocks would be copied verbatim -> skipped, no destination file has been written");
+    return true;
+  }
+
+  const FileCopyMethod file_copy_method =
+      CopyFileContent(command_line_options.GetInputFileName(), command_line_options.GetOutputFileName(),
+                      command_line_options.GetOverwriteExistingFile(), read_rate_limiter, write_rate_limiter);
+  std::stringstream string_stream;
+  string_stream << "All subblocks would be copied verbatim -> the destination file is a copy of the source file (";
+  switch (file_copy_method)
+  {
+    case FileCopyMethod::kReflink:
+      string_stream << "cloned by the file system";
+      break;
+    case FileCopyMethod::kCopyFileRange:
+      string_stream << "copied by the operating system";
+      break;
+    default:
+      string_stream << "copied";
+      break;
+  }
+
+  string_stream << ")";
+  console_io->WriteLineStdOut(string_stream.str());
+  if (console_io->IsStdOutATerminal() && (read_rate_limiter || write_rate_limiter))
+  {
+    PrintThrottledTime(console_io, read_rate_limiter, write_rate_limiter);
+  }
+
+  return true;
+}
+
 void PrintProgress(const std::shared_ptr<IConsoleIo>& console_io, PrintProgressState& print_progress_state, const ProgressInfo& info)
 {
   std::stringstream string_stream;
@@ -168,6 +338,16 @@ void PrintProgress(const std::shared_ptr<IConsoleIo>& console_io, PrintProgressS
     string_stream << " " << info.number_of_items_done;
   }
 
+  if (info.phase == ProcessingPhase::kCopySubblocks && info.input_bytes_per_second > 0)
+  {
+    constexpr double kBytesPerMegabyte = 1024.0 * 1024.0;
+    string_stream << ", " << std::fixed << std::setprecision(1) << info.input_bytes_per_second / kBytesPerMegabyte << " MB/s";
+    if (info.estimated_seconds_remaining >= 0)
+    {
+      string_stream << ", " << std::setprecision(0) << info.estimated_seconds_remaining << " s remaining";
+    }
+  }
+
   // overwrite the previous line if we are in the same phase only
   if (print_progress_state.previous_phase != ProcessingPhase::kInvalid && print_progress_state.previous_phase == info.phase)
   {
@@ -177,3 +357,182 @@ void PrintProgress(const std::shared_ptr<IConsoleIo>& console_io, PrintProgressS
   console_io->WriteLineStdOut(string_stream.str());
   print_progress_state.previous_phase = info.phase;
 }
+
+void PrintStatistics(const std::shared_ptr<IConsoleIo>& console_io, const OperationStatistics& statistics)
+{
+  constexpr double kBytesPerMegabyte = 1024.0 * 1024.0;
+  std::stringstream string_stream;
+  string_stream << "Subblocks: " << statistics.number_of_subblocks_compressed << " compressed, "
+                << statistics.number_of_subblocks_decompressed << " decompressed, "
+                << statistics.number_of_subblocks_copied_verbatim << " copied verbatim, "
+                << statistics.number_of_subblocks_already_compressed << " already compressed as requested, "
+                << statistics.number_of_subblocks_kept_original << " kept original because smaller";
+  console_io->WriteLineStdOut(string_stream.str());
+
+  string_stream.str("");
+  string_stream << "Peak memory in flight: " << std::fixed << std::setprecision(1)
+                << static_cast<double>(statistics.peak_bytes_in_flight) / kBytesPerMegabyte << " MB";
+  console_io->WriteLineStdOut(string_stream.str());
+
+  string_stream.str("");
+  string_stream << "Buffer pool: " << statistics.buffer_pool_hits << " hits, " << statistics.buffer_pool_misses << " misses";
+  console_io->WriteLineStdOut(string_stream.str());
+
+  if (statistics.input_cache_used)
+  {
+    string_stream.str("");
+    string_stream << "Input cache: " << statistics.input_cache_hits << " hits, " << statistics.input_cache_misses << " misses, "
+                  << statistics.input_cache_reads << " reads from the source file";
+    console_io->WriteLineStdOut(string_stream.str());
+  }
+
+  PrintByteStatistics(console_io, statistics.byte_statistics);
+}
+
+void PrintByteStatistics(const std::shared_ptr<IConsoleIo>& console_io, const std::vector<SubBlockByteStatistics>& byte_statistics)
+{
+  if (byte_statistics.empty())
+  {
+    return;
+  }
+
+  const auto pyramid_type_as_string = [](libCZI::SubBlockPyramidType pyramid_type) -> const char*
+  {
+    switch (pyramid_type)
+    {
+      case libCZI::SubBlockPyramidType::None:
+        return "none";
+      case libCZI::SubBlockPyramidType::SingleSubBlock:
+        return "single";
+      case libCZI::SubBlockPyramidType::MultiSubBlock:
+        return "multi";
+      default:
+        return "invalid";
+    }
+  };
+
+  const auto action_as_string = [](SubBlockAction action) -> const char*
+  {
+    switch (action)
+    {
+      case SubBlockAction::kCopiedVerbatim:
+        return "copied verbatim";
+      case SubBlockAction::kCompressed:
+        return "compressed";
+      case SubBlockAction::kDecompressed:
+        return "decompressed";
+      case SubBlockAction::kAlreadyCompressed:
+        return "already compressed";
+      case SubBlockAction::kKeptOriginal:
+        return "kept original";
+      default:
+        return "invalid";
+    }
+  };
+
+  // one line per combination of pixel type, pyramid type, source compression mode and action - the ratio is the size of
+  //  the output relative to the size of the input
+  constexpr double kBytesPerMegabyte = 1024.0 * 1024.0;
+  std::stringstream string_stream;
+  string_stream << std::left << std::setw(20) << "Pixel type" << std::setw(9) << "Pyramid" << std::setw(14) << "Source"
+                << std::setw(20) << "Action" << std::right << std::setw(10) << "Subblocks" << std::setw(12) << "Input MB"
+                << std::setw(12) << "Output MB" << std::setw(8) << "Ratio";
+  console_io->WriteLineStdOut(string_stream.str());
+
+  std::uint64_t total_number_of_subblocks = 0;
+  std::uint64_t total_input_bytes = 0;
+  std::uint64_t total_output_bytes = 0;
+  for (const auto& entry : byte_statistics)
+  {
+    string_stream.str("");
+    string_stream << std::left << std::setw(20) << libCZI::Utils::PixelTypeToInformalString(entry.pixel_type) << std::setw(9)
+                  << pyramid_type_as_string(entry.pyramid_type) << std::setw(14)
+                  << libCZI::Utils::CompressionModeToInformalString(entry.source_compression_mode) << std::setw(20)
+                  << action_as_string(entry.action) << std::right << std::setw(10) << entry.number_of_subblocks << std::fixed
+                  << std::setprecision(1) << std::setw(12) << static_cast<double>(entry.input_bytes) / kBytesPerMegabyte
+                  << std::setw(12) << static_cast<double>(entry.output_bytes) / kBytesPerMegabyte << std::setprecision(2)
+                  << std::setw(8)
+                  << (entry.input_bytes > 0 ? static_cast<double>(entry.output_bytes) / static_cast<double>(entry.input_bytes) : 1.0);
+    console_io->WriteLineStdOut(string_stream.str());
+    total_number_of_subblocks += entry.number_of_subblocks;
+    total_input_bytes += entry.input_bytes;
+    total_output_bytes += entry.output_bytes;
+  }
+
+  string_stream.str("");
+  string_stream << std::left << std::setw(63) << "Total" << std::right << std::setw(10) << total_number_of_subblocks << std::fixed
+                << std::setprecision(1) << std::setw(12) << static_cast<double>(total_input_bytes) / kBytesPerMegabyte << std::setw(12)
+                << static_cast<double>(total_output_bytes) / kBytesPerMegabyte << std::setprecision(2) << std::setw(8)
+                << (total_input_bytes > 0 ? static_cast<double>(total_output_bytes) / static_cast<double>(total_input_bytes) : 1.0);
+  console_io->WriteLineStdOut(string_stream.str());
+}
+
+void PrintSegmentPlacements(const std::shared_ptr<IConsoleIo>& console_io, const SegmentReservations& reservations,
+                            const SegmentPlacements& placements)
+{
+  const auto describe_placement = [](SegmentPlacement placement, bool reserved) -> const char*
+  {
+    switch (placement)
+    {
+      case SegmentPlacement::kReservedSpace:
+        return "at start of file";
+      case SegmentPlacement::kEndOfFile:
+        return reserved ? "at end of file (reserved space too small)" : "at end of file";
+      default:
+        return "not written";
+    }
+  };
+
+  std::stringstream string_stream;
+  string_stream << "Segments: subblock directory "
+                << describe_placement(placements.subblock_directory, reservations.number_of_subblock_directory_entries > 0)
+                << ", attachment directory "
+                << describe_placement(placements.attachment_directory, reservations.number_of_attachment_directory_entries > 0)
+                << ", metadata " << describe_placement(placements.metadata, reservations.metadata_size > 0);
+  console_io->WriteLineStdOut(string_stream.str());
+}
+
+void PrintBytesCopiedFromSource(const std::shared_ptr<IConsoleIo>& console_io, std::uint64_t number_of_bytes)
+{
+  constexpr double kBytesPerMegabyte = 1024.0 * 1024.0;
+  std::stringstream string_stream;
+  string_stream << "Copied from source file by the operating system: " << std::fixed << std::setprecision(1)
+                << static_cast<double>(number_of_bytes) / kBytesPerMegabyte << " MB";
+  console_io->WriteLineStdOut(string_stream.str());
+}
+
+void PrintThrottledTime(const std::shared_ptr<IConsoleIo>& console_io, const std::shared_ptr<RateLimiter>& read_rate_limiter,
+                        const std::shared_ptr<RateLimiter>& write_rate_limiter)
+{
+  const auto get_seconds = [](const std::shared_ptr<RateLimiter>& rate_limiter) -> double
+  { return rate_limiter ? std::chrono::duration<double>(rate_limiter->GetThrottledTime()).count() : 0.0; };
+
+  std::stringstream string_stream;
+  string_stream << "Throttled: " << std::fixed << std::setprecision(1) << get_seconds(read_rate_limiter) << " s reading, "
+                << get_seconds(write_rate_limiter) << " s writing";
+  console_io->WriteLineStdOut(string_stream.str());
+}
+
+void WriteTrace(const std::shared_ptr<IConsoleIo>& console_io, const Tracer& tracer, const std::string& file_name)
+{
+  std::ofstream stream(std::filesystem::u8path(file_name), std::ios::out | std::ios::trunc);
+  if (!stream)
+  {
+    throw std::runtime_error("Could not create the trace file '" + file_name + "'");
+  }
+
+  tracer.WriteChromeTraceJson(stream);
+  stream.close();
+  if (!stream)
+  {
+    throw std::runtime_error("Could not write the trace file '" + file_name + "'");
+  }
+
+  const std::uint64_t number_of_dropped_events = tracer.GetNumberOfDroppedEvents();
+  if (number_of_dropped_events > 0)
+  {
+    std::stringstream string_stream;
+    string_stream << "The trace is incomplete - " << number_of_dropped_events << " events at its start have been overwritten.";
+    console_io->WriteLineStdErr(string_stream.str());
+  }
+}
@@ -0,0 +1,354 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include <benchmark/benchmark.h>
+#include <src/copyczi.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "libczi_utils.h"
+#include "syntheticczi.h"
+
+using std::make_shared, std::shared_ptr, std::tuple;
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// The pixel types which can be created by the utilities of the tests - the first argument of the benchmarks is an
+/// index into this array.
+constexpr std::array<libCZI::PixelType, 5> kPixelTypes{libCZI::PixelType::Gray8, libCZI::PixelType::Gray16, libCZI::PixelType::Gray32Float,
+                                                       libCZI::PixelType::Bgr24, libCZI::PixelType::Bgr48};
+
+/// The tile sizes (width and height in pixels) benchmarked.
+constexpr std::array<std::int64_t, 3> kTileSizes{256, 1024, 2048};
+
+/// The zstd compression levels benchmarked.
+constexpr std::array<std::int64_t, 3> kCompressionLevels{1, 3, 9};
+
+/// The number of pixels of a document (i.e. of all its tiles) - so that the amount of data per iteration depends on
+/// the pixel type only, and not on the tile size.
+constexpr std::int64_t kNumberOfPixelsPerDocument = 2048 * 2048;
+
+/// The content of the tiles of the synthetic documents.
+enum class Content
+{
+  kPattern,  ///< A deterministic pattern (see 'CreateBitmapAndFillWithPattern') - which zstd compresses well.
+  kNoise,      ///< Pseudo-random noise (see 'CreateBitmapAndFillWithNoise') - which is practically incompressible.
+  kSynthetic,  ///< Blobs on a noisy background (see 'RenderSyntheticTile') - which compresses like a fluorescence image.
+};
+
+bool IsHiLoByteUnpackApplicable(libCZI::PixelType pixel_type)
+{
+  return pixel_type == libCZI::PixelType::Gray16 || pixel_type == libCZI::PixelType::Bgr48;
+}
+
+std::string CreateCompressionOptions(std::int64_t compression_level, bool hi_lo_byte_unpack)
+{
+  std::string compression_options = "zstd1:ExplicitLevel=" + std::to_string(compression_level);
+  if (hi_lo_byte_unpack)
+  {
+    compression_options += ";PreProcess=HiLoByteUnpack";
+  }
+
+  return compression_options;
+}
+
+/// Creates a CZI with uncompressed tiles in a mosaic arrangement, which has 'kNumberOfPixelsPerDocument' pixels in total.
+///
+/// \param  pixel_type  The pixel type of the tiles.
+/// \param  tile_size   The width and height of the tiles (in pixels).
+/// \param  content     The content of the tiles.
+///
+/// \returns    A blob containing a CZI document.
+tuple<shared_ptr<void>, size_t> CreateUncompressedCzi(libCZI::PixelType pixel_type, std::uint32_t tile_size, Content content)
+{
+  auto writer = libCZI::CreateCZIWriter();
+  auto out_stream = make_shared<CMemOutputStream>(0);
+  writer->Create(out_stream, make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+
+  const std::int64_t number_of_pixels_per_tile = static_cast<std::int64_t>(tile_size) * tile_size;
+  const std::int64_t number_of_tiles = std::max<std::int64_t>(1, kNumberOfPixelsPerDocument / number_of_pixels_per_tile);
+  for (std::int64_t m_index = 0; m_index < number_of_tiles; ++m_index)
+  {
+    std::shared_ptr<libCZI::IBitmapData> bitmap;
+    switch (content)
+    {
+      case Content::kPattern:
+        bitmap = CreateBitmapAndFillWithPattern(pixel_type, tile_size, tile_size);
+        break;
+      case Content::kNoise:
+        bitmap = CreateBitmapAndFillWithNoise(pixel_type, tile_size, tile_size, static_cast<std::uint32_t>(m_index));
+        break;
+      case Content::kSynthetic:
+      {
+        SyntheticCziOptions synthetic_czi_options;
+        synthetic_czi_options.pixel_type = pixel_type;
+        synthetic_czi_options.bits_per_pixel = pixel_type == libCZI::PixelType::Gray8 || pixel_type == libCZI::PixelType::Bgr24 ? 8 : 12;
+        bitmap = CreateBitmap(pixel_type, tile_size, tile_size);
+        RenderSyntheticTile(synthetic_czi_options, static_cast<int>(m_index) * static_cast<int>(tile_size), 0, 0, 0, 0, bitmap);
+        break;
+      }
+    }
+
+    libCZI::AddSubBlockInfoStridedBitmap add_subblock_info;
+    add_subblock_info.Clear();
+    add_subblock_info.coordinate.Set(libCZI::DimensionIndex::C, 0);
+    add_subblock_info.mIndexValid = true;
+    add_subblock_info.mIndex = static_cast<int>(m_index);
+    add_subblock_info.x = static_cast<int>(m_index) * static_cast<int>(tile_size);
+    add_subblock_info.y = 0;
+    add_subblock_info.logicalWidth = add_subblock_info.physicalWidth = static_cast<int>(tile_size);
+    add_subblock_info.logicalHeight = add_subblock_info.physicalHeight = static_cast<int>(tile_size);
+    add_subblock_info.PixelType = bitmap->GetPixelType();
+    const libCZI::ScopedBitmapLockerSP lock_info_bitmap{bitmap};
+    add_subblock_info.ptrBitmap = lock_info_bitmap.ptrDataRoi;
+    add_subblock_info.strideBitmap = lock_info_bitmap.stride;
+    writer->SyncAddSubBlock(add_subblock_info);
+  }
+
+  const libCZI::PrepareMetadataInfo prepare_metadata_info;
+  const auto metadata_builder = writer->GetPreparedMetadata(prepare_metadata_info);
+
+  // NOLINTNEXTLINE: uninitialized struct is OK b/o Clear()
+  libCZI::WriteMetadataInfo write_metadata_info;
+  write_metadata_info.Clear();
+  const auto& metadata_xml = metadata_builder->GetXml();
+  write_metadata_info.szMetadata = metadata_xml.c_str();
+  write_metadata_info.szMetadataSize = metadata_xml.size() + 1;
+  writer->SyncWriteMetadata(write_metadata_info);
+  writer->Close();
+
+  size_t czi_document_size = 0;
+  const shared_ptr<void> czi_document_data = out_stream->GetCopy(&czi_document_size);
+  return make_tuple(czi_document_data, czi_document_size);
+}
+
+/// Runs an operation (copying the source document into an in-memory document on a single thread).
+///
+/// \param  state                   The benchmark state (used to report an error).
+/// \param  czi_document            The source document.
+/// \param  compression_options     The compression options - if empty, the document is decompressed.
+/// \param  statistics              If non-null, the byte statistics of the operation are stored here.
+///
+/// \returns    The stream containing the destination document.
+shared_ptr<CMemOutputStream> RunOperation(benchmark::State& state, const tuple<shared_ptr<void>, size_t>& czi_document,
+                                             const std::string& compression_options, std::vector<SubBlockByteStatistics>* statistics)
+{
+  const auto reader = libCZI::CreateCZIReader();
+  reader->Open(make_shared<CMemInputOutputStream>(std::get<0>(czi_document).get(), std::get<1>(czi_document)));
+  auto writer = libCZI::CreateCZIWriter();
+  auto out_stream = make_shared<CMemOutputStream>(std::get<1>(czi_document));
+  writer->Create(out_stream, make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+
+  const CopyCziOptions options;
+  std::unique_ptr<CopyCziBase> operation;
+  if (compression_options.empty())
+  {
+    operation = std::make_unique<CopyCziAndDecompress>(reader, writer, nullptr, options);
+  }
+  else
+  {
+    operation = std::make_unique<CopyCziAndCompress>(reader, writer, nullptr, CompressionStrategy::kAll,
+                                                     libCZI::Utils::ParseCompressionOptions(compression_options), options);
+  }
+
+  if (!operation->Run())
+  {
+    state.SkipWithError("copy operation failed");
+  }
+
+  writer->Close();
+  if (statistics != nullptr)
+  {
+    *statistics = operation->GetStatistics().GetByteStatistics();
+  }
+
+  return out_stream;
+}
+
+/// Gets a source document for a benchmark. Since a benchmark function is called several times with the same arguments
+/// (until the number of iterations is determined), the most recently created document is kept - but only this one,
+/// so that the memory used does not grow with the number of benchmarks.
+///
+/// \param  state               The benchmark state (used to report an error).
+/// \param  pixel_type          The pixel type of the tiles.
+/// \param  tile_size           The width and height of the tiles (in pixels).
+/// \param  content             The content of the tiles.
+/// \param  compression_options The compression options the document is compressed with - if empty, the document is
+///                             uncompressed.
+///
+/// \returns    A blob containing a CZI document.
+const tuple<shared_ptr<void>, size_t>& GetSourceCzi(benchmark::State& state, libCZI::PixelType pixel_type, std::uint32_t tile_size,
+                                                   Content content, const std::string& compression_options)
+{
+  static tuple<libCZI::PixelType, std::uint32_t, Content, std::string> key;
+  static tuple<shared_ptr<void>, size_t> czi_document;
+  const auto requested_key = make_tuple(pixel_type, tile_size, content, compression_options);
+  if (std::get<0>(czi_document) == nullptr || key != requested_key)
+  {
+    czi_document = CreateUncompressedCzi(pixel_type, tile_size, content);
+    if (!compression_options.empty())
+    {
+      const auto out_stream = RunOperation(state, czi_document, compression_options, nullptr);
+      size_t czi_document_size = 0;
+      const shared_ptr<void> czi_document_data = out_stream->GetCopy(&czi_document_size);
+      czi_document = make_tuple(czi_document_data, czi_document_size);
+    }
+
+    key = requested_key;
+  }
+
+  return czi_document;
+}
+
+/// Reports the throughput (with respect to the size of the uncompressed pixel data) and the compression ratio (i.e.
+/// the size of the uncompressed subblocks divided by the size of the compressed subblocks).
+void ReportThroughputAndRatio(benchmark::State& state, libCZI::PixelType pixel_type, double compression_ratio)
+{
+  const std::int64_t bytes_per_iteration = kNumberOfPixelsPerDocument * libCZI::Utils::GetBytesPerPixel(pixel_type);
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * bytes_per_iteration);
+  state.counters["ratio"] = compression_ratio;
+  state.SetLabel(libCZI::Utils::PixelTypeToInformalString(pixel_type));
+}
+
+double CalculateCompressionRatio(const std::vector<SubBlockByteStatistics>& statistics, bool is_compressing)
+{
+  std::uint64_t input_bytes = 0;
+  std::uint64_t output_bytes = 0;
+  for (const auto& item : statistics)
+  {
+    input_bytes += item.input_bytes;
+    output_bytes += item.output_bytes;
+  }
+
+  const std::uint64_t compressed_bytes = is_compressing ? output_bytes : input_bytes;
+  const std::uint64_t uncompressed_bytes = is_compressing ? input_bytes : output_bytes;
+  return compressed_bytes > 0 ? static_cast<double>(uncompressed_bytes) / static_cast<double>(compressed_bytes) : 0;
+}
+
+/// Adds the arguments (index of pixel type, tile size, compression level and "HiLoByteUnpack") for 'BM_Compress' -
+/// "HiLoByteUnpack" is only used with the pixel types with 16 bits per channel, since it has no effect otherwise.
+void AddCompressArguments(benchmark::internal::Benchmark* benchmark)
+{
+  for (size_t i = 0; i < kPixelTypes.size(); ++i)
+  {
+    for (const auto tile_size : kTileSizes)
+    {
+      for (const auto compression_level : kCompressionLevels)
+      {
+        benchmark->Args({static_cast<std::int64_t>(i), tile_size, compression_level, 0});
+        if (IsHiLoByteUnpackApplicable(kPixelTypes[i]))
+        {
+          benchmark->Args({static_cast<std::int64_t>(i), tile_size, compression_level, 1});
+        }
+      }
+    }
+  }
+}
+
+/// Adds the arguments (index of pixel type, tile size and "HiLoByteUnpack") for 'BM_Decompress'.
+void AddDecompressArguments(benchmark::internal::Benchmark* benchmark)
+{
+  for (size_t i = 0; i < kPixelTypes.size(); ++i)
+  {
+    for (const auto tile_size : kTileSizes)
+    {
+      benchmark->Args({static_cast<std::int64_t>(i), tile_size, 0});
+      if (IsHiLoByteUnpackApplicable(kPixelTypes[i]))
+      {
+        benchmark->Args({static_cast<std::int64_t>(i), tile_size, 1});
+      }
+    }
+  }
+}
+
+/// Adds the arguments (index of pixel type and tile size) for 'BM_CopyVerbatim'.
+void AddCopyVerbatimArguments(benchmark::internal::Benchmark* benchmark)
+{
+  for (size_t i = 0; i < kPixelTypes.size(); ++i)
+  {
+    for (const auto tile_size : kTileSizes)
+    {
+      benchmark->Args({static_cast<std::int64_t>(i), tile_size});
+    }
+  }
+}
+
+/// Compresses an uncompressed document with "zstd1" - i.e. each subblock goes through 'CopyCziAndCompress::CompressSubBlock'.
+/// The arguments are the index of the pixel type, the tile size, the compression level and whether "HiLoByteUnpack" is used.
+void BM_Compress(benchmark::State& state, Content content)
+{
+  const auto pixel_type = kPixelTypes.at(static_cast<size_t>(state.range(0)));
+  const auto tile_size = static_cast<std::uint32_t>(state.range(1));
+  const std::string compression_options = CreateCompressionOptions(state.range(2), state.range(3) != 0);
+  const auto& czi_document = GetSourceCzi(state, pixel_type, tile_size, content, std::string());
+  std::vector<SubBlockByteStatistics> statistics;
+  for (auto _ : state)
+  {
+    RunOperation(state, czi_document, compression_options, &statistics);
+  }
+
+  ReportThroughputAndRatio(state, pixel_type, CalculateCompressionRatio(statistics, true));
+}
+
+/// Decompresses a document compressed with "zstd1" (with compression level 1). The arguments are the index of the
+/// pixel type, the tile size and whether the document was compressed with "HiLoByteUnpack".
+void BM_Decompress(benchmark::State& state, Content content)
+{
+  const auto pixel_type = kPixelTypes.at(static_cast<size_t>(state.range(0)));
+  const auto tile_size = static_cast<std::uint32_t>(state.range(1));
+  const auto& czi_document = GetSourceCzi(state, pixel_type, tile_size, content, CreateCompressionOptions(1, state.range(2) != 0));
+  std::vector<SubBlockByteStatistics> statistics;
+  for (auto _ : state)
+  {
+    RunOperation(state, czi_document, std::string(), &statistics);
+  }
+
+  ReportThroughputAndRatio(state, pixel_type, CalculateCompressionRatio(statistics, false));
+}
+
+/// "Decompresses" an uncompressed document - i.e. each subblock is copied verbatim, which gives the baseline cost of
+/// reading and writing the subblocks. The arguments are the index of the pixel type and the tile size.
+void BM_CopyVerbatim(benchmark::State& state)
+{
+  const auto pixel_type = kPixelTypes.at(static_cast<size_t>(state.range(0)));
+  const auto tile_size = static_cast<std::uint32_t>(state.range(1));
+  const auto& czi_document = GetSourceCzi(state, pixel_type, tile_size, Content::kPattern, std::string());
+  for (auto _ : state)
+  {
+    RunOperation(state, czi_document, std::string(), nullptr);
+  }
+
+  ReportThroughputAndRatio(state, pixel_type, 1);
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_Compress, pattern, Content::kPattern)
+    ->ArgNames({"pixeltype", "tile", "level", "hilo"})
+    ->Apply(AddCompressArguments)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Compress, noise, Content::kNoise)
+    ->ArgNames({"pixeltype", "tile", "level", "hilo"})
+    ->Apply(AddCompressArguments)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Compress, synthetic, Content::kSynthetic)
+    ->ArgNames({"pixeltype", "tile", "level", "hilo"})
+    ->Apply(AddCompressArguments)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Decompress, pattern, Content::kPattern)
+    ->ArgNames({"pixeltype", "tile", "hilo"})
+    ->Apply(AddDecompressArguments)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Decompress, synthetic, Content::kSynthetic)
+    ->ArgNames({"pixeltype", "tile", "hilo"})
+    ->Apply(AddDecompressArguments)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CopyVerbatim)->ArgNames({"pixeltype", "tile"})->Apply(AddCopyVerbatimArguments)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,139 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include <benchmark/benchmark.h>
+#include <include/inputstream.h>
+#include <include/outputstream.h>
+#include <src/copyczi.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "libczi_utils.h"
+
+using std::make_shared;
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// The number of tiles in x- and y-direction of the synthetic document.
+constexpr int kNumberOfTilesPerRow = 8;
+
+/// The width and height of the tiles of the synthetic document (in pixels) - with Gray16, a tile has 2 MB.
+constexpr std::uint32_t kTileSize = 1024;
+
+/// Creates a file (in the temp-folder) containing a CZI with uncompressed tiles of pixeltype "Gray16" in a mosaic
+/// arrangement.
+/// \returns    The file containing the CZI document.
+std::unique_ptr<TemporaryFile> CreateCziFileWithUncompressedTiles()
+{
+  auto writer = libCZI::CreateCZIWriter();
+  auto out_stream = make_shared<CMemOutputStream>(0);
+  auto writer_info = make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}});  // NOLINT
+  writer->Create(out_stream, writer_info);
+
+  int m_index = 0;
+  for (int row = 0; row < kNumberOfTilesPerRow; ++row)
+  {
+    for (int column = 0; column < kNumberOfTilesPerRow; ++column)
+    {
+      const auto bitmap =
+          CreateBitmapAndFillWithNoise(libCZI::PixelType::Gray16, kTileSize, kTileSize, static_cast<std::uint32_t>(m_index));
+      libCZI::AddSubBlockInfoStridedBitmap add_subblock_info;
+      add_subblock_info.Clear();
+      add_subblock_info.coordinate.Set(libCZI::DimensionIndex::C, 0);
+      add_subblock_info.mIndexValid = true;
+      add_subblock_info.mIndex = m_index++;
+      add_subblock_info.x = column * static_cast<int>(kTileSize);
+      add_subblock_info.y = row * static_cast<int>(kTileSize);
+      add_subblock_info.logicalWidth = add_subblock_info.physicalWidth = static_cast<int>(kTileSize);
+      add_subblock_info.logicalHeight = add_subblock_info.physicalHeight = static_cast<int>(kTileSize);
+      add_subblock_info.PixelType = bitmap->GetPixelType();
+      const libCZI::ScopedBitmapLockerSP lock_info_bitmap{bitmap};
+      add_subblock_info.ptrBitmap = lock_info_bitmap.ptrDataRoi;
+      add_subblock_info.strideBitmap = lock_info_bitmap.stride;
+      writer->SyncAddSubBlock(add_subblock_info);
+    }
+  }
+
+  const libCZI::PrepareMetadataInfo prepare_metadata_info;
+  const auto metadata_builder = writer->GetPreparedMetadata(prepare_metadata_info);
+
+  // NOLINTNEXTLINE: uninitialized struct is OK b/o Clear()
+  libCZI::WriteMetadataInfo write_metadata_info;
+  write_metadata_info.Clear();
+  const auto& metadata_xml = metadata_builder->GetXml();
+  write_metadata_info.szMetadata = metadata_xml.c_str();
+  write_metadata_info.szMetadataSize = metadata_xml.size() + 1;
+  writer->SyncWriteMetadata(write_metadata_info);
+  writer->Close();
+
+  const auto* data = reinterpret_cast<const std::uint8_t*>(out_stream->GetDataC());  // NOLINT
+  return std::make_unique<TemporaryFile>("czicompress_bench_copyfilerange_source.czi",
+                                         std::vector<std::uint8_t>(data, data + out_stream->GetDataSize()));  // NOLINT
+}
+
+const TemporaryFile& GetCziFileWithUncompressedTiles()
+{
+  static const std::unique_ptr<TemporaryFile> czi_file = CreateCziFileWithUncompressedTiles();
+  return *czi_file;
+}
+
+/// Copies the document from file to file with the "decompress" operation, so that all subblocks are copied verbatim.
+/// Either the subblock data is written from memory (which is the default), or it is copied with 'copy_file_range'.
+void BM_CopyVerbatimFileToFile(benchmark::State& state, bool use_copy_file_range)
+{
+  const auto& source_file = GetCziFileWithUncompressedTiles();
+  const TemporaryFile destination_file("czicompress_bench_copyfilerange_destination.czi");
+  const std::uint64_t size_of_source_file = std::filesystem::file_size(std::filesystem::u8path(source_file.GetPath()));
+  std::uint64_t number_of_bytes_copied_from_source = 0;
+  for (auto _ : state)
+  {
+    const auto input_stream = CreateInputStreamForFile(source_file.GetPath(), InputIo::kPread);
+    const auto reader = libCZI::CreateCZIReader();
+    reader->Open(input_stream);
+
+    OutputStreamOptions output_stream_options;
+    output_stream_options.overwrite_existing_file = true;
+    if (use_copy_file_range)
+    {
+      output_stream_options.copy_file_range_source_file_name = source_file.GetPath();
+    }
+
+    const auto output_stream = CreateOutputStreamForFile(destination_file.GetPath(), output_stream_options);
+    auto writer = libCZI::CreateCZIWriter();
+    writer->Create(output_stream, make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+
+    CopyCziOptions options;
+    options.source_stream = input_stream;
+    options.source_range_copy = GetSourceRangeCopy(output_stream);
+    CopyCziAndDecompress copy_czi_and_decompress(reader, writer, nullptr, options);
+    if (!copy_czi_and_decompress.Run())
+    {
+      state.SkipWithError("copy operation failed");
+      break;
+    }
+
+    writer->Close();
+    CloseOutputStream(output_stream.get());
+    if (options.source_range_copy)
+    {
+      number_of_bytes_copied_from_source += options.source_range_copy->GetNumberOfBytesCopiedFromSource();
+    }
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * size_of_source_file));
+  state.counters["copied_from_source"] =
+      benchmark::Counter(static_cast<double>(number_of_bytes_copied_from_source), benchmark::Counter::kAvgIterations);
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_CopyVerbatimFileToFile, write_from_memory, false)->UseRealTime()->Unit(benchmark::kMillisecond);
+#ifndef _WIN32
+BENCHMARK_CAPTURE(BM_CopyVerbatimFileToFile, copy_file_range, true)->UseRealTime()->Unit(benchmark::kMillisecond);
+#endif
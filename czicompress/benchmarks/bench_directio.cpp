@@ -0,0 +1,138 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include <benchmark/benchmark.h>
+#include <include/outputstream.h>
+#include <src/copyczi.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <tuple>
+
+#include "libczi_utils.h"
+
+using std::make_shared, std::shared_ptr, std::tuple;
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// The number of tiles in x- and y-direction of the synthetic document.
+constexpr int kNumberOfTilesPerRow = 8;
+
+/// The width and height of the tiles of the synthetic document (in pixels) - with Gray16, a tile has 2 MB.
+constexpr std::uint32_t kTileSize = 1024;
+
+/// Creates a CZI (in memory) with zstd-compressed tiles of pixeltype "Gray16" in a mosaic arrangement - the tiles are
+/// created uncompressed, and then compressed with the "compress" operation.
+/// \returns    A blob containing the CZI document.
+tuple<shared_ptr<void>, size_t> CreateCziDocumentWithCompressedTiles()
+{
+  const auto writer_info = make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}});  // NOLINT
+  auto writer = libCZI::CreateCZIWriter();
+  const auto uncompressed_stream = make_shared<CMemInputOutputStream>(0);
+  writer->Create(uncompressed_stream, writer_info);
+
+  int m_index = 0;
+  for (int row = 0; row < kNumberOfTilesPerRow; ++row)
+  {
+    for (int column = 0; column < kNumberOfTilesPerRow; ++column)
+    {
+      const auto bitmap = CreateBitmapAndFillWithPattern(libCZI::PixelType::Gray16, kTileSize, kTileSize);
+      libCZI::AddSubBlockInfoStridedBitmap add_subblock_info;
+      add_subblock_info.Clear();
+      add_subblock_info.coordinate.Set(libCZI::DimensionIndex::C, 0);
+      add_subblock_info.mIndexValid = true;
+      add_subblock_info.mIndex = m_index++;
+      add_subblock_info.x = column * static_cast<int>(kTileSize);
+      add_subblock_info.y = row * static_cast<int>(kTileSize);
+      add_subblock_info.logicalWidth = add_subblock_info.physicalWidth = static_cast<int>(kTileSize);
+      add_subblock_info.logicalHeight = add_subblock_info.physicalHeight = static_cast<int>(kTileSize);
+      add_subblock_info.PixelType = bitmap->GetPixelType();
+      const libCZI::ScopedBitmapLockerSP lock_info_bitmap{bitmap};
+      add_subblock_info.ptrBitmap = lock_info_bitmap.ptrDataRoi;
+      add_subblock_info.strideBitmap = lock_info_bitmap.stride;
+      writer->SyncAddSubBlock(add_subblock_info);
+    }
+  }
+
+  const libCZI::PrepareMetadataInfo prepare_metadata_info;
+  const auto metadata_builder = writer->GetPreparedMetadata(prepare_metadata_info);
+
+  // NOLINTNEXTLINE: uninitialized struct is OK b/o Clear()
+  libCZI::WriteMetadataInfo write_metadata_info;
+  write_metadata_info.Clear();
+  const auto& metadata_xml = metadata_builder->GetXml();
+  write_metadata_info.szMetadata = metadata_xml.c_str();
+  write_metadata_info.szMetadataSize = metadata_xml.size() + 1;
+  writer->SyncWriteMetadata(write_metadata_info);
+  writer->Close();
+
+  const auto reader = libCZI::CreateCZIReader();
+  reader->Open(uncompressed_stream);
+  writer = libCZI::CreateCZIWriter();
+  const auto compressed_stream = make_shared<CMemInputOutputStream>(0);
+  writer->Create(compressed_stream, writer_info);
+  {
+    CopyCziAndCompress copy_czi_and_compress(reader, writer, nullptr, CompressionStrategy::kAll,
+                                             libCZI::Utils::ParseCompressionOptions("zstd1:"));
+    copy_czi_and_compress.Run();
+  }
+
+  writer->Close();
+
+  size_t size = 0;
+  auto data = compressed_stream->GetCopy(&size);
+  return {data, size};
+}
+
+const tuple<shared_ptr<void>, size_t>& GetCziDocumentWithCompressedTiles()
+{
+  static const tuple<shared_ptr<void>, size_t> czi_document = CreateCziDocumentWithCompressedTiles();
+  return czi_document;
+}
+
+/// Decompresses the document (from memory) into a file - with the file written with buffered I/O (which is the
+/// default), or with direct I/O. The throughput is given in terms of the size of the destination file. Note that with
+/// buffered I/O the data may still be in the page cache when an iteration ends, whereas with direct I/O it has been
+/// transferred to the storage - so direct I/O is expected to be slower here, and its benefit (that the page cache is
+/// not filled with the data of the destination file) is not visible in this benchmark.
+void BM_DecompressToFile(benchmark::State& state, bool use_direct_io)
+{
+  const auto& czi_document = GetCziDocumentWithCompressedTiles();
+  const TemporaryFile destination_file("czicompress_bench_directio_destination.czi");
+  for (auto _ : state)
+  {
+    const auto input_stream = make_shared<CMemInputOutputStream>(std::get<0>(czi_document).get(), std::get<1>(czi_document));
+    const auto reader = libCZI::CreateCZIReader();
+    reader->Open(input_stream);
+
+    OutputStreamOptions output_stream_options;
+    output_stream_options.overwrite_existing_file = true;
+    output_stream_options.direct_io = use_direct_io;
+    const auto output_stream = CreateOutputStreamForFile(destination_file.GetPath(), output_stream_options);
+    auto writer = libCZI::CreateCZIWriter();
+    writer->Create(output_stream, make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+
+    CopyCziAndDecompress copy_czi_and_decompress(reader, writer, nullptr, CopyCziOptions());
+    if (!copy_czi_and_decompress.Run())
+    {
+      state.SkipWithError("copy operation failed");
+      break;
+    }
+
+    writer->Close();
+    CloseOutputStream(output_stream.get());
+  }
+
+  const std::uint64_t size_of_destination_file = std::filesystem::file_size(std::filesystem::u8path(destination_file.GetPath()));
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * size_of_destination_file));
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_DecompressToFile, buffered, false)->UseRealTime()->Unit(benchmark::kMillisecond);
+#ifndef _WIN32
+BENCHMARK_CAPTURE(BM_DecompressToFile, direct_io, true)->UseRealTime()->Unit(benchmark::kMillisecond);
+#endif
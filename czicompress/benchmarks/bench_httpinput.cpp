@@ -0,0 +1,128 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#ifndef _WIN32
+
+#include <benchmark/benchmark.h>
+#include <include/inputstream.h>
+#include <src/copyczi.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include "httptestserver.h"
+#include "libczi_utils.h"
+
+using std::make_shared, std::shared_ptr, std::tuple;
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// The number of tiles in x- and y-direction of the synthetic document.
+constexpr int kNumberOfTilesPerRow = 8;
+
+/// The width and height of the tiles of the synthetic document (in pixels) - with Gray16, a tile has 512 KB.
+constexpr std::uint32_t kTileSize = 512;
+
+/// Creates a CZI (in memory) with uncompressed tiles of pixeltype "Gray16" in a mosaic arrangement.
+/// \returns    The content of the CZI document.
+std::vector<std::uint8_t> CreateCziDocumentWithUncompressedTiles()
+{
+  auto writer = libCZI::CreateCZIWriter();
+  const auto stream = make_shared<CMemInputOutputStream>(0);
+  writer->Create(stream, make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+
+  int m_index = 0;
+  for (int row = 0; row < kNumberOfTilesPerRow; ++row)
+  {
+    for (int column = 0; column < kNumberOfTilesPerRow; ++column)
+    {
+      const auto bitmap = CreateBitmapAndFillWithPattern(libCZI::PixelType::Gray16, kTileSize, kTileSize);
+      libCZI::AddSubBlockInfoStridedBitmap add_subblock_info;
+      add_subblock_info.Clear();
+      add_subblock_info.coordinate.Set(libCZI::DimensionIndex::C, 0);
+      add_subblock_info.mIndexValid = true;
+      add_subblock_info.mIndex = m_index++;
+      add_subblock_info.x = column * static_cast<int>(kTileSize);
+      add_subblock_info.y = row * static_cast<int>(kTileSize);
+      add_subblock_info.logicalWidth = add_subblock_info.physicalWidth = static_cast<int>(kTileSize);
+      add_subblock_info.logicalHeight = add_subblock_info.physicalHeight = static_cast<int>(kTileSize);
+      add_subblock_info.PixelType = bitmap->GetPixelType();
+      const libCZI::ScopedBitmapLockerSP lock_info_bitmap{bitmap};
+      add_subblock_info.ptrBitmap = lock_info_bitmap.ptrDataRoi;
+      add_subblock_info.strideBitmap = lock_info_bitmap.stride;
+      writer->SyncAddSubBlock(add_subblock_info);
+    }
+  }
+
+  const libCZI::PrepareMetadataInfo prepare_metadata_info;
+  const auto metadata_builder = writer->GetPreparedMetadata(prepare_metadata_info);
+
+  // NOLINTNEXTLINE: uninitialized struct is OK b/o Clear()
+  libCZI::WriteMetadataInfo write_metadata_info;
+  write_metadata_info.Clear();
+  const auto& metadata_xml = metadata_builder->GetXml();
+  write_metadata_info.szMetadata = metadata_xml.c_str();
+  write_metadata_info.szMetadataSize = metadata_xml.size() + 1;
+  writer->SyncWriteMetadata(write_metadata_info);
+  writer->Close();
+
+  const auto* data = static_cast<const std::uint8_t*>(stream->GetDataC());
+  return std::vector<std::uint8_t>(data, data + stream->GetDataSize());  // NOLINT: pointer arithmetic
+}
+
+/// Runs a "decompress" operation (where all subblocks are copied verbatim, so that the throughput is determined by
+/// reading the source document) on the document served by a local HTTP server, which delays each response by the
+/// latency given as the first argument (in milliseconds). The second argument tells whether the subblocks are fetched
+/// ahead of their use (with concurrent requests) - without this, each subblock costs two round trips. The throughput
+/// is given in terms of the size of the source document.
+void BM_CopyFromHttpServer(benchmark::State& state)
+{
+  if (!IsHttpInputAvailable())
+  {
+    state.SkipWithError("czicompress was built without libcurl");
+    return;
+  }
+
+  static const std::vector<std::uint8_t> czi_document = CreateCziDocumentWithUncompressedTiles();
+  const HttpTestServer server(czi_document, std::chrono::milliseconds(state.range(0)));
+  const bool use_read_ahead = state.range(1) != 0;
+  for (auto _ : state)
+  {
+    const auto input_stream = CreateInputStreamForFile(server.GetUrl(), InputIo::kPread);
+    const auto reader = libCZI::CreateCZIReader();
+    reader->Open(input_stream);
+    auto writer = libCZI::CreateCZIWriter();
+    writer->Create(make_shared<CMemInputOutputStream>(0),
+                   make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+
+    CopyCziOptions options;
+    options.number_of_threads = 4;
+    options.source_read_ahead = use_read_ahead ? GetSourceReadAhead(input_stream) : nullptr;
+    CopyCziAndDecompress copy_czi_and_decompress(reader, writer, nullptr, options);
+    if (!copy_czi_and_decompress.Run())
+    {
+      state.SkipWithError("copy operation failed");
+      break;
+    }
+
+    writer->Close();
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * czi_document.size()));
+  state.counters["requests"] = benchmark::Counter(static_cast<double>(server.GetNumberOfRequests()), benchmark::Counter::kAvgIterations);
+}
+
+}  // namespace
+
+BENCHMARK(BM_CopyFromHttpServer)
+    ->ArgsProduct({{0, 1, 5, 20}, {0, 1}})
+    ->ArgNames({"latency_ms", "read_ahead"})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+#endif
@@ -0,0 +1,201 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include <benchmark/benchmark.h>
+#include <src/copyczi.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+#include "libczi_utils.h"
+
+using std::make_shared, std::shared_ptr, std::tuple;
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// The number of tiles in x- and y-direction of the synthetic document.
+constexpr int kNumberOfTilesPerRow = 16;
+
+/// The width and height of the tiles of the synthetic document (in pixels).
+constexpr std::uint32_t kTileSize = 256;
+
+/// The simulated latency of a seek.
+constexpr std::chrono::microseconds kSeekLatency{100};
+
+/// A read starting at most this number of bytes after the end of the previous read is considered
+/// to be sequential (i.e. it does not cause a seek).
+constexpr std::uint64_t kMaxGapForSequentialRead = 4096;
+
+/// Implementation of libCZI::IStream which is backed by a memory buffer, and which simulates the cost
+/// of a seek (on a rotating disk or with a network file system) - a read which does not continue where
+/// the previous read ended is delayed by a fixed latency.
+class SeekPenaltyInputStream : public libCZI::IStream
+{
+private:
+  shared_ptr<void> data_;
+  size_t size_;
+  std::mutex mutex_;
+  std::uint64_t end_of_last_read_{0};
+  std::uint64_t number_of_seeks_{0};
+
+public:
+  SeekPenaltyInputStream(shared_ptr<void> data, size_t size) : data_(std::move(data)), size_(size) {}
+
+  std::uint64_t GetNumberOfSeeks()
+  {
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->number_of_seeks_;
+  }
+
+  void Read(std::uint64_t offset, void* data, std::uint64_t size, std::uint64_t* ptr_bytes_read) override
+  {
+    bool is_seek = false;
+    {
+      const std::lock_guard<std::mutex> lock(this->mutex_);
+      is_seek = offset < this->end_of_last_read_ || offset > this->end_of_last_read_ + kMaxGapForSequentialRead;
+      this->end_of_last_read_ = offset + size;
+      if (is_seek)
+      {
+        ++this->number_of_seeks_;
+      }
+    }
+
+    if (is_seek)
+    {
+      std::this_thread::sleep_for(kSeekLatency);
+    }
+
+    std::uint64_t bytes_read = 0;
+    if (offset < this->size_)
+    {
+      bytes_read = (std::min)(size, static_cast<std::uint64_t>(this->size_ - offset));
+      memcpy(data, static_cast<const char*>(this->data_.get()) + offset, bytes_read);  // NOLINT: pointer arithmetic
+    }
+
+    if (ptr_bytes_read != nullptr)
+    {
+      *ptr_bytes_read = bytes_read;
+    }
+  }
+};
+
+/// Creates a CZI with uncompressed tiles of pixeltype "Gray8" in a mosaic arrangement, where the order of
+/// the subblock directory is shuffled - i.e. reading the subblocks in directory order means jumping around
+/// in the file.
+/// \returns    A blob containing a CZI document.
+tuple<shared_ptr<void>, size_t> CreateFragmentedCzi()
+{
+  auto writer = libCZI::CreateCZIWriter();
+  auto out_stream = make_shared<CMemOutputStream>(0);
+  auto writer_info = make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}});  // NOLINT
+  writer->Create(out_stream, writer_info);
+
+  int m_index = 0;
+  for (int row = 0; row < kNumberOfTilesPerRow; ++row)
+  {
+    for (int column = 0; column < kNumberOfTilesPerRow; ++column)
+    {
+      const auto bitmap = CreateGray8BitmapAndFill(kTileSize, kTileSize, static_cast<uint8_t>(m_index));
+      libCZI::AddSubBlockInfoStridedBitmap add_subblock_info;
+      add_subblock_info.Clear();
+      add_subblock_info.coordinate.Set(libCZI::DimensionIndex::C, 0);
+      add_subblock_info.mIndexValid = true;
+      add_subblock_info.mIndex = m_index++;
+      add_subblock_info.x = column * static_cast<int>(kTileSize);
+      add_subblock_info.y = row * static_cast<int>(kTileSize);
+      add_subblock_info.logicalWidth = add_subblock_info.physicalWidth = static_cast<int>(kTileSize);
+      add_subblock_info.logicalHeight = add_subblock_info.physicalHeight = static_cast<int>(kTileSize);
+      add_subblock_info.PixelType = bitmap->GetPixelType();
+      const libCZI::ScopedBitmapLockerSP lock_info_bitmap{bitmap};
+      add_subblock_info.ptrBitmap = lock_info_bitmap.ptrDataRoi;
+      add_subblock_info.strideBitmap = lock_info_bitmap.stride;
+      writer->SyncAddSubBlock(add_subblock_info);
+    }
+  }
+
+  const libCZI::PrepareMetadataInfo prepare_metadata_info;
+  const auto metadata_builder = writer->GetPreparedMetadata(prepare_metadata_info);
+
+  // NOLINTNEXTLINE: uninitialized struct is OK b/o Clear()
+  libCZI::WriteMetadataInfo write_metadata_info;
+  write_metadata_info.Clear();
+  const auto& metadata_xml = metadata_builder->GetXml();
+  write_metadata_info.szMetadata = metadata_xml.c_str();
+  write_metadata_info.szMetadataSize = metadata_xml.size() + 1;
+  writer->SyncWriteMetadata(write_metadata_info);
+  writer->Close();
+
+  size_t czi_document_size = 0;
+  const shared_ptr<void> czi_document_data = out_stream->GetCopy(&czi_document_size);
+  ShuffleSubBlockDirectory(czi_document_data.get(), czi_document_size, 1);
+  return make_tuple(czi_document_data, czi_document_size);
+}
+
+const tuple<shared_ptr<void>, size_t>& GetFragmentedCzi()
+{
+  static const tuple<shared_ptr<void>, size_t> czi_document = CreateFragmentedCzi();
+  return czi_document;
+}
+
+/// Copies the fragmented document (with the "decompress" operation, so that the subblocks are copied
+/// verbatim and the time is dominated by reading), where the source stream simulates the seek latency.
+/// The argument of the benchmark is the number of threads.
+void BM_CopyFragmentedDocument(benchmark::State& state, SubBlockReadOrder read_order, SubBlockOutputOrder output_order)
+{
+  const auto& czi_document = GetFragmentedCzi();
+  std::uint64_t number_of_seeks = 0;
+  for (auto _ : state)
+  {
+    const auto input_stream = make_shared<SeekPenaltyInputStream>(std::get<0>(czi_document), std::get<1>(czi_document));
+    const auto reader = libCZI::CreateCZIReader();
+    reader->Open(input_stream);
+    auto writer = libCZI::CreateCZIWriter();
+    const auto output_stream = make_shared<CMemOutputStream>(std::get<1>(czi_document));
+    writer->Create(output_stream, make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+
+    CopyCziOptions options;
+    options.number_of_threads = static_cast<int>(state.range(0));
+    options.read_order = read_order;
+    options.output_order = output_order;
+    CopyCziAndDecompress copy_czi_and_decompress(reader, writer, nullptr, options);
+    if (!copy_czi_and_decompress.Run())
+    {
+      state.SkipWithError("copy operation failed");
+      break;
+    }
+
+    writer->Close();
+    number_of_seeks += input_stream->GetNumberOfSeeks();
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * std::get<1>(czi_document)));
+  state.counters["seeks"] = benchmark::Counter(static_cast<double>(number_of_seeks), benchmark::Counter::kAvgIterations);
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_CopyFragmentedDocument, directory_order, SubBlockReadOrder::kDirectory, SubBlockOutputOrder::kSource)
+    ->Arg(1)
+    ->Arg(4)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_CopyFragmentedDocument, file_order_keep_source_order, SubBlockReadOrder::kFilePosition, SubBlockOutputOrder::kSource)
+    ->Arg(1)
+    ->Arg(4)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_CopyFragmentedDocument, file_order_use_read_order, SubBlockReadOrder::kFilePosition, SubBlockOutputOrder::kRead)
+    ->Arg(1)
+    ->Arg(4)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
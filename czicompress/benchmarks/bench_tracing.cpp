@@ -0,0 +1,137 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include <benchmark/benchmark.h>
+#include <include/tracer.h>
+#include <src/copyczi.h>
+
+#include <cstdint>
+#include <memory>
+#include <tuple>
+
+#include "libczi_utils.h"
+
+using std::make_shared, std::shared_ptr, std::tuple;
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// The number of tiles in x- and y-direction of the synthetic document - there are many small tiles, so that the
+/// cost per subblock (which is where the tracing happens) is as visible as possible.
+constexpr int kNumberOfTilesPerRow = 32;
+
+/// The width and height of the tiles of the synthetic document (in pixels).
+constexpr std::uint32_t kTileSize = 64;
+
+/// Creates a CZI with uncompressed tiles of pixeltype "Gray16" (filled with noise) in a mosaic arrangement.
+/// \returns    A blob containing a CZI document.
+tuple<shared_ptr<void>, size_t> CreateCziWithManySmallTiles()
+{
+  auto writer = libCZI::CreateCZIWriter();
+  auto out_stream = make_shared<CMemOutputStream>(0);
+  writer->Create(out_stream, make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+
+  int m_index = 0;
+  for (int row = 0; row < kNumberOfTilesPerRow; ++row)
+  {
+    for (int column = 0; column < kNumberOfTilesPerRow; ++column)
+    {
+      const auto bitmap =
+          CreateBitmapAndFillWithNoise(libCZI::PixelType::Gray16, kTileSize, kTileSize, static_cast<std::uint32_t>(m_index));
+      libCZI::AddSubBlockInfoStridedBitmap add_subblock_info;
+      add_subblock_info.Clear();
+      add_subblock_info.coordinate.Set(libCZI::DimensionIndex::C, 0);
+      add_subblock_info.mIndexValid = true;
+      add_subblock_info.mIndex = m_index++;
+      add_subblock_info.x = column * static_cast<int>(kTileSize);
+      add_subblock_info.y = row * static_cast<int>(kTileSize);
+      add_subblock_info.logicalWidth = add_subblock_info.physicalWidth = static_cast<int>(kTileSize);
+      add_subblock_info.logicalHeight = add_subblock_info.physicalHeight = static_cast<int>(kTileSize);
+      add_subblock_info.PixelType = bitmap->GetPixelType();
+      const libCZI::ScopedBitmapLockerSP lock_info_bitmap{bitmap};
+      add_subblock_info.ptrBitmap = lock_info_bitmap.ptrDataRoi;
+      add_subblock_info.strideBitmap = lock_info_bitmap.stride;
+      writer->SyncAddSubBlock(add_subblock_info);
+    }
+  }
+
+  const libCZI::PrepareMetadataInfo prepare_metadata_info;
+  const auto metadata_builder = writer->GetPreparedMetadata(prepare_metadata_info);
+
+  // NOLINTNEXTLINE: uninitialized struct is OK b/o Clear()
+  libCZI::WriteMetadataInfo write_metadata_info;
+  write_metadata_info.Clear();
+  const auto& metadata_xml = metadata_builder->GetXml();
+  write_metadata_info.szMetadata = metadata_xml.c_str();
+  write_metadata_info.szMetadataSize = metadata_xml.size() + 1;
+  writer->SyncWriteMetadata(write_metadata_info);
+  writer->Close();
+
+  size_t czi_document_size = 0;
+  const shared_ptr<void> czi_document_data = out_stream->GetCopy(&czi_document_size);
+  return make_tuple(czi_document_data, czi_document_size);
+}
+
+const tuple<shared_ptr<void>, size_t>& GetCziWithManySmallTiles()
+{
+  static const tuple<shared_ptr<void>, size_t> czi_document = CreateCziWithManySmallTiles();
+  return czi_document;
+}
+
+/// Measures the cost of recording the begin and the end of a stage - with a null buffer (i.e. tracing disabled),
+/// this is the cost added to each stage of each subblock.
+void BM_TraceScope(benchmark::State& state, bool tracing_enabled)
+{
+  Tracer tracer(1024);
+  TraceBuffer* const trace_buffer = tracing_enabled ? tracer.AddThread("main") : nullptr;
+  int subblock_index = 0;
+  for (auto _ : state)
+  {
+    const TraceScope trace_scope(trace_buffer, TraceStage::kProcess, subblock_index++);
+    benchmark::DoNotOptimize(subblock_index);
+  }
+}
+
+/// Compresses the document with many small tiles, with and without tracing. The argument of the benchmark is the
+/// number of threads.
+void BM_CompressWithTracing(benchmark::State& state, bool tracing_enabled)
+{
+  const auto& czi_document = GetCziWithManySmallTiles();
+  for (auto _ : state)
+  {
+    const auto reader = libCZI::CreateCZIReader();
+    reader->Open(make_shared<CMemInputOutputStream>(std::get<0>(czi_document).get(), std::get<1>(czi_document)));
+    auto writer = libCZI::CreateCZIWriter();
+    writer->Create(make_shared<CMemOutputStream>(std::get<1>(czi_document)),
+                   make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+
+    CopyCziOptions options;
+    options.number_of_threads = static_cast<int>(state.range(0));
+    if (tracing_enabled)
+    {
+      options.tracer = make_shared<Tracer>();
+    }
+
+    CopyCziAndCompress copy_czi_and_compress(reader, writer, nullptr, CompressionStrategy::kAll,
+                                             libCZI::Utils::ParseCompressionOptions("zstd1:ExplicitLevel=1"), options);
+    if (!copy_czi_and_compress.Run())
+    {
+      state.SkipWithError("copy operation failed");
+      break;
+    }
+
+    writer->Close();
+  }
+
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * std::get<1>(czi_document)));
+  const double number_of_subblocks = static_cast<double>(state.iterations()) * kNumberOfTilesPerRow * kNumberOfTilesPerRow;
+  state.counters["subblocks"] = benchmark::Counter(number_of_subblocks, benchmark::Counter::kIsRate);
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_TraceScope, disabled, false);
+BENCHMARK_CAPTURE(BM_TraceScope, enabled, true);
+BENCHMARK_CAPTURE(BM_CompressWithTracing, disabled, false)->Arg(1)->Arg(4)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_CompressWithTracing, enabled, true)->Arg(1)->Arg(4)->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -5,13 +5,24 @@
 #include "capi.h"
 
 #include <CZICompress_Config.h>
-#include <include/utils/utf8/utf8converter.h>
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "inc_libCZI.h"
 #include "include/IOperation.h"
+#include "include/bufferpoolsite.h"
+#include "include/filecopy.h"
+#include "include/inputstream.h"
+#include "include/outputstream.h"
+#include "include/ratelimiter.h"
+#include "include/segmentreservation.h"
 
 #if CZICOMPRESS_WIN32_ENVIRONMENT
 
@@ -25,6 +36,21 @@ private:
   Command command_;
   CompressionStrategy compression_strategy_;
   int compression_level_;
+  InputIo input_io_{InputIo::kPread};
+  InputCache input_cache_{InputCache::kAuto};
+  std::uint64_t write_buffer_size_{0};
+  bool use_copy_file_range_{false};
+  UnchangedFileHandling unchanged_file_handling_{UnchangedFileHandling::kRewrite};
+  bool preallocate_{false};
+  bool use_direct_io_{false};
+  ProcessingResult last_processing_result_{ProcessingResult::kInvalid};
+  std::vector<SubBlockByteStatistics> last_byte_statistics_;
+  SegmentReservations last_segment_reservations_;
+  SegmentPlacements last_segment_placements_;
+
+  // the rate limiters are always in place (without a limit by default), so that a limit can be set while a file is processed
+  std::shared_ptr<RateLimiter> read_rate_limiter_{std::make_shared<RateLimiter>()};
+  std::shared_ptr<RateLimiter> write_rate_limiter_{std::make_shared<RateLimiter>()};
 
 public:
   FileProcessor(Command command, CompressionStrategy strategy, int compression_level)
@@ -32,11 +58,43 @@ public:
   {
   }
 
-  void ProcessFile(const char *const input_path, const char *const output_path, ProgressReport progress_report)
+  void SetInputIo(InputIo input_io) { this->input_io_ = input_io; }
+
+  void SetInputCache(InputCache input_cache) { this->input_cache_ = input_cache; }
+
+  void SetWriteBufferSize(std::uint64_t write_buffer_size) { this->write_buffer_size_ = write_buffer_size; }
+
+  void SetUseCopyFileRange(bool use_copy_file_range) { this->use_copy_file_range_ = use_copy_file_range; }
+
+  void SetPreallocate(bool preallocate) { this->preallocate_ = preallocate; }
+
+  void SetUseDirectIo(bool use_direct_io) { this->use_direct_io_ = use_direct_io; }
+
+  void SetUnchangedFileHandling(UnchangedFileHandling unchanged_file_handling) { this->unchanged_file_handling_ = unchanged_file_handling; }
+
+  ProcessingResult GetLastProcessingResult() const { return this->last_processing_result_; }
+
+  const std::vector<SubBlockByteStatistics> &GetLastByteStatistics() const { return this->last_byte_statistics_; }
+
+  const SegmentReservations &GetLastSegmentReservations() const { return this->last_segment_reservations_; }
+
+  const SegmentPlacements &GetLastSegmentPlacements() const { return this->last_segment_placements_; }
+
+  RateLimiter &GetReadRateLimiter() const { return *this->read_rate_limiter_; }
+
+  RateLimiter &GetWriteRateLimiter() const { return *this->write_rate_limiter_; }
+
+  void ProcessFile(const char *const input_path, const char *const output_path,
+                   const std::function<bool(const ProgressInfoEx &)> &progress_report)
   {
+    this->last_processing_result_ = ProcessingResult::kInvalid;
+    this->last_byte_statistics_.clear();
+    this->last_segment_reservations_ = SegmentReservations();
+    this->last_segment_placements_ = SegmentPlacements();
+
     // create the "CZI-reader"-object
     const std::string input_string(input_path);
-    const auto stream = libCZI::CreateStreamFromFile(utils::utf8::WidenUtf8(input_string).c_str());
+    const auto stream = CreateInputStreamForFile(input_string, this->input_io_, this->input_cache_, this->read_rate_limiter_);
     const auto reader = libCZI::CreateCZIReader();
 
     // Note: we request "strict parsing" when opening the CZI, which will cause libCZI to bail out with an exception
@@ -46,9 +104,49 @@ public:
     open_options.ignore_sizem_for_pyramid_subblocks = true;
     reader->Open(stream, &open_options);
 
-    // create the stream-object representing the destination file
+    // if the operation would not change anything, we may be able to do without writing the destination file (but a
+    //  source file on an HTTP server cannot be cloned - in this case, the destination file is written as usual)
     const std::string output_string(output_path);
-    const auto output_stream = libCZI::CreateOutputStreamForFile(utils::utf8::WidenUtf8(output_string).c_str(), false);
+    if (this->unchanged_file_handling_ != UnchangedFileHandling::kRewrite &&
+        !(this->unchanged_file_handling_ == UnchangedFileHandling::kClone && IsHttpUrl(input_string)) &&
+        this->CreateOperationForSourceDocument(reader)->AreAllSubBlocksCopiedVerbatim())
+    {
+      if (this->unchanged_file_handling_ == UnchangedFileHandling::kClone)
+      {
+        CopyFileContent(input_string, output_string, false, this->read_rate_limiter_, this->write_rate_limiter_);
+        this->last_processing_result_ = ProcessingResult::kCloned;
+      }
+      else
+      {
+        this->last_processing_result_ = ProcessingResult::kSkipped;
+      }
+
+      reader->Close();
+      ProgressInfoEx progress_info_ex{};
+      progress_info_ex.phase = ProcessingPhase::kWriteXmlMetadata;
+      progress_info_ex.progress_percent = 100;
+      progress_info_ex.estimated_seconds_remaining = -1;
+      progress_report(progress_info_ex);
+      return;
+    }
+
+    // create the stream-object representing the destination file
+    OutputStreamOptions output_stream_options;
+    output_stream_options.write_buffer_size = this->write_buffer_size_;
+    if (this->use_copy_file_range_)
+    {
+      output_stream_options.copy_file_range_source_file_name = input_string;
+    }
+
+    output_stream_options.direct_io = this->use_direct_io_;
+    output_stream_options.rate_limiter = this->write_rate_limiter_;
+
+    if (this->preallocate_)
+    {
+      output_stream_options.preallocation_size = this->CreateOperationForSourceDocument(reader)->EstimateSizeOfDestinationDocument();
+    }
+
+    const auto output_stream = CreateOutputStreamForFile(output_string, output_stream_options);
 
     // create (and configure) the "CZI-writer"-object - it is configured to ignore "duplicate subblocks"
     libCZI::CZIWriterOptions czi_writer_options;
@@ -58,12 +156,12 @@ public:
     // GUID_NULL here means that a new Guid is created
     const auto czi_writer_info = std::make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0}});
 
-    // TODO(JBL): it might be desirable to make reservations for the
-    // subblock-directory-/attachments-directory-/metadata-segment
-    //            (so that the end up at the beginning of the file instead
-    //            of at the end), but this shouldn't make a difference in
-    //            terms of proper operation
-    writer->Create(output_stream, czi_writer_info);
+    // reserve space for the subblock-directory-/attachments-directory-/metadata-segment, so that they end up at the
+    //  beginning of the file instead of at the end - the recorder tells us afterwards whether the reservations were used
+    const auto segment_reservations = ReserveSegmentsForCopy(reader.get(), czi_writer_info.get());
+    const auto segment_placement_recorder = std::make_shared<SegmentPlacementRecorder>(output_stream);
+    writer->Create(segment_placement_recorder, czi_writer_info);
+    segment_placement_recorder->SetEndOfReservedSpace();
 
     auto operation = CreateOperationUp();
     OperationDescription operation_description;
@@ -72,47 +170,89 @@ public:
     operation_description.command = this->command_;
     operation_description.compression_strategy = this->compression_strategy_;
     operation_description.compression_option = FileProcessor::CreateCompressionOptions(this->compression_level_);
+    operation_description.source_stream = stream;
+    operation_description.source_range_copy = GetSourceRangeCopy(output_stream);
     operation->SetParameters(operation_description);
 
     operation->DoOperation(
         [&progress_report](const ProgressInfo &progress_info) -> bool
         {
-          // The task here is to map the "progress_info" to a value between 0 and 100
-          // What we do is:
-          // We assign those weights to the phases:
-          // CopySubblocks: 95%
-          // CopyAttachments: 4%
-          // WriteXmlMetadata: 1%
-          //
-          // and we put in the assumption that the phases occur in exactly this order.
-          float phase_progress = 50;
-          if (progress_info.phase == ProcessingPhase::kCopySubblocks && progress_info.number_of_items_todo > 0)
-          {
-            phase_progress =
-                static_cast<float>(progress_info.number_of_items_done) / static_cast<float>(progress_info.number_of_items_todo);
-          }
-
-          float total_progress = 0;
-          switch (progress_info.phase)
-          {
-            case ProcessingPhase::kCopySubblocks:
-              total_progress = 95 * phase_progress;
-              break;
-            case ProcessingPhase::kCopyAttachments:
-              total_progress = 95 + 4 * phase_progress;
-              break;
-            case ProcessingPhase::kWriteXmlMetadata:
-              total_progress = 95 + 4 + 1 * phase_progress;
-          }
-
-          return progress_report(static_cast<int32_t>(total_progress));
+          ProgressInfoEx progress_info_ex{};
+          progress_info_ex.phase = progress_info.phase;
+          progress_info_ex.progress_percent = FileProcessor::CalculateProgressPercent(progress_info);
+          progress_info_ex.input_bytes_done = progress_info.input_bytes_done;
+          progress_info_ex.input_bytes_total = progress_info.input_bytes_total;
+          progress_info_ex.output_bytes_done = progress_info.output_bytes_done;
+          progress_info_ex.output_bytes_total = progress_info.output_bytes_total;
+          progress_info_ex.input_bytes_per_second = progress_info.input_bytes_per_second;
+          progress_info_ex.estimated_seconds_remaining = progress_info.estimated_seconds_remaining;
+          return progress_report(progress_info_ex);
         });
 
     writer->Close();
+    CloseOutputStream(output_stream.get());
     reader->Close();
+    this->last_processing_result_ = ProcessingResult::kProcessed;
+    this->last_byte_statistics_ = operation->GetStatistics().byte_statistics;
+    this->last_segment_reservations_ = segment_reservations;
+    this->last_segment_placements_ = segment_placement_recorder->GetSegmentPlacements();
   }
 
 private:
+  /// Creates an operation object which is able to examine the source document (but not to run the operation).
+  std::unique_ptr<IOperation> CreateOperationForSourceDocument(const std::shared_ptr<libCZI::ICZIReader> &reader) const
+  {
+    OperationDescription operation_description;
+    operation_description.reader = reader;
+    operation_description.command = this->command_;
+    operation_description.compression_strategy = this->compression_strategy_;
+    operation_description.compression_option = FileProcessor::CreateCompressionOptions(this->compression_level_);
+    auto operation = CreateOperationUp();
+    operation->SetParameters(operation_description);
+    return operation;
+  }
+
+  static int32_t CalculateProgressPercent(const ProgressInfo &progress_info)
+  {
+    // The task here is to map the "progress_info" to a value between 0 and 100
+    // What we do is:
+    // We assign those weights to the phases:
+    // CopySubblocks: 95%
+    // CopyAttachments: 4%
+    // WriteXmlMetadata: 1%
+    //
+    // and we put in the assumption that the phases occur in exactly this order. Within the subblock phase, the
+    // progress is given by the bytes of the source file processed (so that it is proportional to the work done,
+    // also if the sizes of the subblocks vary a lot), and otherwise by the number of items.
+    float phase_progress = 0.5F;
+    if (progress_info.phase == ProcessingPhase::kCopySubblocks && progress_info.input_bytes_total > 0)
+    {
+      phase_progress = static_cast<float>(progress_info.input_bytes_done) / static_cast<float>(progress_info.input_bytes_total);
+    }
+    else if (progress_info.number_of_items_todo > 0)
+    {
+      phase_progress = static_cast<float>(progress_info.number_of_items_done) / static_cast<float>(progress_info.number_of_items_todo);
+    }
+
+    float total_progress = 0;
+    switch (progress_info.phase)
+    {
+      case ProcessingPhase::kCopySubblocks:
+        total_progress = 95 * phase_progress;
+        break;
+      case ProcessingPhase::kCopyAttachments:
+        total_progress = 95 + 4 * phase_progress;
+        break;
+      case ProcessingPhase::kWriteXmlMetadata:
+        total_progress = 95 + 4 + 1 * phase_progress;
+        break;
+      default:
+        break;
+    }
+
+    return (std::min)(static_cast<int32_t>(total_progress), 100);
+  }
+
   static libCZI::Utils::CompressionOption CreateCompressionOptions(int compression_level)
   {
     std::stringstream ss;
@@ -124,9 +264,203 @@ private:
 
 void *CreateFileProcessor(Command command, CompressionStrategy strategy, int compression_level)
 {
+  // the bitmaps (decoded from the subblocks) are to be allocated from the buffer pool - this must be done before the
+  //  first call into libCZI, and a file processor is needed for any call into libCZI
+  static std::once_flag pooled_bitmap_site_installed;
+  std::call_once(pooled_bitmap_site_installed,
+                 []() { InstallPooledBitmapSite(libCZI::GetDefaultSiteObject(libCZI::SiteObjectType::Default)); });
+
   return new FileProcessor(command, strategy, compression_level);
 }
 
+int SetInputIo(void *file_processor, InputIo input_io)
+{
+  if (file_processor == nullptr || (input_io != InputIo::kPread && input_io != InputIo::kMmap))
+  {
+    return EXIT_FAILURE;
+  }
+
+  static_cast<FileProcessor *>(file_processor)->SetInputIo(input_io);
+  return EXIT_SUCCESS;
+}
+
+int SetInputCache(void *file_processor, InputCache input_cache)
+{
+  if (file_processor == nullptr ||
+      (input_cache != InputCache::kAuto && input_cache != InputCache::kOn && input_cache != InputCache::kOff))
+  {
+    return EXIT_FAILURE;
+  }
+
+  static_cast<FileProcessor *>(file_processor)->SetInputCache(input_cache);
+  return EXIT_SUCCESS;
+}
+
+int SetWriteBufferSize(void *file_processor, uint64_t write_buffer_size)
+{
+  if (file_processor == nullptr)
+  {
+    return EXIT_FAILURE;
+  }
+
+  static_cast<FileProcessor *>(file_processor)->SetWriteBufferSize(write_buffer_size);
+  return EXIT_SUCCESS;
+}
+
+int SetUseCopyFileRange(void *file_processor, bool use_copy_file_range)
+{
+  if (file_processor == nullptr)
+  {
+    return EXIT_FAILURE;
+  }
+
+  static_cast<FileProcessor *>(file_processor)->SetUseCopyFileRange(use_copy_file_range);
+  return EXIT_SUCCESS;
+}
+
+int SetPreallocate(void *file_processor, bool preallocate)
+{
+  if (file_processor == nullptr)
+  {
+    return EXIT_FAILURE;
+  }
+
+  static_cast<FileProcessor *>(file_processor)->SetPreallocate(preallocate);
+  return EXIT_SUCCESS;
+}
+
+int SetUseDirectIo(void *file_processor, bool use_direct_io)
+{
+  if (file_processor == nullptr)
+  {
+    return EXIT_FAILURE;
+  }
+
+  static_cast<FileProcessor *>(file_processor)->SetUseDirectIo(use_direct_io);
+  return EXIT_SUCCESS;
+}
+
+int SetUnchangedFileHandling(void *file_processor, UnchangedFileHandling unchanged_file_handling)
+{
+  if (file_processor == nullptr ||
+      (unchanged_file_handling != UnchangedFileHandling::kRewrite && unchanged_file_handling != UnchangedFileHandling::kClone &&
+       unchanged_file_handling != UnchangedFileHandling::kSkip))
+  {
+    return EXIT_FAILURE;
+  }
+
+  static_cast<FileProcessor *>(file_processor)->SetUnchangedFileHandling(unchanged_file_handling);
+  return EXIT_SUCCESS;
+}
+
+int GetLastProcessingResult(void *file_processor, ProcessingResult *result)
+{
+  if (file_processor == nullptr || result == nullptr)
+  {
+    return EXIT_FAILURE;
+  }
+
+  *result = static_cast<const FileProcessor *>(file_processor)->GetLastProcessingResult();
+  return EXIT_SUCCESS;
+}
+
+int GetSubBlockByteStatistics(void *file_processor, SubBlockByteStatisticsEntry *entries, uint64_t *number_of_entries)
+{
+  if (file_processor == nullptr || number_of_entries == nullptr || (entries == nullptr && *number_of_entries > 0))
+  {
+    return EXIT_FAILURE;
+  }
+
+  const auto &byte_statistics = static_cast<const FileProcessor *>(file_processor)->GetLastByteStatistics();
+  const auto number_of_entries_to_copy =
+      static_cast<size_t>((std::min)(*number_of_entries, static_cast<uint64_t>(byte_statistics.size())));
+  for (size_t i = 0; i < number_of_entries_to_copy; ++i)
+  {
+    const SubBlockByteStatistics &source = byte_statistics[i];
+    SubBlockByteStatisticsEntry &entry = entries[i];  // NOLINT: pointer arithmetic
+    entry.pixel_type = static_cast<int32_t>(source.pixel_type);
+    entry.pyramid_type = static_cast<int32_t>(source.pyramid_type);
+    entry.source_compression_mode = static_cast<int32_t>(source.source_compression_mode);
+    entry.action = source.action;
+    entry.number_of_subblocks = source.number_of_subblocks;
+    entry.input_bytes = source.input_bytes;
+    entry.output_bytes = source.output_bytes;
+  }
+
+  *number_of_entries = byte_statistics.size();
+  return EXIT_SUCCESS;
+}
+
+int GetSegmentPlacements(void *file_processor, SegmentPlacementsInfo *placements)
+{
+  if (file_processor == nullptr || placements == nullptr)
+  {
+    return EXIT_FAILURE;
+  }
+
+  const auto *processor = static_cast<const FileProcessor *>(file_processor);
+  const SegmentReservations &reservations = processor->GetLastSegmentReservations();
+  const SegmentPlacements &segment_placements = processor->GetLastSegmentPlacements();
+  placements->subblock_directory = segment_placements.subblock_directory;
+  placements->attachment_directory = segment_placements.attachment_directory;
+  placements->metadata = segment_placements.metadata;
+  placements->reserved_subblock_directory_entries = reservations.number_of_subblock_directory_entries;
+  placements->reserved_attachment_directory_entries = reservations.number_of_attachment_directory_entries;
+  placements->reserved_metadata_size = reservations.metadata_size;
+  return EXIT_SUCCESS;
+}
+
+int SetMaxReadMegabytesPerSecond(void *file_processor, double megabytes_per_second)
+{
+  if (file_processor == nullptr)
+  {
+    return EXIT_FAILURE;
+  }
+
+  try
+  {
+    static_cast<FileProcessor *>(file_processor)->GetReadRateLimiter().SetMaxMegabytesPerSecond(megabytes_per_second);
+  }
+  catch (const std::invalid_argument &)
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int SetMaxWriteMegabytesPerSecond(void *file_processor, double megabytes_per_second)
+{
+  if (file_processor == nullptr)
+  {
+    return EXIT_FAILURE;
+  }
+
+  try
+  {
+    static_cast<FileProcessor *>(file_processor)->GetWriteRateLimiter().SetMaxMegabytesPerSecond(megabytes_per_second);
+  }
+  catch (const std::invalid_argument &)
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int GetThrottledTime(void *file_processor, double *read_seconds, double *write_seconds)
+{
+  if (file_processor == nullptr || read_seconds == nullptr || write_seconds == nullptr)
+  {
+    return EXIT_FAILURE;
+  }
+
+  const auto *processor = static_cast<const FileProcessor *>(file_processor);
+  *read_seconds = std::chrono::duration<double>(processor->GetReadRateLimiter().GetThrottledTime()).count();
+  *write_seconds = std::chrono::duration<double>(processor->GetWriteRateLimiter().GetThrottledTime()).count();
+  return EXIT_SUCCESS;
+}
+
 void DestroyFileProcessor(void *file_processor)
 {
   auto *processor = static_cast<FileProcessor *>(file_processor);
@@ -169,8 +503,11 @@ bool GetLibVersionString(char *buffer, uint64_t *size)
   return true;
 }
 
-int ProcessFile(void *file_processor, const char *const input_path, const char *const output_path, char *error_message,
-                size_t *error_message_length, ProgressReport progress)
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+int ProcessFileAndReportError(void *file_processor, const char *const input_path, const char *const output_path, char *error_message,
+                              size_t *error_message_length, const std::function<bool(const ProgressInfoEx &)> &progress)
 {
   try
   {
@@ -216,3 +553,29 @@ int ProcessFile(void *file_processor, const char *const input_path, const char *
     return EXIT_FAILURE;
   }
 }
+
+}  // namespace
+
+int ProcessFile(void *file_processor, const char *const input_path, const char *const output_path, char *error_message,
+                size_t *error_message_length, ProgressReport progress)
+{
+  std::function<bool(const ProgressInfoEx &)> progress_function;
+  if (progress)
+  {
+    progress_function = [progress](const ProgressInfoEx &progress_info) -> bool { return progress(progress_info.progress_percent); };
+  }
+
+  return ProcessFileAndReportError(file_processor, input_path, output_path, error_message, error_message_length, progress_function);
+}
+
+int ProcessFileEx(void *file_processor, const char *const input_path, const char *const output_path, char *error_message,
+                  size_t *error_message_length, ProgressReportEx progress)
+{
+  std::function<bool(const ProgressInfoEx &)> progress_function;
+  if (progress)
+  {
+    progress_function = [progress](const ProgressInfoEx &progress_info) -> bool { return progress(&progress_info); };
+  }
+
+  return ProcessFileAndReportError(file_processor, input_path, output_path, error_message, error_message_length, progress_function);
+}
@@ -12,6 +12,41 @@
 #include "capi_export.h"
 #include "include/command.h"
 #include "include/compressionstrategy.h"
+#include "include/inputio.h"
+#include "include/progressinfo.h"
+#include "include/segmentplacement.h"
+#include "include/subblockaction.h"
+#include "include/unchangedfile.h"
+
+/**
+ * The number of bytes read and written for the subblocks with the same pixel type, pyramid type and compression mode
+ * (of the source subblock) and the same action, as reported by GetSubBlockByteStatistics().
+ */
+struct SubBlockByteStatisticsEntry
+{
+  int32_t pixel_type;               ///< The pixel type of the subblocks (the value of libCZI::PixelType).
+  int32_t pyramid_type;             ///< The pyramid type of the subblocks (the value of libCZI::SubBlockPyramidType).
+  int32_t source_compression_mode;  ///< The compression mode of the source subblocks (the value of libCZI::CompressionMode).
+  SubBlockAction action;            ///< What has been done with the subblocks.
+  uint64_t number_of_subblocks;     ///< The number of subblocks.
+  uint64_t input_bytes;             ///< The size of the data of the subblocks in the source file (in bytes).
+  uint64_t output_bytes;            ///< The size of the data of the subblocks written to the destination file (in bytes).
+};
+
+/**
+ * Where the subblock directory, the attachment directory and the metadata segment have been placed in the destination
+ * file, and the sizes of the reservations made for them at the start of the file, as reported by GetSegmentPlacements().
+ * A segment is written at the end of the file if no space was reserved for it or if the reserved space was insufficient.
+ */
+struct SegmentPlacementsInfo
+{
+  SegmentPlacement subblock_directory;             ///< Where the subblock directory has been placed.
+  SegmentPlacement attachment_directory;           ///< Where the attachment directory has been placed.
+  SegmentPlacement metadata;                       ///< Where the metadata segment has been placed.
+  uint64_t reserved_subblock_directory_entries;    ///< The number of subblock-directory entries space was reserved for.
+  uint64_t reserved_attachment_directory_entries;  ///< The number of attachment-directory entries space was reserved for.
+  uint64_t reserved_metadata_size;                 ///< The number of bytes reserved for the metadata segment.
+};
 
 // input_path is only guaranteed to exist during the duration of this call and should be copied if retained
 typedef bool (*ProgressReport)(int32_t progress_percent);  // NOLINT(readability/casting)
@@ -32,7 +67,44 @@ typedef bool (*ProgressReport)(int32_t progress_percent);  // NOLINT(readability
 extern "C" CAPI_EXPORT int ProcessFile(void* file_processor, const char* const input_path, const char* const output_path,
                                        char* error_message, size_t* error_message_length, ProgressReport progress_report);
 /**
- * Creates a new file processor for use in ProcessFile().
+ * Detailed information about the progress of ProcessFileEx().
+ */
+struct ProgressInfoEx
+{
+  ProcessingPhase phase;               ///< The current processing phase.
+  int32_t progress_percent;            ///< The overall progress (between 0 and 100), as reported by ProcessFile().
+  uint64_t input_bytes_done;           ///< The number of bytes of the subblocks in the source file processed so far.
+  uint64_t input_bytes_total;          ///< The total number of bytes of the subblocks in the source file.
+  uint64_t output_bytes_done;          ///< The number of bytes of subblock data written to the destination file so far.
+  uint64_t output_bytes_total;         ///< The estimated total number of bytes of subblock data to be written.
+  double input_bytes_per_second;       ///< The current throughput (bytes of the source file per second), or 0 if not yet known.
+  double estimated_seconds_remaining;  ///< The estimated time until all subblocks are processed, or negative if not yet known.
+};
+
+typedef bool (*ProgressReportEx)(const ProgressInfoEx* progress_info);  // NOLINT(readability/casting)
+
+/**
+ * Processes a single file with the specified file processor - like ProcessFile(), but reporting the progress in more
+ * detail: the bytes done and the (estimated) total bytes of the subblocks in the source and the destination file, the
+ * current throughput and the estimated remaining time. The ProgressInfoEx passed to the progress function is only valid
+ * for the duration of the call.
+ *
+ * @param  file_processor        A file processor pointer obtained with CreateFileProcessor().
+ * @param  input_path            The UTF8-encoded, null-terminated path of the file to process.
+ * @param  output_path           The UTF8-encoded, null-terminated path of the file to create and write to.
+ * @param  error_message         A character buffer to which a UTF8-encoded error message can be written in case of failure.
+ * @param  error_message_length  Initially, the size of the error_message buffer. If the method fails (returns non-zero),
+ *                               this parameter will be set to the size of the (cropped if necessary) error_message string.
+ * @param progress_report        A function pointer called to report progress and check cancellation.
+ *
+ * @returns    Zero (0) in case of success, a non-zero value in case of failure.
+ */
+extern "C" CAPI_EXPORT int ProcessFileEx(void* file_processor, const char* const input_path, const char* const output_path,
+                                         char* error_message, size_t* error_message_length, ProgressReportEx progress_report);
+
+/**
+ * Creates a new file processor for use in ProcessFile(). The first call sets up libCZI so that the bitmaps decoded from
+ * the subblocks are allocated from a buffer pool, which recycles them across subblocks.
  *
  *  @param command  The #Command to use
  *  @param strategy The #CompressionStrategy to use if the command is a compression command (ignored for decompression)
@@ -42,6 +114,174 @@ extern "C" CAPI_EXPORT int ProcessFile(void* file_processor, const char* const i
  */
 extern "C" CAPI_EXPORT void* CreateFileProcessor(Command command, CompressionStrategy strategy, int compression_level);
 
+/**
+ * Sets the way the source file is accessed by the specified file processor. The default is #InputIo::kPread.
+ *
+ *  @param file_processor   A file processor pointer obtained with CreateFileProcessor().
+ *  @param input_io         The #InputIo to use.
+ *
+ * @returns    Zero (0) in case of success, a non-zero value if an argument is invalid.
+ */
+extern "C" CAPI_EXPORT int SetInputIo(void* file_processor, InputIo input_io);
+
+/**
+ * Sets whether the specified file processor reads the source file through a block cache, which reads the data in
+ * blocks of 64 KB, merges adjacent read operations and reads ahead. This reduces the number of round trips with file
+ * systems where each read operation has a high latency (e.g. NFS or SMB). The default is #InputCache::kAuto, i.e. the
+ * cache is used if the source file is on a network file system (and it is read with #InputIo::kPread).
+ *
+ *  @param file_processor   A file processor pointer obtained with CreateFileProcessor().
+ *  @param input_cache      The #InputCache mode to use.
+ *
+ * @returns    Zero (0) in case of success, a non-zero value if an argument is invalid.
+ */
+extern "C" CAPI_EXPORT int SetInputCache(void* file_processor, InputCache input_cache);
+
+/**
+ * Sets the size of the buffers in which the data for the destination file is collected by the specified file processor.
+ * The buffers are written to the file on a background thread. A size of zero (the default) means that the data is
+ * written directly.
+ *
+ *  @param file_processor     A file processor pointer obtained with CreateFileProcessor().
+ *  @param write_buffer_size  The size of the write buffers in bytes.
+ *
+ * @returns    Zero (0) in case of success, a non-zero value if an argument is invalid.
+ */
+extern "C" CAPI_EXPORT int SetWriteBufferSize(void* file_processor, uint64_t write_buffer_size);
+
+/**
+ * Sets whether the data of subblocks which are copied verbatim is copied from the source file to the destination file
+ * by the operating system (with 'copy_file_range') instead of being written from memory. This is only supported on Linux,
+ * and it cannot be combined with a write buffer (see SetWriteBufferSize()). The default is false.
+ *
+ *  @param file_processor       A file processor pointer obtained with CreateFileProcessor().
+ *  @param use_copy_file_range  True if 'copy_file_range' is to be used.
+ *
+ * @returns    Zero (0) in case of success, a non-zero value if an argument is invalid.
+ */
+extern "C" CAPI_EXPORT int SetUseCopyFileRange(void* file_processor, bool use_copy_file_range);
+
+/**
+ * Sets whether the specified file processor allocates the space for the destination file up front. The size of the
+ * destination file is then estimated (from the directories of the source file and the expected compression ratio),
+ * and the file is truncated to its actual size at the end. This is only supported on Linux - on other platforms, the
+ * setting is ignored. The default is false.
+ *
+ *  @param file_processor   A file processor pointer obtained with CreateFileProcessor().
+ *  @param preallocate      True if the space for the destination file is to be preallocated.
+ *
+ * @returns    Zero (0) in case of success, a non-zero value if an argument is invalid.
+ */
+extern "C" CAPI_EXPORT int SetPreallocate(void* file_processor, bool preallocate);
+
+/**
+ * Sets whether the specified file processor writes the destination file with direct I/O (i.e. bypassing the page cache),
+ * so that writing a large file does not evict the data of other processes from the page cache. If the file system does
+ * not support direct I/O, the file is written as usual. This is only supported on Linux and macOS, and it cannot be
+ * combined with SetUseCopyFileRange(). The default is false.
+ *
+ *  @param file_processor   A file processor pointer obtained with CreateFileProcessor().
+ *  @param use_direct_io    True if the destination file is to be written with direct I/O.
+ *
+ * @returns    Zero (0) in case of success, a non-zero value if an argument is invalid.
+ */
+extern "C" CAPI_EXPORT int SetUseDirectIo(void* file_processor, bool use_direct_io);
+
+/**
+ * Sets how the specified file processor handles a source file for which the operation would copy all subblocks verbatim
+ * (which is determined from the subblock directory before any subblock is read). With #UnchangedFileHandling::kClone, the
+ * destination file is a copy of the source file (made with a reflink if the file system supports it), and with
+ * #UnchangedFileHandling::kSkip, no destination file is written. The default is #UnchangedFileHandling::kRewrite.
+ * What has been done with the last file is reported by GetLastProcessingResult().
+ *
+ *  @param file_processor           A file processor pointer obtained with CreateFileProcessor().
+ *  @param unchanged_file_handling  The #UnchangedFileHandling to use.
+ *
+ * @returns    Zero (0) in case of success, a non-zero value if an argument is invalid.
+ */
+extern "C" CAPI_EXPORT int SetUnchangedFileHandling(void* file_processor, UnchangedFileHandling unchanged_file_handling);
+
+/**
+ * Gets what has been done with the file last processed successfully with ProcessFile() by the specified file processor.
+ *
+ *  @param file_processor   A file processor pointer obtained with CreateFileProcessor().
+ *  @param result           Set to the #ProcessingResult of the last file (#ProcessingResult::kInvalid if there is none).
+ *
+ * @returns    Zero (0) in case of success, a non-zero value if an argument is invalid.
+ */
+extern "C" CAPI_EXPORT int GetLastProcessingResult(void* file_processor, ProcessingResult* result);
+
+/**
+ * Gets the number of bytes read and written for the subblocks of the file last processed successfully with ProcessFile()
+ * by the specified file processor, broken down by pixel type, pyramid type, compression mode of the source subblock and
+ * action - with one entry for each combination which occurred. There are no entries if the destination file has not been
+ * written by the CZI-writer (see GetLastProcessingResult()).
+ * The caller passes in a buffer and a pointer to an uint64, where the latter must contain the number of entries the
+ * buffer can hold. On return, it contains the number of entries available, and as many of them as fit are copied into the
+ * buffer - so the number of entries can be queried first by passing in zero (and a null buffer).
+ *
+ *  @param file_processor       A file processor pointer obtained with CreateFileProcessor().
+ *  @param entries              Pointer to a buffer for the entries (which may be null if *number_of_entries is zero).
+ *  @param number_of_entries    Pointer to an uint64 which on input contains the number of entries the buffer can hold,
+ *                              and on output the number of entries available.
+ *
+ * @returns    Zero (0) in case of success, a non-zero value if an argument is invalid.
+ */
+extern "C" CAPI_EXPORT int GetSubBlockByteStatistics(void* file_processor, SubBlockByteStatisticsEntry* entries,
+                                                     uint64_t* number_of_entries);
+
+/**
+ * Gets where the segments which are written when the destination file is closed (the subblock directory, the attachment
+ * directory and the metadata segment) have been placed for the file last processed successfully with ProcessFile() by
+ * the specified file processor. All segments are reported as #SegmentPlacement::kNotWritten (and the reservations as
+ * zero) if the destination file has not been written by the CZI-writer (see GetLastProcessingResult()).
+ *
+ *  @param file_processor   A file processor pointer obtained with CreateFileProcessor().
+ *  @param placements       Pointer to a struct which receives the placements and the reservations.
+ *
+ * @returns    Zero (0) in case of success, a non-zero value if an argument is invalid.
+ */
+extern "C" CAPI_EXPORT int GetSegmentPlacements(void* file_processor, SegmentPlacementsInfo* placements);
+
+/**
+ * Sets the maximum rate (in megabytes of 1024*1024 bytes per second) at which the specified file processor reads the
+ * source file. Short bursts of 100 ms worth of data are allowed. A value of zero (the default) means that the rate is
+ * not limited. This function may be called from another thread while ProcessFile() is running - the new limit then
+ * takes effect immediately.
+ *
+ *  @param file_processor        A file processor pointer obtained with CreateFileProcessor().
+ *  @param megabytes_per_second  The maximum read rate (a non-negative number).
+ *
+ * @returns    Zero (0) in case of success, a non-zero value if an argument is invalid.
+ */
+extern "C" CAPI_EXPORT int SetMaxReadMegabytesPerSecond(void* file_processor, double megabytes_per_second);
+
+/**
+ * Sets the maximum rate (in megabytes of 1024*1024 bytes per second) at which the specified file processor writes the
+ * destination file. Short bursts of 100 ms worth of data are allowed. A value of zero (the default) means that the rate
+ * is not limited. This function may be called from another thread while ProcessFile() is running - the new limit then
+ * takes effect immediately.
+ *
+ *  @param file_processor        A file processor pointer obtained with CreateFileProcessor().
+ *  @param megabytes_per_second  The maximum write rate (a non-negative number).
+ *
+ * @returns    Zero (0) in case of success, a non-zero value if an argument is invalid.
+ */
+extern "C" CAPI_EXPORT int SetMaxWriteMegabytesPerSecond(void* file_processor, double megabytes_per_second);
+
+/**
+ * Gets the time the specified file processor has spent waiting because of the limits set with
+ * SetMaxReadMegabytesPerSecond() and SetMaxWriteMegabytesPerSecond() - summed over all files processed (and all threads)
+ * since the file processor was created. This function may be called from another thread while ProcessFile() is running.
+ *
+ *  @param file_processor   A file processor pointer obtained with CreateFileProcessor().
+ *  @param read_seconds     Set to the time (in seconds) spent waiting for reading the source file.
+ *  @param write_seconds    Set to the time (in seconds) spent waiting for writing the destination file.
+ *
+ * @returns    Zero (0) in case of success, a non-zero value if an argument is invalid.
+ */
+extern "C" CAPI_EXPORT int GetThrottledTime(void* file_processor, double* read_seconds, double* write_seconds);
+
 /**
  * Destroys a file processor after use.
  *
@@ -4,12 +4,17 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 
 #include "command.h"
 #include "compressionstrategy.h"
 #include "inc_libCZI.h"
+#include "operationstatistics.h"
 #include "progressinfo.h"
+#include "sourcerangecopy.h"
+#include "subblockorder.h"
+#include "tracer.h"
 
 /// This struct gathers all the information needed to perform a copy operation.
 /// Note that "copy operation" here is meant to be a generic term, something
@@ -33,6 +38,43 @@ struct OperationDescription
 
   /// (only valid in case of 'compress' command) The compression option.
   libCZI::Utils::CompressionOption compression_option;
+
+  /// The number of threads used for processing (i.e. decompressing and compressing) the subblocks. With
+  /// a value of 1, all work is done on the calling thread. A value of 0 means that the number of hardware
+  /// threads is used. Note that the result of the operation does not depend on this number.
+  int number_of_threads{1};
+
+  /// The maximum amount of memory (in megabytes) to be held by subblocks which have been read, but not
+  /// yet written. If this budget is exceeded, reading is suspended until enough subblocks have been
+  /// written. A value of 0 means "no limit".
+  std::uint64_t max_inflight_megabytes{0};
+
+  /// The number of subblocks to read ahead on a background thread, so that reading the source document
+  /// overlaps with processing. A value of 0 disables read-ahead (for single-threaded operation).
+  std::uint32_t prefetch_depth{0};
+
+  /// The maximum amount of memory (in megabytes) held by subblocks which have been read ahead. A value
+  /// of 0 means "no limit".
+  std::uint64_t prefetch_megabytes{0};
+
+  /// The order in which the subblocks of the source document are read.
+  SubBlockReadOrder read_order{SubBlockReadOrder::kDirectory};
+
+  /// The order in which the subblocks are written to the destination document (only relevant if the
+  /// subblocks are not read in directory order).
+  SubBlockOutputOrder output_order{SubBlockOutputOrder::kSource};
+
+  /// The stream from which the source document is read. This is needed if 'source_range_copy' is given, and it is
+  /// used for reporting the statistics of the block cache and for fetching the subblocks ahead of their use (if the
+  /// stream supports this, see 'GetSourceReadAhead').
+  std::shared_ptr<libCZI::IStream> source_stream;
+
+  /// If given, the data of subblocks which are copied verbatim is copied directly from the source file by this
+  /// object (which is the stream of the destination file), instead of being written from memory.
+  std::shared_ptr<ISourceRangeCopy> source_range_copy;
+
+  /// If given, the begin and the end of reading, processing and writing each subblock are recorded with this tracer.
+  std::shared_ptr<Tracer> tracer;
 };
 
 /// This interface encapsulates all functionality for a transform operation
@@ -56,6 +98,26 @@ public:
   ///                  functor returns false, the operation will be cancelled.
   virtual void DoOperation(const std::function<bool(const ProgressInfo&)>& progress) = 0;
 
+  /// Determines from the subblock directory of the source document (i.e. without reading any subblock) whether the
+  /// operation would copy all subblocks verbatim - i.e. whether it would leave the image data unchanged. Only the
+  /// reader, the command and the compression strategy of the description are used here. For a document with less
+  /// than two subblocks, false is returned, since the operation updates the compression stated in the metadata then.
+  ///
+  /// \returns True if all subblocks would be copied verbatim; false otherwise (or if this cannot be determined).
+  virtual bool AreAllSubBlocksCopiedVerbatim() = 0;
+
+  /// Estimates the size of the destination document from the directories and the metadata of the source document (i.e.
+  /// without reading any subblock). Only the reader, the command and the compression strategy of the description are
+  /// used here.
+  ///
+  /// \returns The estimated size of the destination document in bytes.
+  virtual std::uint64_t EstimateSizeOfDestinationDocument() = 0;
+
+  /// Gets statistics about the operation last executed with 'DoOperation'.
+  ///
+  /// \returns The statistics.
+  virtual OperationStatistics GetStatistics() const = 0;
+
   virtual ~IOperation() = default;
 };
 
@@ -0,0 +1,18 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+namespace libCZI
+{
+class ISite;
+}
+
+/// Installs a libCZI site object which allocates all bitmaps (in particular the bitmaps decoded from subblocks)
+/// from the process-wide buffer pool, so that those allocations are recycled across subblocks. Logging and the
+/// creation of decoders is delegated to the specified site object. As with 'libCZI::SetSiteObject', this must be
+/// called before the first call into libCZI, and at most once.
+///
+/// \param  underlying_site The site object to which logging and the creation of decoders is delegated.
+void InstallPooledBitmapSite(libCZI::ISite* underlying_site);
@@ -3,12 +3,16 @@
 // SPDX-License-Identifier: MIT
 
 #pragma once
+#include <cstdint>
 #include <memory>
 #include <string>
 
 #include "command.h"
 #include "compressionstrategy.h"
 #include "inc_libCZI.h"
+#include "inputio.h"
+#include "subblockorder.h"
+#include "unchangedfile.h"
 
 class IConsoleIo;
 
@@ -31,6 +35,22 @@ private:
   libCZI::Utils::CompressionOption compression_option_;
   bool overwrite_existing_file_{false};
   bool ignore_duplicate_subblocks_{true};
+  int number_of_threads_{1};
+  std::uint64_t max_inflight_megabytes_{0};
+  std::uint32_t prefetch_depth_{0};
+  std::uint64_t prefetch_megabytes_{0};
+  SubBlockReadOrder read_order_{SubBlockReadOrder::kDirectory};
+  SubBlockOutputOrder output_order_{SubBlockOutputOrder::kSource};
+  InputIo input_io_{InputIo::kPread};
+  InputCache input_cache_{InputCache::kAuto};
+  std::uint64_t write_buffer_megabytes_{0};
+  bool use_copy_file_range_{false};
+  UnchangedFileHandling unchanged_file_handling_{UnchangedFileHandling::kRewrite};
+  bool preallocate_{false};
+  bool use_direct_io_{false};
+  double max_read_megabytes_per_second_{0};
+  double max_write_megabytes_per_second_{0};
+  std::string trace_filename_;
 
 public:
   /// Values that represent the result of the "Parse"-operation.
@@ -103,6 +123,96 @@ public:
   /// \returns  True if duplicate subblocks are to be ignored (with the CZIWriter object); false otherwise.
   bool GetIgnoreDuplicateSubblocks() const { return this->ignore_duplicate_subblocks_; }
 
+  /// Gets the number of threads to be used for processing the subblocks. A value of 0 means that the
+  /// number of hardware threads is to be used.
+  ///
+  /// \returns The number of threads.
+  int GetNumberOfThreads() const { return this->number_of_threads_; }
+
+  /// Gets the maximum amount of memory (in megabytes) to be held by subblocks which have been read but
+  /// not yet written. A value of 0 means "no limit".
+  ///
+  /// \returns The maximum amount of memory in flight in megabytes.
+  std::uint64_t GetMaxInflightMegabytes() const { return this->max_inflight_megabytes_; }
+
+  /// Gets the number of subblocks to read ahead. A value of 0 means that read-ahead is disabled.
+  ///
+  /// \returns The number of subblocks to read ahead.
+  std::uint32_t GetPrefetchDepth() const { return this->prefetch_depth_; }
+
+  /// Gets the maximum amount of memory (in megabytes) to be held by subblocks which have been read ahead.
+  /// A value of 0 means "no limit".
+  ///
+  /// \returns The maximum amount of memory for read-ahead in megabytes.
+  std::uint64_t GetPrefetchMegabytes() const { return this->prefetch_megabytes_; }
+
+  /// Gets the order in which the subblocks of the source file are to be read.
+  ///
+  /// \returns The read order.
+  SubBlockReadOrder GetReadOrder() const { return this->read_order_; }
+
+  /// Gets the order in which the subblocks are to be written to the destination file.
+  ///
+  /// \returns The output order.
+  SubBlockOutputOrder GetOutputOrder() const { return this->output_order_; }
+
+  /// Gets the way the source file is to be accessed.
+  ///
+  /// \returns The input-io mode.
+  InputIo GetInputIo() const { return this->input_io_; }
+
+  /// Gets the mode of the block cache for reading the source file.
+  ///
+  /// \returns The input-cache mode.
+  InputCache GetInputCache() const { return this->input_cache_; }
+
+  /// Gets the size (in megabytes) of the buffers in which the data for the destination file is collected before
+  /// it is written on a background thread. A value of 0 means that the data is written directly.
+  ///
+  /// \returns The size of the write buffers in megabytes.
+  std::uint64_t GetWriteBufferMegabytes() const { return this->write_buffer_megabytes_; }
+
+  /// Gets a boolean indicating whether the data of subblocks which are copied verbatim is to be copied from the source
+  /// file with 'copy_file_range' (instead of being written from memory).
+  ///
+  /// \returns True if 'copy_file_range' is to be used; false otherwise.
+  bool GetUseCopyFileRange() const { return this->use_copy_file_range_; }
+
+  /// Gets how the source file is to be handled if the operation would copy all of its subblocks verbatim.
+  ///
+  /// \returns The handling of unchanged files.
+  UnchangedFileHandling GetUnchangedFileHandling() const { return this->unchanged_file_handling_; }
+
+  /// Gets a boolean indicating whether space for the destination file is to be allocated up front (with the estimated
+  /// size of the destination file).
+  ///
+  /// \returns True if space for the destination file is to be preallocated; false otherwise.
+  bool GetPreallocate() const { return this->preallocate_; }
+
+  /// Gets a boolean indicating whether the destination file is to be written with direct I/O (i.e. bypassing the page
+  /// cache).
+  ///
+  /// \returns True if the destination file is to be written with direct I/O; false otherwise.
+  bool GetUseDirectIo() const { return this->use_direct_io_; }
+
+  /// Gets the maximum rate (in megabytes per second) at which the source file is read. A value of 0 means that the
+  /// rate is not limited.
+  ///
+  /// \returns The maximum read rate in megabytes per second.
+  double GetMaxReadMegabytesPerSecond() const { return this->max_read_megabytes_per_second_; }
+
+  /// Gets the maximum rate (in megabytes per second) at which the destination file is written. A value of 0 means that
+  /// the rate is not limited.
+  ///
+  /// \returns The maximum write rate in megabytes per second.
+  double GetMaxWriteMegabytesPerSecond() const { return this->max_write_megabytes_per_second_; }
+
+  /// Gets the UTF8-encoded filename of the file to which the trace of the operation is written (in the Chrome
+  /// trace-event format). If empty, no trace is recorded.
+  ///
+  /// \returns The filename of the trace file.
+  const std::string& GetTraceFileName() const { return this->trace_filename_; }
+
 private:
   static std::string GetFooterText();
 };
@@ -16,4 +16,7 @@ enum class CompressionStrategy
   kUncompressedAndZStdCompressed,  ///< Only subblocks that are currently
                                    ///< uncompressed or ZStd compressed are
                                    ///< considered for compression.
+  kSmallest,                       ///< All subblocks are compressed, but the compressed data is only
+                                   ///< used if it is smaller than the original data - otherwise the
+                                   ///< subblock is copied verbatim.
 };
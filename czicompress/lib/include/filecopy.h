@@ -0,0 +1,35 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "ratelimiter.h"
+
+/// Values that represent the way a file has been copied.
+enum class FileCopyMethod
+{
+  kInvalid,        ///< An enum constant representing the invalid option
+  kReflink,        ///< The destination file shares the data with the source file (i.e. no data has been copied).
+  kCopyFileRange,  ///< The data has been copied by the kernel (or on the server with network file systems).
+  kReadWrite,      ///< The data has been read and written.
+};
+
+/// Copies the content of a file into a new file. The copy is made with a reflink if the file system supports it,
+/// otherwise with 'copy_file_range' (on Linux), and otherwise by reading and writing the data.
+/// If rate limiters are given, the data copied is counted against them chunk by chunk - both for reading and for
+/// writing, also if the data is copied by the kernel. A reflink does not transfer any data, so it is not limited.
+///
+/// \param  source_file_name            The UTF8-encoded filename of the file to copy.
+/// \param  destination_file_name       The UTF8-encoded filename of the file to create.
+/// \param  overwrite_existing_file     If true, an existing file is overwritten; otherwise it is an error if the file exists.
+/// \param  read_rate_limiter           If not null, the rate limiter for reading from the source file.
+/// \param  write_rate_limiter          If not null, the rate limiter for writing to the destination file.
+///
+/// \returns The way the file has been copied.
+FileCopyMethod CopyFileContent(const std::string& source_file_name, const std::string& destination_file_name,
+                               bool overwrite_existing_file, const std::shared_ptr<RateLimiter>& read_rate_limiter = nullptr,
+                               const std::shared_ptr<RateLimiter>& write_rate_limiter = nullptr);
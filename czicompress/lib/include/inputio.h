@@ -0,0 +1,26 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+/// Values that represent the way the source file is accessed.
+enum class InputIo
+{
+  kInvalid,  ///< An enum constant representing the invalid option
+  kPread,    ///< The source file is read with read-system-calls (this is the stream-object provided by libCZI).
+  kMmap,     ///< The source file is mapped into the address space of the process, and data is copied from the
+             ///< mapping. This avoids a system call for each read operation.
+};
+
+/// Values that represent whether the source file is read through a block cache (which reads the data in larger blocks,
+/// merges adjacent read operations and reads ahead). This is beneficial with file systems where each read operation
+/// has a high latency (e.g. NFS or SMB).
+enum class InputCache
+{
+  kInvalid,  ///< An enum constant representing the invalid option
+  kAuto,     ///< The block cache is used if the source file is on a network file system, and if it is read with
+             ///< InputIo::kPread (with InputIo::kMmap, the operating system reads ahead anyway).
+  kOn,       ///< The block cache is used.
+  kOff,      ///< The block cache is not used.
+};
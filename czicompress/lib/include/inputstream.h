@@ -0,0 +1,87 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "inputio.h"
+#include "ratelimiter.h"
+#include "sourcereadahead.h"
+
+namespace libCZI
+{
+class IStream;
+}
+
+/// Statistics about the use of the block cache for reading the source file.
+struct InputCacheStatistics
+{
+  /// The number of blocks which were found in the cache.
+  std::uint64_t hits{0};
+
+  /// The number of blocks which were not found in the cache (and therefore had to be read from the file).
+  std::uint64_t misses{0};
+
+  /// The number of read operations on the file - adjacent missing blocks are read with one read operation.
+  std::uint64_t number_of_reads{0};
+
+  /// The number of bytes read from the file (including the data read ahead).
+  std::uint64_t bytes_read{0};
+};
+
+/// Creates a stream-object for reading the specified file, accessing the file in the specified way. If the filename
+/// is an http(s)-URL (see 'IsHttpUrl'), the file is read from the server with range requests - in this case, the
+/// input-io mode must be 'pread', and the block cache is used only if requested explicitly.
+/// If a rate limiter is given, the reads from the file are limited by it - the limit applies to the reads below the
+/// block cache (i.e. blocks found in the cache are not counted).
+///
+/// \param  file_name       The UTF8-encoded filename of the file to open (or an http(s)-URL).
+/// \param  input_io        The way the file is accessed.
+/// \param  input_cache     Whether the file is read through a block cache.
+/// \param  rate_limiter    If not null, the rate limiter for reading from the file.
+///
+/// \returns The newly created stream-object.
+std::shared_ptr<libCZI::IStream> CreateInputStreamForFile(const std::string& file_name, InputIo input_io,
+                                                          InputCache input_cache = InputCache::kOff,
+                                                          std::shared_ptr<RateLimiter> rate_limiter = nullptr);
+
+/// Gets the statistics about the use of the block cache, if the specified stream-object reads through a block cache.
+///
+/// \param       stream      The stream-object (as created by 'CreateInputStreamForFile').
+/// \param [out] statistics  If successful, the statistics are put here.
+///
+/// \returns True if the stream-object reads through a block cache (and the statistics have been retrieved); false otherwise.
+bool TryGetInputCacheStatistics(libCZI::IStream* stream, InputCacheStatistics& statistics);
+
+/// Determines whether the specified file is located on a network file system (e.g. NFS or SMB). If this cannot be
+/// determined, false is returned.
+///
+/// \param  file_name   The UTF8-encoded filename of the file.
+///
+/// \returns True if the file is located on a network file system; false otherwise.
+bool IsFileOnNetworkFileSystem(const std::string& file_name);
+
+/// Determines whether the specified filename is an http(s)-URL, i.e. whether it starts with "http://" or "https://"
+/// (ignoring case).
+///
+/// \param  file_name   The filename.
+///
+/// \returns True if the filename is an http(s)-URL; false otherwise.
+bool IsHttpUrl(const std::string& file_name);
+
+/// Determines whether reading the source file from an http(s)-URL is available (i.e. czicompress was built with libcurl).
+///
+/// \returns True if reading from an http(s)-URL is available; false otherwise.
+bool IsHttpInputAvailable();
+
+/// Gets the read-ahead interface of the specified stream-object, if it is able to fetch the subblocks ahead of their
+/// use (which is the case for a stream-object reading from an http(s)-URL, with or without the block cache).
+///
+/// \param  stream  The stream-object (as created by 'CreateInputStreamForFile').
+///
+/// \returns The read-ahead interface of the stream-object; or null if it does not support this.
+std::shared_ptr<ISourceReadAhead> GetSourceReadAhead(const std::shared_ptr<libCZI::IStream>& stream);
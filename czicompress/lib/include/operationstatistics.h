@@ -0,0 +1,85 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "inc_libCZI.h"
+#include "subblockaction.h"
+
+/// The number of bytes read and written for the subblocks with the same pixel type, pyramid type and compression mode
+/// (of the source subblock) and the same action.
+struct SubBlockByteStatistics
+{
+  /// The pixel type of the subblocks.
+  libCZI::PixelType pixel_type{libCZI::PixelType::Invalid};
+
+  /// The pyramid type of the subblocks.
+  libCZI::SubBlockPyramidType pyramid_type{libCZI::SubBlockPyramidType::Invalid};
+
+  /// The compression mode of the subblocks in the source document.
+  libCZI::CompressionMode source_compression_mode{libCZI::CompressionMode::Invalid};
+
+  /// What has been done with the subblocks.
+  SubBlockAction action{SubBlockAction::kCopiedVerbatim};
+
+  /// The number of subblocks.
+  std::uint64_t number_of_subblocks{0};
+
+  /// The size of the data of the subblocks in the source document (in bytes).
+  std::uint64_t input_bytes{0};
+
+  /// The size of the data of the subblocks written to the destination document (in bytes).
+  std::uint64_t output_bytes{0};
+};
+
+/// Statistics about an operation, which are available after the operation has completed.
+struct OperationStatistics
+{
+  /// The number of subblocks which were copied verbatim.
+  std::uint64_t number_of_subblocks_copied_verbatim{0};
+
+  /// The number of subblocks which were compressed.
+  std::uint64_t number_of_subblocks_compressed{0};
+
+  /// The number of subblocks which were decompressed.
+  std::uint64_t number_of_subblocks_decompressed{0};
+
+  /// The number of subblocks which were already compressed as requested, and therefore were copied verbatim.
+  std::uint64_t number_of_subblocks_already_compressed{0};
+
+  /// The number of subblocks which were copied verbatim because the compressed data would not have been smaller.
+  std::uint64_t number_of_subblocks_kept_original{0};
+
+  /// The maximum number of bytes held by subblocks which were read, but not yet written (i.e. the
+  /// source data, the decoded bitmaps and the compressed data).
+  std::uint64_t peak_bytes_in_flight{0};
+
+  /// The number of buffer allocations (for decoded bitmaps and compressed data) which were served
+  /// with a recycled buffer from the buffer pool.
+  std::uint64_t buffer_pool_hits{0};
+
+  /// The number of buffer allocations for which a new buffer had to be allocated.
+  std::uint64_t buffer_pool_misses{0};
+
+  /// True if the source file was read through a block cache - only then the following input cache statistics are valid.
+  bool input_cache_used{false};
+
+  /// The number of blocks which were found in the block cache for the source file (including the reads made when
+  /// opening the document).
+  std::uint64_t input_cache_hits{0};
+
+  /// The number of blocks which had to be read from the source file.
+  std::uint64_t input_cache_misses{0};
+
+  /// The number of read operations on the source file made by the block cache.
+  std::uint64_t input_cache_reads{0};
+
+  /// The number of bytes read and written for the subblocks, broken down by pixel type, pyramid type, compression mode
+  /// of the source subblock and action - ordered by these keys (in this order), with one entry for each combination
+  /// which occurred.
+  std::vector<SubBlockByteStatistics> byte_statistics;
+};
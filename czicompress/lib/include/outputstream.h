@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "ratelimiter.h"
+#include "sourcerangecopy.h"
+
+namespace libCZI
+{
+class IOutputStream;
+}
+
+/// Options for creating the stream-object for the destination file.
+struct OutputStreamOptions
+{
+  /// If true, an existing file is overwritten; otherwise it is an error if the file exists.
+  bool overwrite_existing_file{false};
+
+  /// The size (in bytes) of the buffers in which write operations are merged before they are written to the file
+  /// on a background thread. A value of 0 means that the data is written directly.
+  std::uint64_t write_buffer_size{0};
+
+  /// If not empty, the UTF8-encoded filename of the source file - the stream-object is then able to copy ranges of
+  /// the source file into the destination file with 'copy_file_range' (see 'ISourceRangeCopy'). This is only supported
+  /// on POSIX systems, and it cannot be combined with a write buffer.
+  std::string copy_file_range_source_file_name;
+
+  /// The number of bytes to allocate for the file up front (with 'fallocate'), typically an estimate of the final size
+  /// of the file - the file is truncated to the size of the data written when the stream is closed. A value of 0 means
+  /// no preallocation. This is a hint only - it is ignored on platforms other than POSIX systems, and if the operating
+  /// system or the file system does not support it.
+  std::uint64_t preallocation_size{0};
+
+  /// If true, the file is written with direct I/O (i.e. bypassing the page cache), so that writing a large file does not
+  /// evict the data of other processes from the page cache. If the file system does not support direct I/O, the file is
+  /// written as usual. This is only supported on POSIX systems, and it cannot be combined with copying ranges of the
+  /// source file.
+  bool direct_io{false};
+
+  /// If not null, the writes to the file are limited by this rate limiter - the limit applies to the writes below the
+  /// write buffer (i.e. to the merged write operations), and it includes the ranges copied from the source file.
+  std::shared_ptr<RateLimiter> rate_limiter;
+};
+
+/// Creates a stream-object for writing the specified file.
+///
+/// \param  file_name   The UTF8-encoded filename of the file to create.
+/// \param  options     Options controlling how the file is written.
+///
+/// \returns The newly created stream-object.
+std::shared_ptr<libCZI::IOutputStream> CreateOutputStreamForFile(const std::string& file_name, const OutputStreamOptions& options);
+
+/// Gets the interface for copying ranges of the source file directly into the destination file, if the stream-object
+/// (created with 'CreateOutputStreamForFile') supports this.
+///
+/// \param  output_stream   The stream-object.
+///
+/// \returns The interface for copying ranges of the source file; or null if this is not supported by the stream-object.
+std::shared_ptr<ISourceRangeCopy> GetSourceRangeCopy(const std::shared_ptr<libCZI::IOutputStream>& output_stream);
+
+/// Closes a stream-object created with 'CreateOutputStreamForFile' - i.e. waits until all data has been written to
+/// the file. If an error occurred while writing data in the background (or if truncating a preallocated file failed),
+/// an exception is thrown. This must be called after the CZI-writer has been closed.
+///
+/// \param  output_stream   The stream-object to close.
+void CloseOutputStream(libCZI::IOutputStream* output_stream);
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <cstdint>
+
 /// Values that represent distinct phases in the CZI-copy operation.
 enum class ProcessingPhase
 {
@@ -34,6 +36,31 @@ struct ProgressInfo
   /// If less than zero, then no information about the number of items to
   /// process is available.
   int number_of_items_todo{0};
+
+  /// The number of bytes of the subblocks in the source document processed so far. The size of a subblock is the size
+  /// of its segment in the source file (as determined from the subblock directory) - so this is proportional to the
+  /// work done reading the source document, also if the sizes of the subblocks vary a lot. The byte counts refer to the
+  /// subblocks only, and they keep their final values in the phases after the subblocks.
+  std::uint64_t input_bytes_done{0};
+
+  /// The total number of bytes of the subblocks in the source document (the size of the last subblock segment in the
+  /// file is estimated).
+  std::uint64_t input_bytes_total{0};
+
+  /// The number of bytes of subblock data written to the destination document so far.
+  std::uint64_t output_bytes_done{0};
+
+  /// The estimated total number of bytes of subblock data to be written to the destination document (based on the
+  /// expected compression ratio) - the actual number may differ.
+  std::uint64_t output_bytes_total{0};
+
+  /// The current throughput in bytes of the source document per second (averaged over the last few seconds), or 0 if
+  /// it is not yet known.
+  double input_bytes_per_second{0};
+
+  /// The estimated time (in seconds) until all subblocks have been processed (based on the current throughput), or a
+  /// negative value if it is not yet known.
+  double estimated_seconds_remaining{-1};
 };
 
 /// Convert the enum to an informal string.
@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+/// A token bucket limiting the rate at which data is read or written. Each read or write operation acquires as many
+/// tokens as it transfers bytes, and the bucket is refilled at the maximum rate - up to a burst of 100 ms worth of
+/// data. An operation which finds too few tokens is admitted nevertheless (leaving a debt), and the following operations
+/// wait until the debt has been paid off - so that operations larger than the burst are possible.
+/// The maximum rate can be changed at any time (also while other threads are waiting), and the time spent waiting is
+/// accumulated. The class is thread-safe.
+class RateLimiter
+{
+private:
+  std::mutex mutex_;
+  std::condition_variable condition_variable_;
+  double bytes_per_second_{0};
+  double tokens_{0};
+  std::chrono::steady_clock::time_point time_of_last_refill_;
+  std::chrono::nanoseconds throttled_time_{0};
+
+public:
+  /// Constructor.
+  ///
+  /// \param  megabytes_per_second    The maximum rate in megabytes (of 1024*1024 bytes) per second - a value of 0 means
+  ///                                 that the rate is not limited.
+  explicit RateLimiter(double megabytes_per_second = 0);
+
+  RateLimiter(const RateLimiter&) = delete;
+  RateLimiter& operator=(const RateLimiter&) = delete;
+
+  /// Sets the maximum rate - this takes effect immediately, also for operations which are waiting.
+  ///
+  /// \param  megabytes_per_second    The maximum rate in megabytes (of 1024*1024 bytes) per second - a value of 0 means
+  ///                                 that the rate is not limited. Negative values are not allowed.
+  void SetMaxMegabytesPerSecond(double megabytes_per_second);
+
+  /// Gets the maximum rate.
+  ///
+  /// \returns The maximum rate in megabytes per second (0 if the rate is not limited).
+  double GetMaxMegabytesPerSecond();
+
+  /// Acquires the tokens for transferring the specified number of bytes, i.e. waits if the rate is exceeded.
+  ///
+  /// \param  number_of_bytes The number of bytes to be transferred.
+  void Acquire(std::uint64_t number_of_bytes);
+
+  /// Gets the time spent waiting in 'Acquire' so far (summed over all threads).
+  ///
+  /// \returns The time spent waiting.
+  std::chrono::nanoseconds GetThrottledTime();
+
+private:
+  /// Adds the tokens accumulated since the last refill. The caller must hold the lock.
+  void Refill(std::chrono::steady_clock::time_point now);
+};
@@ -0,0 +1,14 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+/// Values that represent where a segment has been placed in the destination file.
+enum class SegmentPlacement
+{
+  kNotWritten,     ///< The segment has not been written (or the file header has not been written yet).
+  kReservedSpace,  ///< The segment has been written into the space reserved at the start of the file.
+  kEndOfFile,      ///< The segment has been written after the subblocks (because no space was reserved for it,
+                   ///< or the reserved space was insufficient).
+};
@@ -0,0 +1,82 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "inc_libCZI.h"
+#include "segmentplacement.h"
+
+/// The sizes of the reservations made for the segments which are written when the CZI-writer is closed. A value
+/// of 0 means that no reservation is made for the respective segment.
+struct SegmentReservations
+{
+  size_t number_of_subblock_directory_entries{0};    ///< The number of subblock-directory entries to reserve space for.
+  size_t number_of_attachment_directory_entries{0};  ///< The number of attachment-directory entries to reserve space for.
+  size_t metadata_size{0};                           ///< The number of bytes to reserve for the metadata segment.
+};
+
+/// Makes reservations at the start of the destination file for the subblock directory, the attachment directory and
+/// the metadata segment - so that those segments end up at the start of the file (instead of at the end), and readers
+/// can access them without seeking to the end of the file. The reservations are sized for a copy of the specified
+/// source document. If a reservation turns out to be insufficient, the CZI-writer writes the segment at the end of
+/// the file instead.
+///
+/// \param [in]     reader      The reader of the source document.
+/// \param [in,out] writer_info The writer info (to be passed to 'ICziWriter::Create') in which the reservations are set.
+///
+/// \returns The reservations which have been made.
+SegmentReservations ReserveSegmentsForCopy(libCZI::ICZIReader* reader, libCZI::CCziWriterInfo* writer_info);
+
+/// The placements of the segments which are written when the CZI-writer is closed.
+struct SegmentPlacements
+{
+  SegmentPlacement subblock_directory{SegmentPlacement::kNotWritten};
+  SegmentPlacement attachment_directory{SegmentPlacement::kNotWritten};
+  SegmentPlacement metadata{SegmentPlacement::kNotWritten};
+};
+
+/// Implementation of libCZI::IOutputStream which forwards all write operations to another stream, and observes the
+/// file header in order to determine where the CZI-writer placed the subblock directory, the attachment directory
+/// and the metadata segment. The stream is to be passed to 'ICziWriter::Create', and 'SetEndOfReservedSpace'
+/// must be called after this - all data written up to this point is the file header and the reserved space.
+class SegmentPlacementRecorder : public libCZI::IOutputStream
+{
+private:
+  /// The number of bytes at the start of the file which contain the positions of the segments.
+  static constexpr size_t kSizeOfObservedFileHeader = 112;
+
+  std::shared_ptr<libCZI::IOutputStream> underlying_stream_;
+  std::array<std::uint8_t, kSizeOfObservedFileHeader> file_header_{};
+  std::uint64_t end_of_data_written_{0};
+  std::uint64_t end_of_reserved_space_{0};
+
+public:
+  /// Constructor.
+  ///
+  /// \param  underlying_stream   The stream to which the write operations are forwarded.
+  explicit SegmentPlacementRecorder(std::shared_ptr<libCZI::IOutputStream> underlying_stream)
+      : underlying_stream_(std::move(underlying_stream))
+  {
+  }
+
+  void Write(std::uint64_t offset, const void* data, std::uint64_t size, std::uint64_t* ptr_bytes_written) override;
+
+  /// Records that all data written so far is the file header and the reserved space. This is to be called right
+  /// after 'ICziWriter::Create'.
+  void SetEndOfReservedSpace() { this->end_of_reserved_space_ = this->end_of_data_written_; }
+
+  /// Gets the placements of the segments. This gives meaningful results after the CZI-writer has been closed.
+  ///
+  /// \returns The placements of the segments.
+  SegmentPlacements GetSegmentPlacements() const;
+
+private:
+  SegmentPlacement GetPlacementOfSegmentAt(size_t offset_in_file_header) const;
+};
@@ -0,0 +1,37 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+
+/// Interface of a stream-object for the destination file which is able to copy a range of the source file into the
+/// destination file directly - i.e. without the data passing through the memory of the process. On file systems which
+/// support it, the data is not even copied (but shared between the files, or copied on the server side).
+/// The copy operation announces (right before handing data to the CZI-writer) that the data is identical to a range
+/// of the source file. When the CZI-writer then writes exactly this data, the range is copied from the source file
+/// instead. So, the data is only used if copying the range is not possible (e.g. if the files are on different file
+/// systems), and the content of the destination file is the same in any case.
+class ISourceRangeCopy
+{
+public:
+  /// Announces that the next write operation with exactly the specified pointer and size is writing data which is
+  /// identical to the data found in the source file at the specified offset. Write operations which do not match
+  /// (e.g. the segment header written by the CZI-writer before the data) leave the announcement in place - it is
+  /// discarded when the matching write operation has been done or with the next announcement (an announcement with
+  /// a size of 0 discards the previous one without announcing anything).
+  ///
+  /// \param  data            Pointer to the data which is going to be written.
+  /// \param  size            The size of the data in bytes.
+  /// \param  source_offset   The offset in the source file at which the same data is found.
+  virtual void AnnounceSourceRange(const void* data, std::uint64_t size, std::uint64_t source_offset) = 0;
+
+  /// Gets the number of bytes which have been copied directly from the source file (i.e. for which the data
+  /// in memory did not have to be written).
+  ///
+  /// \returns The number of bytes copied directly from the source file.
+  virtual std::uint64_t GetNumberOfBytesCopiedFromSource() const = 0;
+
+  virtual ~ISourceRangeCopy() = default;
+};
@@ -0,0 +1,26 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/// Interface of a stream-object for the source file which is able to fetch data ahead of its use - e.g. with several
+/// concurrent requests, which hides the latency of each request if the source file is read from an HTTP server.
+/// The copy operation announces (before it starts reading the subblocks) the file positions of the subblocks in the
+/// order in which it is going to read them. The stream-object may then fetch the data from each of those positions up
+/// to the next announced position (i.e. the subblock segment) in the background. Read operations which are not covered
+/// by the data fetched ahead are carried out as usual, so the announcement is only a hint.
+class ISourceReadAhead
+{
+public:
+  /// Announces the file positions of the subblock segments which are going to be read, in the order in which they
+  /// are going to be read. A previous announcement is discarded.
+  ///
+  /// \param  positions   The file positions of the subblock segments, in the order in which they are going to be read.
+  virtual void AnnounceSubBlockPositions(const std::vector<std::uint64_t>& positions) = 0;
+
+  virtual ~ISourceReadAhead() = default;
+};
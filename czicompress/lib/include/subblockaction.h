@@ -0,0 +1,15 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+/// Values that represent what has been done with a subblock (as distinguished in the byte statistics).
+enum class SubBlockAction
+{
+  kCopiedVerbatim,     ///< The subblock was copied verbatim.
+  kCompressed,         ///< The subblock was compressed.
+  kDecompressed,       ///< The subblock was decompressed.
+  kAlreadyCompressed,  ///< The subblock was already compressed as requested, and therefore was copied verbatim.
+  kKeptOriginal,       ///< The subblock was copied verbatim because the compressed data would not have been smaller.
+};
@@ -0,0 +1,26 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+/// Values that represent the order in which the subblocks of the source document are read.
+enum class SubBlockReadOrder
+{
+  kInvalid,        ///< An enum constant representing the invalid option
+  kDirectory,      ///< The subblocks are read in the order in which they are listed in the subblock
+                   ///< directory of the source document.
+  kFilePosition,   ///< The subblocks are read in the order of their position in the source document
+                   ///< (i.e. with ascending file offset), which avoids random I/O if the directory
+                   ///< order does not match the order of the data in the file.
+};
+
+/// Values that represent the order in which the subblocks are written to the destination document.
+/// This is only relevant if the read order differs from the directory order.
+enum class SubBlockOutputOrder
+{
+  kInvalid,  ///< An enum constant representing the invalid option
+  kSource,   ///< The subblocks are written in the order of the subblock directory of the source document,
+             ///< i.e. the destination document lists the subblocks in the same order as the source.
+  kRead,     ///< The subblocks are written in the order in which they are read.
+};
@@ -0,0 +1,156 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// Values that represent the stages of processing a subblock, which are recorded by the tracer.
+enum class TraceStage : std::uint8_t
+{
+  kRead,     ///< The subblock is read from the source document.
+  kProcess,  ///< The subblock is processed, i.e. it is decided what to do with it, and it is decoded and compressed.
+  kWrite,    ///< The subblock is written to the destination document.
+};
+
+/// The events recorded by one thread. The events are kept in a ring buffer of fixed size, i.e. if more events are
+/// recorded than fit into the buffer, the oldest events are overwritten - so the memory used for tracing is bounded,
+/// and recording an event does not allocate memory. An object of this class must only be used by the thread it was
+/// created for (see 'Tracer::AddThread').
+class TraceBuffer
+{
+private:
+  struct Event
+  {
+    std::int64_t timestamp_in_nanoseconds;
+    int subblock_index;
+    TraceStage stage;
+    bool is_begin;
+  };
+
+  std::string thread_name_;
+  std::chrono::steady_clock::time_point start_time_;
+  std::vector<Event> events_;
+  std::uint64_t number_of_events_{0};
+
+public:
+  /// Constructor.
+  ///
+  /// \param  thread_name         The name of the thread (as shown in the trace viewer).
+  /// \param  start_time          The time point from which the timestamps are measured.
+  /// \param  number_of_events    The maximum number of events kept (must be greater than zero).
+  TraceBuffer(std::string thread_name, std::chrono::steady_clock::time_point start_time, size_t number_of_events);
+
+  /// Records the begin or the end of a stage of processing a subblock.
+  ///
+  /// \param  stage           The stage.
+  /// \param  subblock_index  The index of the subblock in the source document.
+  /// \param  is_begin        True if the stage begins, false if it ends.
+  void AddEvent(TraceStage stage, int subblock_index, bool is_begin)
+  {
+    const auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->start_time_);
+    this->events_[this->number_of_events_ % this->events_.size()] = Event{timestamp.count(), subblock_index, stage, is_begin};
+    ++this->number_of_events_;
+  }
+
+  /// Gets the number of events which have been overwritten because the ring buffer was full.
+  ///
+  /// \returns The number of events overwritten.
+  std::uint64_t GetNumberOfDroppedEvents() const;
+
+private:
+  friend class Tracer;
+
+  /// Writes the events (from the oldest to the newest) as Chrome trace events to the stream, each preceded by a comma.
+  /// End events whose begin event has been overwritten are left out.
+  void WriteChromeTraceEvents(std::ostream& stream, int thread_id) const;
+};
+
+/// This class is recording when the stages of processing the subblocks begin and end on the threads of a
+/// copy-operation, and it writes them in the Chrome trace-event format (JSON), which can be viewed with Perfetto
+/// (https://ui.perfetto.dev) or chrome://tracing. Each thread taking part in the operation gets its own buffer (with
+/// 'AddThread'), so that recording an event does not need any synchronization. If no tracer is given to the
+/// operation, the only cost is a check for a null pointer per stage.
+class Tracer
+{
+public:
+  /// The default number of events kept per thread.
+  static constexpr size_t kDefaultNumberOfEventsPerThread = 256 * 1024;
+
+  /// Constructor. The timestamps of the events are measured from the construction of the tracer.
+  ///
+  /// \param  number_of_events_per_thread The maximum number of events kept per thread - if more events are recorded
+  ///                                     by a thread, the oldest ones are overwritten.
+  explicit Tracer(size_t number_of_events_per_thread = kDefaultNumberOfEventsPerThread);
+
+  /// Creates the buffer for the events of a thread. This method is thread-safe, and the returned buffer stays valid
+  /// for the lifetime of the tracer.
+  ///
+  /// \param  thread_name The name of the thread (as shown in the trace viewer).
+  ///
+  /// \returns The buffer for the events of the thread.
+  TraceBuffer* AddThread(const std::string& thread_name);
+
+  /// Writes all recorded events in the Chrome trace-event format (a JSON object with the array "traceEvents"). This
+  /// must not be called while events are being recorded.
+  ///
+  /// \param  stream  The stream to write to.
+  void WriteChromeTraceJson(std::ostream& stream) const;
+
+  /// Gets the number of events (summed over all threads) which have been overwritten because a ring buffer was full.
+  ///
+  /// \returns The number of events overwritten.
+  std::uint64_t GetNumberOfDroppedEvents() const;
+
+private:
+  size_t number_of_events_per_thread_;
+  std::chrono::steady_clock::time_point start_time_;
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<TraceBuffer>> buffers_;  ///< protected by 'mutex_'
+};
+
+/// Records the begin of a stage when constructed and its end when destroyed. If the buffer is null (i.e. tracing
+/// is disabled), nothing is recorded.
+class TraceScope
+{
+private:
+  TraceBuffer* buffer_;
+  TraceStage stage_;
+  int subblock_index_;
+
+public:
+  /// Constructor - records the begin of the stage.
+  ///
+  /// \param  buffer          The buffer of the current thread (may be null).
+  /// \param  stage           The stage.
+  /// \param  subblock_index  The index of the subblock in the source document.
+  TraceScope(TraceBuffer* buffer, TraceStage stage, int subblock_index) : buffer_(buffer), stage_(stage), subblock_index_(subblock_index)
+  {
+    if (this->buffer_ != nullptr)
+    {
+      this->buffer_->AddEvent(this->stage_, this->subblock_index_, true);
+    }
+  }
+
+  /// Destructor - records the end of the stage.
+  ~TraceScope()
+  {
+    if (this->buffer_ != nullptr)
+    {
+      this->buffer_->AddEvent(this->stage_, this->subblock_index_, false);
+    }
+  }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope(TraceScope&&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+  TraceScope& operator=(TraceScope&&) = delete;
+};
@@ -0,0 +1,26 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+/// Values that represent how a source file is handled if the operation would copy all of its subblocks verbatim
+/// (e.g. an already compressed file with the compression strategy "uncompressed"). This is determined from the subblock
+/// directory, before any subblock is read.
+enum class UnchangedFileHandling
+{
+  kInvalid,  ///< An enum constant representing the invalid option
+  kRewrite,  ///< The operation is carried out as usual, i.e. the destination file is written by the CZI-writer.
+  kClone,    ///< The destination file is a copy of the source file - it is made by the file system (with a reflink) if
+             ///< possible, otherwise the data is copied by the operating system.
+  kSkip,     ///< No destination file is written.
+};
+
+/// Values that represent what has been done with a source file.
+enum class ProcessingResult
+{
+  kInvalid,    ///< An enum constant representing the invalid option (i.e. no file has been processed)
+  kProcessed,  ///< The operation has been carried out, i.e. the destination file has been written by the CZI-writer.
+  kCloned,     ///< All subblocks would have been copied verbatim, and the destination file is a copy of the source file.
+  kSkipped,    ///< All subblocks would have been copied verbatim, and no destination file has been written.
+};
@@ -5,15 +5,33 @@
 #pragma once
 
 #include <cstdint>
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "../inc_libCZI.h"
+#include "../include/operationstatistics.h"
 
 /// This class is providing statistics about a "copy-operation" - how many
-/// subblocks were compressed, uncompressed or copied verbatim.
+/// subblocks were compressed, uncompressed or copied verbatim (or found to be
+/// already compressed as requested, or kept because compressing did not make
+/// them smaller), and how many bytes were read and written for them.
 class ActionWithSubBlockStatistics
 {
 private:
   std::uint64_t count_subblocks_copied_verbatim_{0};
   std::uint64_t count_subblocks_compressed_{0};
   std::uint64_t count_subblocks_decompressed_{0};
+  std::uint64_t count_subblocks_already_compressed_{0};
+  std::uint64_t count_subblocks_kept_original_{0};
+  std::uint64_t peak_bytes_in_flight_{0};
+  std::uint64_t buffer_pool_hits_{0};
+  std::uint64_t buffer_pool_misses_{0};
+  std::uint64_t total_output_bytes_{0};
+
+  /// The byte statistics, keyed by pixel type, pyramid type, source compression mode and action.
+  std::map<std::tuple<libCZI::PixelType, libCZI::SubBlockPyramidType, libCZI::CompressionMode, SubBlockAction>, SubBlockByteStatistics>
+      byte_statistics_;
 
 public:
   /// Default constructor for ActionWithSubBlockStatistics class.
@@ -35,6 +53,54 @@ public:
   /// Increment the count of subblocks decompressed.
   void Increment_Decompressed() { ++this->count_subblocks_decompressed_; }
 
+  /// Increment the count of subblocks which were already compressed as requested (and copied verbatim).
+  void Increment_AlreadyCompressed() { ++this->count_subblocks_already_compressed_; }
+
+  /// Increment the count of subblocks for which the original data was kept because compressing did not make it smaller.
+  void Increment_KeptOriginal() { ++this->count_subblocks_kept_original_; }
+
+  /// Update the peak number of bytes held by subblocks in flight (i.e. read but not yet written) - the
+  /// peak is set to the given value if it is larger than the current peak.
+  /// \param bytes_in_flight Number of bytes in flight.
+  void UpdatePeakBytesInFlight(std::uint64_t bytes_in_flight)
+  {
+    if (bytes_in_flight > this->peak_bytes_in_flight_)
+    {
+      this->peak_bytes_in_flight_ = bytes_in_flight;
+    }
+  }
+
+  /// Set the number of buffer allocations which were served from the buffer pool (hits), and the
+  /// number of allocations for which a new buffer had to be allocated (misses).
+  /// \param hits Number of hits.
+  /// \param misses Number of misses.
+  void SetBufferPoolHitsAndMisses(std::uint64_t hits, std::uint64_t misses)
+  {
+    this->buffer_pool_hits_ = hits;
+    this->buffer_pool_misses_ = misses;
+  }
+
+  /// Add the number of bytes read and written for a subblock to the byte statistics.
+  /// \param source_subblock_info The information about the source subblock.
+  /// \param action What has been done with the subblock.
+  /// \param input_bytes The size of the data of the subblock in the source document.
+  /// \param output_bytes The size of the data written to the destination document.
+  void AddBytes(const libCZI::SubBlockInfo& source_subblock_info, SubBlockAction action, std::uint64_t input_bytes,
+                std::uint64_t output_bytes)
+  {
+    const libCZI::CompressionMode source_compression_mode = source_subblock_info.GetCompressionMode();
+    auto& entry = this->byte_statistics_[std::make_tuple(source_subblock_info.pixelType, source_subblock_info.pyramidType,
+                                                         source_compression_mode, action)];
+    entry.pixel_type = source_subblock_info.pixelType;
+    entry.pyramid_type = source_subblock_info.pyramidType;
+    entry.source_compression_mode = source_compression_mode;
+    entry.action = action;
+    ++entry.number_of_subblocks;
+    entry.input_bytes += input_bytes;
+    entry.output_bytes += output_bytes;
+    this->total_output_bytes_ += output_bytes;
+  }
+
   /// Get the count of subblocks copied verbatim.
   /// \returns Count of subblocks copied verbatim.
   std::uint64_t GetCountOfSubblocksCopiedVerbatim() const { return this->count_subblocks_copied_verbatim_; }
@@ -47,10 +113,49 @@ public:
   /// \returns Count of subblocks decompressed.
   std::uint64_t GetCountOfSubblocksDecompressed() const { return this->count_subblocks_decompressed_; }
 
+  /// Get the count of subblocks which were already compressed as requested (and copied verbatim).
+  /// \returns Count of subblocks already compressed.
+  std::uint64_t GetCountOfSubblocksAlreadyCompressed() const { return this->count_subblocks_already_compressed_; }
+
+  /// Get the count of subblocks for which the original data was kept because compressing did not make it smaller.
+  /// \returns Count of subblocks for which the original data was kept.
+  std::uint64_t GetCountOfSubblocksKeptOriginal() const { return this->count_subblocks_kept_original_; }
+
+  /// Get the peak number of bytes held by subblocks in flight (i.e. read but not yet written).
+  /// \returns Peak number of bytes in flight.
+  std::uint64_t GetPeakBytesInFlight() const { return this->peak_bytes_in_flight_; }
+
+  /// Get the number of buffer allocations which were served from the buffer pool.
+  /// \returns Number of buffer pool hits.
+  std::uint64_t GetBufferPoolHits() const { return this->buffer_pool_hits_; }
+
+  /// Get the number of buffer allocations for which a new buffer had to be allocated.
+  /// \returns Number of buffer pool misses.
+  std::uint64_t GetBufferPoolMisses() const { return this->buffer_pool_misses_; }
+
+  /// Get the total number of bytes written for the subblocks so far (i.e. the sum of the output bytes of the byte statistics).
+  /// \returns Total number of output bytes.
+  std::uint64_t GetTotalOutputBytes() const { return this->total_output_bytes_; }
+
+  /// Get the byte statistics, ordered by pixel type, pyramid type, source compression mode and action.
+  /// \returns The byte statistics, with one entry for each combination which occurred.
+  std::vector<SubBlockByteStatistics> GetByteStatistics() const
+  {
+    std::vector<SubBlockByteStatistics> byte_statistics;
+    byte_statistics.reserve(this->byte_statistics_.size());
+    for (const auto& item : this->byte_statistics_)
+    {
+      byte_statistics.push_back(item.second);
+    }
+
+    return byte_statistics;
+  }
+
   /// Get the total count of subblocks processed.
   /// \returns Total count of subblocks processed.
   std::uint64_t GetTotalCountOfSubblocksProcessed() const
   {
-    return this->count_subblocks_copied_verbatim_ + this->count_subblocks_compressed_ + this->count_subblocks_decompressed_;
+    return this->count_subblocks_copied_verbatim_ + this->count_subblocks_compressed_ + this->count_subblocks_decompressed_ +
+           this->count_subblocks_already_compressed_ + this->count_subblocks_kept_original_;
   }
 };
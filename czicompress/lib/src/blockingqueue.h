@@ -0,0 +1,111 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+/// A simple thread-safe FIFO-queue, used to hand over work items between the stages of the
+/// subblock-processing pipeline. The queue can be "closed", which means that no more items will
+/// be added to it - consumers waiting for items will then be woken up, and 'Pop' will return false
+/// once the queue is drained.
+///
+/// \tparam t   Type of the items stored in the queue.
+template <typename t>
+class BlockingQueue
+{
+private:
+  std::mutex mutex_;
+  std::condition_variable condition_variable_;
+  std::deque<t> queue_;
+  bool closed_{false};
+
+public:
+  BlockingQueue() = default;
+
+  BlockingQueue(const BlockingQueue&) = delete;
+  BlockingQueue(BlockingQueue&&) = delete;
+  BlockingQueue& operator=(const BlockingQueue&) = delete;
+  BlockingQueue& operator=(BlockingQueue&&) = delete;
+  ~BlockingQueue() = default;
+
+  /// Adds an item to the end of the queue. If the queue is closed, the item is discarded.
+  ///
+  /// \param  item    The item to add.
+  ///
+  /// \returns    True if the item was added; false if the queue is closed (and the item was discarded).
+  bool Push(t item)
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      if (this->closed_)
+      {
+        return false;
+      }
+
+      this->queue_.push_back(std::move(item));
+    }
+
+    this->condition_variable_.notify_one();
+    return true;
+  }
+
+  /// Removes the item at the front of the queue. If the queue is empty, this method blocks
+  /// until either an item is available or the queue is closed.
+  ///
+  /// \param [out] item    If successful, the item is put here.
+  ///
+  /// \returns    True if an item was retrieved; false if the queue is closed and empty.
+  bool Pop(t& item)
+  {
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    this->condition_variable_.wait(lock, [this] { return !this->queue_.empty() || this->closed_; });
+    if (this->queue_.empty())
+    {
+      return false;
+    }
+
+    item = std::move(this->queue_.front());
+    this->queue_.pop_front();
+    return true;
+  }
+
+  /// Closes the queue - no more items can be added, and all waiting consumers are woken up.
+  /// Items already in the queue can still be retrieved.
+  void Close()
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      this->closed_ = true;
+    }
+
+    this->condition_variable_.notify_all();
+  }
+
+  /// Closes the queue and discards all items currently in it.
+  void CloseAndClear()
+  {
+    std::deque<t> items_to_discard;
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      this->closed_ = true;
+      items_to_discard.swap(this->queue_);
+    }
+
+    this->condition_variable_.notify_all();
+  }
+
+  /// Gets the number of items currently in the queue.
+  ///
+  /// \returns    The number of items in the queue.
+  std::size_t Size()
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->queue_.size();
+  }
+};
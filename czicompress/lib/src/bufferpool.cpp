@@ -0,0 +1,136 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "bufferpool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// The size of the smallest size class - smaller requests are rounded up to this size.
+constexpr std::size_t kSizeOfSmallestSizeClass = 4096;
+
+/// The size of the largest size class - larger requests are not served from the pool.
+constexpr std::size_t kSizeOfLargestSizeClass = static_cast<std::size_t>(1) << 30;
+
+/// The number of size classes for each power of two.
+constexpr std::size_t kNumberOfSizeClassesPerPowerOfTwo = 4;
+
+}  // namespace
+
+BufferPool::BufferPool(std::uint64_t max_number_of_bytes_retained) : max_number_of_bytes_retained_(max_number_of_bytes_retained)
+{
+  for (std::size_t power_of_two = kSizeOfSmallestSizeClass; power_of_two < kSizeOfLargestSizeClass; power_of_two *= 2)
+  {
+    for (std::size_t i = 0; i < kNumberOfSizeClassesPerPowerOfTwo; ++i)
+    {
+      SizeClass size_class;
+      size_class.size_of_buffer = power_of_two + i * (power_of_two / kNumberOfSizeClassesPerPowerOfTwo);
+      this->size_classes_.push_back(std::move(size_class));
+    }
+  }
+
+  SizeClass largest_size_class;
+  largest_size_class.size_of_buffer = kSizeOfLargestSizeClass;
+  this->size_classes_.push_back(std::move(largest_size_class));
+}
+
+BufferPool::~BufferPool()
+{
+  for (auto& size_class : this->size_classes_)
+  {
+    for (void* buffer : size_class.free_buffers)
+    {
+      std::free(buffer);  // NOLINT
+    }
+  }
+}
+
+/*static*/ std::shared_ptr<BufferPool> BufferPool::GetSharedInstance()
+{
+  static const std::shared_ptr<BufferPool> shared_instance = std::make_shared<BufferPool>();
+  return shared_instance;
+}
+
+std::shared_ptr<void> BufferPool::Allocate(std::size_t size)
+{
+  const int size_class_index = this->GetSizeClassIndex(size);
+  void* buffer = nullptr;
+  {
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    if (size_class_index >= 0 && !this->size_classes_[size_class_index].free_buffers.empty())
+    {
+      auto& size_class = this->size_classes_[size_class_index];
+      buffer = size_class.free_buffers.back();
+      size_class.free_buffers.pop_back();
+      this->number_of_bytes_retained_ -= size_class.size_of_buffer;
+      ++this->number_of_hits_;
+    }
+    else
+    {
+      ++this->number_of_misses_;
+    }
+  }
+
+  if (buffer == nullptr)
+  {
+    buffer = std::malloc(size_class_index >= 0 ? this->size_classes_[size_class_index].size_of_buffer : size);  // NOLINT
+    if (buffer == nullptr)
+    {
+      throw std::bad_alloc();
+    }
+  }
+
+  if (size_class_index < 0)
+  {
+    // this buffer is too large for the pool, so it is freed immediately when released
+    return std::shared_ptr<void>(buffer, [](void* pointer) { std::free(pointer); });  // NOLINT
+  }
+
+  auto pool = this->shared_from_this();
+  return std::shared_ptr<void>(buffer, [pool, size_class_index](void* pointer) { pool->Release(pointer, size_class_index); });
+}
+
+std::uint64_t BufferPool::GetNumberOfHits()
+{
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->number_of_hits_;
+}
+
+std::uint64_t BufferPool::GetNumberOfMisses()
+{
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->number_of_misses_;
+}
+
+int BufferPool::GetSizeClassIndex(std::size_t size) const
+{
+  const auto iterator = std::lower_bound(this->size_classes_.cbegin(), this->size_classes_.cend(), size,
+                                         [](const SizeClass& size_class, std::size_t value) { return size_class.size_of_buffer < value; });
+  if (iterator == this->size_classes_.cend())
+  {
+    return -1;
+  }
+
+  return static_cast<int>(iterator - this->size_classes_.cbegin());
+}
+
+void BufferPool::Release(void* buffer, int size_class_index)
+{
+  {
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    auto& size_class = this->size_classes_[size_class_index];
+    if (this->number_of_bytes_retained_ + size_class.size_of_buffer <= this->max_number_of_bytes_retained_)
+    {
+      size_class.free_buffers.push_back(buffer);
+      this->number_of_bytes_retained_ += size_class.size_of_buffer;
+      return;
+    }
+  }
+
+  std::free(buffer);  // NOLINT
+}
@@ -0,0 +1,83 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/// This class implements a pool of memory buffers, used for the buffers which are allocated for each subblock (the decoded
+/// bitmaps and the compressed data). Requested sizes are rounded up to a size class (there are four size classes for each
+/// power of two, so at most 25% of a buffer is wasted), and a buffer which is released is kept in the pool - it is then handed
+/// out again for the next request of the same size class. This avoids the fragmentation we see with the general-purpose heap
+/// when allocating and freeing lots of large buffers of varying size. The total size of the buffers kept in the pool is
+/// limited; if this limit would be exceeded, a released buffer is freed instead. All methods are thread-safe.
+class BufferPool : public std::enable_shared_from_this<BufferPool>
+{
+private:
+  struct SizeClass
+  {
+    std::size_t size_of_buffer{0};
+    std::vector<void*> free_buffers;
+  };
+
+  std::mutex mutex_;
+  std::vector<SizeClass> size_classes_;
+  std::uint64_t max_number_of_bytes_retained_;
+  std::uint64_t number_of_bytes_retained_{0};
+  std::uint64_t number_of_hits_{0};
+  std::uint64_t number_of_misses_{0};
+
+public:
+  /// The default for the maximum number of bytes kept in the pool.
+  static constexpr std::uint64_t kDefaultMaxNumberOfBytesRetained = 512ULL * 1024 * 1024;
+
+  /// Constructor. Note that the pool must be owned by a std::shared_ptr (i.e. it must be created with std::make_shared).
+  ///
+  /// \param  max_number_of_bytes_retained    The maximum number of bytes kept in the pool.
+  explicit BufferPool(std::uint64_t max_number_of_bytes_retained = kDefaultMaxNumberOfBytesRetained);
+
+  BufferPool(const BufferPool&) = delete;
+  BufferPool(BufferPool&&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+  BufferPool& operator=(BufferPool&&) = delete;
+  ~BufferPool();
+
+  /// Gets the process-wide instance of the buffer pool, which is used by default.
+  ///
+  /// \returns    The process-wide buffer pool.
+  static std::shared_ptr<BufferPool> GetSharedInstance();
+
+  /// Allocates a buffer of (at least) the specified size. The buffer is put back into the pool when the
+  /// last reference to it is released. The content of the buffer is undefined.
+  ///
+  /// \param  size    The size of the buffer in bytes.
+  ///
+  /// \returns    The buffer.
+  std::shared_ptr<void> Allocate(std::size_t size);
+
+  /// Gets the number of allocations which were served with a buffer from the pool.
+  ///
+  /// \returns    The number of hits.
+  std::uint64_t GetNumberOfHits();
+
+  /// Gets the number of allocations which could not be served with a buffer from the pool (i.e. for which a
+  /// new buffer had to be allocated).
+  ///
+  /// \returns    The number of misses.
+  std::uint64_t GetNumberOfMisses();
+
+private:
+  /// Gets the index of the smallest size class which is large enough for the specified size.
+  ///
+  /// \param  size    The size in bytes.
+  ///
+  /// \returns    The index of the size class, or -1 if the size is larger than the largest size class.
+  int GetSizeClassIndex(std::size_t size) const;
+
+  void Release(void* buffer, int size_class_index);
+};
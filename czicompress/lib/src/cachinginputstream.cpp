@@ -0,0 +1,220 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "cachinginputstream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+CachingInputStream::CachingInputStream(std::shared_ptr<libCZI::IStream> stream, std::uint32_t block_size, std::uint32_t number_of_blocks)
+    : stream_(std::move(stream)), block_size_(block_size), max_number_of_blocks_(number_of_blocks)
+{
+  if (!this->stream_)
+  {
+    throw std::invalid_argument("The stream must not be null.");
+  }
+
+  this->source_read_ahead_ = GetSourceReadAhead(this->stream_);
+
+  if (this->block_size_ == 0 || this->max_number_of_blocks_ == 0)
+  {
+    throw std::invalid_argument("The block size and the number of blocks must be greater than zero.");
+  }
+}
+
+void CachingInputStream::Read(std::uint64_t offset, void* data, std::uint64_t size, std::uint64_t* ptr_bytes_read)
+{
+  bool is_within_announced_range = false;
+  {
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    is_within_announced_range = this->IsWithinAnnouncedRange(offset, size);
+  }
+
+  if (is_within_announced_range)
+  {
+    // the data has been (or is being) fetched ahead by the underlying stream, so the read operation is passed on as is
+    std::uint64_t size_read = 0;
+    this->stream_->Read(offset, data, size, &size_read);
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    ++this->statistics_.number_of_reads;
+    this->statistics_.bytes_read += size_read;
+    if (ptr_bytes_read != nullptr)
+    {
+      *ptr_bytes_read = size_read;
+    }
+
+    return;
+  }
+
+  auto* destination = static_cast<std::uint8_t*>(data);
+  const std::uint64_t end = offset + size;
+  std::uint64_t position = offset;
+  while (position < end)
+  {
+    const std::uint64_t block_index = position / this->block_size_;
+    const std::uint64_t position_in_block = position % this->block_size_;
+    const std::uint64_t size_in_block = (std::min)(end - position, this->block_size_ - position_in_block);
+    {
+      const std::lock_guard<std::mutex> lock(this->mutex_);
+      const auto iterator = this->blocks_.find(block_index);
+      if (iterator != this->blocks_.end())
+      {
+        ++this->statistics_.hits;
+        this->lru_list_.splice(this->lru_list_.begin(), this->lru_list_, iterator->second.position_in_lru_list);
+        const auto& block_data = iterator->second.data;
+        const std::uint64_t size_available =
+            block_data.size() > position_in_block ? (std::min)(size_in_block, block_data.size() - position_in_block) : 0;
+        memcpy(destination + (position - offset), block_data.data() + position_in_block, static_cast<size_t>(size_available));  // NOLINT
+        position += size_available;
+        if (size_available < size_in_block)
+        {
+          // the block is the last one of the file
+          break;
+        }
+
+        continue;
+      }
+    }
+
+    std::uint64_t size_read = 0;
+    const bool is_complete = this->ReadFromStream(position, end, destination + (position - offset), size_read);  // NOLINT
+    position += size_read;
+    if (!is_complete)
+    {
+      // we reached the end of the file
+      break;
+    }
+  }
+
+  if (ptr_bytes_read != nullptr)
+  {
+    *ptr_bytes_read = position - offset;
+  }
+}
+
+void CachingInputStream::AnnounceSubBlockPositions(const std::vector<std::uint64_t>& positions)
+{
+  if (!this->source_read_ahead_)
+  {
+    return;
+  }
+
+  std::vector<std::uint64_t> sorted_positions(positions);
+  std::sort(sorted_positions.begin(), sorted_positions.end());
+  {
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    this->announced_positions_ = std::move(sorted_positions);
+  }
+
+  this->source_read_ahead_->AnnounceSubBlockPositions(positions);
+}
+
+InputCacheStatistics CachingInputStream::GetStatistics()
+{
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->statistics_;
+}
+
+bool CachingInputStream::IsWithinAnnouncedRange(std::uint64_t offset, std::uint64_t size) const
+{
+  const auto next_position = std::upper_bound(this->announced_positions_.cbegin(), this->announced_positions_.cend(), offset);
+  if (next_position == this->announced_positions_.cbegin())
+  {
+    return false;
+  }
+
+  // the last range extends to the end of the file
+  return next_position == this->announced_positions_.cend() || offset + size <= *next_position;
+}
+
+bool CachingInputStream::ReadFromStream(std::uint64_t position, std::uint64_t end, std::uint8_t* destination, std::uint64_t& size_copied)
+{
+  const std::uint64_t first_block = position / this->block_size_;
+  const std::uint64_t last_block_of_request = (end - 1) / this->block_size_;
+
+  // determine the adjacent blocks which are missing in the cache (and the blocks to read ahead)
+  std::uint64_t number_of_missing_blocks = 0;
+  std::uint64_t number_of_blocks_to_read_ahead = 0;
+  {
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    do
+    {
+      ++number_of_missing_blocks;
+    } while (first_block + number_of_missing_blocks <= last_block_of_request &&
+             this->blocks_.find(first_block + number_of_missing_blocks) == this->blocks_.end());
+
+    // the read-ahead size is doubled with each sequential read operation, and it is reset with a non-sequential one
+    this->number_of_blocks_to_read_ahead_ =
+        first_block == this->next_block_of_sequential_read_
+            ? (std::min)((std::max)(this->number_of_blocks_to_read_ahead_ * 2, 1U), kMaxNumberOfBlocksToReadAhead)
+            : 0;
+    if (first_block + number_of_missing_blocks > last_block_of_request)
+    {
+      while (number_of_blocks_to_read_ahead < this->number_of_blocks_to_read_ahead_ &&
+             this->blocks_.find(first_block + number_of_missing_blocks + number_of_blocks_to_read_ahead) == this->blocks_.end())
+      {
+        ++number_of_blocks_to_read_ahead;
+      }
+    }
+
+    this->next_block_of_sequential_read_ = first_block + number_of_missing_blocks + number_of_blocks_to_read_ahead;
+    this->statistics_.misses += number_of_missing_blocks;
+    ++this->statistics_.number_of_reads;
+  }
+
+  const std::uint64_t end_of_missing_data = (std::min)(end, (first_block + number_of_missing_blocks) * this->block_size_);
+  std::uint64_t size_read = 0;
+  if (number_of_missing_blocks > kMaxNumberOfBlocksToReadAhead)
+  {
+    // a large read operation is passed on directly - it does not benefit from the cache
+    this->stream_->Read(position, destination, end_of_missing_data - position, &size_read);
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    this->statistics_.bytes_read += size_read;
+    size_copied = size_read;
+    return size_copied == end_of_missing_data - position;
+  }
+
+  const std::uint64_t start_of_first_block = first_block * this->block_size_;
+  std::vector<std::uint8_t> buffer(static_cast<size_t>((number_of_missing_blocks + number_of_blocks_to_read_ahead) * this->block_size_));
+  this->stream_->Read(start_of_first_block, buffer.data(), buffer.size(), &size_read);
+
+  {
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    this->statistics_.bytes_read += size_read;
+    for (std::uint64_t start_of_block = 0; start_of_block < size_read; start_of_block += this->block_size_)
+    {
+      const auto begin_of_block = buffer.begin() + static_cast<std::ptrdiff_t>(start_of_block);
+      const auto end_of_block = buffer.begin() + static_cast<std::ptrdiff_t>((std::min)(start_of_block + this->block_size_, size_read));
+      this->InsertBlock(first_block + start_of_block / this->block_size_, std::vector<std::uint8_t>(begin_of_block, end_of_block));
+    }
+  }
+
+  const std::uint64_t position_in_buffer = position - start_of_first_block;
+  size_copied = size_read > position_in_buffer ? (std::min)(end_of_missing_data - position, size_read - position_in_buffer) : 0;
+  memcpy(destination, buffer.data() + position_in_buffer, static_cast<size_t>(size_copied));  // NOLINT: pointer arithmetic
+  return size_copied == end_of_missing_data - position;
+}
+
+void CachingInputStream::InsertBlock(std::uint64_t block_index, std::vector<std::uint8_t> data)
+{
+  const auto iterator = this->blocks_.find(block_index);
+  if (iterator != this->blocks_.end())
+  {
+    // another thread has read the block in the meantime
+    iterator->second.data = std::move(data);
+    this->lru_list_.splice(this->lru_list_.begin(), this->lru_list_, iterator->second.position_in_lru_list);
+    return;
+  }
+
+  if (this->blocks_.size() >= this->max_number_of_blocks_)
+  {
+    this->blocks_.erase(this->lru_list_.back());
+    this->lru_list_.pop_back();
+  }
+
+  this->lru_list_.push_front(block_index);
+  this->blocks_.emplace(block_index, CachedBlock{std::move(data), this->lru_list_.begin()});
+}
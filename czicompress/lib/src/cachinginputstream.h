@@ -0,0 +1,110 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "../inc_libCZI.h"
+#include "../include/inputstream.h"
+#include "../include/sourcereadahead.h"
+
+/// Implementation of libCZI::IStream which reads from another stream through a cache of fixed-size blocks (aligned to
+/// the block size). This is meant for file systems with a high latency per read operation (e.g. NFS or SMB), where
+/// the many small read operations of libCZI (segment headers, subblock metadata and then the subblock data) each cost
+/// a round trip:
+/// - read operations are done in units of blocks, so that a small read operation fetches the data around it as well,
+/// - if several adjacent blocks are missing for a read operation, they are read with a single read operation,
+/// - if the read operations proceed sequentially, the following blocks are read ahead (with a growing read-ahead size),
+/// - the least recently used blocks are evicted when the cache is full.
+/// Read operations for which more than the maximum read-ahead size is missing in the cache are passed on to the
+/// underlying stream directly (without going through the cache), since they do not benefit from the cache.
+/// If the underlying stream is able to fetch the subblocks ahead (see 'ISourceReadAhead'), the announcement of the
+/// subblock positions is passed on to it, and read operations within an announced range bypass the cache - so that
+/// they are served from the data fetched ahead (a read operation of the cache, being aligned to the blocks, would not
+/// match the announced ranges).
+/// The class is thread-safe, but read operations on the underlying stream are done without holding the lock - so that
+/// concurrent read operations are not serialized.
+class CachingInputStream : public libCZI::IStream, public ISourceReadAhead
+{
+public:
+  /// The default size of a block.
+  static constexpr std::uint32_t kDefaultBlockSize = 64 * 1024;
+
+  /// The default number of blocks held in the cache (i.e. 16 MB with the default block size).
+  static constexpr std::uint32_t kDefaultNumberOfBlocks = 256;
+
+  /// The maximum number of blocks which are read ahead (i.e. 1 MB with the default block size).
+  static constexpr std::uint32_t kMaxNumberOfBlocksToReadAhead = 16;
+
+private:
+  struct CachedBlock
+  {
+    std::vector<std::uint8_t> data;  ///< The data of the block - this is less than the block size only at the end of the file.
+    std::list<std::uint64_t>::iterator position_in_lru_list;
+  };
+
+  std::shared_ptr<libCZI::IStream> stream_;
+  std::shared_ptr<ISourceReadAhead> source_read_ahead_;  ///< The read-ahead interface of the underlying stream (if any).
+  std::uint32_t block_size_;
+  std::uint32_t max_number_of_blocks_;
+
+  std::mutex mutex_;  ///< Protects the cache, the state of the read-ahead and the statistics.
+  std::unordered_map<std::uint64_t, CachedBlock> blocks_;
+  std::list<std::uint64_t> lru_list_;  ///< The indices of the cached blocks, the most recently used first.
+  std::uint64_t next_block_of_sequential_read_{0};
+  std::uint32_t number_of_blocks_to_read_ahead_{0};
+  std::vector<std::uint64_t> announced_positions_;  ///< The announced positions of the subblocks, sorted ascending.
+  InputCacheStatistics statistics_;
+
+public:
+  /// Constructor.
+  ///
+  /// \param  stream              The stream to read from.
+  /// \param  block_size          The size of a block in bytes.
+  /// \param  number_of_blocks    The maximum number of blocks held in the cache.
+  explicit CachingInputStream(std::shared_ptr<libCZI::IStream> stream, std::uint32_t block_size = kDefaultBlockSize,
+                              std::uint32_t number_of_blocks = kDefaultNumberOfBlocks);
+
+  CachingInputStream(const CachingInputStream&) = delete;
+  CachingInputStream& operator=(const CachingInputStream&) = delete;
+
+  void Read(std::uint64_t offset, void* data, std::uint64_t size, std::uint64_t* ptr_bytes_read) override;
+
+  /// Passes the announcement on to the underlying stream, if it is able to fetch the subblocks ahead - otherwise, the
+  /// announcement is ignored.
+  ///
+  /// \param  positions   The file positions of the subblock segments, in the order in which they are going to be read.
+  void AnnounceSubBlockPositions(const std::vector<std::uint64_t>& positions) override;
+
+  /// Determines whether the underlying stream is able to fetch the subblocks ahead.
+  ///
+  /// \returns True if the underlying stream is able to fetch the subblocks ahead; false otherwise.
+  bool HasSourceReadAhead() const { return this->source_read_ahead_ != nullptr; }
+
+  /// Gets the statistics about the use of the cache so far.
+  ///
+  /// \returns The statistics.
+  InputCacheStatistics GetStatistics();
+
+private:
+  /// Determines whether the read operation is within one of the announced ranges (i.e. from an announced position
+  /// up to the next announced position). The caller must hold the lock.
+  bool IsWithinAnnouncedRange(std::uint64_t offset, std::uint64_t size) const;
+
+  /// Reads the data from the specified position up to the next block which is in the cache (or up to the specified end)
+  /// from the underlying stream, and copies it to the destination. The caller must not hold the lock.
+  ///
+  /// \returns True if all of the data could be read; false if the end of the file was reached.
+  bool ReadFromStream(std::uint64_t position, std::uint64_t end, std::uint8_t* destination, std::uint64_t& size_copied);
+
+  /// Inserts the block into the cache (evicting the least recently used block if the cache is full). The caller must
+  /// hold the lock.
+  void InsertBlock(std::uint64_t block_index, std::vector<std::uint8_t> data);
+};
@@ -14,6 +14,7 @@
 #include <vector>
 
 #include "inc_libCZI.h"
+#include "include/inputstream.h"
 
 using std::string, std::ostringstream, std::endl, std::istringstream, std::make_shared;
 
@@ -151,6 +152,22 @@ CommandLineOptions::ParseResult CommandLineOptions::Parse(int argc, const char*
   string compression_options_text;  // NOLINT(misc-const-correctness)
   bool overwrite_existing_file{false};
   bool ignore_duplicate_subblocks{false};
+  int number_of_threads{1};
+  std::uint64_t max_inflight_megabytes{0};
+  std::uint32_t prefetch_depth{0};
+  std::uint64_t prefetch_megabytes{0};
+  SubBlockReadOrder read_order{SubBlockReadOrder::kInvalid};
+  SubBlockOutputOrder output_order{SubBlockOutputOrder::kInvalid};
+  InputIo input_io{InputIo::kInvalid};
+  InputCache input_cache{InputCache::kInvalid};
+  std::uint64_t write_buffer_megabytes{0};
+  bool use_copy_file_range{false};
+  UnchangedFileHandling unchanged_file_handling{UnchangedFileHandling::kInvalid};
+  bool preallocate{false};
+  bool use_direct_io{false};
+  double max_read_megabytes_per_second{0};
+  double max_write_megabytes_per_second{0};
+  string trace_filename;  // NOLINT(misc-const-correctness)
 
   // specify the string-to-enum-mapping for a boolean option
   std::map<std::string, bool> map_string_to_boolean{
@@ -164,7 +181,25 @@ CommandLineOptions::ParseResult CommandLineOptions::Parse(int argc, const char*
   const std::map<std::string, CompressionStrategy> map_string_to_strategy{
       {"all", CompressionStrategy::kAll},
       {"uncompressed", CompressionStrategy::kOnlyUncompressed},
-      {"uncompressed_and_zstd", CompressionStrategy::kUncompressedAndZStdCompressed}};
+      {"uncompressed_and_zstd", CompressionStrategy::kUncompressedAndZStdCompressed},
+      {"smallest", CompressionStrategy::kSmallest}};
+
+  // specify the string-to-enum-mapping for "read order" and "output order"
+  const std::map<std::string, SubBlockReadOrder> map_string_to_read_order{{"directory", SubBlockReadOrder::kDirectory},
+                                                                           {"file", SubBlockReadOrder::kFilePosition}};
+  const std::map<std::string, SubBlockOutputOrder> map_string_to_output_order{{"source", SubBlockOutputOrder::kSource},
+                                                                               {"read", SubBlockOutputOrder::kRead}};
+
+  // specify the string-to-enum-mapping for "input io"
+  const std::map<std::string, InputIo> map_string_to_input_io{{"pread", InputIo::kPread}, {"mmap", InputIo::kMmap}};
+
+  // specify the string-to-enum-mapping for "input-cache"
+  const std::map<std::string, InputCache> map_string_to_input_cache{
+      {"auto", InputCache::kAuto}, {"on", InputCache::kOn}, {"off", InputCache::kOff}};
+
+  // specify the string-to-enum-mapping for "if unchanged"
+  const std::map<std::string, UnchangedFileHandling> map_string_to_unchanged_file_handling{
+      {"rewrite", UnchangedFileHandling::kRewrite}, {"clone", UnchangedFileHandling::kClone}, {"skip", UnchangedFileHandling::kSkip}};
 
   app.add_option("-c,--command", command,
                  "Specifies the mode of operation: "
@@ -174,12 +209,17 @@ CommandLineOptions::ParseResult CommandLineOptions::Parse(int argc, const char*
       ->required()
       ->transform(CLI::CheckedTransformer(map_string_to_command, CLI::ignore_case));
 
-  CLI::Option* option =
-      app.add_option("-i,--input", source_filename, "The source CZI-file to be processed.")->option_text("SOURCE_FILE")->required();
+  CLI::Option* option = app.add_option("-i,--input", source_filename,
+                                       "The source CZI-file to be processed. This can also be an http(s)-URL, in which case the "
+                                       "file is read from the server with range requests (if the server supports them).")
+                            ->option_text("SOURCE_FILE")
+                            ->required();
   if (!this->validation_mode_for_unittests_)
   {
-    // in "unit-test mode", we don't want to check whether the file exists
-    option->check(CLI::ExistingFile);
+    // in "unit-test mode", we don't want to check whether the file exists (an URL is checked when it is opened)
+    const CLI::Validator http_url(
+        [](const std::string& str) { return IsHttpUrl(str) ? std::string() : std::string("Not an http(s)-URL"); }, "URL");
+    option->check(CLI::ExistingFile | http_url);
   }
 
   app.add_option("-o,--output", destination_filename, "The destination CZI-file to be written.")
@@ -189,7 +229,7 @@ CommandLineOptions::ParseResult CommandLineOptions::Parse(int argc, const char*
   app.add_option("-s,--strategy", compression_strategy,
                  "Choose which subblocks of the source file are compressed. "
                  "STRATEGY can be one of 'all', 'uncompressed', "
-                 "'uncompressed_and_zstd'. The default is 'uncompressed'.")
+                 "'uncompressed_and_zstd', 'smallest'. The default is 'uncompressed'.")
       ->option_text("STRATEGY")
       ->default_val(CompressionStrategy::kOnlyUncompressed)
       ->transform(CLI::CheckedTransformer(map_string_to_strategy, CLI::ignore_case));
@@ -208,6 +248,139 @@ CommandLineOptions::ParseResult CommandLineOptions::Parse(int argc, const char*
       ->default_val(true)
       ->transform(CLI::CheckedTransformer(map_string_to_boolean, CLI::ignore_case));
 
+  app.add_option("--threads", number_of_threads,
+                 "The number of threads used for decompressing and compressing the image data. With a value of 1, all "
+                 "work is done sequentially on one thread. A value of 0 means that the number of hardware threads is used. "
+                 "The output does not depend on this number. The default is 1.")
+      ->option_text("NUMBER")
+      ->default_val(1)
+      ->check(CLI::NonNegativeNumber);
+
+  app.add_option("--max-inflight-mb", max_inflight_megabytes,
+                 "The maximum amount of memory (in megabytes) held by subblocks which have been read, but not yet written. "
+                 "If this budget is exceeded, reading is suspended until enough subblocks have been written. A value of 0 "
+                 "means 'no limit'. The default is 0.")
+      ->option_text("NUMBER")
+      ->default_val(0);
+
+  app.add_option("--prefetch-depth", prefetch_depth,
+                 "The number of subblocks to read ahead on a background thread, so that reading the source file overlaps "
+                 "with compressing and writing. A value of 0 disables read-ahead. The default is 0.")
+      ->option_text("NUMBER")
+      ->default_val(0);
+
+  app.add_option("--prefetch-mb", prefetch_megabytes,
+                 "The maximum amount of memory (in megabytes) held by subblocks which have been read ahead. A value of 0 "
+                 "means 'no limit'. The default is 0.")
+      ->option_text("NUMBER")
+      ->default_val(0);
+
+  app.add_option("--read-order", read_order,
+                 "Choose the order in which the subblocks of the source file are read. ORDER can be 'directory' (the "
+                 "order of the subblock directory) or 'file' (ascending file offset, which avoids random I/O if the "
+                 "subblocks are scattered in the file). The default is 'directory'.")
+      ->option_text("ORDER")
+      ->default_val(SubBlockReadOrder::kDirectory)
+      ->transform(CLI::CheckedTransformer(map_string_to_read_order, CLI::ignore_case));
+
+  app.add_option("--output-order", output_order,
+                 "Choose the order in which the subblocks are written to the destination file. ORDER can be 'source' "
+                 "(the order of the subblock directory of the source file) or 'read' (the order in which the subblocks "
+                 "are read). This is only relevant with '--read-order file'. The default is 'source'.")
+      ->option_text("ORDER")
+      ->default_val(SubBlockOutputOrder::kSource)
+      ->transform(CLI::CheckedTransformer(map_string_to_output_order, CLI::ignore_case));
+
+  app.add_option("--input-io", input_io,
+                 "Choose how the source file is accessed. MODE can be 'pread' (the data is read with read-system-calls) "
+                 "or 'mmap' (the file is mapped into memory, which avoids a system call for each read operation). "
+                 "The default is 'pread'.")
+      ->option_text("MODE")
+      ->default_val(InputIo::kPread)
+      ->transform(CLI::CheckedTransformer(map_string_to_input_io, CLI::ignore_case));
+
+  app.add_option("--input-cache", input_cache,
+                 "Choose whether the source file is read through a block cache, which reads the data in blocks of 64 KB, "
+                 "merges adjacent read operations and reads ahead - this reduces the number of round trips with file "
+                 "systems where each read operation has a high latency. MODE can be 'auto' (the cache is used if the "
+                 "source file is on a network file system, e.g. NFS or SMB, and '--input-io pread' is used), 'on' or "
+                 "'off'. The default is 'auto'.")
+      ->option_text("MODE")
+      ->default_val(InputCache::kAuto)
+      ->transform(CLI::CheckedTransformer(map_string_to_input_cache, CLI::ignore_case));
+
+  app.add_option("--write-buffer-mb", write_buffer_megabytes,
+                 "The size (in megabytes) of the buffers in which the data for the destination file is collected. The "
+                 "buffers are written to the file on a background thread, so that processing does not wait for the "
+                 "storage (which is beneficial in particular for network shares). A value of 0 means that the data is "
+                 "written directly. The default is 0.")
+      ->option_text("NUMBER")
+      ->default_val(0);
+
+  app.add_option("--copy-file-range", use_copy_file_range,
+                 "If this option is enabled, the data of subblocks which are copied verbatim is copied from the source "
+                 "file to the destination file by the operating system (with 'copy_file_range'), instead of being written "
+                 "from memory. On file systems supporting it (e.g. XFS, btrfs or NFS 4.2) the data is then shared between "
+                 "the files or copied on the server. This is only available on Linux, and it cannot be combined with "
+                 "'--write-buffer-mb'. The default is 'off'.")
+      ->option_text("BOOLEAN")
+      ->default_val(false)
+      ->transform(CLI::CheckedTransformer(map_string_to_boolean, CLI::ignore_case));
+
+  app.add_option("--if-unchanged", unchanged_file_handling,
+                 "Choose what to do if the operation would copy all subblocks verbatim (e.g. an already compressed file "
+                 "with strategy 'uncompressed'), which is determined from the subblock directory before any subblock is "
+                 "read. MODE can be 'rewrite' (the destination file is written as usual), 'clone' (the destination file "
+                 "is a copy of the source file, made with a reflink if the file system supports it) or 'skip' (no "
+                 "destination file is written). The default is 'rewrite'.")
+      ->option_text("MODE")
+      ->default_val(UnchangedFileHandling::kRewrite)
+      ->transform(CLI::CheckedTransformer(map_string_to_unchanged_file_handling, CLI::ignore_case));
+
+  app.add_option("--preallocate", preallocate,
+                 "If this option is enabled, the size of the destination file is estimated before the operation starts "
+                 "(from the directories of the source file and the expected compression ratio), and the space for it is "
+                 "allocated up front - this reduces the fragmentation of large files. The file is truncated to its actual "
+                 "size at the end. This is only available on Linux - elsewhere, the option is ignored. The default is 'off'.")
+      ->option_text("BOOLEAN")
+      ->default_val(false)
+      ->transform(CLI::CheckedTransformer(map_string_to_boolean, CLI::ignore_case));
+
+  app.add_option("--direct-io", use_direct_io,
+                 "If this option is enabled, the destination file is written with direct I/O (bypassing the page cache), "
+                 "so that writing a large file does not evict the data of other processes from the page cache. The data is "
+                 "collected in aligned buffers of 4 MB. If the file system does not support direct I/O, the file is "
+                 "written as usual. This is only available on Linux and macOS, and it cannot be combined with "
+                 "'--copy-file-range'. The default is 'off'.")
+      ->option_text("BOOLEAN")
+      ->default_val(false)
+      ->transform(CLI::CheckedTransformer(map_string_to_boolean, CLI::ignore_case));
+
+  app.add_option("--max-read-mbps", max_read_megabytes_per_second,
+                 "The maximum rate (in megabytes per second) at which the source file is read, so that the operation "
+                 "does not saturate a shared storage or network link. Short bursts of 100 ms worth of data are allowed. "
+                 "Blocks found in the block cache (see '--input-cache') are not counted. This also applies to the copy made "
+                 "with '--if-unchanged clone', unless it is a reflink. A value of 0 means that the rate is not limited. "
+                 "The default is 0.")
+      ->option_text("NUMBER")
+      ->default_val(0)
+      ->check(CLI::NonNegativeNumber);
+
+  app.add_option("--max-write-mbps", max_write_megabytes_per_second,
+                 "The maximum rate (in megabytes per second) at which the destination file is written. Short bursts of "
+                 "100 ms worth of data are allowed. This includes the data copied with '--copy-file-range', and the copy "
+                 "made with '--if-unchanged clone' (unless it is a reflink). A value of 0 means that the rate is not "
+                 "limited. The default is 0.")
+      ->option_text("NUMBER")
+      ->default_val(0)
+      ->check(CLI::NonNegativeNumber);
+
+  app.add_option("--trace", trace_filename,
+                 "Record when each subblock is read, processed and written (and on which thread), and write this to the "
+                 "specified file in the Chrome trace-event format (JSON) - it can be viewed with https://ui.perfetto.dev "
+                 "or chrome://tracing. This is meant for tuning the number of threads and the read-ahead.")
+      ->option_text("TRACE_FILE");
+
   const auto formatter = make_shared<CustomFormatter>();
   app.formatter(formatter);
   app.footer(CommandLineOptions::GetFooterText());
@@ -239,6 +412,22 @@ CommandLineOptions::ParseResult CommandLineOptions::Parse(int argc, const char*
 
   this->overwrite_existing_file_ = overwrite_existing_file;
   this->ignore_duplicate_subblocks_ = ignore_duplicate_subblocks;
+  this->number_of_threads_ = number_of_threads;
+  this->max_inflight_megabytes_ = max_inflight_megabytes;
+  this->prefetch_depth_ = prefetch_depth;
+  this->prefetch_megabytes_ = prefetch_megabytes;
+  this->read_order_ = read_order;
+  this->output_order_ = output_order;
+  this->input_io_ = input_io;
+  this->input_cache_ = input_cache;
+  this->write_buffer_megabytes_ = write_buffer_megabytes;
+  this->use_copy_file_range_ = use_copy_file_range;
+  this->unchanged_file_handling_ = unchanged_file_handling;
+  this->preallocate_ = preallocate;
+  this->use_direct_io_ = use_direct_io;
+  this->max_read_megabytes_per_second_ = max_read_megabytes_per_second;
+  this->max_write_megabytes_per_second_ = max_write_megabytes_per_second;
+  this->trace_filename_ = trace_filename;
 
   return CommandLineOptions::ParseResult::kOk;
 }
@@ -256,8 +445,11 @@ With the 'decompress' command, compressed image data is converted to uncompresse
 subblocks of the source file will be compressed. The source document may already contain compressed data (possibly
 with a lossy compression scheme). In this case it is undesirable to compress the data with lossless zstd, as that will
 almost certainly increase the file size. Therefore, the "uncompressed" strategy compresses only uncompressed subblocks.
-The "uncompressed_and_zstd" strategy compresses the subblocks that are uncompressed OR compressed with Zstd, and the
-"all" strategy compresses all subblocks, regardless of their current compression status.
+The "uncompressed_and_zstd" strategy compresses the subblocks that are uncompressed OR compressed with Zstd (except for
+subblocks which are already compressed with the requested compression mode and pre-processing - those are copied
+verbatim), and the "all" strategy compresses all subblocks, regardless of their current compression status. The
+"smallest" strategy compresses all subblocks as well, but keeps the original data of a subblock if the compressed data
+would not be smaller - so the output is never larger than the input.
 Some compression schemes that can occur in a CZI-file cannot be decompressed by this tool. Data compressed with such a
 scheme will be copied verbatim to the destination file, regardless of the command and strategy chosen.
 )";
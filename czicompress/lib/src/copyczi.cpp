@@ -4,10 +4,25 @@
 
 #include "copyczi.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
 #include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <tuple>
 #include <utility>
+#include <vector>
+
+#include "blockingqueue.h"
+#include "inflightbudget.h"
+#include "subblockhelpers.h"
+#include "subblockprefetcher.h"
+#include "workerthreadscope.h"
 
 namespace
 {  // unnamed namespace makes functions only accessible from this file
@@ -37,11 +52,57 @@ void InitMetaDataAndAttachment(AddSubBlockInfoType& subblock_info_target, const
   subblock_info_target.sbBlkAttachmentSize = CheckSizeAndCastToUint32(attachment_size);
 }
 
+// The following sizes are used for estimating the size of the destination document, see the CZI file format
+// specification for the layout of the segments. Segments are aligned to multiples of 32 bytes.
+constexpr std::uint64_t kSegmentAlignment = 32;
+constexpr std::uint64_t kSizeOfSegmentHeader = 32;
+constexpr std::uint64_t kSizeOfFileHeaderSegment = kSizeOfSegmentHeader + 512;
+
+/// The size of the fixed part of a subblock segment (incl. the directory entry) - this is the minimum size, which
+/// is sufficient for up to 10 dimensions.
+constexpr std::uint64_t kSizeOfFixedPartOfSubBlockSegment = 256;
+
+/// The size of the header of the subblock directory segment.
+constexpr std::uint64_t kSizeOfSubBlockDirectoryHeader = 128;
+
+/// The size of an entry in the subblock directory - this depends on the number of dimensions, and we assume (more than)
+/// the usual number of dimensions here.
+constexpr std::uint64_t kEstimatedSizeOfSubBlockDirectoryEntry = 32 + 20 * 10;
+
+/// The sizes of the header of the attachment directory segment and of its entries.
+constexpr std::uint64_t kSizeOfAttachmentDirectoryHeader = 256;
+constexpr std::uint64_t kSizeOfAttachmentDirectoryEntry = 128;
+
+/// The size of the header of the metadata segment.
+constexpr std::uint64_t kSizeOfMetadataSegmentHeader = 256;
+
+/// The metadata of the destination document is modified by the copy operation - we add this fraction of its size
+/// to the estimate.
+constexpr std::uint64_t kMetadataSizeMarginDivisor = 4;
+
+/// The expected ratio of the size of zstd-compressed data to the size of the uncompressed data. This is a typical
+/// value for microscopy images - if the estimate is too large, the preallocated space is released when closing.
+constexpr double kExpectedCompressionRatio = 0.6;
+
+std::uint64_t AlignSegmentSize(std::uint64_t size) { return (size + kSegmentAlignment - 1) / kSegmentAlignment * kSegmentAlignment; }
+
+/// Determines whether enough subblocks have been processed as requested (i.e. compressed or decompressed) to state the
+/// resulting compression in the metadata of the document - which is the case if they make up at least half of the
+/// subblocks (and so always with less than two subblocks).
+bool IsCompressionOfDocumentChanged(std::uint64_t number_of_subblocks_processed, std::uint64_t total_number_of_subblocks)
+{
+  return number_of_subblocks_processed >= total_number_of_subblocks / 2;
+}
+
 }  // namespace
 
 CopyCziBase::CopyCziBase(std::shared_ptr<libCZI::ICZIReader> reader, std::shared_ptr<libCZI::ICziWriter> writer,
-                         std::function<bool(const ProgressInfo&)> progress_report)
-    : reader_(std::move(reader)), writer_(std::move(writer)), progress_report_(std::move(progress_report))
+                         std::function<bool(const ProgressInfo&)> progress_report, const CopyCziOptions& options)
+    : reader_(std::move(reader)),
+      writer_(std::move(writer)),
+      progress_report_(std::move(progress_report)),
+      options_(options),
+      buffer_pool_(options.buffer_pool ? options.buffer_pool : BufferPool::GetSharedInstance())
 {
 }
 
@@ -57,6 +118,174 @@ int CopyCziBase::CheckUint32AndCastToInt(const uint32_t value)
 
 const ActionWithSubBlockStatistics& CopyCziBase::GetStatistics() const { return this->action_count; }
 
+bool CopyCziBase::AreAllSubBlocksCopiedVerbatim() const
+{
+  bool all_copied_verbatim = true;
+  std::uint64_t number_of_subblocks = 0;
+  this->reader_->EnumerateSubBlocks(
+      [&](int, const libCZI::SubBlockInfo& info) -> bool
+      {
+        ++number_of_subblocks;
+        all_copied_verbatim = this->IsCopiedVerbatimWithCompressionMode(info.GetCompressionMode());
+        return all_copied_verbatim;
+      });
+
+  // even if no subblock is processed, the metadata is modified if the document has less than two subblocks (see
+  //  'ModifyMetadata') - so the document would not be left unchanged
+  return all_copied_verbatim && !IsCompressionOfDocumentChanged(0, number_of_subblocks);
+}
+
+bool CopyCziBase::IsCopiedVerbatimWithCompressionMode(libCZI::CompressionMode) const { return false; }
+
+double CopyCziBase::GetExpectedSizeRatioOfProcessedSubBlocks() const { return 1; }
+
+std::vector<CopyCziBase::SubBlockSizeEstimate> CopyCziBase::EstimateSizesOfSubBlocks() const
+{
+  std::vector<SubBlockSizeEstimate> subblock_estimates;
+  this->reader_->EnumerateSubBlocksEx(
+      [&](int index, const libCZI::DirectorySubBlockInfo& info) -> bool
+      {
+        const libCZI::CompressionMode compression_mode = info.GetCompressionMode();
+        const bool copied_verbatim = this->IsCopiedVerbatimWithCompressionMode(compression_mode);
+        const double source_size_ratio = compression_mode == libCZI::CompressionMode::UnCompressed ? 1 : kExpectedCompressionRatio;
+        const std::uint64_t size_of_pixel_data = static_cast<std::uint64_t>(info.physicalSize.w) * info.physicalSize.h *
+                                                 libCZI::Utils::GetBytesPerPixel(info.pixelType);
+        const auto estimate_size_of_segment = [size_of_pixel_data](double size_ratio) -> std::uint64_t
+        {
+          const auto size_of_data = static_cast<std::uint64_t>(static_cast<double>(size_of_pixel_data) * size_ratio);
+          return AlignSegmentSize(kSizeOfSegmentHeader + kSizeOfFixedPartOfSubBlockSegment + size_of_data);
+        };
+
+        SubBlockSizeEstimate subblock_estimate;
+        subblock_estimate.subblock_index = index;
+        subblock_estimate.file_position = info.filePosition;
+        subblock_estimate.copied_verbatim = copied_verbatim;
+        subblock_estimate.source_size = estimate_size_of_segment(source_size_ratio);
+        subblock_estimate.estimated_size =
+            estimate_size_of_segment(copied_verbatim ? source_size_ratio : this->GetExpectedSizeRatioOfProcessedSubBlocks());
+        subblock_estimates.push_back(subblock_estimate);
+        return true;
+      });
+
+  // the size of a subblock in the source document is the distance to the next segment (which might include other
+  // segments in between, but this is fine for an estimate) - except for the last one, and this is also the size of a
+  // subblock copied verbatim in the destination document
+  std::sort(subblock_estimates.begin(), subblock_estimates.end(),
+            [](const SubBlockSizeEstimate& a, const SubBlockSizeEstimate& b) -> bool { return a.file_position < b.file_position; });
+  for (size_t i = 0; i + 1 < subblock_estimates.size(); ++i)
+  {
+    subblock_estimates[i].source_size = subblock_estimates[i + 1].file_position - subblock_estimates[i].file_position;
+    if (subblock_estimates[i].copied_verbatim)
+    {
+      subblock_estimates[i].estimated_size = subblock_estimates[i].source_size;
+    }
+  }
+
+  return subblock_estimates;
+}
+
+void CopyCziBase::InitializeByteProgress(ProgressInfo& progress_info)
+{
+  this->subblock_source_sizes_.clear();
+  progress_info.input_bytes_total = 0;
+  progress_info.output_bytes_total = 0;
+  for (const auto& subblock_estimate : this->EstimateSizesOfSubBlocks())
+  {
+    if (subblock_estimate.subblock_index >= 0)
+    {
+      const auto index = static_cast<size_t>(subblock_estimate.subblock_index);
+      if (index >= this->subblock_source_sizes_.size())
+      {
+        this->subblock_source_sizes_.resize(index + 1, 0);
+      }
+
+      this->subblock_source_sizes_[index] = subblock_estimate.source_size;
+    }
+
+    // the output bytes count the data of the subblocks only (as the byte statistics do)
+    progress_info.input_bytes_total += subblock_estimate.source_size;
+    constexpr std::uint64_t kSizeOfSubBlockSegmentOverhead = kSizeOfSegmentHeader + kSizeOfFixedPartOfSubBlockSegment;
+    if (subblock_estimate.estimated_size > kSizeOfSubBlockSegmentOverhead)
+    {
+      progress_info.output_bytes_total += subblock_estimate.estimated_size - kSizeOfSubBlockSegmentOverhead;
+    }
+  }
+
+  this->throughput_estimator_ = ThroughputEstimator();
+  this->throughput_estimator_.AddSample(0);
+}
+
+void CopyCziBase::AddSubBlockToProgress(int subblock_index, ProgressInfo& progress_info)
+{
+  ++progress_info.number_of_items_done;
+  progress_info.input_bytes_done += this->GetSourceSizeOfSubBlock(subblock_index);
+
+  progress_info.output_bytes_done = this->action_count.GetTotalOutputBytes();
+  this->throughput_estimator_.AddSample(progress_info.input_bytes_done);
+  progress_info.input_bytes_per_second = this->throughput_estimator_.GetBytesPerSecond();
+  progress_info.estimated_seconds_remaining = this->throughput_estimator_.GetEstimatedSecondsRemaining(progress_info.input_bytes_total);
+}
+
+std::uint64_t CopyCziBase::EstimateSizeOfDestinationDocument() const
+{
+  const auto subblock_estimates = this->EstimateSizesOfSubBlocks();
+  std::uint64_t estimated_size = kSizeOfFileHeaderSegment;
+  for (const auto& subblock_estimate : subblock_estimates)
+  {
+    estimated_size += subblock_estimate.estimated_size;
+  }
+
+  estimated_size += AlignSegmentSize(kSizeOfSegmentHeader + kSizeOfSubBlockDirectoryHeader +
+                                     subblock_estimates.size() * kEstimatedSizeOfSubBlockDirectoryEntry);
+
+  std::uint64_t number_of_attachments = 0;
+  this->reader_->EnumerateAttachments(
+      [&number_of_attachments](int, const libCZI::AttachmentInfo&) -> bool
+      {
+        ++number_of_attachments;
+        return true;
+      });
+  if (number_of_attachments > 0)
+  {
+    estimated_size +=
+        AlignSegmentSize(kSizeOfSegmentHeader + kSizeOfAttachmentDirectoryHeader + number_of_attachments * kSizeOfAttachmentDirectoryEntry);
+  }
+
+  const auto metadata_segment = this->reader_->ReadMetadataSegment();
+  if (metadata_segment)
+  {
+    const void* ptr = nullptr;
+    size_t size = 0;
+    metadata_segment->DangerousGetRawData(libCZI::IMetadataSegment::MemBlkType::XmlMetadata, ptr, size);
+    estimated_size += AlignSegmentSize(kSizeOfSegmentHeader + kSizeOfMetadataSegmentHeader + size + size / kMetadataSizeMarginDivisor);
+  }
+
+  return estimated_size;
+}
+
+/*static*/ bool CopyCziBase::IsCompressionModeSupportedForDecoding(libCZI::CompressionMode compression_mode)
+{
+  return compression_mode == libCZI::CompressionMode::UnCompressed || compression_mode == libCZI::CompressionMode::JpgXr ||
+         compression_mode == libCZI::CompressionMode::Zstd0 || compression_mode == libCZI::CompressionMode::Zstd1;
+}
+
+std::uint64_t CopyCziBase::ProcessedSubBlock::GetSizeOfProcessedData() const
+{
+  std::uint64_t size = 0;
+  if (this->bitmap)
+  {
+    const libCZI::ScopedBitmapLockerSP bitmap_locked{this->bitmap};
+    size += static_cast<std::uint64_t>(bitmap_locked.stride) * this->bitmap->GetHeight();
+  }
+
+  if (this->compressed_data)
+  {
+    size += this->compressed_data->GetSizeOfData();
+  }
+
+  return size;
+}
+
 /*static*/ void CopyCziBase::SetPositionCoordinatePixelType(const std::shared_ptr<libCZI::ISubBlock>& subblock,
                                                             libCZI::AddSubBlockInfoBase& add_subblock_info_target)
 {
@@ -85,41 +314,93 @@ const ActionWithSubBlockStatistics& CopyCziBase::GetStatistics() const { return
   }
 }
 
+/*static*/ int CopyCziBase::DetermineNumberOfWorkerThreads(const int number_of_threads)
+{
+  if (number_of_threads > 0)
+  {
+    return number_of_threads;
+  }
+
+  // hardware_concurrency may return 0 if the value is not computable
+  const unsigned int number_of_hardware_threads = std::thread::hardware_concurrency();
+  return number_of_hardware_threads > 0 ? static_cast<int>(number_of_hardware_threads) : 1;
+}
+
 bool CopyCziBase::Run()
 {
   ProgressInfo progress_info;
   progress_info.phase = ProcessingPhase::kCopySubblocks;
   progress_info.number_of_items_todo = this->reader_->GetStatistics().subBlockCount;
+  this->InitializeByteProgress(progress_info);
 
-  bool was_cancelled = false;
+  const int number_of_worker_threads = CopyCziBase::DetermineNumberOfWorkerThreads(this->options_.number_of_threads);
 
-  this->reader_->EnumerateSubBlocks(
-      [&](int index, const libCZI::SubBlockInfo&) -> bool
-      {
-        const auto subblock = this->reader_->ReadSubBlock(index);
-        this->ProcessAndWriteSubBlock(subblock);
-        progress_info.number_of_items_done++;
-        if (this->progress_report_ && !this->progress_report_(progress_info))
+  if ((this->options_.source_stream && this->options_.source_range_copy) || this->options_.source_read_ahead)
+  {
+    this->subblock_file_positions_.clear();
+    this->reader_->EnumerateSubBlocksEx(
+        [this](int index, const libCZI::DirectorySubBlockInfo& info) -> bool
         {
-          was_cancelled = true;
-          return false;
-        }
+          if (index >= 0)
+          {
+            if (static_cast<size_t>(index) >= this->subblock_file_positions_.size())
+            {
+              this->subblock_file_positions_.resize(static_cast<size_t>(index) + 1, 0);
+            }
+
+            this->subblock_file_positions_[static_cast<size_t>(index)] = info.filePosition;
+          }
+
+          return true;
+        });
+  }
 
-        return true;
-      });
+  // if the subblocks are to be reordered before writing, we need the pipeline (which is able to reorder) - also
+  // with only one worker thread
+  const bool reordering_required = this->IsReorderingRequired();
+  const auto work_list = this->CreateWorkList(this->GetMaxNumberOfSubBlocksInFlight(number_of_worker_threads));
+  if (this->options_.source_read_ahead)
+  {
+    std::vector<std::uint64_t> positions_in_read_order;
+    positions_in_read_order.reserve(work_list.size());
+    for (const auto& item : work_list)
+    {
+      if (item.subblock_index >= 0 && static_cast<size_t>(item.subblock_index) < this->subblock_file_positions_.size())
+      {
+        positions_in_read_order.push_back(this->subblock_file_positions_[static_cast<size_t>(item.subblock_index)]);
+      }
+    }
 
-  if (was_cancelled)
+    this->options_.source_read_ahead->AnnounceSubBlockPositions(positions_in_read_order);
+  }
+
+  const std::uint64_t buffer_pool_hits_at_start = this->buffer_pool_->GetNumberOfHits();
+  const std::uint64_t buffer_pool_misses_at_start = this->buffer_pool_->GetNumberOfMisses();
+  const bool completed = number_of_worker_threads > 1 || reordering_required
+                             ? this->CopySubBlocksMultiThreaded(progress_info, work_list, number_of_worker_threads)
+                             : this->CopySubBlocksSingleThreaded(progress_info, work_list);
+
+  // note that (if the buffer pool is shared) this includes allocations made by other operations running concurrently
+  this->action_count.SetBufferPoolHitsAndMisses(this->buffer_pool_->GetNumberOfHits() - buffer_pool_hits_at_start,
+                                                this->buffer_pool_->GetNumberOfMisses() - buffer_pool_misses_at_start);
+  if (!completed)
   {
     return false;
   }
 
-  progress_info = ProgressInfo();
+  bool was_cancelled = false;
+
+  // the byte counts (and the throughput) of the subblocks are kept in the following phases
   progress_info.phase = ProcessingPhase::kCopyAttachments;
-  // TODO(JBL): Currently, there is no (easy) way to find the total number of
-  // attachments (afaik).
-  //             So, we set the number of items to do to -1, which means
-  //             "unknown".
-  progress_info.number_of_items_todo = -1;
+  progress_info.number_of_items_done = 0;
+  progress_info.number_of_items_todo = 0;
+  progress_info.estimated_seconds_remaining = 0;
+  this->reader_->EnumerateAttachments(
+      [&progress_info](int, const libCZI::AttachmentInfo&) -> bool
+      {
+        ++progress_info.number_of_items_todo;
+        return true;
+      });
   this->reader_->EnumerateAttachments(
       [&](int index, const libCZI::AttachmentInfo&) -> bool
       {
@@ -140,8 +421,8 @@ bool CopyCziBase::Run()
     return false;
   }
 
-  progress_info = ProgressInfo();
   progress_info.phase = ProcessingPhase::kWriteXmlMetadata;
+  progress_info.number_of_items_done = 0;
   progress_info.number_of_items_todo = 1;
   if (this->progress_report_ && !this->progress_report_(progress_info))
   {
@@ -156,19 +437,531 @@ bool CopyCziBase::Run()
   return !failed;
 }
 
-void CopyCziBase::ProcessAndWriteSubBlock(const std::shared_ptr<libCZI::ISubBlock>& subblock)
+std::uint64_t CopyCziBase::GetMaxNumberOfSubBlocksInFlight(int number_of_worker_threads) const
 {
-  auto action_with_subblock = this->DecideWhatToDoWithSubBlock(subblock);
+  return 4 * static_cast<std::uint64_t>(number_of_worker_threads) + this->options_.prefetch_depth;
+}
+
+bool CopyCziBase::IsReorderingRequired() const
+{
+  return this->options_.read_order == SubBlockReadOrder::kFilePosition && this->options_.output_order == SubBlockOutputOrder::kSource;
+}
+
+std::uint64_t CopyCziBase::GetSourceSizeOfSubBlock(int subblock_index) const
+{
+  if (subblock_index >= 0 && static_cast<size_t>(subblock_index) < this->subblock_source_sizes_.size())
+  {
+    return this->subblock_source_sizes_[static_cast<size_t>(subblock_index)];
+  }
+
+  return 0;
+}
+
+std::vector<CopyCziBase::SubBlockWorkItem> CopyCziBase::CreateWorkList(std::uint64_t reorder_window)
+{
+  std::vector<SubBlockWorkItem> work_list;
+  if (this->options_.read_order != SubBlockReadOrder::kFilePosition)
+  {
+    this->reader_->EnumerateSubBlocks(
+        [&](int index, const libCZI::SubBlockInfo&) -> bool
+        {
+          SubBlockWorkItem item;
+          item.subblock_index = index;
+          item.output_position = work_list.size();
+          item.window_size = 1;
+          item.window_estimated_bytes = this->GetSourceSizeOfSubBlock(index);
+          work_list.push_back(item);
+          return true;
+        });
+
+    return work_list;
+  }
+
+  std::vector<std::uint64_t> file_positions;
+  this->reader_->EnumerateSubBlocksEx(
+      [&](int index, const libCZI::DirectorySubBlockInfo& info) -> bool
+      {
+        SubBlockWorkItem item;
+        item.subblock_index = index;
+        item.output_position = work_list.size();
+        work_list.push_back(item);
+        file_positions.push_back(info.filePosition);
+        return true;
+      });
+
+  // 'output_position' is the position in source order at this point, so we can use it to look up the file position
+  const auto is_before_in_file = [&](const SubBlockWorkItem& a, const SubBlockWorkItem& b) -> bool
+  { return file_positions[a.output_position] < file_positions[b.output_position]; };
+
+  if (this->IsReorderingRequired())
+  {
+    // we sort only within windows of consecutive subblocks (in source order) - a window has at most the maximum
+    // number of subblocks in flight (so the pipeline can always complete a window), and its estimated size is at
+    // most half of the byte budget (so that the next window can be admitted while the writer completes the
+    // current one) - the size of a subblock is estimated by the distance to the next segment in the source file
+    const std::uint64_t max_window_size = (std::max)(reorder_window, static_cast<std::uint64_t>(1));
+    const std::uint64_t max_window_bytes = this->options_.max_bytes_in_flight / 2;
+    for (std::uint64_t window_start = 0; window_start < work_list.size();)
+    {
+      std::uint64_t window_end = window_start;
+      std::uint64_t window_bytes = 0;
+      while (window_end < work_list.size() && window_end - window_start < max_window_size)
+      {
+        const std::uint64_t subblock_bytes = this->GetSourceSizeOfSubBlock(work_list[window_end].subblock_index);
+        if (max_window_bytes > 0 && window_end > window_start && window_bytes + subblock_bytes > max_window_bytes)
+        {
+          break;
+        }
+
+        window_bytes += subblock_bytes;
+        ++window_end;
+      }
+
+      std::stable_sort(work_list.begin() + window_start, work_list.begin() + window_end, is_before_in_file);  // NOLINT
+      work_list[window_start].window_size = window_end - window_start;
+      work_list[window_start].window_estimated_bytes = window_bytes;
+      window_start = window_end;
+    }
+  }
+  else
+  {
+    std::stable_sort(work_list.begin(), work_list.end(), is_before_in_file);
+    for (std::uint64_t i = 0; i < work_list.size(); ++i)
+    {
+      work_list[i].output_position = i;
+      work_list[i].window_size = 1;
+      work_list[i].window_estimated_bytes = this->GetSourceSizeOfSubBlock(work_list[i].subblock_index);
+    }
+  }
+
+  return work_list;
+}
+
+TraceBuffer* CopyCziBase::AddTraceThread(const std::string& thread_name) const
+{
+  return this->options_.tracer ? this->options_.tracer->AddThread(thread_name) : nullptr;
+}
+
+bool CopyCziBase::CopySubBlocksSingleThreaded(ProgressInfo& progress_info, const std::vector<SubBlockWorkItem>& work_list)
+{
+  // note that in this case the subblocks are written in the order in which they are read, i.e. the
+  // output position of an item is its position in the work list
+  TraceBuffer* const trace_buffer = this->AddTraceThread("main");
+  if (this->options_.prefetch_depth == 0)
+  {
+    for (const auto& item : work_list)
+    {
+      std::shared_ptr<libCZI::ISubBlock> subblock;
+      {
+        const TraceScope trace_scope(trace_buffer, TraceStage::kRead, item.subblock_index);
+        subblock = this->reader_->ReadSubBlock(item.subblock_index);
+      }
+
+      if (!this->ProcessAndWriteSubBlockAndReportProgress(item.subblock_index, subblock, progress_info, trace_buffer))
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // the subblocks are read on a background thread, while we process and write them on this thread
+  std::vector<int> subblock_indices;
+  subblock_indices.reserve(work_list.size());
+  for (const auto& item : work_list)
+  {
+    subblock_indices.push_back(item.subblock_index);
+  }
+
+  SubBlockPrefetcher prefetcher(this->reader_, subblock_indices, this->options_.prefetch_depth, this->options_.prefetch_max_bytes,
+                                this->options_.tracer);
+  std::shared_ptr<libCZI::ISubBlock> subblock;
+  for (size_t i = 0; prefetcher.GetNext(subblock); ++i)
+  {
+    // the prefetcher delivers the subblocks in the order of the list of indices
+    if (!this->ProcessAndWriteSubBlockAndReportProgress(subblock_indices[i], subblock, progress_info, trace_buffer))
+    {
+      return false;
+    }
+
+    subblock.reset();
+  }
+
+  return true;
+}
+
+bool CopyCziBase::ProcessAndWriteSubBlockAndReportProgress(int subblock_index, const std::shared_ptr<libCZI::ISubBlock>& subblock,
+                                                            ProgressInfo& progress_info, TraceBuffer* trace_buffer)
+{
+  ProcessedSubBlock processed_subblock;
+  {
+    const TraceScope trace_scope(trace_buffer, TraceStage::kProcess, subblock_index);
+    processed_subblock = this->ProcessSubBlock(subblock);
+  }
+
+  processed_subblock.subblock_index = subblock_index;
+
+  // there is only one subblock being processed at any time, so the peak is the maximum over all subblocks
+  this->action_count.UpdatePeakBytesInFlight(GetSizeOfSubBlockInMemory(subblock) + processed_subblock.GetSizeOfProcessedData());
+
+  {
+    const TraceScope trace_scope(trace_buffer, TraceStage::kWrite, subblock_index);
+    this->WriteProcessedSubBlock(processed_subblock);
+  }
+
+  this->AddSubBlockToProgress(subblock_index, progress_info);
+  return !this->progress_report_ || this->progress_report_(progress_info);
+}
+
+bool CopyCziBase::CopySubBlocksMultiThreaded(ProgressInfo& progress_info, const std::vector<SubBlockWorkItem>& work_list,
+                                             const int number_of_worker_threads)
+{
+  // The pipeline is constructed as follows:
+  // - one thread is reading the subblocks and puts them into the "read_queue" (tagged with a sequence
+  //    number, which is the position at which the subblock is to be written)
+  // - the worker threads take the subblocks from the "read_queue", process them, and put the result into
+  //    the "processed_subblocks" map (keyed by the sequence number)
+  // - this thread takes the processed subblocks from the map in the order of the sequence number, and
+  //    writes them out
+  // So, the order in which the subblocks are written is exactly the same as with the single-threaded
+  // operation. The number of subblocks "in flight" (i.e. read but not yet written) and the number of bytes
+  // held by them are limited, so that the memory consumption is bounded in case the writer cannot keep up.
+  // The subblocks are admitted in windows (see 'CreateWorkList'), and a window is only admitted if its
+  // estimated size fits into the byte budget. If the subblocks are read in a different order than they are
+  // written, they are reordered within a window - a window is admitted as a whole (so the writer can always
+  // complete it), and we allow for two windows in flight in order to keep the pipeline busy at the window
+  // boundaries. Otherwise, each subblock is a window of its own.
+  struct ReadSubBlockItem
+  {
+    std::uint64_t sequence_number{0};
+    std::uint64_t size_in_memory{0};
+    int subblock_index{0};
+    std::shared_ptr<libCZI::ISubBlock> subblock;
+  };
+
+  struct ProcessedSubBlockItem
+  {
+    std::uint64_t size_in_memory{0};
+    ProcessedSubBlock processed_subblock;
+  };
+
+  const bool reordering_required = this->IsReorderingRequired();
+  const std::uint64_t max_number_of_subblocks_in_flight = this->GetMaxNumberOfSubBlocksInFlight(number_of_worker_threads);
+  InFlightBudget in_flight_budget(this->options_.max_bytes_in_flight,
+                                  reordering_required ? 2 * max_number_of_subblocks_in_flight : max_number_of_subblocks_in_flight);
+
+  BlockingQueue<ReadSubBlockItem> read_queue;
+
+  // the following variables are protected by 'mutex'
+  std::mutex mutex;
+  std::condition_variable condition_variable;
+  std::map<std::uint64_t, ProcessedSubBlockItem> processed_subblocks;
+  std::uint64_t number_of_subblocks_read = 0;
+  bool reading_done = false;
+  bool abort = false;
+  std::exception_ptr exception;
+
+  const auto abort_pipeline = [&](const std::exception_ptr& exception_to_report)
+  {
+    {
+      const std::lock_guard<std::mutex> lock(mutex);
+      if (exception_to_report && !exception)
+      {
+        exception = exception_to_report;
+      }
+
+      abort = true;
+    }
+
+    condition_variable.notify_all();
+    in_flight_budget.Abort();
+    read_queue.CloseAndClear();
+  };
+
+  // the buffers for the events of the threads are created here, so that an error doing so is reported to the caller
+  TraceBuffer* const reader_trace_buffer = this->AddTraceThread("reader");
+  std::vector<TraceBuffer*> worker_trace_buffers;
+  worker_trace_buffers.reserve(number_of_worker_threads);
+  for (int i = 0; i < number_of_worker_threads; ++i)
+  {
+    worker_trace_buffers.push_back(this->AddTraceThread("worker " + std::to_string(i + 1)));
+  }
+
+  TraceBuffer* const writer_trace_buffer = this->AddTraceThread("writer");
+
+  std::thread reader_thread(
+      [&]()
+      {
+        std::uint64_t number_of_items_read = 0;
+        try
+        {
+          for (const auto& work_item : work_list)
+          {
+            if (work_item.window_size > 0 && !in_flight_budget.WaitForAdmission(work_item.window_size, work_item.window_estimated_bytes))
+            {
+              break;
+            }
+
+            ReadSubBlockItem item;
+            item.sequence_number = work_item.output_position;
+            item.subblock_index = work_item.subblock_index;
+            {
+              const TraceScope trace_scope(reader_trace_buffer, TraceStage::kRead, work_item.subblock_index);
+              item.subblock = this->reader_->ReadSubBlock(work_item.subblock_index);
+            }
+
+            ++number_of_items_read;
+            item.size_in_memory = GetSizeOfSubBlockInMemory(item.subblock);
+            in_flight_budget.AddBytes(item.size_in_memory);
+            if (!read_queue.Push(std::move(item)))
+            {
+              break;
+            }
+          }
+        }
+        catch (...)
+        {
+          abort_pipeline(std::current_exception());
+        }
+
+        {
+          const std::lock_guard<std::mutex> lock(mutex);
+          number_of_subblocks_read = number_of_items_read;
+          reading_done = true;
+        }
+
+        condition_variable.notify_all();
+        read_queue.Close();
+      });
+
+  std::vector<std::thread> worker_threads;
+  try
+  {
+    worker_threads.reserve(number_of_worker_threads);
+    for (int i = 0; i < number_of_worker_threads; ++i)
+    {
+      worker_threads.emplace_back(
+          [&, trace_buffer = worker_trace_buffers[i]]()
+          {
+            const WorkerThreadScope worker_thread_scope;
+            ReadSubBlockItem item;
+            while (read_queue.Pop(item))
+            {
+              try
+              {
+                ProcessedSubBlockItem processed_item;
+                {
+                  const TraceScope trace_scope(trace_buffer, TraceStage::kProcess, item.subblock_index);
+                  processed_item.processed_subblock = this->ProcessSubBlock(item.subblock);
+                }
+
+                processed_item.processed_subblock.subblock_index = item.subblock_index;
+                item.subblock.reset();
+                const std::uint64_t size_of_processed_data = processed_item.processed_subblock.GetSizeOfProcessedData();
+                in_flight_budget.AddBytes(size_of_processed_data);
+                processed_item.size_in_memory = item.size_in_memory + size_of_processed_data;
+                {
+                  const std::lock_guard<std::mutex> lock(mutex);
+                  processed_subblocks.emplace(item.sequence_number, std::move(processed_item));
+                }
+
+                condition_variable.notify_all();
+              }
+              catch (...)
+              {
+                abort_pipeline(std::current_exception());
+                return;
+              }
+            }
+          });
+    }
+  }
+  catch (...)
+  {
+    // the threads already started must be stopped and joined before leaving (the destructor of a joinable
+    // std::thread would terminate the process)
+    abort_pipeline(nullptr);
+    reader_thread.join();
+    for (auto& worker_thread : worker_threads)
+    {
+      worker_thread.join();
+    }
+
+    throw;
+  }
+
+  bool was_cancelled = false;
+  try
+  {
+    for (std::uint64_t next_sequence_number = 0;; ++next_sequence_number)
+    {
+      ProcessedSubBlockItem processed_item;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition_variable.wait(lock,
+                                [&]()
+                                {
+                                  return abort || processed_subblocks.find(next_sequence_number) != processed_subblocks.end() ||
+                                         (reading_done && next_sequence_number >= number_of_subblocks_read);
+                                });
+        const auto iterator = processed_subblocks.find(next_sequence_number);
+        if (abort || iterator == processed_subblocks.end())
+        {
+          break;
+        }
+
+        processed_item = std::move(iterator->second);
+        processed_subblocks.erase(iterator);
+      }
+
+      {
+        const TraceScope trace_scope(writer_trace_buffer, TraceStage::kWrite, processed_item.processed_subblock.subblock_index);
+        this->WriteProcessedSubBlock(processed_item.processed_subblock);
+      }
+
+      this->AddSubBlockToProgress(processed_item.processed_subblock.subblock_index, progress_info);
+      processed_item.processed_subblock = ProcessedSubBlock();
+      in_flight_budget.Release(processed_item.size_in_memory);
+      if (this->progress_report_ && !this->progress_report_(progress_info))
+      {
+        was_cancelled = true;
+        abort_pipeline(nullptr);
+        break;
+      }
+    }
+  }
+  catch (...)
+  {
+    abort_pipeline(std::current_exception());
+  }
+
+  reader_thread.join();
+  for (auto& worker_thread : worker_threads)
+  {
+    worker_thread.join();
+  }
+
+  this->action_count.UpdatePeakBytesInFlight(in_flight_budget.GetPeakNumberOfBytes());
+
+  if (exception)
+  {
+    std::rethrow_exception(exception);
+  }
+
+  return !was_cancelled;
+}
+
+CopyCziBase::ProcessedSubBlock CopyCziBase::ProcessSubBlock(const std::shared_ptr<libCZI::ISubBlock>& subblock)
+{
+  const auto action_with_subblock = this->DecideWhatToDoWithSubBlock(subblock);
   switch (action_with_subblock)
   {
+    case ActionWithSubBlock::kDecompress:
+      return this->DecompressSubBlock(subblock);
+    case ActionWithSubBlock::kCompress:
+      return this->CompressSubBlockIfPossible(subblock);
+    case ActionWithSubBlock::kCopyAlreadyCompressed:
+    {
+      ProcessedSubBlock processed_subblock;
+      processed_subblock.subblock = subblock;
+      processed_subblock.action = ActionWithSubBlock::kCopyAlreadyCompressed;
+      return processed_subblock;
+    }
     case ActionWithSubBlock::kCopy:
-      this->WriteSubblockVerbatim(subblock);
+    default:
+    {
+      ProcessedSubBlock processed_subblock;
+      processed_subblock.subblock = subblock;
+      processed_subblock.action = ActionWithSubBlock::kCopy;
+      return processed_subblock;
+    }
+  }
+}
+
+CopyCziBase::ProcessedSubBlock CopyCziBase::DecompressSubBlock(const std::shared_ptr<libCZI::ISubBlock>& subblock)
+{
+  ProcessedSubBlock processed_subblock;
+  processed_subblock.subblock = subblock;
+
+  const libCZI::CompressionMode subblock_compression_mode = subblock->GetSubBlockInfo().GetCompressionMode();
+  switch (subblock_compression_mode)
+  {
+    default:
+    case libCZI::CompressionMode::UnCompressed:
+      // well, in this case we have nothing other to do than to copy the
+      // subblock verbatim
+      processed_subblock.action = ActionWithSubBlock::kCopy;
+      break;
+    case libCZI::CompressionMode::JpgXr:
+    case libCZI::CompressionMode::Zstd0:
+    case libCZI::CompressionMode::Zstd1:
+      processed_subblock.action = ActionWithSubBlock::kDecompress;
+      processed_subblock.bitmap = subblock->CreateBitmap();
+      break;
+  }
+
+  return processed_subblock;
+}
+
+CopyCziBase::ProcessedSubBlock CopyCziBase::CompressSubBlockIfPossible(const std::shared_ptr<libCZI::ISubBlock>& subblock)
+{
+  ProcessedSubBlock processed_subblock;
+  processed_subblock.subblock = subblock;
+
+  // First, we check if we can decompress the subblock (or - if it is already
+  // uncompressed) - If not, we cannot compress it obviously, and what we do is
+  // to copy it verbatim then
+  if (!CopyCziBase::IsCompressionModeSupportedForDecoding(subblock->GetSubBlockInfo().GetCompressionMode()))
+  {
+    processed_subblock.action = ActionWithSubBlock::kCopy;
+  }
+  else
+  {
+    // If that's not the case - then let's get the bitmap and compress it
+    auto compression_mode_and_compressed_memory_block = this->CompressSubBlock(subblock);
+    processed_subblock.action = ActionWithSubBlock::kCompress;
+    processed_subblock.compression_mode = std::get<0>(compression_mode_and_compressed_memory_block);
+    processed_subblock.compressed_data = std::move(std::get<1>(compression_mode_and_compressed_memory_block));
+
+    if (this->IsOriginalKeptIfNotSmaller())
+    {
+      const void* raw_data = nullptr;
+      size_t size_of_raw_data = 0;
+      subblock->DangerousGetRawData(libCZI::ISubBlock::MemBlkType::Data, raw_data, size_of_raw_data);
+      if (processed_subblock.compressed_data->GetSizeOfData() >= size_of_raw_data)
+      {
+        processed_subblock.action = ActionWithSubBlock::kKeepOriginal;
+        processed_subblock.compression_mode = libCZI::CompressionMode::Invalid;
+        processed_subblock.compressed_data.reset();
+      }
+    }
+  }
+
+  return processed_subblock;
+}
+
+void CopyCziBase::WriteProcessedSubBlock(const ProcessedSubBlock& processed_subblock)
+{
+  switch (processed_subblock.action)
+  {
+    case ActionWithSubBlock::kCopy:
+      this->WriteSubblockVerbatim(processed_subblock.subblock, processed_subblock.subblock_index, SubBlockAction::kCopiedVerbatim);
+      this->action_count.Increment_CopiedVerbatim();
+      break;
+    case ActionWithSubBlock::kCopyAlreadyCompressed:
+      this->WriteSubblockVerbatim(processed_subblock.subblock, processed_subblock.subblock_index, SubBlockAction::kAlreadyCompressed);
+      this->action_count.Increment_AlreadyCompressed();
+      break;
+    case ActionWithSubBlock::kKeepOriginal:
+      this->WriteSubblockVerbatim(processed_subblock.subblock, processed_subblock.subblock_index, SubBlockAction::kKeptOriginal);
+      this->action_count.Increment_KeptOriginal();
       break;
     case ActionWithSubBlock::kDecompress:
-      this->DecompressAndWriteSubBlock(subblock);
+      this->WriteDecompressedSubBlock(processed_subblock);
       break;
     case ActionWithSubBlock::kCompress:
-      this->CompressAndWriteSubBlock(subblock);
+      this->WriteCompressedSubBlock(processed_subblock);
       break;
   }
 }
@@ -223,7 +1016,7 @@ void CopyCziBase::WriteMetadataSegment(const std::shared_ptr<libCZI::IMetadataSe
   }
 }
 
-void CopyCziBase::WriteSubblockVerbatim(const std::shared_ptr<libCZI::ISubBlock>& subblock)
+void CopyCziBase::WriteSubblockVerbatim(const std::shared_ptr<libCZI::ISubBlock>& subblock, int subblock_index, SubBlockAction action)
 {
   libCZI::AddSubBlockInfoMemPtr subblock_info_target;
 
@@ -237,73 +1030,70 @@ void CopyCziBase::WriteSubblockVerbatim(const std::shared_ptr<libCZI::ISubBlock>
   CopyCziBase::SetPositionCoordinatePixelType(subblock, subblock_info_target);
   subblock_info_target.compressionModeRaw = subblock->GetSubBlockInfo().compressionModeRaw;
 
+  this->AnnounceSourceRangeOfSubBlockData(subblock_index, rawData.get(), size_data);
   this->writer_->SyncAddSubBlock(subblock_info_target);
-  this->action_count.Increment_CopiedVerbatim();
+  if (this->options_.source_range_copy)
+  {
+    // the announcement must not outlive the data - a buffer allocated later at the same address (and with the same
+    //  size) would be mistaken for it
+    this->options_.source_range_copy->AnnounceSourceRange(nullptr, 0, 0);
+  }
+  this->action_count.AddBytes(subblock->GetSubBlockInfo(), action, size_data, size_data);
 }
 
-void CopyCziBase::DecompressAndWriteSubBlock(const std::shared_ptr<libCZI::ISubBlock>& subblock)
+void CopyCziBase::AnnounceSourceRangeOfSubBlockData(int subblock_index, const void* data, size_t size)
 {
-  const libCZI::CompressionMode subblock_compression_mode = subblock->GetSubBlockInfo().GetCompressionMode();
-  switch (subblock_compression_mode)
+  if (!this->options_.source_range_copy || subblock_index < 0 ||
+      static_cast<size_t>(subblock_index) >= this->subblock_file_positions_.size())
   {
-    default:
-    case libCZI::CompressionMode::UnCompressed:
-      // well, in this case we have nothing other to do than to copy the
-      // subblock verbatim
-      this->WriteSubblockVerbatim(subblock);
-      break;
-    case libCZI::CompressionMode::JpgXr:
-    case libCZI::CompressionMode::Zstd0:
-    case libCZI::CompressionMode::Zstd1:
-    {
-      libCZI::AddSubBlockInfoStridedBitmap subblock_info_target;
+    return;
+  }
+
+  // the writer passes the data (with the pointer given to it) to the destination stream, where we then recognize it -
+  // if the position of the data in the source file cannot be determined, we simply do not announce it
+  std::uint64_t data_position = 0;
+  const std::uint64_t segment_position = this->subblock_file_positions_[static_cast<size_t>(subblock_index)];
+  if (TryGetFilePositionOfSubBlockData(this->options_.source_stream.get(), segment_position, data, size, data_position))
+  {
+    this->options_.source_range_copy->AnnounceSourceRange(data, size, data_position);
+  }
+}
 
-      InitMetaDataAndAttachment(subblock_info_target, subblock);
+void CopyCziBase::WriteDecompressedSubBlock(const ProcessedSubBlock& processed_subblock)
+{
+  libCZI::AddSubBlockInfoStridedBitmap subblock_info_target;
 
-      const auto bitmap = subblock->CreateBitmap();
-      const libCZI::ScopedBitmapLockerSP bitmap_locked{bitmap};
-      subblock_info_target.ptrBitmap = bitmap_locked.ptrDataRoi;
-      subblock_info_target.strideBitmap = bitmap_locked.stride;
+  InitMetaDataAndAttachment(subblock_info_target, processed_subblock.subblock);
 
-      CopyCziBase::SetPositionCoordinatePixelType(subblock, subblock_info_target);
-      subblock_info_target.SetCompressionMode(libCZI::CompressionMode::UnCompressed);  // set uncompressed.
+  const libCZI::ScopedBitmapLockerSP bitmap_locked{processed_subblock.bitmap};
+  subblock_info_target.ptrBitmap = bitmap_locked.ptrDataRoi;
+  subblock_info_target.strideBitmap = bitmap_locked.stride;
 
-      this->writer_->SyncAddSubBlock(subblock_info_target);
-      this->action_count.Increment_Decompressed();
-    }
+  CopyCziBase::SetPositionCoordinatePixelType(processed_subblock.subblock, subblock_info_target);
+  subblock_info_target.SetCompressionMode(libCZI::CompressionMode::UnCompressed);  // set uncompressed.
 
-    break;
-  }
+  this->writer_->SyncAddSubBlock(subblock_info_target);
+  this->action_count.Increment_Decompressed();
+  this->action_count.AddBytes(processed_subblock.subblock->GetSubBlockInfo(), SubBlockAction::kDecompressed,
+                              GetSizeOfSubBlockData(processed_subblock.subblock),
+                              static_cast<std::uint64_t>(processed_subblock.bitmap->GetWidth()) * processed_subblock.bitmap->GetHeight() *
+                                  libCZI::Utils::GetBytesPerPixel(processed_subblock.bitmap->GetPixelType()));
 }
 
-void CopyCziBase::CompressAndWriteSubBlock(const std::shared_ptr<libCZI::ISubBlock>& subblock)
+void CopyCziBase::WriteCompressedSubBlock(const ProcessedSubBlock& processed_subblock)
 {
-  // First, we check if we can decompress the subblock (or - if it is already
-  // uncompressed) - If not, we cannot compress it obviously, and what we do is
-  // to copy it verbatim then
-  const libCZI::CompressionMode subblock_compression_mode = subblock->GetSubBlockInfo().GetCompressionMode();
-  if (subblock_compression_mode != libCZI::CompressionMode::UnCompressed && subblock_compression_mode != libCZI::CompressionMode::JpgXr &&
-      subblock_compression_mode != libCZI::CompressionMode::Zstd0 && subblock_compression_mode != libCZI::CompressionMode::Zstd1)
-  {
-    this->WriteSubblockVerbatim(subblock);
-  }
-  else
-  {
-    // If that's not the case - then let's get the bitmap, compress it, and
-    // write it out
-    libCZI::AddSubBlockInfoMemPtr subblock_info_target;
-    InitMetaDataAndAttachment(subblock_info_target, subblock);
-
-    const auto compression_mode_and_compressed_memory_block = this->CompressSubBlock(subblock);
+  libCZI::AddSubBlockInfoMemPtr subblock_info_target;
+  InitMetaDataAndAttachment(subblock_info_target, processed_subblock.subblock);
 
-    subblock_info_target.ptrData = std::get<1>(compression_mode_and_compressed_memory_block)->GetPtr();
-    subblock_info_target.dataSize = CheckSizeAndCastToUint32(std::get<1>(compression_mode_and_compressed_memory_block)->GetSizeOfData());
+  subblock_info_target.ptrData = processed_subblock.compressed_data->GetPtr();
+  subblock_info_target.dataSize = CheckSizeAndCastToUint32(processed_subblock.compressed_data->GetSizeOfData());
 
-    CopyCziBase::SetPositionCoordinatePixelType(subblock, subblock_info_target);
-    subblock_info_target.SetCompressionMode(std::get<0>(compression_mode_and_compressed_memory_block) /*CompressionMode::Zstd1*/);
-    this->writer_->SyncAddSubBlock(subblock_info_target);
-    this->action_count.Increment_Compressed();
-  }
+  CopyCziBase::SetPositionCoordinatePixelType(processed_subblock.subblock, subblock_info_target);
+  subblock_info_target.SetCompressionMode(processed_subblock.compression_mode);
+  this->writer_->SyncAddSubBlock(subblock_info_target);
+  this->action_count.Increment_Compressed();
+  this->action_count.AddBytes(processed_subblock.subblock->GetSubBlockInfo(), SubBlockAction::kCompressed,
+                              GetSizeOfSubBlockData(processed_subblock.subblock), processed_subblock.compressed_data->GetSizeOfData());
 }
 
 std::tuple<libCZI::CompressionMode, std::shared_ptr<libCZI::IMemoryBlock>> CopyCziBase::CompressSubBlock(
@@ -312,6 +1102,8 @@ std::tuple<libCZI::CompressionMode, std::shared_ptr<libCZI::IMemoryBlock>> CopyC
   throw std::runtime_error("The method or operation is not implemented.");
 }
 
+bool CopyCziBase::IsOriginalKeptIfNotSmaller() const { return false; }
+
 std::shared_ptr<libCZI::ICziMetadataBuilder> CopyCziBase::ModifyMetadata(const std::shared_ptr<libCZI::IMetadataSegment>& metadata_segment)
 {
   // base class implementation does nothing here
@@ -339,16 +1131,49 @@ CopyCziAndCompress::ActionWithSubBlock CopyCziAndCompress::DecideWhatToDoWithSub
       if (subblock_compression_mode == libCZI::CompressionMode::UnCompressed ||
           subblock_compression_mode == libCZI::CompressionMode::Zstd0 || subblock_compression_mode == libCZI::CompressionMode::Zstd1)
       {
-        return ActionWithSubBlock::kCompress;
+        // if the subblock is already compressed as requested, compressing it again would be a waste of time
+        return this->IsAlreadyCompressedAsRequested(subblock) ? ActionWithSubBlock::kCopyAlreadyCompressed : ActionWithSubBlock::kCompress;
       }
 
       return ActionWithSubBlock::kCopy;
     }
+    case CompressionStrategy::kSmallest:
+      // whether the compressed data is actually used is decided after compressing (see 'IsOriginalKeptIfNotSmaller')
+      return ActionWithSubBlock::kCompress;
     default:
       throw std::runtime_error("Unknown strategy");
   }
 }
 
+bool CopyCziAndCompress::IsCopiedVerbatimWithCompressionMode(libCZI::CompressionMode compression_mode) const
+{
+  switch (this->strategy_)
+  {
+    case CompressionStrategy::kOnlyUncompressed:
+      return compression_mode != libCZI::CompressionMode::UnCompressed;
+    case CompressionStrategy::kUncompressedAndZStdCompressed:
+      return compression_mode != libCZI::CompressionMode::UnCompressed && compression_mode != libCZI::CompressionMode::Zstd0 &&
+             compression_mode != libCZI::CompressionMode::Zstd1;
+    default:
+      // with the other strategies, all subblocks are compressed - unless they cannot be decoded
+      return !CopyCziBase::IsCompressionModeSupportedForDecoding(compression_mode);
+  }
+}
+
+double CopyCziAndCompress::GetExpectedSizeRatioOfProcessedSubBlocks() const { return kExpectedCompressionRatio; }
+
+bool CopyCziAndCompress::IsOriginalKeptIfNotSmaller() const { return this->strategy_ == CompressionStrategy::kSmallest; }
+
+bool CopyCziAndCompress::IsAlreadyCompressedAsRequested(const std::shared_ptr<libCZI::ISubBlock>& subblock) const
+{
+  const libCZI::SubBlockInfo& subblock_info = subblock->GetSubBlockInfo();
+  const void* raw_data = nullptr;
+  size_t size_of_raw_data = 0;
+  subblock->DangerousGetRawData(libCZI::ISubBlock::MemBlkType::Data, raw_data, size_of_raw_data);
+  return ZstdCompressor::IsEncodedWith(this->compression_option_.first, subblock_info.pixelType, this->compression_option_.second.get(),
+                                       subblock_info.GetCompressionMode(), raw_data, size_of_raw_data);
+}
+
 std::tuple<libCZI::CompressionMode, std::shared_ptr<libCZI::IMemoryBlock>> CopyCziAndCompress::CompressSubBlock(
     const std::shared_ptr<libCZI::ISubBlock>& subblock)
 {
@@ -358,24 +1183,51 @@ std::tuple<libCZI::CompressionMode, std::shared_ptr<libCZI::IMemoryBlock>> CopyC
     throw std::runtime_error("Unknown or unsupported compression mode");
   }
 
+  const libCZI::SubBlockInfo& subblock_info = subblock->GetSubBlockInfo();
+
+  // if the subblock is uncompressed, its data already is the pixel buffer - so we compress it in place instead
+  // of copying it into a bitmap object first
+  const void* pixel_data = nullptr;
+  std::uint32_t stride = 0;
+  if (TryGetPixelDataOfUncompressedSubBlock(subblock, pixel_data, stride))
+  {
+    const auto compressed_memory_block = this->compressor_pool_.Compress(
+        this->compression_option_.first, subblock_info.physicalSize.w, subblock_info.physicalSize.h, stride, subblock_info.pixelType,
+        pixel_data, this->compression_option_.second.get());
+    return std::make_tuple(this->compression_option_.first, compressed_memory_block);
+  }
+
+  // if the subblock is zstd-compressed, we transcode it - i.e. decompress it into a reusable buffer (instead of
+  // creating a bitmap object) and compress this buffer again
+  const libCZI::CompressionMode subblock_compression_mode = subblock_info.GetCompressionMode();
+  if (subblock_compression_mode == libCZI::CompressionMode::Zstd0 || subblock_compression_mode == libCZI::CompressionMode::Zstd1)
+  {
+    const void* raw_data = nullptr;
+    size_t size_of_raw_data = 0;
+    subblock->DangerousGetRawData(libCZI::ISubBlock::MemBlkType::Data, raw_data, size_of_raw_data);
+    const auto compressed_memory_block = this->compressor_pool_.Transcode(
+        this->compression_option_.first, subblock_compression_mode, subblock_info.physicalSize.w, subblock_info.physicalSize.h,
+        subblock_info.pixelType, raw_data, size_of_raw_data, this->compression_option_.second.get());
+    return std::make_tuple(this->compression_option_.first, compressed_memory_block);
+  }
+
   const auto bitmap = subblock->CreateBitmap();
   const libCZI::ScopedBitmapLockerSP bitmap_locked(bitmap);
 
   const auto compressed_memory_block =
-      this->compression_option_.first == libCZI::CompressionMode::Zstd0
-          ? libCZI::ZstdCompress::CompressZStd0Alloc(bitmap->GetWidth(), bitmap->GetHeight(), bitmap_locked.stride, bitmap->GetPixelType(),
-                                                     bitmap_locked.ptrDataRoi, this->compression_option_.second.get())
-          : libCZI::ZstdCompress::CompressZStd1Alloc(bitmap->GetWidth(), bitmap->GetHeight(), bitmap_locked.stride, bitmap->GetPixelType(),
-                                                     bitmap_locked.ptrDataRoi, this->compression_option_.second.get());
+      this->compressor_pool_.Compress(this->compression_option_.first, bitmap->GetWidth(), bitmap->GetHeight(), bitmap_locked.stride,
+                                      bitmap->GetPixelType(), bitmap_locked.ptrDataRoi, this->compression_option_.second.get());
   return std::make_tuple(this->compression_option_.first, compressed_memory_block);
 }
 
 std::shared_ptr<libCZI::ICziMetadataBuilder> CopyCziAndCompress::ModifyMetadata(
     const std::shared_ptr<libCZI::IMetadataSegment>& metadata_segment)
 {
-  // well... if we at least compressed half of the subblocks, then we feel entitled to set the
-  // documents metadata (which states the "prevalant compression")
-  if (this->GetStatistics().GetCountOfSubblocksCompressed() >= this->GetStatistics().GetTotalCountOfSubblocksProcessed() / 2)
+  // well... if we at least compressed half of the subblocks (or found them already compressed as requested), then we
+  // feel entitled to set the documents metadata (which states the "prevalant compression")
+  if (IsCompressionOfDocumentChanged(
+          this->GetStatistics().GetCountOfSubblocksCompressed() + this->GetStatistics().GetCountOfSubblocksAlreadyCompressed(),
+          this->GetStatistics().GetTotalCountOfSubblocksProcessed()))
   {
     auto metadata_src = metadata_segment->CreateMetaFromMetadataSegment();
     const auto metadata_builder = libCZI::CreateMetadataBuilderFromXml(metadata_src->GetXml());
@@ -397,6 +1249,13 @@ CopyCziAndDecompress::ActionWithSubBlock CopyCziAndDecompress::DecideWhatToDoWit
   return ActionWithSubBlock::kDecompress;
 }
 
+bool CopyCziAndDecompress::IsCopiedVerbatimWithCompressionMode(libCZI::CompressionMode compression_mode) const
+{
+  // see 'DecompressSubBlock' - uncompressed subblocks (and those with an unknown compression mode) are copied verbatim
+  return compression_mode != libCZI::CompressionMode::JpgXr && compression_mode != libCZI::CompressionMode::Zstd0 &&
+         compression_mode != libCZI::CompressionMode::Zstd1;
+}
+
 std::shared_ptr<libCZI::ICziMetadataBuilder> CopyCziAndDecompress::ModifyMetadata(
     const std::shared_ptr<libCZI::IMetadataSegment>& metadata_segment)
 {
@@ -404,7 +1263,8 @@ std::shared_ptr<libCZI::ICziMetadataBuilder> CopyCziAndDecompress::ModifyMetadat
   // documents metadata (which states the "prevalant compression") - in this case, we set the
   // "OriginalCompressionMethod"/"OriginalEncodingQuality" elements to
   // the appropriate values (i.e. "Uncompressed").
-  if (this->GetStatistics().GetCountOfSubblocksDecompressed() >= this->GetStatistics().GetTotalCountOfSubblocksProcessed() / 2)
+  if (IsCompressionOfDocumentChanged(this->GetStatistics().GetCountOfSubblocksDecompressed(),
+                                     this->GetStatistics().GetTotalCountOfSubblocksProcessed()))
   {
     auto metadata_src = metadata_segment->CreateMetaFromMetadataSegment();
     const auto metadata_builder = libCZI::CreateMetadataBuilderFromXml(metadata_src->GetXml());
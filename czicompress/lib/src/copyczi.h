@@ -7,13 +7,85 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include "../inc_libCZI.h"
 #include "../include/compressionstrategy.h"
 #include "../include/progressinfo.h"
+#include "../include/sourcerangecopy.h"
+#include "../include/sourcereadahead.h"
+#include "../include/subblockorder.h"
+#include "../include/tracer.h"
 #include "actionwithsubblockstatistics.h"
+#include "bufferpool.h"
+#include "throughputestimator.h"
+#include "zstdcompressor.h"
+
+/// Options controlling how the work of a copy-operation is carried out. Except for the output order,
+/// those options do not influence the result (i.e. the destination document), only the way it is produced.
+struct CopyCziOptions
+{
+  /// The number of worker threads used for processing (i.e. decompressing and compressing) the
+  /// subblocks. If this number is 1, all subblocks are processed on the thread calling 'Run'.
+  /// Otherwise, a pipeline is used - one thread is reading the subblocks, the given number of
+  /// worker threads are processing them, and the thread calling 'Run' is writing them out (in
+  /// the same order as with the single-threaded operation). A value of 0 means that the number
+  /// of hardware threads is used.
+  int number_of_threads{1};
+
+  /// The maximum number of bytes held by subblocks which have been read, but not yet written (i.e.
+  /// the source data, the decoded bitmaps and the compressed data). If this budget is exceeded, reading
+  /// is suspended until enough subblocks have been written. A value of 0 means "no limit". Note that
+  /// (in order to guarantee progress) a subblock is always admitted if no other subblock is in flight,
+  /// so the budget may be exceeded by a single large subblock.
+  std::uint64_t max_bytes_in_flight{0};
+
+  /// The number of subblocks to read ahead on a background thread (so that reading overlaps with
+  /// processing and writing). If 0, no read-ahead is done with single-threaded operation. With
+  /// multi-threaded operation, reading is always done on a separate thread - in this case the
+  /// prefetch depth is added to the number of subblocks allowed to be in flight.
+  std::uint32_t prefetch_depth{0};
+
+  /// The maximum number of bytes held by subblocks which have been read ahead, but which are not yet
+  /// being processed. A value of 0 means "no limit". Note that at least one subblock is always read
+  /// ahead (if read-ahead is enabled), irrespective of its size.
+  std::uint64_t prefetch_max_bytes{0};
+
+  /// The order in which the subblocks of the source document are read.
+  SubBlockReadOrder read_order{SubBlockReadOrder::kDirectory};
+
+  /// The order in which the subblocks are written to the destination document (only relevant if the
+  /// read order is not the directory order). If the source order is to be kept while reading in file
+  /// order, the subblocks are read in file order only within a window of subblocks (of at most the
+  /// maximum number of subblocks in flight, and of at most half of 'max_bytes_in_flight' as estimated from
+  /// the subblock directory), so that the memory needed for reordering stays within the budget - except
+  /// for a single subblock larger than the budget, and except for the data created by processing.
+  SubBlockOutputOrder output_order{SubBlockOutputOrder::kSource};
+
+  /// The buffer pool from which the buffers for the compressed data are allocated. If null, the
+  /// process-wide buffer pool is used.
+  std::shared_ptr<BufferPool> buffer_pool;
+
+  /// The stream from which the source document is read - this is needed (together with 'source_range_copy') for
+  /// locating the data of the subblocks in the source file.
+  std::shared_ptr<libCZI::IStream> source_stream;
+
+  /// If given (together with 'source_stream'), the data of the subblocks which are copied verbatim is announced to
+  /// this object (which is the stream of the destination file), so that it can be copied directly from the source
+  /// file instead of being written from memory.
+  std::shared_ptr<ISourceRangeCopy> source_range_copy;
+
+  /// If given, the file positions of the subblocks are announced to this object (which is the stream of the source
+  /// file) in the order in which they are going to be read, so that it can fetch them ahead of their use.
+  std::shared_ptr<ISourceReadAhead> source_read_ahead;
+
+  /// If given, the begin and the end of reading, processing and writing each subblock are recorded with this tracer
+  /// (on each of the threads taking part in the operation).
+  std::shared_ptr<Tracer> tracer;
+};
 
 /// This abstract base class is implementing the following functionality:
 /// - We run through all subblocks of the source document.
@@ -24,6 +96,10 @@
 /// class.
 /// - After we are done with the subblocks, we then copy the attachments and
 /// metadata segment.
+/// Note that - depending on the options - 'DecideWhatToDoWithSubBlock' and 'CompressSubBlock'
+/// may be called concurrently from multiple threads, so implementations must be thread-safe.
+/// Writing to the destination document, the statistics and the progress reporting are
+/// always done on the thread calling 'Run'.
 class CopyCziBase
 {
 public:
@@ -31,8 +107,9 @@ public:
   /// @param reader The reader used for reading.
   /// @param writer The writer used for writing.
   /// @param progress_report The progress reporting function.
+  /// @param options The options controlling how the operation is carried out.
   CopyCziBase(std::shared_ptr<libCZI::ICZIReader> reader, std::shared_ptr<libCZI::ICziWriter> writer,
-              std::function<bool(const ProgressInfo&)> progress_report);
+              std::function<bool(const ProgressInfo&)> progress_report, const CopyCziOptions& options = CopyCziOptions());
 
   virtual ~CopyCziBase() = default;
 
@@ -46,19 +123,42 @@ public:
   /// was aborted.
   bool Run();
 
-protected:
-  /// Gets the statistics object.
+  /// Determines from the subblock directory (i.e. without reading any subblock) whether all subblocks would be copied
+  /// verbatim by 'Run' - in which case the operation would not change the image data of the document. Note that
+  /// this is a conservative check, i.e. it may return false even if all subblocks turn out to be copied verbatim -
+  /// and it returns false for a document with less than two subblocks, whose metadata is modified in any case.
+  ///
+  /// \returns True if all subblocks would be copied verbatim; false otherwise.
+  bool AreAllSubBlocksCopiedVerbatim() const;
+
+  /// Estimates the size of the destination document from the subblock directory, the attachment directory and the
+  /// metadata of the source document (i.e. without reading any subblock). The size of subblocks copied verbatim is
+  /// taken from the source document (as far as it can be determined from the positions of the subblocks), and the size
+  /// of the other subblocks is estimated from the size of their pixel data. Note that the size of attachments is not
+  /// known, so it is only included if the attachments are placed between subblocks in the source document.
+  ///
+  /// \returns The estimated size of the destination document in bytes.
+  std::uint64_t EstimateSizeOfDestinationDocument() const;
+
+  /// Gets the statistics object. Note that the statistics is complete only after 'Run' has returned.
   ///
   /// \returns The statistics object.
   const ActionWithSubBlockStatistics& GetStatistics() const;
 
+protected:
   /// Values that represent the action to be taken with a subblock.
   enum class ActionWithSubBlock
   {
-    kCopy,        ///< The subblock is to be copied verbatim.
-    kDecompress,  ///< The subblock is to be decompressed and then written.
-    kCompress,    ///< The subblock is to be compressed (and, if necessary,
-                  ///< decompressed before) and then written.
+    kCopy,                   ///< The subblock is to be copied verbatim.
+    kDecompress,             ///< The subblock is to be decompressed and then written.
+    kCompress,               ///< The subblock is to be compressed (and, if necessary,
+                             ///< decompressed before) and then written.
+    kCopyAlreadyCompressed,  ///< The subblock is already compressed as requested, so it is
+                             ///< copied verbatim (but counted separately in the statistics).
+    kKeepOriginal,           ///< The subblock was compressed, but the compressed data is not smaller
+                             ///< than the original data, so the subblock is copied verbatim (this is
+                             ///< only the result of processing, it is not returned by
+                             ///< 'DecideWhatToDoWithSubBlock').
   };
 
   /// This method is called for each subblock, and it is to be determined which
@@ -70,6 +170,29 @@ protected:
   /// \returns    An enum specifying the action to take place with the subblock.
   virtual ActionWithSubBlock DecideWhatToDoWithSubBlock(const std::shared_ptr<libCZI::ISubBlock>& subblock) = 0;
 
+  /// Determines whether a subblock with the specified compression mode (as given by the subblock directory) is
+  /// certainly copied verbatim with the action "Copy" - i.e. irrespective of its data. This must be consistent with
+  /// 'DecideWhatToDoWithSubBlock', and the base class implementation returns false.
+  ///
+  /// \param  compression_mode    The compression mode of the subblock.
+  ///
+  /// \returns True if a subblock with this compression mode is certainly copied verbatim; false otherwise.
+  virtual bool IsCopiedVerbatimWithCompressionMode(libCZI::CompressionMode compression_mode) const;
+
+  /// Gets the expected ratio of the size of the data of a processed (i.e. not verbatim copied) subblock to the size of
+  /// its uncompressed pixel data. This is used for estimating the size of the destination document, and the base class
+  /// implementation returns 1 (i.e. the data is expected to be uncompressed).
+  ///
+  /// \returns The expected size ratio of processed subblocks.
+  virtual double GetExpectedSizeRatioOfProcessedSubBlocks() const;
+
+  /// Determines whether subblocks with the specified compression mode can be decoded (and thus compressed).
+  ///
+  /// \param  compression_mode    The compression mode.
+  ///
+  /// \returns True if subblocks with this compression mode can be decoded; false otherwise.
+  static bool IsCompressionModeSupportedForDecoding(libCZI::CompressionMode compression_mode);
+
   /// In case the action is "Compress", then this method is called to compress
   /// the subblock. This method is only called for the action "Compress", and
   /// the base class implementation throws an exception.
@@ -82,6 +205,13 @@ protected:
   virtual std::tuple<libCZI::CompressionMode, std::shared_ptr<libCZI::IMemoryBlock>> CompressSubBlock(
       const std::shared_ptr<libCZI::ISubBlock>& subblock);
 
+  /// Gets a boolean indicating whether the original data of a subblock is to be kept (i.e. the subblock is to be
+  /// copied verbatim) if the compressed data is not smaller than the original data. The base class implementation
+  /// returns false, i.e. the compressed data is always used.
+  ///
+  /// \returns   True if the original data is to be kept if compressing does not make it smaller; false otherwise.
+  virtual bool IsOriginalKeptIfNotSmaller() const;
+
   /// This method is called when the metadata-segment is being process. It allows to
   /// alter the XML and do modifications.
   /// If no modification is needed (and the data from the source metadata-segment) is to be
@@ -96,7 +226,41 @@ protected:
   ///          metadata to be written to the destination document.
   virtual std::shared_ptr<libCZI::ICziMetadataBuilder> ModifyMetadata(const std::shared_ptr<libCZI::IMetadataSegment>& metadata_segment);
 
+  /// Gets the buffer pool to be used for the buffers allocated while processing the subblocks.
+  ///
+  /// \returns The buffer pool.
+  const std::shared_ptr<BufferPool>& GetBufferPool() const { return this->buffer_pool_; }
+
 private:
+  /// The result of processing a subblock (i.e. the CPU-bound part of the operation), which is
+  /// then handed over to the writing stage.
+  struct ProcessedSubBlock
+  {
+    /// The source subblock.
+    std::shared_ptr<libCZI::ISubBlock> subblock;
+
+    /// The index of the source subblock in the source document.
+    int subblock_index{-1};
+
+    /// What is to be written - a verbatim copy of the subblock, the decoded bitmap or the compressed data.
+    ActionWithSubBlock action{ActionWithSubBlock::kCopy};
+
+    /// (only valid for action "Decompress") The decoded bitmap.
+    std::shared_ptr<libCZI::IBitmapData> bitmap;
+
+    /// (only valid for action "Compress") The compression mode of the compressed data.
+    libCZI::CompressionMode compression_mode{libCZI::CompressionMode::Invalid};
+
+    /// (only valid for action "Compress") The compressed data.
+    std::shared_ptr<libCZI::IMemoryBlock> compressed_data;
+
+    /// Gets the number of bytes held by this object in addition to the source subblock, i.e. the size of
+    /// the decoded bitmap or of the compressed data.
+    ///
+    /// \returns The number of bytes held in addition to the source subblock.
+    std::uint64_t GetSizeOfProcessedData() const;
+  };
+
   /// This object is used to keep a statistics about the operations done with the subblocks.
   ActionWithSubBlockStatistics action_count;
 
@@ -113,17 +277,170 @@ private:
   static void SetPositionCoordinatePixelType(const std::shared_ptr<libCZI::ISubBlock>& subblock,
                                              libCZI::AddSubBlockInfoBase& add_subblock_info_target);
 
-  void ProcessAndWriteSubBlock(const std::shared_ptr<libCZI::ISubBlock>& subblock);
+  /// Determine the number of worker threads to use - i.e. resolve the value 0 ("use the number
+  /// of hardware threads") and sanitize the value given with the options.
+  ///
+  /// \param  number_of_threads   The number of threads as given with the options.
+  ///
+  /// \returns    The number of worker threads to use (which is at least 1).
+  static int DetermineNumberOfWorkerThreads(int number_of_threads);
+
+  /// An item of the list of subblocks to be processed.
+  struct SubBlockWorkItem
+  {
+    /// The index of the subblock in the source document.
+    int subblock_index{0};
+
+    /// The position at which the subblock is to be written, i.e. the subblock is the n-th subblock
+    /// written to the destination document.
+    std::uint64_t output_position{0};
+
+    /// If the subblock is the first one of a window (i.e. of consecutive subblocks which are admitted to the
+    /// pipeline as a whole), the number of subblocks in the window; 0 otherwise.
+    std::uint64_t window_size{0};
+
+    /// (only valid if 'window_size' is non-zero) The estimated number of bytes held by the subblocks of the window
+    /// once they are read - i.e. the sum of the sizes of their segments in the source file.
+    std::uint64_t window_estimated_bytes{0};
+  };
+
+  /// Gets the maximum number of subblocks in flight (i.e. read but not yet written) for the given number of
+  /// worker threads. This is also the maximum size of the window within which subblocks are reordered.
+  ///
+  /// \param  number_of_worker_threads    The number of worker threads.
+  ///
+  /// \returns    The maximum number of subblocks in flight.
+  std::uint64_t GetMaxNumberOfSubBlocksInFlight(int number_of_worker_threads) const;
+
+  /// Gets a boolean indicating whether the order in which the subblocks are read differs from the order in which
+  /// they are written - in which case the subblocks have to be reordered before writing.
+  ///
+  /// \returns   True if reordering is required; false otherwise.
+  bool IsReorderingRequired() const;
+
+  /// Creates the list of subblocks to be processed, in the order in which they are to be read. If reading in file
+  /// order but writing in source order, the subblocks are sorted by their file position only within windows of
+  /// consecutive subblocks (in source order). A window has at most the given number of subblocks, and (if the number
+  /// of bytes in flight is limited) the sizes of its subblocks in the source file add up to at most half of the
+  /// limit, so that two windows fit into the budget. Otherwise, each subblock is a window of its own.
+  ///
+  /// \param  reorder_window  The maximum number of subblocks in a window within which subblocks are reordered (only
+  ///                         used if reordering is required).
+  ///
+  /// \returns The list of subblocks to be processed.
+  std::vector<SubBlockWorkItem> CreateWorkList(std::uint64_t reorder_window);
+
+  /// The estimated sizes of a subblock, as determined from the subblock directory.
+  struct SubBlockSizeEstimate
+  {
+    /// The index of the subblock in the source document.
+    int subblock_index{0};
+
+    /// The position of the subblock segment in the source file.
+    std::uint64_t file_position{0};
+
+    /// Whether the subblock is certainly copied verbatim (see 'IsCopiedVerbatimWithCompressionMode').
+    bool copied_verbatim{false};
+
+    /// The size of the subblock segment in the source file - this is the distance to the next subblock segment
+    /// (except for the last one, for which it is estimated from the size of its pixel data).
+    std::uint64_t source_size{0};
+
+    /// The estimated size of the subblock segment in the destination file.
+    std::uint64_t estimated_size{0};
+  };
+
+  /// Estimates the sizes of all subblocks in the source file and in the destination file from the subblock directory.
+  ///
+  /// \returns The size estimates, sorted by the file position of the subblocks.
+  std::vector<SubBlockSizeEstimate> EstimateSizesOfSubBlocks() const;
+
+  /// Initializes the byte counts of the progress information (i.e. the totals for the input and the output) from the
+  /// subblock directory, and resets the throughput estimate.
+  ///
+  /// \param [in,out] progress_info   The progress information.
+  void InitializeByteProgress(ProgressInfo& progress_info);
+
+  /// Updates the progress information after the specified subblock has been written - i.e. the number of items and
+  /// bytes done, the throughput and the estimated remaining time.
+  ///
+  /// \param          subblock_index  The index of the subblock in the source document.
+  /// \param [in,out] progress_info   The progress information.
+  void AddSubBlockToProgress(int subblock_index, ProgressInfo& progress_info);
+
+  /// Gets the size of the segment of the specified subblock in the source file (see 'SubBlockSizeEstimate') - this is
+  /// only available after 'InitializeByteProgress' has been called.
+  ///
+  /// \param  subblock_index  The index of the subblock in the source document.
+  ///
+  /// \returns The size of the subblock segment in the source file; or 0 if it is not known.
+  std::uint64_t GetSourceSizeOfSubBlock(int subblock_index) const;
+
+  bool CopySubBlocksSingleThreaded(ProgressInfo& progress_info, const std::vector<SubBlockWorkItem>& work_list);
+  bool CopySubBlocksMultiThreaded(ProgressInfo& progress_info, const std::vector<SubBlockWorkItem>& work_list,
+                                  int number_of_worker_threads);
+  bool ProcessAndWriteSubBlockAndReportProgress(int subblock_index, const std::shared_ptr<libCZI::ISubBlock>& subblock,
+                                                ProgressInfo& progress_info, TraceBuffer* trace_buffer);
+
+  /// Creates the buffer for recording the events of the calling thread, if tracing is enabled.
+  ///
+  /// \param  thread_name The name of the thread (as shown in the trace viewer).
+  ///
+  /// \returns The buffer for the events of the thread; or null if tracing is disabled.
+  TraceBuffer* AddTraceThread(const std::string& thread_name) const;
+
+  /// Process the subblock - i.e. decide what to do with it, and do the CPU-bound part of this
+  /// action (decoding and compressing). This method may be called concurrently from multiple
+  /// threads, it must not modify the state of this object.
+  ///
+  /// \param  subblock    The source subblock.
+  ///
+  /// \returns    The processed subblock, ready to be passed to 'WriteProcessedSubBlock'.
+  ProcessedSubBlock ProcessSubBlock(const std::shared_ptr<libCZI::ISubBlock>& subblock);
+  ProcessedSubBlock DecompressSubBlock(const std::shared_ptr<libCZI::ISubBlock>& subblock);
+  ProcessedSubBlock CompressSubBlockIfPossible(const std::shared_ptr<libCZI::ISubBlock>& subblock);
+
+  /// Write the processed subblock to the destination document, and update the statistics. This
+  /// method is only to be called from the thread executing 'Run'.
+  ///
+  /// \param  processed_subblock  The processed subblock.
+  void WriteProcessedSubBlock(const ProcessedSubBlock& processed_subblock);
   void WriteAttachment(const std::shared_ptr<libCZI::IAttachment>& attachment);
   void WriteMetadataSegment(const std::shared_ptr<libCZI::IMetadataSegment>& metadata_segment);
 
-  void WriteSubblockVerbatim(const std::shared_ptr<libCZI::ISubBlock>& subblock);
-  void DecompressAndWriteSubBlock(const std::shared_ptr<libCZI::ISubBlock>& subblock);
-  void CompressAndWriteSubBlock(const std::shared_ptr<libCZI::ISubBlock>& subblock);
+  /// Write the subblock verbatim to the destination document. Note that only the byte statistics is updated (and not
+  /// the count of the action).
+  ///
+  /// \param  subblock        The subblock.
+  /// \param  subblock_index  The index of the subblock in the source document.
+  /// \param  action          The action (one of the verbatim copies) under which the bytes are recorded.
+  void WriteSubblockVerbatim(const std::shared_ptr<libCZI::ISubBlock>& subblock, int subblock_index, SubBlockAction action);
+
+  /// If copying ranges of the source file is enabled, announce to the destination stream that the specified data of
+  /// a subblock (which is about to be passed to the writer) can be copied from the source file.
+  ///
+  /// \param  subblock_index  The index of the subblock in the source document.
+  /// \param  data            The data of the subblock.
+  /// \param  size            The size of the data in bytes.
+  void AnnounceSourceRangeOfSubBlockData(int subblock_index, const void* data, size_t size);
+  void WriteDecompressedSubBlock(const ProcessedSubBlock& processed_subblock);
+  void WriteCompressedSubBlock(const ProcessedSubBlock& processed_subblock);
 
   std::shared_ptr<libCZI::ICZIReader> reader_;
   std::shared_ptr<libCZI::ICziWriter> writer_;
   std::function<bool(const ProgressInfo&)> progress_report_;
+  CopyCziOptions options_;
+  std::shared_ptr<BufferPool> buffer_pool_;
+
+  /// (only used if copying ranges of the source file or reading ahead is enabled) The file positions of the subblock
+  /// segments of the source document, indexed by the subblock index.
+  std::vector<std::uint64_t> subblock_file_positions_;
+
+  /// The sizes of the subblock segments in the source file (see 'SubBlockSizeEstimate'), indexed by the subblock index.
+  std::vector<std::uint64_t> subblock_source_sizes_;
+
+  /// The estimate of the throughput of reading the source document (while processing the subblocks).
+  ThroughputEstimator throughput_estimator_;
 };
 
 /// Implementation of the "copy operation" which compresses the output The
@@ -134,11 +451,14 @@ private:
   CompressionStrategy strategy_{CompressionStrategy::kInvalid};
   libCZI::Utils::CompressionOption compression_option_;
 
+  /// The compressors (i.e. zstd compression contexts and scratch buffers) are reused for all subblocks.
+  ZstdCompressorPool compressor_pool_{this->GetBufferPool()};
+
 public:
   CopyCziAndCompress(std::shared_ptr<libCZI::ICZIReader> reader, std::shared_ptr<libCZI::ICziWriter> writer,
                      std::function<bool(const ProgressInfo&)> progress_report, CompressionStrategy strategy,
-                     libCZI::Utils::CompressionOption compression_option)
-      : CopyCziBase(std::move(reader), std::move(writer), progress_report),
+                     libCZI::Utils::CompressionOption compression_option, const CopyCziOptions& options = CopyCziOptions())
+      : CopyCziBase(std::move(reader), std::move(writer), std::move(progress_report), options),
         strategy_(strategy),
         compression_option_(std::move(compression_option))
   {
@@ -146,9 +466,22 @@ public:
 
 protected:
   ActionWithSubBlock DecideWhatToDoWithSubBlock(const std::shared_ptr<libCZI::ISubBlock>& subblock) override;
+  bool IsCopiedVerbatimWithCompressionMode(libCZI::CompressionMode compression_mode) const override;
+  double GetExpectedSizeRatioOfProcessedSubBlocks() const override;
   std::shared_ptr<libCZI::ICziMetadataBuilder> ModifyMetadata(const std::shared_ptr<libCZI::IMetadataSegment>& metadata_segment) override;
   std::tuple<libCZI::CompressionMode, std::shared_ptr<libCZI::IMemoryBlock>> CompressSubBlock(
       const std::shared_ptr<libCZI::ISubBlock>& subblock) override;
+  bool IsOriginalKeptIfNotSmaller() const override;
+
+private:
+  /// Determines whether the subblock is already compressed with the requested compression mode and parameters (as far
+  /// as this can be determined from the compressed data - the compression level cannot), so that compressing it again
+  /// would give the same result.
+  ///
+  /// \param  subblock    The subblock.
+  ///
+  /// \returns    True if the subblock is already compressed as requested; false otherwise.
+  bool IsAlreadyCompressedAsRequested(const std::shared_ptr<libCZI::ISubBlock>& subblock) const;
 };
 
 /// Implementation of the "copy operation" which decompresses the output.
@@ -156,12 +489,13 @@ class CopyCziAndDecompress : public CopyCziBase
 {
 public:
   CopyCziAndDecompress(std::shared_ptr<libCZI::ICZIReader> reader, std::shared_ptr<libCZI::ICziWriter> writer,
-                       std::function<bool(const ProgressInfo&)> progress_report)
-      : CopyCziBase(std::move(reader), std::move(writer), std::move(progress_report))
+                       std::function<bool(const ProgressInfo&)> progress_report, const CopyCziOptions& options = CopyCziOptions())
+      : CopyCziBase(std::move(reader), std::move(writer), std::move(progress_report), options)
   {
   }
 
 protected:
   ActionWithSubBlock DecideWhatToDoWithSubBlock(const std::shared_ptr<libCZI::ISubBlock>& subblock) override;
+  bool IsCopiedVerbatimWithCompressionMode(libCZI::CompressionMode compression_mode) const override;
   std::shared_ptr<libCZI::ICziMetadataBuilder> ModifyMetadata(const std::shared_ptr<libCZI::IMetadataSegment>& metadata_segment) override;
 };
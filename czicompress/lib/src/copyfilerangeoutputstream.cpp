@@ -0,0 +1,154 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "copyfilerangeoutputstream.h"
+
+#include <CZICompress_Config.h>
+
+#if CZICOMPRESS_UNIX_ENVIRONMENT
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// Determines whether the error reported by 'copy_file_range' means that the operation is not possible for the
+/// files in question (as opposed to an I/O error) - in which case the data is to be written from memory instead.
+bool IsCopyFileRangeNotPossible(int error_number)
+{
+  return error_number == EXDEV || error_number == ENOSYS || error_number == EOPNOTSUPP || error_number == EINVAL ||
+         error_number == EBADF || error_number == EPERM || error_number == ETXTBSY;
+}
+
+}  // namespace
+
+CopyFileRangeOutputStream::CopyFileRangeOutputStream(const std::string& file_name, bool overwrite_existing_file,
+                                                     const std::string& source_file_name, std::uint64_t preallocation_size)
+    : PosixFileOutputStream(file_name, overwrite_existing_file, preallocation_size)
+{
+  this->source_file_descriptor_ = open(source_file_name.c_str(), O_RDONLY | O_CLOEXEC);  // NOLINT: vararg function
+  if (this->source_file_descriptor_ < 0)
+  {
+    // the destination file has just been created, and we do not leave it behind
+    const int error_number = errno;
+    unlink(file_name.c_str());
+    throw std::runtime_error(GetErrorText("open", source_file_name, error_number));
+  }
+}
+
+CopyFileRangeOutputStream::~CopyFileRangeOutputStream() { this->CloseSourceFile(); }
+
+void CopyFileRangeOutputStream::Write(std::uint64_t offset, const void* data, std::uint64_t size, std::uint64_t* ptr_bytes_written)
+{
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  if (this->file_descriptor_ < 0)
+  {
+    throw std::logic_error("The stream has already been closed.");
+  }
+
+  // the CZI-writer writes the segment header (and the metadata) of the subblock before its data, so the announcement
+  //  is kept until the data is written
+  const bool is_announced = size > 0 && data == this->announced_data_ && size == this->announced_size_;
+  const std::uint64_t source_offset = this->announced_source_offset_;
+  if (is_announced)
+  {
+    this->announced_data_ = nullptr;
+    this->announced_size_ = 0;
+  }
+
+  std::uint64_t size_copied = 0;
+  if (is_announced && this->copy_file_range_possible_)
+  {
+    size_copied = this->CopySourceRange(source_offset, offset, size);
+    this->number_of_bytes_copied_from_source_ += size_copied;
+    this->RecordEndOfDataWritten(offset + size_copied);
+  }
+
+  // whatever could not be copied from the source file is written from memory
+  this->WriteFromMemory(offset + size_copied, static_cast<const std::uint8_t*>(data) + size_copied,  // NOLINT: pointer arithmetic
+                        size - size_copied);
+  if (ptr_bytes_written != nullptr)
+  {
+    *ptr_bytes_written = size;
+  }
+}
+
+void CopyFileRangeOutputStream::AnnounceSourceRange(const void* data, std::uint64_t size, std::uint64_t source_offset)
+{
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  this->announced_data_ = data;
+  this->announced_size_ = size;
+  this->announced_source_offset_ = source_offset;
+}
+
+std::uint64_t CopyFileRangeOutputStream::GetNumberOfBytesCopiedFromSource() const { return this->number_of_bytes_copied_from_source_; }
+
+void CopyFileRangeOutputStream::Close()
+{
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  this->CloseSourceFile();
+  this->CloseFile();
+}
+
+void CopyFileRangeOutputStream::CloseSourceFile()
+{
+  if (this->source_file_descriptor_ >= 0)
+  {
+    close(this->source_file_descriptor_);
+    this->source_file_descriptor_ = -1;
+  }
+}
+
+std::uint64_t CopyFileRangeOutputStream::CopySourceRange(std::uint64_t source_offset, std::uint64_t offset, std::uint64_t size)
+{
+#if defined(__linux__)
+  std::uint64_t size_copied = 0;
+  while (size_copied < size)
+  {
+    auto source_position = static_cast<off_t>(source_offset + size_copied);
+    auto destination_position = static_cast<off_t>(offset + size_copied);
+    const auto size_to_copy =
+        static_cast<size_t>((std::min)(size - size_copied, static_cast<std::uint64_t>((std::numeric_limits<ssize_t>::max)())));
+    const ssize_t result =
+        copy_file_range(this->source_file_descriptor_, &source_position, this->file_descriptor_, &destination_position, size_to_copy, 0);
+    if (result < 0)
+    {
+      const int error_number = errno;
+      if (error_number == EINTR)
+      {
+        continue;
+      }
+
+      if (IsCopyFileRangeNotPossible(error_number))
+      {
+        this->copy_file_range_possible_ = false;
+        break;
+      }
+
+      throw std::runtime_error(GetErrorText("copy_file_range", this->file_name_, error_number));
+    }
+
+    if (result == 0)
+    {
+      // the source file is shorter than expected - the remaining data is written from memory
+      break;
+    }
+
+    size_copied += static_cast<std::uint64_t>(result);
+  }
+
+  return size_copied;
+#else
+  this->copy_file_range_possible_ = false;
+  return 0;
+#endif
+}
+
+#endif  // CZICOMPRESS_UNIX_ENVIRONMENT
@@ -0,0 +1,66 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "../include/sourcerangecopy.h"
+#include "posixfileoutputstream.h"
+
+/// Implementation of libCZI::IOutputStream (for POSIX systems) which writes to a file, and which is able to copy
+/// announced ranges of a source file into the destination file with 'copy_file_range' - so that the kernel copies
+/// the data (or shares the extents on file systems supporting reflinks, like XFS and btrfs, or copies it on the
+/// server with NFS 4.2) instead of writing it from the memory of the process.
+/// If 'copy_file_range' is not available or not possible for the two files (e.g. if they are on different file
+/// systems), the data is written from memory, and no further attempts to use 'copy_file_range' are made.
+class CopyFileRangeOutputStream : public PosixFileOutputStream, public ISourceRangeCopy
+{
+private:
+  int source_file_descriptor_{-1};
+
+  const void* announced_data_{nullptr};  ///< The announcement is protected by the mutex of the base class.
+  std::uint64_t announced_size_{0};
+  std::uint64_t announced_source_offset_{0};
+  bool copy_file_range_possible_{true};
+  std::atomic<std::uint64_t> number_of_bytes_copied_from_source_{0};
+
+public:
+  /// Constructor - the destination file is created and the source file is opened, an exception is thrown if this fails.
+  ///
+  /// \param  file_name                   The UTF8-encoded filename of the file to create.
+  /// \param  overwrite_existing_file     If true, an existing file is overwritten; otherwise it is an error if the file exists.
+  /// \param  source_file_name            The UTF8-encoded filename of the source file, from which ranges are to be copied.
+  /// \param  preallocation_size          The number of bytes to allocate for the file up front - 0 means no preallocation.
+  CopyFileRangeOutputStream(const std::string& file_name, bool overwrite_existing_file, const std::string& source_file_name,
+                            std::uint64_t preallocation_size = 0);
+  ~CopyFileRangeOutputStream() override;
+
+  CopyFileRangeOutputStream(const CopyFileRangeOutputStream&) = delete;
+  CopyFileRangeOutputStream& operator=(const CopyFileRangeOutputStream&) = delete;
+
+  void Write(std::uint64_t offset, const void* data, std::uint64_t size, std::uint64_t* ptr_bytes_written) override;
+
+  void AnnounceSourceRange(const void* data, std::uint64_t size, std::uint64_t source_offset) override;
+  std::uint64_t GetNumberOfBytesCopiedFromSource() const override;
+
+  /// Closes the files. If closing the destination file fails (which may be the first time a write error is reported,
+  /// e.g. with network file systems), an exception is thrown. After this, the stream cannot be written to anymore.
+  void Close() override;
+
+private:
+  /// Copies the specified range of the source file to the specified offset of the destination file with
+  /// 'copy_file_range', as far as this is possible.
+  ///
+  /// \param  source_offset   The offset in the source file.
+  /// \param  offset          The offset in the destination file.
+  /// \param  size            The number of bytes to copy.
+  ///
+  /// \returns The number of bytes which have been copied - the remaining bytes need to be written from memory.
+  std::uint64_t CopySourceRange(std::uint64_t source_offset, std::uint64_t offset, std::uint64_t size);
+
+  void CloseSourceFile();
+};
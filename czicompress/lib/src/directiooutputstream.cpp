@@ -0,0 +1,224 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "directiooutputstream.h"
+
+#include <CZICompress_Config.h>
+
+#if CZICOMPRESS_UNIX_ENVIRONMENT
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+constexpr std::uint64_t AlignDown(std::uint64_t value) { return value - value % DirectIoOutputStream::kAlignment; }
+
+constexpr std::uint64_t AlignUp(std::uint64_t value) { return AlignDown(value + DirectIoOutputStream::kAlignment - 1); }
+
+}  // namespace
+
+DirectIoOutputStream::DirectIoOutputStream(const std::string& file_name, bool overwrite_existing_file, std::uint64_t preallocation_size,
+                                           size_t staging_buffer_size)
+    : PosixFileOutputStream(file_name, overwrite_existing_file, preallocation_size, true),
+      staging_buffer_size_(static_cast<size_t>(AlignUp((std::max)(staging_buffer_size, kAlignment))))
+{
+  this->staging_buffer_ = DirectIoOutputStream::AllocateAlignedBuffer(this->staging_buffer_size_);
+  this->block_buffer_ = DirectIoOutputStream::AllocateAlignedBuffer(kAlignment);
+}
+
+DirectIoOutputStream::~DirectIoOutputStream()
+{
+  try
+  {
+    this->Close();
+  }
+  catch (...)
+  {
+    // there is no way to report an error here - 'Close' should have been called before
+  }
+}
+
+void DirectIoOutputStream::Write(std::uint64_t offset, const void* data, std::uint64_t size, std::uint64_t* ptr_bytes_written)
+{
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  if (this->file_descriptor_ < 0)
+  {
+    throw std::logic_error("The stream has already been closed.");
+  }
+
+  this->RecordEndOfDataWritten(offset + size);
+  const auto* source = static_cast<const std::uint8_t*>(data);
+  std::uint64_t size_remaining = size;
+  while (size_remaining > 0)
+  {
+    // if the data does not continue (or overwrite) the data in the staging buffer, we start over with a new one
+    if (!this->is_staging_buffer_in_use_ || offset < this->staging_buffer_offset_ ||
+        offset > this->staging_buffer_offset_ + this->staging_buffer_fill_)
+    {
+      this->FlushStagingBuffer();
+      this->StartStagingBuffer(offset);
+    }
+
+    const auto position_in_buffer = static_cast<size_t>(offset - this->staging_buffer_offset_);
+    const auto size_to_copy =
+        static_cast<size_t>((std::min)(size_remaining, static_cast<std::uint64_t>(this->staging_buffer_size_ - position_in_buffer)));
+    memcpy(this->staging_buffer_.get() + position_in_buffer, source, size_to_copy);  // NOLINT: pointer arithmetic
+    this->staging_buffer_fill_ = (std::max)(this->staging_buffer_fill_, position_in_buffer + size_to_copy);
+    source += size_to_copy;  // NOLINT: pointer arithmetic
+    offset += size_to_copy;
+    size_remaining -= size_to_copy;
+
+    if (this->staging_buffer_fill_ == this->staging_buffer_size_)
+    {
+      this->FlushStagingBuffer();
+    }
+  }
+
+  if (ptr_bytes_written != nullptr)
+  {
+    *ptr_bytes_written = size;
+  }
+}
+
+void DirectIoOutputStream::Close()
+{
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  if (this->file_descriptor_ < 0)
+  {
+    return;
+  }
+
+  try
+  {
+    this->FlushStagingBuffer();
+
+    // the last block has been padded, so the file is (in general) larger than the data written
+    if (this->size_written_to_file_ > this->GetEndOfDataWritten() &&
+        ftruncate(this->file_descriptor_, static_cast<off_t>(this->GetEndOfDataWritten())) != 0)
+    {
+      throw std::runtime_error(PosixFileOutputStream::GetErrorText("ftruncate", this->file_name_, errno));
+    }
+  }
+  catch (...)
+  {
+    this->CloseFile();
+    throw;
+  }
+
+  this->CloseFile();
+}
+
+void DirectIoOutputStream::StartStagingBuffer(std::uint64_t offset)
+{
+  this->staging_buffer_offset_ = AlignDown(offset);
+  this->staging_buffer_fill_ = static_cast<size_t>(offset - this->staging_buffer_offset_);
+  if (this->staging_buffer_fill_ > 0)
+  {
+    // the data in front of the offset (within the block) must be preserved
+    this->ReadBlock(this->staging_buffer_offset_, this->staging_buffer_.get());
+  }
+
+  this->is_staging_buffer_in_use_ = true;
+}
+
+void DirectIoOutputStream::FlushStagingBuffer()
+{
+  if (!this->is_staging_buffer_in_use_)
+  {
+    return;
+  }
+
+  const auto size_to_write = static_cast<size_t>(AlignUp(this->staging_buffer_fill_));
+  if (size_to_write > this->staging_buffer_fill_)
+  {
+    // the data behind the data in the staging buffer (within the last block) must be preserved
+    const std::uint64_t offset_of_last_block = this->staging_buffer_offset_ + size_to_write - kAlignment;
+    this->ReadBlock(offset_of_last_block, this->block_buffer_.get());
+    const auto position_in_block = static_cast<size_t>(this->staging_buffer_offset_ + this->staging_buffer_fill_ - offset_of_last_block);
+    memcpy(this->staging_buffer_.get() + this->staging_buffer_fill_, this->block_buffer_.get() + position_in_block,  // NOLINT
+           kAlignment - position_in_block);
+  }
+
+  this->WriteAligned(this->staging_buffer_offset_, this->staging_buffer_.get(), size_to_write);
+  this->size_written_to_file_ = (std::max)(this->size_written_to_file_, this->staging_buffer_offset_ + size_to_write);
+  this->is_staging_buffer_in_use_ = false;
+  this->staging_buffer_fill_ = 0;
+}
+
+void DirectIoOutputStream::ReadBlock(std::uint64_t offset, std::uint8_t* destination)
+{
+  size_t size_read = 0;
+  if (offset < this->size_written_to_file_)
+  {
+    while (size_read < kAlignment)
+    {
+      const ssize_t result = pread(this->file_descriptor_, destination + size_read,  // NOLINT: pointer arithmetic
+                                   kAlignment - size_read, static_cast<off_t>(offset + size_read));
+      if (result < 0)
+      {
+        const int error_number = errno;
+        if (error_number == EINTR)
+        {
+          continue;
+        }
+
+        throw std::runtime_error(PosixFileOutputStream::GetErrorText("pread", this->file_name_, error_number));
+      }
+
+      if (result == 0)
+      {
+        break;
+      }
+
+      size_read += static_cast<size_t>(result);
+    }
+  }
+
+  // whatever is beyond the end of the file is zero
+  memset(destination + size_read, 0, kAlignment - size_read);  // NOLINT: pointer arithmetic
+}
+
+void DirectIoOutputStream::WriteAligned(std::uint64_t offset, const std::uint8_t* data, size_t size)
+{
+  while (size > 0)
+  {
+    const auto size_to_write = (std::min)(size, static_cast<size_t>(AlignDown((std::numeric_limits<ssize_t>::max)())));
+    const ssize_t result = pwrite(this->file_descriptor_, data, size_to_write, static_cast<off_t>(offset));
+    if (result < 0)
+    {
+      const int error_number = errno;
+      if (error_number == EINTR)
+      {
+        continue;
+      }
+
+      throw std::runtime_error(PosixFileOutputStream::GetErrorText("pwrite", this->file_name_, error_number));
+    }
+
+    data += result;  // NOLINT: pointer arithmetic
+    offset += static_cast<std::uint64_t>(result);
+    size -= static_cast<size_t>(result);
+  }
+}
+
+/*static*/ std::unique_ptr<std::uint8_t, DirectIoOutputStream::FreeDeleter> DirectIoOutputStream::AllocateAlignedBuffer(size_t size)
+{
+  void* pointer = nullptr;
+  if (posix_memalign(&pointer, kAlignment, size) != 0)
+  {
+    throw std::bad_alloc();
+  }
+
+  return std::unique_ptr<std::uint8_t, FreeDeleter>(static_cast<std::uint8_t*>(pointer));
+}
+
+#endif  // CZICOMPRESS_UNIX_ENVIRONMENT
@@ -0,0 +1,73 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "posixfileoutputstream.h"
+
+/// Implementation of libCZI::IOutputStream (for POSIX systems) which writes to a file with direct I/O, i.e. bypassing the
+/// page cache - so that writing a large file does not evict the data of other processes from the page cache.
+/// With direct I/O, the file offsets, the sizes and the memory addresses of all write operations must be aligned. So, the
+/// data is collected in an aligned staging buffer, which is written when it is full (or when a write operation does not
+/// continue the data in it, e.g. when the CZI-writer updates the file header). If a write operation does not start or
+/// end at a block boundary, the remaining part of the block is read from the file first. When the stream is closed, the
+/// file is truncated to the size of the data written (since the last block was padded).
+/// If the file system does not support direct I/O, the file is written with buffered I/O (in the same way).
+class DirectIoOutputStream : public PosixFileOutputStream
+{
+public:
+  /// The alignment of the file offsets, sizes and memory addresses - this is the logical block size of practically all
+  /// storage devices (or a multiple of it).
+  static constexpr size_t kAlignment = 4096;
+
+  /// The default size of the staging buffer.
+  static constexpr size_t kDefaultStagingBufferSize = 4 * 1024 * 1024;
+
+private:
+  struct FreeDeleter
+  {
+    void operator()(void* pointer) const { std::free(pointer); }  // NOLINT: memory was allocated with posix_memalign
+  };
+
+  std::unique_ptr<std::uint8_t, FreeDeleter> staging_buffer_;
+  size_t staging_buffer_size_;
+  std::unique_ptr<std::uint8_t, FreeDeleter> block_buffer_;  ///< Buffer for reading a single block from the file.
+
+  bool is_staging_buffer_in_use_{false};
+  std::uint64_t staging_buffer_offset_{0};  ///< The file offset of the data in the staging buffer (a multiple of kAlignment).
+  size_t staging_buffer_fill_{0};           ///< The number of bytes in the staging buffer.
+  std::uint64_t size_written_to_file_{0};   ///< The size of the file, including the padding of the last block.
+
+public:
+  /// Constructor - the file is created, an exception is thrown if this fails.
+  ///
+  /// \param  file_name                   The UTF8-encoded filename of the file to create.
+  /// \param  overwrite_existing_file     If true, an existing file is overwritten; otherwise it is an error if the file exists.
+  /// \param  preallocation_size          The number of bytes to allocate for the file up front - 0 means no preallocation.
+  /// \param  staging_buffer_size         The size of the staging buffer in bytes - it is rounded up to a multiple of kAlignment.
+  DirectIoOutputStream(const std::string& file_name, bool overwrite_existing_file, std::uint64_t preallocation_size,
+                       size_t staging_buffer_size = kDefaultStagingBufferSize);
+  ~DirectIoOutputStream() override;
+
+  DirectIoOutputStream(const DirectIoOutputStream&) = delete;
+  DirectIoOutputStream& operator=(const DirectIoOutputStream&) = delete;
+
+  void Write(std::uint64_t offset, const void* data, std::uint64_t size, std::uint64_t* ptr_bytes_written) override;
+
+  /// Writes the data remaining in the staging buffer, truncates the file to the size of the data written and closes it.
+  /// If this fails, an exception is thrown. After this, the stream cannot be written to anymore.
+  void Close() override;
+
+private:
+  void StartStagingBuffer(std::uint64_t offset);
+  void FlushStagingBuffer();
+  void ReadBlock(std::uint64_t offset, std::uint8_t* destination);
+  void WriteAligned(std::uint64_t offset, const std::uint8_t* data, size_t size);
+  static std::unique_ptr<std::uint8_t, FreeDeleter> AllocateAlignedBuffer(size_t size);
+};
@@ -0,0 +1,330 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "../include/filecopy.h"
+
+#include <CZICompress_Config.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#if CZICOMPRESS_WIN32_ENVIRONMENT
+#include <Windows.h>
+#include <include/utils/errorhandling/winerrorformatting.h>
+#include <include/utils/utf8/utf8converter.h>
+#endif
+
+#if CZICOMPRESS_UNIX_ENVIRONMENT
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <limits>
+#if defined(__linux__)
+#include <linux/fs.h>
+#endif
+#endif
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// Counts the specified number of bytes against the rate limiter (i.e. waits if the rate is exceeded).
+///
+/// \param  rate_limiter    The rate limiter - if null, nothing is done.
+/// \param  number_of_bytes The number of bytes transferred.
+void AcquireFromRateLimiter(const std::shared_ptr<RateLimiter>& rate_limiter, std::uint64_t number_of_bytes)
+{
+  if (rate_limiter && number_of_bytes > 0)
+  {
+    rate_limiter->Acquire(number_of_bytes);
+  }
+}
+
+void ThrowIfSameFile(const std::string& source_file_name, const std::string& destination_file_name)
+{
+  std::error_code error_code;
+  if (std::filesystem::equivalent(std::filesystem::u8path(source_file_name), std::filesystem::u8path(destination_file_name), error_code))
+  {
+    throw std::invalid_argument("The source file and the destination file are the same file.");
+  }
+}
+
+#if CZICOMPRESS_UNIX_ENVIRONMENT
+
+/// The size of the buffer used for copying the data by reading and writing.
+constexpr size_t kSizeOfCopyBuffer = 1024 * 1024;
+
+std::string GetErrorText(const std::string& operation, const std::string& file_name, int error_number)
+{
+  return "Error: " + operation + " failed for file '" + file_name + "': " + std::generic_category().message(error_number);
+}
+
+/// Closes the file descriptor when going out of scope.
+class FileDescriptor
+{
+private:
+  int file_descriptor_;
+
+public:
+  explicit FileDescriptor(int file_descriptor) : file_descriptor_(file_descriptor) {}
+  ~FileDescriptor()
+  {
+    if (this->file_descriptor_ >= 0)
+    {
+      close(this->file_descriptor_);
+    }
+  }
+
+  FileDescriptor(const FileDescriptor&) = delete;
+  FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+  int Get() const { return this->file_descriptor_; }
+
+  /// Closes the file descriptor - for files which have been written to, the result must be checked.
+  ///
+  /// \returns The result of 'close'.
+  int Close()
+  {
+    const int result = close(this->file_descriptor_);
+    this->file_descriptor_ = -1;
+    return result;
+  }
+};
+
+/// Copies the data from the specified offset to the end of the source file with 'copy_file_range'. If a rate limiter
+/// is given, the data is copied in chunks of the size of the copy buffer, and each chunk is counted against the rate
+/// limiters.
+///
+/// \returns The number of bytes copied - this is less than requested if 'copy_file_range' is not possible for the files.
+std::uint64_t CopyWithCopyFileRange(int source_file_descriptor, int destination_file_descriptor, std::uint64_t size,
+                                    const std::string& destination_file_name, const std::shared_ptr<RateLimiter>& read_rate_limiter,
+                                    const std::shared_ptr<RateLimiter>& write_rate_limiter)
+{
+#if defined(__linux__)
+  const std::uint64_t max_size_of_chunk = read_rate_limiter || write_rate_limiter
+                                              ? static_cast<std::uint64_t>(kSizeOfCopyBuffer)
+                                              : static_cast<std::uint64_t>((std::numeric_limits<ssize_t>::max)());
+  std::uint64_t size_copied = 0;
+  while (size_copied < size)
+  {
+    const auto size_to_copy = static_cast<size_t>((std::min)(size - size_copied, max_size_of_chunk));
+    const ssize_t result = copy_file_range(source_file_descriptor, nullptr, destination_file_descriptor, nullptr, size_to_copy, 0);
+    if (result < 0)
+    {
+      const int error_number = errno;
+      if (error_number == EINTR)
+      {
+        continue;
+      }
+
+      if (error_number == EXDEV || error_number == ENOSYS || error_number == EOPNOTSUPP || error_number == EINVAL)
+      {
+        break;
+      }
+
+      throw std::runtime_error(GetErrorText("copy_file_range", destination_file_name, error_number));
+    }
+
+    if (result == 0)
+    {
+      break;
+    }
+
+    size_copied += static_cast<std::uint64_t>(result);
+    AcquireFromRateLimiter(read_rate_limiter, static_cast<std::uint64_t>(result));
+    AcquireFromRateLimiter(write_rate_limiter, static_cast<std::uint64_t>(result));
+  }
+
+  return size_copied;
+#else
+  return 0;
+#endif
+}
+
+/// Copies the remaining data (from the current file offsets) by reading and writing. The reads and the writes are
+/// counted against the rate limiters (if given).
+void CopyWithReadWrite(int source_file_descriptor, int destination_file_descriptor, const std::string& source_file_name,
+                       const std::string& destination_file_name, const std::shared_ptr<RateLimiter>& read_rate_limiter,
+                       const std::shared_ptr<RateLimiter>& write_rate_limiter)
+{
+  std::vector<char> buffer(kSizeOfCopyBuffer);
+  for (;;)
+  {
+    const ssize_t bytes_read = read(source_file_descriptor, buffer.data(), buffer.size());
+    if (bytes_read < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+
+      throw std::runtime_error(GetErrorText("read", source_file_name, errno));
+    }
+
+    if (bytes_read == 0)
+    {
+      return;
+    }
+
+    AcquireFromRateLimiter(read_rate_limiter, static_cast<std::uint64_t>(bytes_read));
+    AcquireFromRateLimiter(write_rate_limiter, static_cast<std::uint64_t>(bytes_read));
+    ssize_t bytes_written = 0;
+    while (bytes_written < bytes_read)
+    {
+      const ssize_t result = write(destination_file_descriptor, buffer.data() + bytes_written,  // NOLINT: pointer arithmetic
+                                   static_cast<size_t>(bytes_read - bytes_written));
+      if (result < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+
+        throw std::runtime_error(GetErrorText("write", destination_file_name, errno));
+      }
+
+      bytes_written += result;
+    }
+  }
+}
+
+FileCopyMethod CopyOpenedFile(int source_file_descriptor, int destination_file_descriptor, const std::string& source_file_name,
+                              const std::string& destination_file_name, const std::shared_ptr<RateLimiter>& read_rate_limiter,
+                              const std::shared_ptr<RateLimiter>& write_rate_limiter)
+{
+#if defined(FICLONE)
+  if (ioctl(destination_file_descriptor, FICLONE, source_file_descriptor) == 0)  // NOLINT: vararg function
+  {
+    return FileCopyMethod::kReflink;
+  }
+#endif
+
+  struct stat source_file_status = {};
+  if (fstat(source_file_descriptor, &source_file_status) != 0)
+  {
+    throw std::runtime_error(GetErrorText("fstat", source_file_name, errno));
+  }
+
+  const auto size = static_cast<std::uint64_t>(source_file_status.st_size);
+  const std::uint64_t size_copied = CopyWithCopyFileRange(source_file_descriptor, destination_file_descriptor, size, destination_file_name,
+                                                          read_rate_limiter, write_rate_limiter);
+  if (size_copied == size)
+  {
+    return FileCopyMethod::kCopyFileRange;
+  }
+
+  // 'copy_file_range' advances the file offsets, so we continue where it stopped
+  CopyWithReadWrite(source_file_descriptor, destination_file_descriptor, source_file_name, destination_file_name, read_rate_limiter,
+                    write_rate_limiter);
+  return FileCopyMethod::kReadWrite;
+}
+
+#endif
+
+#if CZICOMPRESS_WIN32_ENVIRONMENT
+
+/// The rate limiters for copying a file with 'CopyFileEx', and the number of bytes already counted against them.
+struct CopyFileRateLimiters
+{
+  std::shared_ptr<RateLimiter> read_rate_limiter;
+  std::shared_ptr<RateLimiter> write_rate_limiter;
+  std::uint64_t number_of_bytes_counted;
+};
+
+DWORD CALLBACK CopyFileProgressRoutine(LARGE_INTEGER, LARGE_INTEGER total_bytes_transferred, LARGE_INTEGER, LARGE_INTEGER, DWORD, DWORD,
+                                       HANDLE, HANDLE, LPVOID data)
+{
+  auto* const rate_limiters = static_cast<CopyFileRateLimiters*>(data);
+  const auto number_of_bytes_transferred = static_cast<std::uint64_t>(total_bytes_transferred.QuadPart);
+  if (number_of_bytes_transferred > rate_limiters->number_of_bytes_counted)
+  {
+    const std::uint64_t number_of_bytes = number_of_bytes_transferred - rate_limiters->number_of_bytes_counted;
+    AcquireFromRateLimiter(rate_limiters->read_rate_limiter, number_of_bytes);
+    AcquireFromRateLimiter(rate_limiters->write_rate_limiter, number_of_bytes);
+    rate_limiters->number_of_bytes_counted = number_of_bytes_transferred;
+  }
+
+  return PROGRESS_CONTINUE;
+}
+
+#endif
+
+}  // namespace
+
+#if CZICOMPRESS_UNIX_ENVIRONMENT
+
+FileCopyMethod CopyFileContent(const std::string& source_file_name, const std::string& destination_file_name,
+                               bool overwrite_existing_file, const std::shared_ptr<RateLimiter>& read_rate_limiter,
+                               const std::shared_ptr<RateLimiter>& write_rate_limiter)
+{
+  ThrowIfSameFile(source_file_name, destination_file_name);
+
+  FileDescriptor source_file(open(source_file_name.c_str(), O_RDONLY | O_CLOEXEC));  // NOLINT: vararg function
+  if (source_file.Get() < 0)
+  {
+    throw std::runtime_error(GetErrorText("open", source_file_name, errno));
+  }
+
+  const int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (overwrite_existing_file ? O_TRUNC : O_EXCL);
+  FileDescriptor destination_file(open(destination_file_name.c_str(), flags, 0666));  // NOLINT: vararg function
+  if (destination_file.Get() < 0)
+  {
+    throw std::runtime_error(GetErrorText("open", destination_file_name, errno));
+  }
+
+  FileCopyMethod file_copy_method = FileCopyMethod::kInvalid;
+  try
+  {
+    file_copy_method = CopyOpenedFile(source_file.Get(), destination_file.Get(), source_file_name, destination_file_name,
+                                      read_rate_limiter, write_rate_limiter);
+    if (destination_file.Close() != 0)
+    {
+      throw std::runtime_error(GetErrorText("close", destination_file_name, errno));
+    }
+  }
+  catch (...)
+  {
+    // do not leave an incomplete file behind
+    std::error_code error_code;
+    std::filesystem::remove(std::filesystem::u8path(destination_file_name), error_code);
+    throw;
+  }
+
+  return file_copy_method;
+}
+
+#endif
+
+#if CZICOMPRESS_WIN32_ENVIRONMENT
+
+FileCopyMethod CopyFileContent(const std::string& source_file_name, const std::string& destination_file_name,
+                               bool overwrite_existing_file, const std::shared_ptr<RateLimiter>& read_rate_limiter,
+                               const std::shared_ptr<RateLimiter>& write_rate_limiter)
+{
+  ThrowIfSameFile(source_file_name, destination_file_name);
+
+  // note that CopyFileEx clones the data (instead of copying it) on file systems supporting this (e.g. ReFS with
+  // recent versions of Windows), but it does not tell us whether it did so - the progress routine is called after
+  // each chunk, and this is where the chunk is counted against the rate limiters
+  CopyFileRateLimiters rate_limiters{read_rate_limiter, write_rate_limiter, 0};
+  if (!CopyFileExW(utils::utf8::WidenUtf8(source_file_name).c_str(), utils::utf8::WidenUtf8(destination_file_name).c_str(),
+                   read_rate_limiter || write_rate_limiter ? CopyFileProgressRoutine : nullptr, &rate_limiters, nullptr,
+                   overwrite_existing_file ? 0 : COPY_FILE_FAIL_IF_EXISTS))
+  {
+    throw std::runtime_error("Error: copying file '" + source_file_name + "' to '" + destination_file_name +
+                             "' failed: " + utils::errorhandling::GetReadableLastError());
+  }
+
+  return FileCopyMethod::kReadWrite;
+}
+
+#endif
@@ -0,0 +1,531 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "httpinputstream.h"
+
+#include <CZICompress_Config.h>
+
+#if CZICOMPRESS_HTTP_INPUT_AVAILABLE
+#include <curl/curl.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// The number of attempts for a request which fails on the transport level (or with a server error).
+constexpr int kNumberOfAttempts = 3;
+
+/// The state of a transfer, as passed to the libcurl callbacks.
+struct TransferState
+{
+  std::uint8_t* destination{nullptr};
+  std::uint64_t capacity{0};
+  std::uint64_t size_received{0};
+  std::uint64_t file_size{0};
+  bool has_file_size{false};
+  bool exceeded_destination{false};
+};
+
+size_t WriteCallback(char* data, size_t size, size_t count, void* user_data)
+{
+  auto* state = static_cast<TransferState*>(user_data);
+  const size_t number_of_bytes = size * count;
+  if (state->size_received + number_of_bytes > state->capacity)
+  {
+    // returning a different number than passed in aborts the transfer
+    state->exceeded_destination = true;
+    return 0;
+  }
+
+  memcpy(state->destination + state->size_received, data, number_of_bytes);  // NOLINT: pointer arithmetic
+  state->size_received += number_of_bytes;
+  return number_of_bytes;
+}
+
+size_t HeaderCallback(char* data, size_t size, size_t count, void* user_data)
+{
+  auto* state = static_cast<TransferState*>(user_data);
+  const size_t number_of_bytes = size * count;
+  const std::string header(data, number_of_bytes);
+  if (header.compare(0, 5, "HTTP/") == 0)
+  {
+    // a new response begins (e.g. after a redirect)
+    state->has_file_size = false;
+    return number_of_bytes;
+  }
+
+  // the header looks like "Content-Range: bytes 0-0/1234" or "Content-Range: bytes */1234"
+  static constexpr char kContentRange[] = "content-range:";  // NOLINT: C-style array
+  if (header.size() < sizeof(kContentRange) - 1 ||
+      !std::equal(kContentRange, kContentRange + sizeof(kContentRange) - 1, header.begin(),
+                  [](char a, char b) { return a == static_cast<char>(std::tolower(static_cast<unsigned char>(b))); }))
+  {
+    return number_of_bytes;
+  }
+
+  const auto position_of_slash = header.find('/');
+  if (position_of_slash != std::string::npos)
+  {
+    std::istringstream stream(header.substr(position_of_slash + 1));
+    std::uint64_t file_size = 0;
+    if (stream >> file_size)
+    {
+      state->file_size = file_size;
+      state->has_file_size = true;
+    }
+  }
+
+  return number_of_bytes;
+}
+
+void EnsureCurlIsInitialized()
+{
+  static std::once_flag once_flag;
+  std::call_once(once_flag,
+                 []()
+                 {
+                   if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK)
+                   {
+                     throw std::runtime_error("Initialization of libcurl failed.");
+                   }
+                 });
+}
+
+}  // namespace
+
+void HttpInputStream::CurlHandleDeleter::operator()(void* handle) const
+{
+  curl_easy_cleanup(handle);
+}
+
+HttpInputStream::HttpInputStream(std::string url, std::uint32_t max_number_of_connections, std::uint64_t max_read_ahead_bytes)
+    : url_(std::move(url)), max_number_of_connections_(max_number_of_connections), max_read_ahead_bytes_(max_read_ahead_bytes)
+{
+  if (this->max_number_of_connections_ == 0)
+  {
+    throw std::invalid_argument("The maximum number of connections must be greater than zero.");
+  }
+
+  EnsureCurlIsInitialized();
+
+  // request the first byte in order to learn the size of the file (and to check that range requests are supported)
+  std::uint8_t first_byte = 0;
+  const RangeResponse response = this->MakeRangeRequest(0, &first_byte, 1);
+  if (response.status_code == 416 && response.has_file_size && response.file_size == 0)
+  {
+    // the file is empty
+    return;
+  }
+
+  if (response.status_code == 200)
+  {
+    throw std::runtime_error("The server does not support range requests for \"" + this->url_ + "\".");
+  }
+
+  if (response.status_code != 206 || !response.has_file_size)
+  {
+    throw std::runtime_error("Request for \"" + this->url_ + "\" failed with HTTP status code " +
+                             std::to_string(response.status_code) + ".");
+  }
+
+  this->size_ = response.file_size;
+}
+
+HttpInputStream::~HttpInputStream()
+{
+  this->StopReadAheadThreads();
+}
+
+void HttpInputStream::Read(std::uint64_t offset, void* data, std::uint64_t size, std::uint64_t* ptr_bytes_read)
+{
+  const std::uint64_t size_to_read = offset < this->size_ ? (std::min)(size, this->size_ - offset) : 0;
+  if (size_to_read > 0 && !this->TryReadFromReadAheadRanges(offset, data, size_to_read))
+  {
+    if (size_to_read >= 2 * kMinSizeOfConcurrentRequest && this->max_number_of_connections_ > 1)
+    {
+      this->ReadWithConcurrentRequests(offset, static_cast<std::uint8_t*>(data), size_to_read);
+    }
+    else
+    {
+      this->FetchRange(offset, data, size_to_read);
+    }
+  }
+
+  if (ptr_bytes_read != nullptr)
+  {
+    *ptr_bytes_read = size_to_read;
+  }
+}
+
+void HttpInputStream::AnnounceSubBlockPositions(const std::vector<std::uint64_t>& positions)
+{
+  // a range extends from an announced position to the next higher announced position (or to the end of the file)
+  std::vector<std::uint64_t> sorted_positions(positions);
+  std::sort(sorted_positions.begin(), sorted_positions.end());
+  std::deque<std::shared_ptr<ReadAheadRange>> ranges;
+  for (const auto position : positions)
+  {
+    if (position >= this->size_)
+    {
+      continue;
+    }
+
+    const auto next_position = std::upper_bound(sorted_positions.begin(), sorted_positions.end(), position);
+    auto range = std::make_shared<ReadAheadRange>();
+    range->offset = position;
+    range->size = (next_position != sorted_positions.end() ? (std::min)(*next_position, this->size_) : this->size_) - position;
+    if (range->size > this->max_read_ahead_bytes_)
+    {
+      range->state = ReadAheadState::kSkipped;
+    }
+
+    ranges.push_back(std::move(range));
+  }
+
+  const std::lock_guard<std::mutex> lock(this->read_ahead_mutex_);
+  this->read_ahead_ranges_ = std::move(ranges);
+  this->number_of_ranges_started_ = 0;
+  this->read_ahead_bytes_in_use_ = 0;
+  if (this->read_ahead_threads_.empty())
+  {
+    // one connection is left for the read operations which are not covered by the ranges
+    const std::uint32_t number_of_threads = (std::max)(this->max_number_of_connections_ - 1, 1U);
+    for (std::uint32_t i = 0; i < number_of_threads; ++i)
+    {
+      this->read_ahead_threads_.emplace_back([this]() { this->ReadAheadThreadFunction(); });
+    }
+  }
+
+  this->read_ahead_condition_variable_.notify_all();
+}
+
+std::uint64_t HttpInputStream::GetNumberOfRequests()
+{
+  const std::lock_guard<std::mutex> lock(this->connections_mutex_);
+  return this->number_of_requests_;
+}
+
+bool HttpInputStream::TryReadFromReadAheadRanges(std::uint64_t offset, void* data, std::uint64_t size)
+{
+  std::unique_lock<std::mutex> lock(this->read_ahead_mutex_);
+
+  // the ranges are read in the announced order, so the range in question is usually the first (or one of the first) -
+  //  we only look at the ranges which have been started and at a few ones following them
+  const size_t number_of_ranges_to_search =
+      (std::min)(this->read_ahead_ranges_.size(), this->number_of_ranges_started_ + this->max_number_of_connections_);
+  const auto begin_of_search = this->read_ahead_ranges_.begin();
+  const auto end_of_search = begin_of_search + static_cast<std::ptrdiff_t>(number_of_ranges_to_search);
+  const auto iterator = std::find_if(begin_of_search, end_of_search,
+                                     [&](const std::shared_ptr<ReadAheadRange>& range)
+                                     { return offset >= range->offset && offset + size <= range->offset + range->size; });
+  if (iterator == end_of_search)
+  {
+    return false;
+  }
+
+  // the ranges before the one found have been passed
+  const auto release_range = [this](const std::shared_ptr<ReadAheadRange>& range)
+  {
+    if (range->state == ReadAheadState::kFetching || range->state == ReadAheadState::kDone || range->state == ReadAheadState::kFailed)
+    {
+      this->read_ahead_bytes_in_use_ -= range->size;
+    }
+  };
+
+  const auto number_of_ranges_passed = static_cast<size_t>(iterator - begin_of_search);
+  std::for_each(begin_of_search, iterator, release_range);
+  this->read_ahead_ranges_.erase(begin_of_search, iterator);
+  this->number_of_ranges_started_ -= (std::min)(number_of_ranges_passed, this->number_of_ranges_started_);
+  this->read_ahead_condition_variable_.notify_all();
+
+  const std::shared_ptr<ReadAheadRange> range = this->read_ahead_ranges_.front();
+  if (range->state == ReadAheadState::kPending)
+  {
+    // the read-ahead threads did not get to this range yet, so we fetch it ourselves (all of it, since the remainder
+    //  of the subblock segment is going to be read next)
+    range->state = ReadAheadState::kFetching;
+    this->read_ahead_bytes_in_use_ += range->size;
+    this->number_of_ranges_started_ = (std::max)(this->number_of_ranges_started_, static_cast<size_t>(1));
+    lock.unlock();
+    bool success = true;
+    try
+    {
+      range->data.resize(static_cast<size_t>(range->size));
+      this->FetchRange(range->offset, range->data.data(), range->size);
+    }
+    catch (const std::exception&)
+    {
+      success = false;
+    }
+
+    lock.lock();
+    range->state = success ? ReadAheadState::kDone : ReadAheadState::kFailed;
+    this->read_ahead_condition_variable_.notify_all();
+  }
+
+  this->read_ahead_condition_variable_.wait(lock, [&]() { return range->state != ReadAheadState::kFetching; });
+  if (range->state != ReadAheadState::kDone)
+  {
+    return false;
+  }
+
+  if (offset + size == range->offset + range->size && !this->read_ahead_ranges_.empty() && this->read_ahead_ranges_.front() == range)
+  {
+    // the end of the range has been read, so the range is not needed anymore
+    release_range(range);
+    this->read_ahead_ranges_.pop_front();
+    this->number_of_ranges_started_ -= (std::min)(static_cast<size_t>(1), this->number_of_ranges_started_);
+    this->read_ahead_condition_variable_.notify_all();
+  }
+
+  // the data of the range is not modified anymore, so we can copy it without holding the lock
+  lock.unlock();
+  memcpy(data, range->data.data() + (offset - range->offset), static_cast<size_t>(size));  // NOLINT: pointer arithmetic
+  return true;
+}
+
+void HttpInputStream::ReadWithConcurrentRequests(std::uint64_t offset, std::uint8_t* data, std::uint64_t size)
+{
+  const std::uint64_t number_of_parts =
+      (std::min)(static_cast<std::uint64_t>(this->max_number_of_connections_), size / kMinSizeOfConcurrentRequest);
+  const std::uint64_t size_of_part = (size + number_of_parts - 1) / number_of_parts;
+  std::vector<std::exception_ptr> exceptions(static_cast<size_t>(number_of_parts));
+  const auto fetch_part = [&](std::uint64_t part)
+  {
+    try
+    {
+      const std::uint64_t start_of_part = part * size_of_part;
+      this->FetchRange(offset + start_of_part, data + start_of_part, (std::min)(size_of_part, size - start_of_part));  // NOLINT
+    }
+    catch (...)
+    {
+      exceptions[static_cast<size_t>(part)] = std::current_exception();
+    }
+  };
+
+  // the first part is fetched on the calling thread
+  std::vector<std::thread> threads;
+  for (std::uint64_t part = 1; part < number_of_parts; ++part)
+  {
+    threads.emplace_back(fetch_part, part);
+  }
+
+  fetch_part(0);
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  for (const auto& exception : exceptions)
+  {
+    if (exception)
+    {
+      std::rethrow_exception(exception);
+    }
+  }
+}
+
+void HttpInputStream::ReadAheadThreadFunction()
+{
+  std::unique_lock<std::mutex> lock(this->read_ahead_mutex_);
+  for (;;)
+  {
+    this->read_ahead_condition_variable_.wait(lock,
+                                              [this]()
+                                              {
+                                                if (this->stop_read_ahead_)
+                                                {
+                                                  return true;
+                                                }
+
+                                                if (this->number_of_ranges_started_ >= this->read_ahead_ranges_.size())
+                                                {
+                                                  return false;
+                                                }
+
+                                                const auto& next_range = this->read_ahead_ranges_[this->number_of_ranges_started_];
+                                                return next_range->state != ReadAheadState::kPending ||
+                                                       this->read_ahead_bytes_in_use_ + next_range->size <= this->max_read_ahead_bytes_;
+                                              });
+
+    if (this->stop_read_ahead_)
+    {
+      return;
+    }
+
+    const std::shared_ptr<ReadAheadRange> range = this->read_ahead_ranges_[this->number_of_ranges_started_++];
+    if (range->state != ReadAheadState::kPending)
+    {
+      continue;
+    }
+
+    range->state = ReadAheadState::kFetching;
+    this->read_ahead_bytes_in_use_ += range->size;
+    lock.unlock();
+    bool success = true;
+    try
+    {
+      range->data.resize(static_cast<size_t>(range->size));
+      this->FetchRange(range->offset, range->data.data(), range->size);
+    }
+    catch (const std::exception&)
+    {
+      // the read operation for this range will then be carried out directly (and report the error)
+      success = false;
+    }
+
+    lock.lock();
+    range->state = success ? ReadAheadState::kDone : ReadAheadState::kFailed;
+    if (!success)
+    {
+      range->data = std::vector<std::uint8_t>();
+    }
+
+    this->read_ahead_condition_variable_.notify_all();
+  }
+}
+
+void HttpInputStream::StopReadAheadThreads()
+{
+  {
+    const std::lock_guard<std::mutex> lock(this->read_ahead_mutex_);
+    this->stop_read_ahead_ = true;
+  }
+
+  this->read_ahead_condition_variable_.notify_all();
+  for (auto& thread : this->read_ahead_threads_)
+  {
+    thread.join();
+  }
+
+  this->read_ahead_threads_.clear();
+}
+
+void HttpInputStream::FetchRange(std::uint64_t offset, void* data, std::uint64_t size)
+{
+  for (int attempt = 1;; ++attempt)
+  {
+    RangeResponse response;
+    try
+    {
+      response = this->MakeRangeRequest(offset, data, size);
+    }
+    catch (const std::runtime_error&)
+    {
+      if (attempt < kNumberOfAttempts)
+      {
+        continue;
+      }
+
+      throw;
+    }
+
+    if (response.status_code >= 500 && attempt < kNumberOfAttempts)
+    {
+      continue;
+    }
+
+    if (response.status_code != 206 || response.exceeded_destination)
+    {
+      throw std::runtime_error("Range request for \"" + this->url_ + "\" failed with HTTP status code " +
+                               std::to_string(response.status_code) + ".");
+    }
+
+    if (response.size_received != size)
+    {
+      throw std::runtime_error("Range request for \"" + this->url_ + "\" returned " + std::to_string(response.size_received) +
+                               " bytes instead of " + std::to_string(size) + " bytes.");
+    }
+
+    return;
+  }
+}
+
+HttpInputStream::RangeResponse HttpInputStream::MakeRangeRequest(std::uint64_t offset, void* data, std::uint64_t size)
+{
+  TransferState state;
+  state.destination = static_cast<std::uint8_t*>(data);
+  state.capacity = size;
+  const std::string range = std::to_string(offset) + "-" + std::to_string(offset + size - 1);
+
+  CurlHandle connection = this->AcquireConnection();
+  void* handle = connection.get();
+  curl_easy_setopt(handle, CURLOPT_RANGE, range.c_str());
+  curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, WriteCallback);
+  curl_easy_setopt(handle, CURLOPT_WRITEDATA, &state);
+  curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, HeaderCallback);
+  curl_easy_setopt(handle, CURLOPT_HEADERDATA, &state);
+  const CURLcode result = curl_easy_perform(handle);
+  RangeResponse response;
+  curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &response.status_code);
+  this->ReleaseConnection(std::move(connection));
+
+  if (result != CURLE_OK && !state.exceeded_destination)
+  {
+    throw std::runtime_error("Request for \"" + this->url_ + "\" failed: " + curl_easy_strerror(result));
+  }
+
+  response.size_received = state.size_received;
+  response.file_size = state.file_size;
+  response.has_file_size = state.has_file_size;
+  response.exceeded_destination = state.exceeded_destination;
+  return response;
+}
+
+HttpInputStream::CurlHandle HttpInputStream::AcquireConnection()
+{
+  {
+    std::unique_lock<std::mutex> lock(this->connections_mutex_);
+    this->connections_condition_variable_.wait(
+        lock,
+        [this]()
+        { return !this->idle_connections_.empty() || this->number_of_connections_in_use_ < this->max_number_of_connections_; });
+
+    ++this->number_of_connections_in_use_;
+    ++this->number_of_requests_;
+    if (!this->idle_connections_.empty())
+    {
+      CurlHandle connection = std::move(this->idle_connections_.back());
+      this->idle_connections_.pop_back();
+      return connection;
+    }
+  }
+
+  CurlHandle connection(curl_easy_init());
+  if (!connection)
+  {
+    this->ReleaseConnection(nullptr);
+    throw std::runtime_error("Creating a libcurl handle failed.");
+  }
+
+  curl_easy_setopt(connection.get(), CURLOPT_URL, this->url_.c_str());
+  curl_easy_setopt(connection.get(), CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(connection.get(), CURLOPT_FOLLOWLOCATION, 1L);
+  curl_easy_setopt(connection.get(), CURLOPT_CONNECTTIMEOUT, 30L);
+  return connection;
+}
+
+void HttpInputStream::ReleaseConnection(CurlHandle connection)
+{
+  {
+    const std::lock_guard<std::mutex> lock(this->connections_mutex_);
+    --this->number_of_connections_in_use_;
+    if (connection)
+    {
+      this->idle_connections_.push_back(std::move(connection));
+    }
+  }
+
+  this->connections_condition_variable_.notify_one();
+}
+
+#endif
@@ -0,0 +1,137 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../inc_libCZI.h"
+#include "../include/sourcereadahead.h"
+
+/// Implementation of libCZI::IStream which reads a file from an HTTP(S) server with range requests (using libcurl).
+/// The size of the file is determined when the stream is created, and the server must support range requests.
+/// Requests are made on a pool of connections (which are kept open between requests), and concurrent read operations
+/// use different connections. In addition, the following makes use of several connections at a time:
+/// - a large read operation is split into several range requests, which are made concurrently,
+/// - if the positions of the subblocks are announced (see ISourceReadAhead), the subblock segments are fetched ahead
+///   of their use with concurrent requests, up to a limit of bytes held in memory.
+class HttpInputStream : public libCZI::IStream, public ISourceReadAhead
+{
+public:
+  /// The default maximum number of concurrent requests (i.e. connections).
+  static constexpr std::uint32_t kDefaultMaxNumberOfConnections = 8;
+
+  /// The default maximum number of bytes fetched ahead (and held in memory).
+  static constexpr std::uint64_t kDefaultMaxReadAheadBytes = 64 * 1024 * 1024;
+
+  /// The minimum size of a part of a read operation which is fetched with a separate (concurrent) request.
+  static constexpr std::uint64_t kMinSizeOfConcurrentRequest = 1024 * 1024;
+
+private:
+  /// Deleter for a libcurl easy handle.
+  struct CurlHandleDeleter
+  {
+    void operator()(void* handle) const;
+  };
+
+  using CurlHandle = std::unique_ptr<void, CurlHandleDeleter>;
+
+  enum class ReadAheadState
+  {
+    kPending,   ///< The range has not been fetched yet.
+    kSkipped,   ///< The range is too large to be fetched ahead.
+    kFetching,  ///< The range is being fetched.
+    kDone,      ///< The data of the range is available.
+    kFailed,    ///< Fetching the range failed.
+  };
+
+  struct ReadAheadRange
+  {
+    std::uint64_t offset{0};
+    std::uint64_t size{0};
+    ReadAheadState state{ReadAheadState::kPending};
+    std::vector<std::uint8_t> data;
+  };
+
+  struct RangeResponse
+  {
+    long status_code{0};  // NOLINT: the type used by libcurl
+    std::uint64_t size_received{0};
+    std::uint64_t file_size{0};     ///< The size of the file as reported in the 'Content-Range' header.
+    bool has_file_size{false};      ///< Whether the response had a 'Content-Range' header with the size of the file.
+    bool exceeded_destination{false};  ///< Whether the server sent more data than requested.
+  };
+
+  std::string url_;
+  std::uint32_t max_number_of_connections_;
+  std::uint64_t max_read_ahead_bytes_;
+  std::uint64_t size_{0};
+
+  std::mutex connections_mutex_;  ///< Protects the pool of connections.
+  std::condition_variable connections_condition_variable_;
+  std::vector<CurlHandle> idle_connections_;
+  std::uint32_t number_of_connections_in_use_{0};
+  std::uint64_t number_of_requests_{0};
+
+  std::mutex read_ahead_mutex_;  ///< Protects the ranges to read ahead and the state of the read-ahead threads.
+  std::condition_variable read_ahead_condition_variable_;
+  std::deque<std::shared_ptr<ReadAheadRange>> read_ahead_ranges_;  ///< The announced ranges which have not been passed yet.
+  size_t number_of_ranges_started_{0};      ///< The number of ranges (at the front of 'read_ahead_ranges_') not pending anymore.
+  std::uint64_t read_ahead_bytes_in_use_{0};  ///< The size of the ranges being fetched or fetched (and not passed yet).
+  bool stop_read_ahead_{false};
+  std::vector<std::thread> read_ahead_threads_;
+
+public:
+  /// Constructor - the size of the file is requested from the server, an exception is thrown if this fails (or if
+  /// the server does not support range requests).
+  ///
+  /// \param  url                         The URL of the file (with the scheme 'http' or 'https').
+  /// \param  max_number_of_connections   The maximum number of concurrent requests.
+  /// \param  max_read_ahead_bytes        The maximum number of bytes fetched ahead (see ISourceReadAhead).
+  explicit HttpInputStream(std::string url, std::uint32_t max_number_of_connections = kDefaultMaxNumberOfConnections,
+                           std::uint64_t max_read_ahead_bytes = kDefaultMaxReadAheadBytes);
+  ~HttpInputStream() override;
+
+  HttpInputStream(const HttpInputStream&) = delete;
+  HttpInputStream& operator=(const HttpInputStream&) = delete;
+
+  void Read(std::uint64_t offset, void* data, std::uint64_t size, std::uint64_t* ptr_bytes_read) override;
+
+  void AnnounceSubBlockPositions(const std::vector<std::uint64_t>& positions) override;
+
+  /// Gets the size of the file.
+  ///
+  /// \returns The size of the file in bytes.
+  std::uint64_t GetSize() const { return this->size_; }
+
+  /// Gets the number of requests made to the server so far.
+  ///
+  /// \returns The number of requests.
+  std::uint64_t GetNumberOfRequests();
+
+private:
+  bool TryReadFromReadAheadRanges(std::uint64_t offset, void* data, std::uint64_t size);
+  void ReadWithConcurrentRequests(std::uint64_t offset, std::uint8_t* data, std::uint64_t size);
+  void ReadAheadThreadFunction();
+  void StopReadAheadThreads();
+
+  /// Fetches the specified range of the file (which must be within the file) - failed requests are retried, and an
+  /// exception is thrown if the range could not be fetched.
+  void FetchRange(std::uint64_t offset, void* data, std::uint64_t size);
+
+  /// Makes a request for the specified range on a connection from the pool. The data received is put into the
+  /// destination - if the server sends more than 'size' bytes (e.g. because it ignores the range), the transfer is
+  /// aborted. An exception is thrown if the request fails on the transport level.
+  RangeResponse MakeRangeRequest(std::uint64_t offset, void* data, std::uint64_t size);
+
+  CurlHandle AcquireConnection();
+  void ReleaseConnection(CurlHandle connection);
+};
@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "inflightbudget.h"
+
+#include <algorithm>
+
+InFlightBudget::InFlightBudget(std::uint64_t max_number_of_bytes, std::uint64_t max_number_of_items)
+    : max_number_of_bytes_(max_number_of_bytes), max_number_of_items_(max_number_of_items)
+{
+}
+
+bool InFlightBudget::WaitForAdmission(std::uint64_t number_of_items, std::uint64_t estimated_number_of_bytes)
+{
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  this->condition_variable_.wait(
+      lock,
+      [this, number_of_items, estimated_number_of_bytes]()
+      {
+        if (this->aborted_ || this->number_of_items_ == 0)
+        {
+          return true;
+        }
+
+        const bool bytes_ok =
+            this->max_number_of_bytes_ == 0 || this->number_of_bytes_ + estimated_number_of_bytes < this->max_number_of_bytes_;
+        const bool items_ok = this->max_number_of_items_ == 0 || this->number_of_items_ + number_of_items <= this->max_number_of_items_;
+        return bytes_ok && items_ok;
+      });
+  if (this->aborted_)
+  {
+    return false;
+  }
+
+  this->number_of_items_ += number_of_items;
+  return true;
+}
+
+void InFlightBudget::AddBytes(std::uint64_t number_of_bytes)
+{
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  this->number_of_bytes_ += number_of_bytes;
+  this->peak_number_of_bytes_ = (std::max)(this->peak_number_of_bytes_, this->number_of_bytes_);
+}
+
+void InFlightBudget::Release(std::uint64_t number_of_bytes)
+{
+  {
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    this->number_of_bytes_ -= (std::min)(number_of_bytes, this->number_of_bytes_);
+    if (this->number_of_items_ > 0)
+    {
+      --this->number_of_items_;
+    }
+  }
+
+  this->condition_variable_.notify_all();
+}
+
+void InFlightBudget::Abort()
+{
+  {
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    this->aborted_ = true;
+  }
+
+  this->condition_variable_.notify_all();
+}
+
+std::uint64_t InFlightBudget::GetPeakNumberOfBytes()
+{
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->peak_number_of_bytes_;
+}
@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+/// This class implements an admission control for the items "in flight" in the subblock-processing
+/// pipeline - i.e. items which have been read, but are not yet written. It keeps track of the number
+/// of items and the number of bytes held by them, and the producer (the reader) is blocked in
+/// 'WaitForAdmission' as long as one of the limits is exceeded. Note that a new item is always
+/// admitted if no item is in flight - so a single item exceeding the budget can still pass through.
+/// All methods are thread-safe.
+class InFlightBudget
+{
+private:
+  std::mutex mutex_;
+  std::condition_variable condition_variable_;
+  std::uint64_t max_number_of_bytes_;
+  std::uint64_t max_number_of_items_;
+  std::uint64_t number_of_bytes_{0};
+  std::uint64_t number_of_items_{0};
+  std::uint64_t peak_number_of_bytes_{0};
+  bool aborted_{false};
+
+public:
+  /// Constructor.
+  ///
+  /// \param  max_number_of_bytes The maximum number of bytes in flight. If zero, the number of bytes is not limited.
+  /// \param  max_number_of_items The maximum number of items in flight. If zero, the number of items is not limited.
+  InFlightBudget(std::uint64_t max_number_of_bytes, std::uint64_t max_number_of_items);
+
+  InFlightBudget(const InFlightBudget&) = delete;
+  InFlightBudget(InFlightBudget&&) = delete;
+  InFlightBudget& operator=(const InFlightBudget&) = delete;
+  InFlightBudget& operator=(InFlightBudget&&) = delete;
+  ~InFlightBudget() = default;
+
+  /// Waits until new items can be admitted (i.e. until the number of bytes in flight plus the estimated number of
+  /// bytes of the new items is below its limit, and the number of items in flight plus the new items does not exceed
+  /// its limit), and then accounts for the new items. The number of bytes held by the items is to be reported with
+  /// 'AddBytes' subsequently, and each item is to be released individually with 'Release'.
+  ///
+  /// \param  number_of_items           The number of items to admit (as a whole).
+  /// \param  estimated_number_of_bytes The estimated number of bytes which the new items are going to hold - this is
+  ///                                   only used for the decision, the actual number is to be reported with 'AddBytes'.
+  ///
+  /// \returns    True if the items were admitted; false if the budget was aborted (and the items were not admitted).
+  bool WaitForAdmission(std::uint64_t number_of_items = 1, std::uint64_t estimated_number_of_bytes = 0);
+
+  /// Increases the number of bytes held by the items in flight.
+  ///
+  /// \param  number_of_bytes The number of bytes to add.
+  void AddBytes(std::uint64_t number_of_bytes);
+
+  /// Reports that an item is no longer in flight.
+  ///
+  /// \param  number_of_bytes The number of bytes which were held by the item (i.e. the sum of all 'AddBytes'-calls for it).
+  void Release(std::uint64_t number_of_bytes);
+
+  /// Aborts - all callers blocked in 'WaitForAdmission' return immediately (returning false), and subsequent
+  /// calls will also fail.
+  void Abort();
+
+  /// Gets the maximum number of bytes which were in flight at any time.
+  ///
+  /// \returns    The peak number of bytes in flight.
+  std::uint64_t GetPeakNumberOfBytes();
+};
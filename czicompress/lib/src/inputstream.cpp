@@ -0,0 +1,208 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "../include/inputstream.h"
+
+#include <CZICompress_Config.h>
+#include <include/utils/utf8/utf8converter.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "../inc_libCZI.h"
+#include "cachinginputstream.h"
+#include "httpinputstream.h"
+#include "memorymappedinputstream.h"
+#include "ratelimitedinputstream.h"
+
+#if CZICOMPRESS_WIN32_ENVIRONMENT
+#include <Windows.h>
+
+#include <vector>
+#endif
+
+#if CZICOMPRESS_UNIX_ENVIRONMENT
+#if defined(__APPLE__)
+#include <sys/mount.h>
+#include <sys/param.h>
+
+#include <cstring>
+#elif defined(__linux__)
+#include <sys/vfs.h>
+#endif
+#endif
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+#if CZICOMPRESS_UNIX_ENVIRONMENT && defined(__linux__)
+/// The magic numbers (as reported by 'statfs') of network file systems.
+// NOLINTNEXTLINE: C-style array
+constexpr std::uint32_t kNetworkFileSystemMagicNumbers[] = {
+    0x00006969,  // NFS
+    0x0000517b,  // SMB
+    0xff534d42,  // CIFS
+    0xfe534d42,  // SMB2
+    0x00c36400,  // Ceph
+    0x6b414653,  // AFS (kAFS)
+    0x5346414f,  // AFS (OpenAFS)
+    0x73757245,  // Coda
+    0x0000564c,  // NCP
+    0x01021997,  // 9P
+    0x0bd00bd0,  // Lustre
+};
+#endif
+
+#if CZICOMPRESS_UNIX_ENVIRONMENT && defined(__APPLE__)
+/// The names (as reported by 'statfs') of network file systems.
+const char* const kNetworkFileSystemNames[] = {"nfs", "smbfs", "afpfs", "webdav", "cifs"};  // NOLINT: C-style array
+#endif
+
+}  // namespace
+
+std::shared_ptr<libCZI::IStream> CreateInputStreamForFile(const std::string& file_name, InputIo input_io, InputCache input_cache,
+                                                          std::shared_ptr<RateLimiter> rate_limiter)
+{
+  const bool is_http_url = IsHttpUrl(file_name);
+  std::shared_ptr<libCZI::IStream> stream;
+  if (is_http_url)
+  {
+    if (input_io != InputIo::kPread)
+    {
+      throw std::invalid_argument("An http(s)-URL can only be read with the input-io mode 'pread'");
+    }
+
+#if CZICOMPRESS_HTTP_INPUT_AVAILABLE
+    stream = std::make_shared<HttpInputStream>(file_name);
+#else
+    throw std::invalid_argument("Reading from an http(s)-URL is not available (czicompress was built without libcurl)");
+#endif
+  }
+  else
+  {
+    switch (input_io)
+    {
+      case InputIo::kPread:
+        stream = libCZI::CreateStreamFromFile(utils::utf8::WidenUtf8(file_name).c_str());
+        break;
+      case InputIo::kMmap:
+        stream = std::make_shared<MemoryMappedInputStream>(file_name);
+        break;
+      default:
+        throw std::invalid_argument("Unknown or unsupported input-io mode");
+    }
+  }
+
+  if (rate_limiter)
+  {
+    stream = std::make_shared<RateLimitedInputStream>(stream, std::move(rate_limiter));
+  }
+
+  switch (input_cache)
+  {
+    case InputCache::kOff:
+      return stream;
+    case InputCache::kOn:
+      return std::make_shared<CachingInputStream>(stream);
+    case InputCache::kAuto:
+      if (!is_http_url && input_io == InputIo::kPread && IsFileOnNetworkFileSystem(file_name))
+      {
+        return std::make_shared<CachingInputStream>(stream);
+      }
+
+      return stream;
+    default:
+      throw std::invalid_argument("Unknown or unsupported input-cache mode");
+  }
+}
+
+bool TryGetInputCacheStatistics(libCZI::IStream* stream, InputCacheStatistics& statistics)
+{
+  auto* caching_input_stream = dynamic_cast<CachingInputStream*>(stream);
+  if (caching_input_stream == nullptr)
+  {
+    return false;
+  }
+
+  statistics = caching_input_stream->GetStatistics();
+  return true;
+}
+
+bool IsFileOnNetworkFileSystem(const std::string& file_name)
+{
+#if CZICOMPRESS_WIN32_ENVIRONMENT
+  const std::wstring file_name_wide = utils::utf8::WidenUtf8(file_name);
+  std::vector<wchar_t> volume_path(file_name_wide.size() + MAX_PATH);
+  if (!GetVolumePathNameW(file_name_wide.c_str(), volume_path.data(), static_cast<DWORD>(volume_path.size())))
+  {
+    return false;
+  }
+
+  return GetDriveTypeW(volume_path.data()) == DRIVE_REMOTE;
+#elif CZICOMPRESS_UNIX_ENVIRONMENT && defined(__linux__)
+  struct statfs file_system_info = {};
+  if (statfs(file_name.c_str(), &file_system_info) != 0)
+  {
+    return false;
+  }
+
+  const auto magic_number = static_cast<std::uint32_t>(file_system_info.f_type);
+  return std::find(std::begin(kNetworkFileSystemMagicNumbers), std::end(kNetworkFileSystemMagicNumbers), magic_number) !=
+         std::end(kNetworkFileSystemMagicNumbers);
+#elif CZICOMPRESS_UNIX_ENVIRONMENT && defined(__APPLE__)
+  struct statfs file_system_info = {};
+  if (statfs(file_name.c_str(), &file_system_info) != 0)
+  {
+    return false;
+  }
+
+  return std::any_of(std::begin(kNetworkFileSystemNames), std::end(kNetworkFileSystemNames),
+                     [&](const char* name) { return strcmp(file_system_info.f_fstypename, name) == 0; });
+#else
+  return false;
+#endif
+}
+
+bool IsHttpUrl(const std::string& file_name)
+{
+  const auto starts_with = [&](const std::string& prefix)
+  {
+    return file_name.size() > prefix.size() &&
+           std::equal(prefix.begin(), prefix.end(), file_name.begin(),
+                      [](char a, char b) { return a == static_cast<char>(std::tolower(static_cast<unsigned char>(b))); });
+  };
+
+  return starts_with("http://") || starts_with("https://");
+}
+
+bool IsHttpInputAvailable()
+{
+  return CZICOMPRESS_HTTP_INPUT_AVAILABLE != 0;
+}
+
+std::shared_ptr<ISourceReadAhead> GetSourceReadAhead(const std::shared_ptr<libCZI::IStream>& stream)
+{
+#if CZICOMPRESS_HTTP_INPUT_AVAILABLE
+  // the block cache passes the announcement on to the stream below it, and the read operations within the announced
+  //  ranges bypass the cache (see 'CachingInputStream')
+  const auto caching_input_stream = std::dynamic_pointer_cast<CachingInputStream>(stream);
+  if (caching_input_stream)
+  {
+    return caching_input_stream->HasSourceReadAhead() ? caching_input_stream : nullptr;
+  }
+
+  // the subblocks fetched ahead are limited when they are read from the rate-limited stream (and not when they are
+  // fetched) - since the data fetched ahead is bounded, this still limits the average rate
+  const auto rate_limited_input_stream = std::dynamic_pointer_cast<RateLimitedInputStream>(stream);
+  return std::dynamic_pointer_cast<HttpInputStream>(rate_limited_input_stream ? rate_limited_input_stream->GetUnderlyingStream() : stream);
+#else
+  return nullptr;
+#endif
+}
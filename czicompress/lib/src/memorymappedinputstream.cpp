@@ -0,0 +1,264 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "memorymappedinputstream.h"
+
+#include <CZICompress_Config.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+#if CZICOMPRESS_WIN32_ENVIRONMENT
+#include <Windows.h>
+#include <include/utils/errorhandling/winerrorformatting.h>
+#include <include/utils/utf8/utf8converter.h>
+#endif
+
+#if CZICOMPRESS_UNIX_ENVIRONMENT
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// The amount of data (in bytes) which is requested ahead of the current read position if the read operations
+/// proceed sequentially.
+constexpr std::uint64_t kReadAheadSize = 8 * 1024 * 1024;
+
+/// The maximal gap (in bytes) between two read operations for them to be considered sequential.
+constexpr std::uint64_t kMaxGapForSequentialRead = 64 * 1024;
+
+/// The number of consecutive sequential read operations after which the mapping is marked for sequential access.
+constexpr std::uint32_t kNumberOfSequentialReadsForSequentialAccess = 4;
+
+/// The minimal size of a (non-sequential) read operation for which the data is requested ahead of time - for smaller
+/// read operations, the system call is more expensive than the page faults.
+constexpr std::uint64_t kMinSizeForWillNeedHint = 256 * 1024;
+
+std::string GetErrorText(const std::string& operation, const std::string& file_name)
+{
+#if CZICOMPRESS_WIN32_ENVIRONMENT
+  return "Error: " + operation + " failed for file '" + file_name + "': " + utils::errorhandling::GetReadableLastError();
+#else
+  return "Error: " + operation + " failed for file '" + file_name + "': " + std::generic_category().message(errno);
+#endif
+}
+
+}  // namespace
+
+#if CZICOMPRESS_WIN32_ENVIRONMENT
+
+MemoryMappedInputStream::MemoryMappedInputStream(const std::string& file_name)
+{
+  const HANDLE file_handle = CreateFileW(utils::utf8::WidenUtf8(file_name).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file_handle == INVALID_HANDLE_VALUE)
+  {
+    throw std::runtime_error(GetErrorText("CreateFile", file_name));
+  }
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file_handle, &file_size))
+  {
+    const auto error_text = GetErrorText("GetFileSizeEx", file_name);
+    CloseHandle(file_handle);
+    throw std::runtime_error(error_text);
+  }
+
+  this->size_ = static_cast<std::uint64_t>(file_size.QuadPart);
+  if (this->size_ > 0)
+  {
+    // the view of the mapping stays valid after the handles have been closed
+    const HANDLE mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle == nullptr)
+    {
+      const auto error_text = GetErrorText("CreateFileMapping", file_name);
+      CloseHandle(file_handle);
+      throw std::runtime_error(error_text);
+    }
+
+    this->data_ = static_cast<const std::uint8_t*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    const auto error_text = this->data_ == nullptr ? GetErrorText("MapViewOfFile", file_name) : std::string();
+    CloseHandle(mapping_handle);
+    CloseHandle(file_handle);
+    if (this->data_ == nullptr)
+    {
+      throw std::runtime_error(error_text);
+    }
+  }
+  else
+  {
+    CloseHandle(file_handle);
+  }
+}
+
+MemoryMappedInputStream::~MemoryMappedInputStream()
+{
+  if (this->data_ != nullptr)
+  {
+    UnmapViewOfFile(this->data_);
+  }
+}
+
+void MemoryMappedInputStream::AdviseSequentialAccess(bool /*sequential*/)
+{
+  // there is no equivalent to 'madvise(MADV_SEQUENTIAL)' for a view of a file mapping
+}
+
+void MemoryMappedInputStream::AdviseWillNeed(std::uint64_t offset, std::uint64_t size)
+{
+#if _WIN32_WINNT >= _WIN32_WINNT_WIN8
+  WIN32_MEMORY_RANGE_ENTRY memory_range;
+  memory_range.VirtualAddress = const_cast<std::uint8_t*>(this->data_ + offset);  // NOLINT
+  memory_range.NumberOfBytes = static_cast<SIZE_T>(size);
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &memory_range, 0);
+#endif
+}
+
+#endif
+
+#if CZICOMPRESS_UNIX_ENVIRONMENT
+
+MemoryMappedInputStream::MemoryMappedInputStream(const std::string& file_name)
+{
+  const int file_descriptor = open(file_name.c_str(), O_RDONLY | O_CLOEXEC);  // NOLINT
+  if (file_descriptor < 0)
+  {
+    throw std::runtime_error(GetErrorText("open", file_name));
+  }
+
+  struct stat file_status {};
+  if (fstat(file_descriptor, &file_status) != 0)
+  {
+    const auto error_text = GetErrorText("fstat", file_name);
+    close(file_descriptor);
+    throw std::runtime_error(error_text);
+  }
+
+  this->size_ = static_cast<std::uint64_t>(file_status.st_size);
+  if (this->size_ > (std::numeric_limits<size_t>::max)())
+  {
+    close(file_descriptor);
+    throw std::runtime_error("Error: the file '" + file_name + "' is too large to be mapped");
+  }
+
+  if (this->size_ > 0)
+  {
+    // the mapping stays valid after the file descriptor has been closed
+    void* mapping = mmap(nullptr, static_cast<size_t>(this->size_), PROT_READ, MAP_SHARED, file_descriptor, 0);
+    const auto error_text = mapping == MAP_FAILED ? GetErrorText("mmap", file_name) : std::string();
+    close(file_descriptor);
+    if (mapping == MAP_FAILED)
+    {
+      throw std::runtime_error(error_text);
+    }
+
+    this->data_ = static_cast<const std::uint8_t*>(mapping);
+  }
+  else
+  {
+    close(file_descriptor);
+  }
+}
+
+MemoryMappedInputStream::~MemoryMappedInputStream()
+{
+  if (this->data_ != nullptr)
+  {
+    munmap(const_cast<std::uint8_t*>(this->data_), static_cast<size_t>(this->size_));  // NOLINT
+  }
+}
+
+void MemoryMappedInputStream::AdviseSequentialAccess(bool sequential)
+{
+  // with MADV_SEQUENTIAL, the kernel reads ahead more aggressively and frees pages which have been read more quickly
+  madvise(const_cast<std::uint8_t*>(this->data_), static_cast<size_t>(this->size_),  // NOLINT
+          sequential ? MADV_SEQUENTIAL : MADV_NORMAL);
+}
+
+void MemoryMappedInputStream::AdviseWillNeed(std::uint64_t offset, std::uint64_t size)
+{
+  // madvise requires the address to be aligned to a page boundary
+  static const std::uint64_t page_size = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+  const std::uint64_t aligned_offset = offset - offset % page_size;
+  madvise(const_cast<std::uint8_t*>(this->data_ + aligned_offset), static_cast<size_t>(size + offset - aligned_offset),  // NOLINT
+          MADV_WILLNEED);
+}
+
+#endif
+
+void MemoryMappedInputStream::Read(std::uint64_t offset, void* data, std::uint64_t size, std::uint64_t* ptr_bytes_read)
+{
+  std::uint64_t size_to_copy = 0;
+  if (offset < this->size_)
+  {
+    size_to_copy = (std::min)(size, this->size_ - offset);
+    this->AdviseAccess(offset, size_to_copy);
+    memcpy(data, this->data_ + offset, static_cast<size_t>(size_to_copy));  // NOLINT: pointer arithmetic
+  }
+
+  if (ptr_bytes_read != nullptr)
+  {
+    *ptr_bytes_read = size_to_copy;
+  }
+}
+
+void MemoryMappedInputStream::AdviseAccess(std::uint64_t offset, std::uint64_t size)
+{
+  std::uint64_t offset_to_request = 0;
+  std::uint64_t size_to_request = 0;
+  {
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    const bool is_sequential = offset >= this->end_of_last_read_ && offset - this->end_of_last_read_ <= kMaxGapForSequentialRead;
+    this->end_of_last_read_ = offset + size;
+    if (is_sequential)
+    {
+      this->number_of_sequential_reads_ = (std::min)(this->number_of_sequential_reads_ + 1, kNumberOfSequentialReadsForSequentialAccess);
+    }
+    else
+    {
+      this->number_of_sequential_reads_ = 0;
+    }
+
+    const bool sequential_access = this->number_of_sequential_reads_ >= kNumberOfSequentialReadsForSequentialAccess;
+    if (sequential_access != this->sequential_access_advised_)
+    {
+      this->AdviseSequentialAccess(sequential_access);
+      this->sequential_access_advised_ = sequential_access;
+    }
+
+    if (is_sequential)
+    {
+      // request the data following the current read position, but only if less than half of the read-ahead
+      // is outstanding - so that the hint is given in reasonably large portions
+      if (this->end_of_data_requested_ < offset + size + kReadAheadSize / 2)
+      {
+        offset_to_request = (std::max)(offset, this->end_of_data_requested_);
+        const std::uint64_t end_to_request = (std::min)(offset + size + kReadAheadSize, this->size_);
+        size_to_request = end_to_request > offset_to_request ? end_to_request - offset_to_request : 0;
+        this->end_of_data_requested_ = (std::max)(this->end_of_data_requested_, end_to_request);
+      }
+    }
+    else
+    {
+      this->end_of_data_requested_ = offset + size;
+      if (size >= kMinSizeForWillNeedHint)
+      {
+        offset_to_request = offset;
+        size_to_request = size;
+      }
+    }
+  }
+
+  if (size_to_request > 0)
+  {
+    this->AdviseWillNeed(offset_to_request, size_to_request);
+  }
+}
@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "../inc_libCZI.h"
+
+/// Implementation of libCZI::IStream which maps the complete file into the address space of the process. Data
+/// is copied directly from the mapping, so no system call is necessary for a read operation. The operating system
+/// is given hints about the access pattern: if the read operations proceed sequentially, the mapping is marked
+/// for sequential access and the data following the current read position is requested ahead of time, otherwise
+/// only the data of the current read operation is requested.
+/// Note that the file must not be truncated while it is mapped - accessing the mapping beyond the end of the
+/// file results in an access violation.
+class MemoryMappedInputStream : public libCZI::IStream
+{
+private:
+  const std::uint8_t* data_{nullptr};
+  std::uint64_t size_{0};
+
+  std::mutex mutex_;  ///< Protects the state used for the access hints.
+  std::uint64_t end_of_last_read_{0};
+  std::uint64_t end_of_data_requested_{0};
+  std::uint32_t number_of_sequential_reads_{0};
+  bool sequential_access_advised_{false};
+
+public:
+  /// Constructor - the file is opened and mapped, an exception is thrown if this fails.
+  ///
+  /// \param  file_name   The UTF8-encoded filename of the file to map.
+  explicit MemoryMappedInputStream(const std::string& file_name);
+  ~MemoryMappedInputStream() override;
+
+  MemoryMappedInputStream(const MemoryMappedInputStream&) = delete;
+  MemoryMappedInputStream& operator=(const MemoryMappedInputStream&) = delete;
+
+  void Read(std::uint64_t offset, void* data, std::uint64_t size, std::uint64_t* ptr_bytes_read) override;
+
+  /// Gets the size of the file.
+  ///
+  /// \returns The size of the file in bytes.
+  std::uint64_t GetSize() const { return this->size_; }
+
+private:
+  void AdviseAccess(std::uint64_t offset, std::uint64_t size);
+  void AdviseSequentialAccess(bool sequential);
+  void AdviseWillNeed(std::uint64_t offset, std::uint64_t size);
+};
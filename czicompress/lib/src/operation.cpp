@@ -6,6 +6,7 @@
 
 #include <memory>
 
+#include "../include/inputstream.h"
 #include "copyczi.h"
 #include "inc_libCZI.h"
 
@@ -25,17 +26,59 @@ void Operation::DoOperation(const std::function<bool(const ProgressInfo&)>& prog
 
   const auto operation = this->CreateCopyClass(progress_report_function);
   operation->Run();
+
+  const auto& action_with_subblock_statistics = operation->GetStatistics();
+  this->statistics_ = OperationStatistics();
+  this->statistics_.number_of_subblocks_copied_verbatim = action_with_subblock_statistics.GetCountOfSubblocksCopiedVerbatim();
+  this->statistics_.number_of_subblocks_compressed = action_with_subblock_statistics.GetCountOfSubblocksCompressed();
+  this->statistics_.number_of_subblocks_decompressed = action_with_subblock_statistics.GetCountOfSubblocksDecompressed();
+  this->statistics_.number_of_subblocks_already_compressed = action_with_subblock_statistics.GetCountOfSubblocksAlreadyCompressed();
+  this->statistics_.number_of_subblocks_kept_original = action_with_subblock_statistics.GetCountOfSubblocksKeptOriginal();
+  this->statistics_.peak_bytes_in_flight = action_with_subblock_statistics.GetPeakBytesInFlight();
+  this->statistics_.buffer_pool_hits = action_with_subblock_statistics.GetBufferPoolHits();
+  this->statistics_.buffer_pool_misses = action_with_subblock_statistics.GetBufferPoolMisses();
+  this->statistics_.byte_statistics = action_with_subblock_statistics.GetByteStatistics();
+
+  InputCacheStatistics input_cache_statistics;
+  if (this->description_.source_stream && TryGetInputCacheStatistics(this->description_.source_stream.get(), input_cache_statistics))
+  {
+    this->statistics_.input_cache_used = true;
+    this->statistics_.input_cache_hits = input_cache_statistics.hits;
+    this->statistics_.input_cache_misses = input_cache_statistics.misses;
+    this->statistics_.input_cache_reads = input_cache_statistics.number_of_reads;
+  }
+}
+
+bool Operation::AreAllSubBlocksCopiedVerbatim() { return this->CreateCopyClass(nullptr)->AreAllSubBlocksCopiedVerbatim(); }
+
+std::uint64_t Operation::EstimateSizeOfDestinationDocument()
+{
+  return this->CreateCopyClass(nullptr)->EstimateSizeOfDestinationDocument();
 }
 
+OperationStatistics Operation::GetStatistics() const { return this->statistics_; }
+
 std::unique_ptr<CopyCziBase> Operation::CreateCopyClass(const std::function<bool(const ProgressInfo&)>& progress)
 {
+  CopyCziOptions options;
+  options.number_of_threads = this->description_.number_of_threads;
+  options.max_bytes_in_flight = this->description_.max_inflight_megabytes * 1024 * 1024;
+  options.prefetch_depth = this->description_.prefetch_depth;
+  options.prefetch_max_bytes = this->description_.prefetch_megabytes * 1024 * 1024;
+  options.read_order = this->description_.read_order;
+  options.output_order = this->description_.output_order;
+  options.source_stream = this->description_.source_stream;
+  options.source_range_copy = this->description_.source_range_copy;
+  options.source_read_ahead = GetSourceReadAhead(this->description_.source_stream);
+  options.tracer = this->description_.tracer;
+
   switch (this->description_.command)
   {
     case Command::kDecompress:
-      return std::make_unique<CopyCziAndDecompress>(this->description_.reader, this->description_.writer, progress);
+      return std::make_unique<CopyCziAndDecompress>(this->description_.reader, this->description_.writer, progress, options);
     case Command::kCompress:
       return std::make_unique<CopyCziAndCompress>(this->description_.reader, this->description_.writer, progress,
-                                                  this->description_.compression_strategy, this->description_.compression_option);
+                                                  this->description_.compression_strategy, this->description_.compression_option, options);
     default:
       throw std::runtime_error("Unknown command");
   }
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 
 #include "copyczi.h"
@@ -15,12 +16,16 @@ class Operation final : public IOperation
 {
 private:
   OperationDescription description_;
+  OperationStatistics statistics_;
 
 public:
   ~Operation() override = default;
 
   void SetParameters(const OperationDescription& description) override;
   void DoOperation(const std::function<bool(const ProgressInfo&)>& progress) override;
+  bool AreAllSubBlocksCopiedVerbatim() override;
+  std::uint64_t EstimateSizeOfDestinationDocument() override;
+  OperationStatistics GetStatistics() const override;
 
 private:
   std::unique_ptr<CopyCziBase> CreateCopyClass(const std::function<bool(const ProgressInfo&)>& progress);
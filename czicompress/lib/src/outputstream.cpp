@@ -0,0 +1,132 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "../include/outputstream.h"
+
+#include <CZICompress_Config.h>
+#include <include/utils/utf8/utf8converter.h>
+
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "../inc_libCZI.h"
+#include "../include/inputstream.h"
+#include "copyfilerangeoutputstream.h"
+#include "directiooutputstream.h"
+#include "posixfileoutputstream.h"
+#include "ratelimitedoutputstream.h"
+#include "writebehindoutputstream.h"
+
+std::shared_ptr<libCZI::IOutputStream> CreateOutputStreamForFile(const std::string& file_name, const OutputStreamOptions& options)
+{
+  if (!options.copy_file_range_source_file_name.empty())
+  {
+    if (options.write_buffer_size > 0)
+    {
+      throw std::invalid_argument("Copying ranges of the source file cannot be combined with a write buffer.");
+    }
+
+    if (options.direct_io)
+    {
+      throw std::invalid_argument("Copying ranges of the source file cannot be combined with direct I/O.");
+    }
+
+    if (IsHttpUrl(options.copy_file_range_source_file_name))
+    {
+      throw std::invalid_argument("Copying ranges of the source file is not possible if it is read from an http(s)-URL.");
+    }
+
+#if CZICOMPRESS_UNIX_ENVIRONMENT
+    std::shared_ptr<libCZI::IOutputStream> copy_file_range_output_stream = std::make_shared<CopyFileRangeOutputStream>(
+        file_name, options.overwrite_existing_file, options.copy_file_range_source_file_name, options.preallocation_size);
+    if (options.rate_limiter)
+    {
+      copy_file_range_output_stream =
+          std::make_shared<RateLimitedOutputStream>(std::move(copy_file_range_output_stream), options.rate_limiter);
+    }
+
+    return copy_file_range_output_stream;
+#else
+    throw std::invalid_argument("Copying ranges of the source file is not supported on this platform.");
+#endif
+  }
+
+  std::shared_ptr<libCZI::IOutputStream> output_stream;
+  if (options.direct_io)
+  {
+#if CZICOMPRESS_UNIX_ENVIRONMENT
+    output_stream = std::make_shared<DirectIoOutputStream>(file_name, options.overwrite_existing_file, options.preallocation_size);
+#else
+    throw std::invalid_argument("Direct I/O is not supported on this platform.");
+#endif
+  }
+  // preallocating is a hint only, which is ignored on other platforms
+#if CZICOMPRESS_UNIX_ENVIRONMENT
+  else if (options.preallocation_size > 0)
+  {
+    output_stream = std::make_shared<PosixFileOutputStream>(file_name, options.overwrite_existing_file, options.preallocation_size);
+  }
+#endif
+  else
+  {
+    output_stream = libCZI::CreateOutputStreamForFile(utils::utf8::WidenUtf8(file_name).c_str(), options.overwrite_existing_file);
+  }
+
+  if (options.rate_limiter)
+  {
+    output_stream = std::make_shared<RateLimitedOutputStream>(std::move(output_stream), options.rate_limiter);
+  }
+
+  if (options.write_buffer_size == 0)
+  {
+    return output_stream;
+  }
+
+  if (options.write_buffer_size > (std::numeric_limits<size_t>::max)())
+  {
+    throw std::invalid_argument("The write buffer size is too large.");
+  }
+
+  return std::make_shared<WriteBehindOutputStream>(std::move(output_stream), static_cast<size_t>(options.write_buffer_size));
+}
+
+std::shared_ptr<ISourceRangeCopy> GetSourceRangeCopy(const std::shared_ptr<libCZI::IOutputStream>& output_stream)
+{
+  // the announcements are passed on to the stream below the rate limiter, which sees the same write operations
+  const auto rate_limited_output_stream = std::dynamic_pointer_cast<RateLimitedOutputStream>(output_stream);
+  if (rate_limited_output_stream)
+  {
+    return GetSourceRangeCopy(rate_limited_output_stream->GetUnderlyingStream());
+  }
+
+  return std::dynamic_pointer_cast<ISourceRangeCopy>(output_stream);
+}
+
+void CloseOutputStream(libCZI::IOutputStream* output_stream)
+{
+  auto* write_behind_output_stream = dynamic_cast<WriteBehindOutputStream*>(output_stream);
+  if (write_behind_output_stream != nullptr)
+  {
+    write_behind_output_stream->Close();
+    CloseOutputStream(write_behind_output_stream->GetUnderlyingStream().get());
+  }
+
+  auto* rate_limited_output_stream = dynamic_cast<RateLimitedOutputStream*>(output_stream);
+  if (rate_limited_output_stream != nullptr)
+  {
+    CloseOutputStream(rate_limited_output_stream->GetUnderlyingStream().get());
+  }
+
+#if CZICOMPRESS_UNIX_ENVIRONMENT
+  // this includes the 'CopyFileRangeOutputStream' and the 'DirectIoOutputStream'
+  auto* posix_file_output_stream = dynamic_cast<PosixFileOutputStream*>(output_stream);
+  if (posix_file_output_stream != nullptr)
+  {
+    posix_file_output_stream->Close();
+  }
+#endif
+}
@@ -0,0 +1,74 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "pooledbitmapsite.h"
+
+#include "../include/bufferpoolsite.h"
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// Implementation of libCZI::IBitmapData where the pixel data is held in a buffer from a buffer pool.
+class PooledBitmap : public libCZI::IBitmapData
+{
+private:
+  std::shared_ptr<void> buffer_;
+  libCZI::PixelType pixel_type_;
+  std::uint32_t width_;
+  std::uint32_t height_;
+  std::uint32_t stride_;
+
+public:
+  PooledBitmap(std::shared_ptr<void> buffer, libCZI::PixelType pixel_type, std::uint32_t width, std::uint32_t height, std::uint32_t stride)
+      : buffer_(std::move(buffer)), pixel_type_(pixel_type), width_(width), height_(height), stride_(stride)
+  {
+  }
+
+  libCZI::PixelType GetPixelType() const override { return this->pixel_type_; }
+
+  libCZI::IntSize GetSize() const override { return libCZI::IntSize{this->width_, this->height_}; }
+
+  libCZI::BitmapLockInfo Lock() override
+  {
+    libCZI::BitmapLockInfo bitmap_lock_info;
+    bitmap_lock_info.ptrData = this->buffer_.get();
+    bitmap_lock_info.ptrDataRoi = this->buffer_.get();
+    bitmap_lock_info.stride = this->stride_;
+    bitmap_lock_info.size = static_cast<std::uint64_t>(this->stride_) * this->height_;
+    return bitmap_lock_info;
+  }
+
+  void Unlock() override {}
+};
+
+}  // namespace
+
+bool PooledBitmapSite::IsEnabled(int log_level) { return this->underlying_site_->IsEnabled(log_level); }
+
+void PooledBitmapSite::Log(int level, const char* message) { this->underlying_site_->Log(level, message); }
+
+std::shared_ptr<libCZI::IDecoder> PooledBitmapSite::GetDecoder(libCZI::ImageDecoderType type, const char* arguments)
+{
+  return this->underlying_site_->GetDecoder(type, arguments);
+}
+
+std::shared_ptr<libCZI::IBitmapData> PooledBitmapSite::CreateBitmap(libCZI::PixelType pixel_type, std::uint32_t width,
+                                                                    std::uint32_t height, std::uint32_t stride, std::uint32_t extra_rows,
+                                                                    std::uint32_t extra_columns)
+{
+  if (stride == 0)
+  {
+    stride = (width + extra_columns) * libCZI::Utils::GetBytesPerPixel(pixel_type);
+  }
+
+  auto buffer = this->buffer_pool_->Allocate(static_cast<size_t>(stride) * (static_cast<size_t>(height) + extra_rows));
+  return std::make_shared<PooledBitmap>(std::move(buffer), pixel_type, width, height, stride);
+}
+
+void InstallPooledBitmapSite(libCZI::ISite* underlying_site)
+{
+  // the site object must stay alive as long as libCZI is in use, i.e. until the end of the process
+  static PooledBitmapSite pooled_bitmap_site(underlying_site, BufferPool::GetSharedInstance());
+  libCZI::SetSiteObject(&pooled_bitmap_site);
+}
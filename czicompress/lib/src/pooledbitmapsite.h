@@ -0,0 +1,39 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "../inc_libCZI.h"
+#include "bufferpool.h"
+
+/// Implementation of libCZI::ISite which allocates the bitmaps from a buffer pool. libCZI creates all bitmaps
+/// (in particular the bitmaps decoded from subblocks) through the site object, so with this site object installed,
+/// the decoded bitmaps are recycled across subblocks. All other functionality (logging and the decoders) is
+/// delegated to another site object.
+class PooledBitmapSite : public libCZI::ISite
+{
+private:
+  libCZI::ISite* underlying_site_;
+  std::shared_ptr<BufferPool> buffer_pool_;
+
+public:
+  /// Constructor.
+  ///
+  /// \param  underlying_site The site object to which logging and the creation of decoders is delegated.
+  /// \param  buffer_pool     The buffer pool from which the bitmaps are allocated.
+  PooledBitmapSite(libCZI::ISite* underlying_site, std::shared_ptr<BufferPool> buffer_pool)
+      : underlying_site_(underlying_site), buffer_pool_(std::move(buffer_pool))
+  {
+  }
+
+  bool IsEnabled(int log_level) override;
+  void Log(int level, const char* message) override;
+  std::shared_ptr<libCZI::IDecoder> GetDecoder(libCZI::ImageDecoderType type, const char* arguments) override;
+  std::shared_ptr<libCZI::IBitmapData> CreateBitmap(libCZI::PixelType pixel_type, std::uint32_t width, std::uint32_t height,
+                                                    std::uint32_t stride, std::uint32_t extra_rows, std::uint32_t extra_columns) override;
+};
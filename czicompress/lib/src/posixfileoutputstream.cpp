@@ -0,0 +1,179 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "posixfileoutputstream.h"
+
+#include <CZICompress_Config.h>
+
+#if CZICOMPRESS_UNIX_ENVIRONMENT
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+PosixFileOutputStream::PosixFileOutputStream(const std::string& file_name, bool overwrite_existing_file, std::uint64_t preallocation_size)
+    : PosixFileOutputStream(file_name, overwrite_existing_file, preallocation_size, false)
+{
+}
+
+PosixFileOutputStream::PosixFileOutputStream(const std::string& file_name, bool overwrite_existing_file, std::uint64_t preallocation_size,
+                                             bool direct_io)
+    : file_name_(file_name)
+{
+  const int flags = O_CREAT | O_CLOEXEC | (overwrite_existing_file ? O_TRUNC : O_EXCL) | (direct_io ? O_RDWR : O_WRONLY);
+  this->file_descriptor_ = open(file_name.c_str(), flags, 0666);  // NOLINT: vararg function
+  if (this->file_descriptor_ < 0)
+  {
+    throw std::runtime_error(PosixFileOutputStream::GetErrorText("open", file_name, errno));
+  }
+
+  // direct I/O is enabled on the open file (instead of passing O_DIRECT to 'open'), because if the file system does not
+  // support it, we continue with buffered I/O
+  if (direct_io)
+  {
+#if defined(O_DIRECT)
+    const int status_flags = fcntl(this->file_descriptor_, F_GETFL);  // NOLINT: vararg function
+    this->is_direct_io_ = status_flags >= 0 && fcntl(this->file_descriptor_, F_SETFL, status_flags | O_DIRECT) == 0;  // NOLINT
+#elif defined(F_NOCACHE)
+    // on macOS, the page cache is bypassed with the F_NOCACHE-flag instead
+    this->is_direct_io_ = fcntl(this->file_descriptor_, F_NOCACHE, 1) == 0;  // NOLINT: vararg function
+#endif
+  }
+
+  if (preallocation_size > 0)
+  {
+    this->Preallocate(preallocation_size);
+  }
+}
+
+PosixFileOutputStream::~PosixFileOutputStream()
+{
+  try
+  {
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    this->CloseFile();
+  }
+  catch (...)
+  {
+    // there is no way to report an error here - 'Close' should have been called before
+  }
+}
+
+void PosixFileOutputStream::Write(std::uint64_t offset, const void* data, std::uint64_t size, std::uint64_t* ptr_bytes_written)
+{
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  if (this->file_descriptor_ < 0)
+  {
+    throw std::logic_error("The stream has already been closed.");
+  }
+
+  this->WriteFromMemory(offset, data, size);
+  if (ptr_bytes_written != nullptr)
+  {
+    *ptr_bytes_written = size;
+  }
+}
+
+void PosixFileOutputStream::Close()
+{
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  this->CloseFile();
+}
+
+void PosixFileOutputStream::WriteFromMemory(std::uint64_t offset, const void* data, std::uint64_t size)
+{
+  this->RecordEndOfDataWritten(offset + size);
+  const auto* source = static_cast<const std::uint8_t*>(data);
+  while (size > 0)
+  {
+    const auto size_to_write = static_cast<size_t>((std::min)(size, static_cast<std::uint64_t>((std::numeric_limits<ssize_t>::max)())));
+    const ssize_t result = pwrite(this->file_descriptor_, source, size_to_write, static_cast<off_t>(offset));
+    if (result < 0)
+    {
+      const int error_number = errno;
+      if (error_number == EINTR)
+      {
+        continue;
+      }
+
+      throw std::runtime_error(PosixFileOutputStream::GetErrorText("pwrite", this->file_name_, error_number));
+    }
+
+    source += result;  // NOLINT: pointer arithmetic
+    offset += static_cast<std::uint64_t>(result);
+    size -= static_cast<std::uint64_t>(result);
+  }
+}
+
+void PosixFileOutputStream::RecordEndOfDataWritten(std::uint64_t end_of_data)
+{
+  this->end_of_data_written_ = (std::max)(this->end_of_data_written_, end_of_data);
+}
+
+void PosixFileOutputStream::CloseFile()
+{
+  if (this->file_descriptor_ < 0)
+  {
+    return;
+  }
+
+  // the preallocated space beyond the data written is released - note that the file may also have grown beyond it
+  int error_number = 0;
+  if (this->preallocated_size_ > this->end_of_data_written_ &&
+      ftruncate(this->file_descriptor_, static_cast<off_t>(this->end_of_data_written_)) != 0)
+  {
+    error_number = errno;
+  }
+
+  if (close(this->file_descriptor_) != 0 && error_number == 0)
+  {
+    error_number = errno;
+  }
+
+  this->file_descriptor_ = -1;
+  if (error_number != 0)
+  {
+    throw std::runtime_error(PosixFileOutputStream::GetErrorText("close", this->file_name_, error_number));
+  }
+}
+
+/*static*/ std::string PosixFileOutputStream::GetErrorText(const std::string& operation, const std::string& file_name, int error_number)
+{
+  return "Error: " + operation + " failed for file '" + file_name + "': " + std::generic_category().message(error_number);
+}
+
+void PosixFileOutputStream::Preallocate(std::uint64_t size)
+{
+#if defined(__linux__)
+  // we use 'fallocate' (instead of 'posix_fallocate') because the latter falls back to writing zeros if the file system
+  // does not support preallocating - which would double the amount of data written
+  int result = 0;
+  do
+  {
+    result = fallocate(this->file_descriptor_, 0, 0, static_cast<off_t>(size));
+  } while (result != 0 && errno == EINTR);
+
+  if (result == 0)
+  {
+    this->preallocated_size_ = size;
+    return;
+  }
+
+  // the file has just been created, so if the preallocation failed half-way (e.g. with ENOSPC), we can simply discard
+  // what has been allocated - the data is then written without preallocation (and it might still fit)
+  if (ftruncate(this->file_descriptor_, 0) != 0)
+  {
+    throw std::runtime_error(PosixFileOutputStream::GetErrorText("ftruncate", this->file_name_, errno));
+  }
+#else
+  (void)size;
+#endif
+}
+
+#endif  // CZICOMPRESS_UNIX_ENVIRONMENT
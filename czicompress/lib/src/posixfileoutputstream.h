@@ -0,0 +1,92 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "../inc_libCZI.h"
+
+/// Implementation of libCZI::IOutputStream (for POSIX systems) which writes to a file with 'pwrite'. Optionally, space
+/// for the file is allocated up front (with 'fallocate'), so that the file system can place the file in few large extents
+/// instead of extending it one segment at a time. When the stream is closed, the file is truncated to the size of the data
+/// actually written - so the preallocated size is only an estimate, and it may be smaller or larger than the final size.
+/// Preallocating is a hint only, i.e. if the file system does not support it (or there is not enough free space), the
+/// file is written without preallocation.
+class PosixFileOutputStream : public libCZI::IOutputStream
+{
+protected:
+  std::string file_name_;
+  int file_descriptor_{-1};
+  std::mutex mutex_;  ///< Protects the file descriptor and the end of the data written.
+
+private:
+  std::uint64_t preallocated_size_{0};
+  std::uint64_t end_of_data_written_{0};
+  bool is_direct_io_{false};
+
+public:
+  /// Constructor - the file is created, an exception is thrown if this fails.
+  ///
+  /// \param  file_name                   The UTF8-encoded filename of the file to create.
+  /// \param  overwrite_existing_file     If true, an existing file is overwritten; otherwise it is an error if the file exists.
+  /// \param  preallocation_size          The number of bytes to allocate for the file up front - 0 means no preallocation.
+  PosixFileOutputStream(const std::string& file_name, bool overwrite_existing_file, std::uint64_t preallocation_size);
+  ~PosixFileOutputStream() override;
+
+protected:
+  /// Constructor for derived classes which are able to write to a file opened for direct I/O (i.e. bypassing the page
+  /// cache). With direct I/O, the file is opened for reading and writing, and all write operations must be aligned. If
+  /// the file system does not support direct I/O, the file is opened as usual - see 'IsDirectIo'.
+  ///
+  /// \param  file_name                   The UTF8-encoded filename of the file to create.
+  /// \param  overwrite_existing_file     If true, an existing file is overwritten; otherwise it is an error if the file exists.
+  /// \param  preallocation_size          The number of bytes to allocate for the file up front - 0 means no preallocation.
+  /// \param  direct_io                   If true, the file is to be opened for direct I/O.
+  PosixFileOutputStream(const std::string& file_name, bool overwrite_existing_file, std::uint64_t preallocation_size, bool direct_io);
+
+public:
+  PosixFileOutputStream(const PosixFileOutputStream&) = delete;
+  PosixFileOutputStream& operator=(const PosixFileOutputStream&) = delete;
+
+  void Write(std::uint64_t offset, const void* data, std::uint64_t size, std::uint64_t* ptr_bytes_written) override;
+
+  /// Gets the number of bytes which have been allocated for the file up front - this is 0 if no preallocation was
+  /// requested, or if preallocating failed.
+  ///
+  /// \returns The number of bytes preallocated.
+  std::uint64_t GetPreallocatedSize() const { return this->preallocated_size_; }
+
+  /// Gets a boolean indicating whether the file has been opened for direct I/O (i.e. the page cache is bypassed).
+  ///
+  /// \returns True if the file has been opened for direct I/O; false otherwise.
+  bool IsDirectIo() const { return this->is_direct_io_; }
+
+  /// Closes the file - if space was preallocated, the file is truncated to the size of the data written before. If
+  /// this fails (which may be the first time a write error is reported, e.g. with network file systems), an exception is
+  /// thrown. After this, the stream cannot be written to anymore.
+  virtual void Close();
+
+protected:
+  /// Writes the data at the specified offset of the file. The caller must hold the mutex.
+  void WriteFromMemory(std::uint64_t offset, const void* data, std::uint64_t size);
+
+  /// Records that the file has been written up to the specified offset. The caller must hold the mutex.
+  void RecordEndOfDataWritten(std::uint64_t end_of_data);
+
+  /// Gets the offset up to which the file has been written. The caller must hold the mutex.
+  ///
+  /// \returns The end of the data written.
+  std::uint64_t GetEndOfDataWritten() const { return this->end_of_data_written_; }
+
+  /// Closes the file. The caller must hold the mutex.
+  void CloseFile();
+
+  static std::string GetErrorText(const std::string& operation, const std::string& file_name, int error_number);
+
+private:
+  void Preallocate(std::uint64_t size);
+};
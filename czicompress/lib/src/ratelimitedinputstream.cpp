@@ -0,0 +1,24 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "ratelimitedinputstream.h"
+
+#include <stdexcept>
+#include <utility>
+
+RateLimitedInputStream::RateLimitedInputStream(std::shared_ptr<libCZI::IStream> underlying_stream,
+                                               std::shared_ptr<RateLimiter> rate_limiter)
+    : underlying_stream_(std::move(underlying_stream)), rate_limiter_(std::move(rate_limiter))
+{
+  if (!this->underlying_stream_ || !this->rate_limiter_)
+  {
+    throw std::invalid_argument("The stream and the rate limiter must not be null.");
+  }
+}
+
+void RateLimitedInputStream::Read(std::uint64_t offset, void* data, std::uint64_t size, std::uint64_t* ptr_bytes_read)
+{
+  this->rate_limiter_->Acquire(size);
+  this->underlying_stream_->Read(offset, data, size, ptr_bytes_read);
+}
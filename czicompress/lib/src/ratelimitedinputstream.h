@@ -0,0 +1,34 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "../inc_libCZI.h"
+#include "../include/ratelimiter.h"
+
+/// Implementation of libCZI::IStream which limits the rate at which data is read from an underlying stream - each
+/// read operation acquires the tokens for the requested number of bytes from the rate limiter before it is carried out.
+class RateLimitedInputStream : public libCZI::IStream
+{
+private:
+  std::shared_ptr<libCZI::IStream> underlying_stream_;
+  std::shared_ptr<RateLimiter> rate_limiter_;
+
+public:
+  /// Constructor.
+  ///
+  /// \param  underlying_stream   The stream to read from.
+  /// \param  rate_limiter        The rate limiter (which may be shared with other streams).
+  RateLimitedInputStream(std::shared_ptr<libCZI::IStream> underlying_stream, std::shared_ptr<RateLimiter> rate_limiter);
+
+  void Read(std::uint64_t offset, void* data, std::uint64_t size, std::uint64_t* ptr_bytes_read) override;
+
+  /// Gets the stream which is read from.
+  ///
+  /// \returns The underlying stream.
+  const std::shared_ptr<libCZI::IStream>& GetUnderlyingStream() const { return this->underlying_stream_; }
+};
@@ -0,0 +1,24 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "ratelimitedoutputstream.h"
+
+#include <stdexcept>
+#include <utility>
+
+RateLimitedOutputStream::RateLimitedOutputStream(std::shared_ptr<libCZI::IOutputStream> underlying_stream,
+                                                 std::shared_ptr<RateLimiter> rate_limiter)
+    : underlying_stream_(std::move(underlying_stream)), rate_limiter_(std::move(rate_limiter))
+{
+  if (!this->underlying_stream_ || !this->rate_limiter_)
+  {
+    throw std::invalid_argument("The stream and the rate limiter must not be null.");
+  }
+}
+
+void RateLimitedOutputStream::Write(std::uint64_t offset, const void* data, std::uint64_t size, std::uint64_t* ptr_bytes_written)
+{
+  this->rate_limiter_->Acquire(size);
+  this->underlying_stream_->Write(offset, data, size, ptr_bytes_written);
+}
@@ -0,0 +1,36 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "../inc_libCZI.h"
+#include "../include/ratelimiter.h"
+
+/// Implementation of libCZI::IOutputStream which limits the rate at which data is written to an underlying stream -
+/// each write operation acquires the tokens for its number of bytes from the rate limiter before it is carried out.
+/// The data is passed on unchanged (with the same pointer), so that the underlying stream is able to recognize
+/// announced ranges of the source file (see 'ISourceRangeCopy') - those are limited in the same way.
+class RateLimitedOutputStream : public libCZI::IOutputStream
+{
+private:
+  std::shared_ptr<libCZI::IOutputStream> underlying_stream_;
+  std::shared_ptr<RateLimiter> rate_limiter_;
+
+public:
+  /// Constructor.
+  ///
+  /// \param  underlying_stream   The stream to write to.
+  /// \param  rate_limiter        The rate limiter (which may be shared with other streams).
+  RateLimitedOutputStream(std::shared_ptr<libCZI::IOutputStream> underlying_stream, std::shared_ptr<RateLimiter> rate_limiter);
+
+  void Write(std::uint64_t offset, const void* data, std::uint64_t size, std::uint64_t* ptr_bytes_written) override;
+
+  /// Gets the stream which is written to.
+  ///
+  /// \returns The underlying stream.
+  const std::shared_ptr<libCZI::IOutputStream>& GetUnderlyingStream() const { return this->underlying_stream_; }
+};
@@ -0,0 +1,96 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "../include/ratelimiter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+constexpr double kBytesPerMegabyte = 1024.0 * 1024.0;
+
+/// The size of the bucket, i.e. the number of seconds worth of data which can be transferred in a burst.
+constexpr double kBurstSeconds = 0.1;
+
+}  // namespace
+
+RateLimiter::RateLimiter(double megabytes_per_second) : time_of_last_refill_(std::chrono::steady_clock::now())
+{
+  this->SetMaxMegabytesPerSecond(megabytes_per_second);
+}
+
+void RateLimiter::SetMaxMegabytesPerSecond(double megabytes_per_second)
+{
+  if (!(megabytes_per_second >= 0) || std::isinf(megabytes_per_second))
+  {
+    throw std::invalid_argument("The maximum rate must be a non-negative number.");
+  }
+
+  {
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    this->Refill(std::chrono::steady_clock::now());
+    this->bytes_per_second_ = megabytes_per_second * kBytesPerMegabyte;
+
+    // a debt is kept (it is paid off at the new rate) unless the limit is lifted, and the tokens are capped at the new
+    //  burst size
+    this->tokens_ = this->bytes_per_second_ > 0 ? (std::min)(this->tokens_, this->bytes_per_second_ * kBurstSeconds) : 0;
+  }
+
+  this->condition_variable_.notify_all();
+}
+
+double RateLimiter::GetMaxMegabytesPerSecond()
+{
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->bytes_per_second_ / kBytesPerMegabyte;
+}
+
+void RateLimiter::Acquire(std::uint64_t number_of_bytes)
+{
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  if (this->bytes_per_second_ <= 0)
+  {
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  this->Refill(now);
+  if (this->tokens_ < 0)
+  {
+    // we wait until the debt left by previous operations has been paid off - the rate may change (or the limit may be
+    //  lifted) while we are waiting
+    const auto start_of_wait = now;
+    while (this->tokens_ < 0 && this->bytes_per_second_ > 0)
+    {
+      const std::chrono::duration<double> time_to_wait(-this->tokens_ / this->bytes_per_second_);
+      this->condition_variable_.wait_for(lock, std::chrono::duration_cast<std::chrono::nanoseconds>(time_to_wait));
+      now = std::chrono::steady_clock::now();
+      this->Refill(now);
+    }
+
+    this->throttled_time_ += std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_of_wait);
+    if (this->bytes_per_second_ <= 0)
+    {
+      return;
+    }
+  }
+
+  this->tokens_ -= static_cast<double>(number_of_bytes);
+}
+
+std::chrono::nanoseconds RateLimiter::GetThrottledTime()
+{
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->throttled_time_;
+}
+
+void RateLimiter::Refill(std::chrono::steady_clock::time_point now)
+{
+  const std::chrono::duration<double> elapsed = now - this->time_of_last_refill_;
+  this->time_of_last_refill_ = now;
+  this->tokens_ = (std::min)(this->tokens_ + elapsed.count() * this->bytes_per_second_, this->bytes_per_second_ * kBurstSeconds);
+}
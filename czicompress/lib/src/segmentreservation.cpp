@@ -0,0 +1,94 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "../include/segmentreservation.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+// see the CZI file format specification for the layout of the file header segment (the positions are 64-bit
+// little-endian integers, where 0 means "not present")
+constexpr size_t kSegmentHeaderSize = 32;
+constexpr size_t kOffsetOfSubBlockDirectoryPosition = kSegmentHeaderSize + 52;
+constexpr size_t kOffsetOfMetadataPosition = kSegmentHeaderSize + 60;
+constexpr size_t kOffsetOfAttachmentDirectoryPosition = kSegmentHeaderSize + 72;
+
+/// The metadata of the destination document is modified (and re-serialized) by the copy operation, so it may be
+/// somewhat larger than the metadata of the source document - we add this fraction of its size to the reservation...
+constexpr size_t kMetadataReservationMarginDivisor = 4;
+
+/// ...plus this number of bytes.
+constexpr size_t kMetadataReservationMarginBytes = 16 * 1024;
+
+}  // namespace
+
+SegmentReservations ReserveSegmentsForCopy(libCZI::ICZIReader* reader, libCZI::CCziWriterInfo* writer_info)
+{
+  SegmentReservations reservations;
+
+  // the destination document contains the same subblocks and attachments as the source document
+  const auto statistics = reader->GetStatistics();
+  reservations.number_of_subblock_directory_entries = static_cast<size_t>((std::max)(statistics.subBlockCount, 0));
+
+  reader->EnumerateAttachments(
+      [&reservations](int, const libCZI::AttachmentInfo&) -> bool
+      {
+        ++reservations.number_of_attachment_directory_entries;
+        return true;
+      });
+
+  const auto metadata_segment = reader->ReadMetadataSegment();
+  if (metadata_segment)
+  {
+    const void* ptr = nullptr;
+    size_t size = 0;
+    metadata_segment->DangerousGetRawData(libCZI::IMetadataSegment::MemBlkType::XmlMetadata, ptr, size);
+    reservations.metadata_size = size + size / kMetadataReservationMarginDivisor + kMetadataReservationMarginBytes;
+  }
+
+  writer_info->SetReservedSizeForSubBlockDirectory(reservations.number_of_subblock_directory_entries > 0,
+                                                   reservations.number_of_subblock_directory_entries);
+  writer_info->SetReservedSizeForAttachmentsDirectory(reservations.number_of_attachment_directory_entries > 0,
+                                                      reservations.number_of_attachment_directory_entries);
+  writer_info->SetReservedSizeForMetadataSegment(reservations.metadata_size > 0, reservations.metadata_size);
+  return reservations;
+}
+
+void SegmentPlacementRecorder::Write(std::uint64_t offset, const void* data, std::uint64_t size, std::uint64_t* ptr_bytes_written)
+{
+  this->underlying_stream_->Write(offset, data, size, ptr_bytes_written);
+
+  // keep a copy of the part of the file header which contains the positions of the segments
+  if (offset < kSizeOfObservedFileHeader)
+  {
+    const size_t size_to_copy = static_cast<size_t>((std::min)(size, kSizeOfObservedFileHeader - offset));
+    memcpy(this->file_header_.data() + offset, data, size_to_copy);  // NOLINT: pointer arithmetic
+  }
+
+  this->end_of_data_written_ = (std::max)(this->end_of_data_written_, offset + size);
+}
+
+SegmentPlacements SegmentPlacementRecorder::GetSegmentPlacements() const
+{
+  SegmentPlacements placements;
+  placements.subblock_directory = this->GetPlacementOfSegmentAt(kOffsetOfSubBlockDirectoryPosition);
+  placements.attachment_directory = this->GetPlacementOfSegmentAt(kOffsetOfAttachmentDirectoryPosition);
+  placements.metadata = this->GetPlacementOfSegmentAt(kOffsetOfMetadataPosition);
+  return placements;
+}
+
+SegmentPlacement SegmentPlacementRecorder::GetPlacementOfSegmentAt(size_t offset_in_file_header) const
+{
+  std::uint64_t position = 0;
+  memcpy(&position, this->file_header_.data() + offset_in_file_header, sizeof(position));  // NOLINT: pointer arithmetic
+  if (position == 0)
+  {
+    return SegmentPlacement::kNotWritten;
+  }
+
+  return position < this->end_of_reserved_space_ ? SegmentPlacement::kReservedSpace : SegmentPlacement::kEndOfFile;
+}
@@ -0,0 +1,126 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "subblockhelpers.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+// see the CZI file format specification for the layout of the subblock segment - the segment header is followed
+// by the sizes of the metadata, the attachment and the data, and the directory entry; this part is padded to (at
+// least) 256 bytes, and it is followed by the metadata, the data and the attachment
+constexpr size_t kSegmentHeaderSize = 32;
+constexpr size_t kOffsetOfMetadataSize = kSegmentHeaderSize;
+constexpr size_t kOffsetOfDataSize = kSegmentHeaderSize + 8;
+constexpr size_t kOffsetOfDirectoryEntry = kSegmentHeaderSize + 16;
+constexpr size_t kOffsetOfDimensionCountInDirectoryEntry = 28;
+constexpr size_t kSizeOfDirectoryEntryWithoutDimensions = 32;
+constexpr size_t kSizeOfDimensionEntry = 20;
+constexpr size_t kMinimalSizeOfSubBlockSegmentData = 256;
+constexpr size_t kSizeOfSubBlockSegmentHeaderToRead = kOffsetOfDirectoryEntry + kOffsetOfDimensionCountInDirectoryEntry + 4;
+constexpr char kSubBlockSegmentId[] = "ZISRAWSUBBLOCK";
+
+/// The number of bytes at the start of the data which are compared in order to validate the position of the data.
+constexpr size_t kSizeOfDataToCompare = 64;
+
+template <typename T>
+T GetLittleEndianValue(const std::uint8_t* ptr)
+{
+  T value;
+  memcpy(&value, ptr, sizeof(T));
+  return value;
+}
+
+}  // namespace
+
+std::uint64_t GetSizeOfSubBlockInMemory(const std::shared_ptr<libCZI::ISubBlock>& subblock)
+{
+  std::uint64_t total_size = 0;
+  for (const auto memory_block_type :
+       {libCZI::ISubBlock::MemBlkType::Metadata, libCZI::ISubBlock::MemBlkType::Data, libCZI::ISubBlock::MemBlkType::Attachment})
+  {
+    const void* ptr{nullptr};
+    size_t size = 0;
+    subblock->DangerousGetRawData(memory_block_type, ptr, size);
+    total_size += size;
+  }
+
+  return total_size;
+}
+
+std::uint64_t GetSizeOfSubBlockData(const std::shared_ptr<libCZI::ISubBlock>& subblock)
+{
+  const void* ptr{nullptr};
+  size_t size = 0;
+  subblock->DangerousGetRawData(libCZI::ISubBlock::MemBlkType::Data, ptr, size);
+  return size;
+}
+
+bool TryGetPixelDataOfUncompressedSubBlock(const std::shared_ptr<libCZI::ISubBlock>& subblock, const void*& data, std::uint32_t& stride)
+{
+  const libCZI::SubBlockInfo& subblock_info = subblock->GetSubBlockInfo();
+  if (subblock_info.GetCompressionMode() != libCZI::CompressionMode::UnCompressed)
+  {
+    return false;
+  }
+
+  const void* raw_data = nullptr;
+  size_t size_of_raw_data = 0;
+  subblock->DangerousGetRawData(libCZI::ISubBlock::MemBlkType::Data, raw_data, size_of_raw_data);
+  const std::uint64_t line_length =
+      static_cast<std::uint64_t>(subblock_info.physicalSize.w) * libCZI::Utils::GetBytesPerPixel(subblock_info.pixelType);
+  if (raw_data == nullptr || line_length > (std::numeric_limits<std::uint32_t>::max)() ||
+      size_of_raw_data < line_length * subblock_info.physicalSize.h)
+  {
+    return false;
+  }
+
+  data = raw_data;
+  stride = static_cast<std::uint32_t>(line_length);
+  return true;
+}
+
+bool TryGetFilePositionOfSubBlockData(libCZI::IStream* stream, std::uint64_t segment_position, const void* data, std::uint64_t size,
+                                      std::uint64_t& data_position)
+{
+  std::array<std::uint8_t, kSizeOfSubBlockSegmentHeaderToRead> segment_header{};
+  std::uint64_t bytes_read = 0;
+  stream->Read(segment_position, segment_header.data(), segment_header.size(), &bytes_read);
+  if (bytes_read != segment_header.size() || memcmp(segment_header.data(), kSubBlockSegmentId, sizeof(kSubBlockSegmentId)) != 0)
+  {
+    return false;
+  }
+
+  const auto metadata_size =
+      GetLittleEndianValue<std::int32_t>(segment_header.data() + kOffsetOfMetadataSize);                   // NOLINT: pointer arithmetic
+  const auto data_size = GetLittleEndianValue<std::int64_t>(segment_header.data() + kOffsetOfDataSize);  // NOLINT: pointer arithmetic
+  const auto dimension_count = GetLittleEndianValue<std::int32_t>(segment_header.data() + kOffsetOfDirectoryEntry +  // NOLINT
+                                                                   kOffsetOfDimensionCountInDirectoryEntry);
+  if (metadata_size < 0 || data_size < 0 || static_cast<std::uint64_t>(data_size) != size || dimension_count < 0)
+  {
+    return false;
+  }
+
+  const std::uint64_t size_of_segment_data =
+      (std::max)(static_cast<std::uint64_t>(kOffsetOfDirectoryEntry - kSegmentHeaderSize + kSizeOfDirectoryEntryWithoutDimensions) +
+                     static_cast<std::uint64_t>(dimension_count) * kSizeOfDimensionEntry,
+                 static_cast<std::uint64_t>(kMinimalSizeOfSubBlockSegmentData));
+  const std::uint64_t position = segment_position + kSegmentHeaderSize + size_of_segment_data + static_cast<std::uint64_t>(metadata_size);
+
+  std::array<std::uint8_t, kSizeOfDataToCompare> start_of_data{};
+  const auto size_to_compare = static_cast<size_t>((std::min)(size, static_cast<std::uint64_t>(kSizeOfDataToCompare)));
+  stream->Read(position, start_of_data.data(), size_to_compare, &bytes_read);
+  if (bytes_read != size_to_compare || memcmp(start_of_data.data(), data, size_to_compare) != 0)
+  {
+    return false;
+  }
+
+  data_position = position;
+  return true;
+}
@@ -0,0 +1,51 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "../inc_libCZI.h"
+
+/// Gets the number of bytes held by the subblock object, i.e. the size of its data, metadata and attachment.
+///
+/// \param  subblock    The subblock.
+///
+/// \returns    The number of bytes held by the subblock object.
+std::uint64_t GetSizeOfSubBlockInMemory(const std::shared_ptr<libCZI::ISubBlock>& subblock);
+
+/// Gets the size of the data of the subblock (i.e. of the - possibly compressed - pixel data, without the metadata and
+/// the attachment).
+///
+/// \param  subblock    The subblock.
+///
+/// \returns    The size of the data of the subblock in bytes.
+std::uint64_t GetSizeOfSubBlockData(const std::shared_ptr<libCZI::ISubBlock>& subblock);
+
+/// Tries to get the pixel data of an uncompressed subblock directly from the subblock's data (i.e. without creating
+/// a bitmap object, which would mean copying all pixels). This succeeds if the subblock is uncompressed, and if its data
+/// is large enough to hold the bitmap (with the lines packed without padding, as is the case for uncompressed
+/// subblocks). Note that the pointer is only valid as long as the subblock object is alive.
+///
+/// \param         subblock    The subblock.
+/// \param [out]   data        If successful, the pointer to the pixel data.
+/// \param [out]   stride      If successful, the stride of the pixel data.
+///
+/// \returns    True if the pixel data could be retrieved; false otherwise.
+bool TryGetPixelDataOfUncompressedSubBlock(const std::shared_ptr<libCZI::ISubBlock>& subblock, const void*& data, std::uint32_t& stride);
+
+/// Determines the position of the data of a subblock in the file, by reading the header of the subblock segment from
+/// the stream. In order to guard against a malformed segment, the data size given in the segment must be equal to the
+/// specified size, and the bytes found at the start of the data must be identical to the specified data.
+///
+/// \param          stream              The stream of the file containing the subblock.
+/// \param          segment_position    The position of the subblock segment in the file (as given by the subblock directory).
+/// \param          data                The data of the subblock.
+/// \param          size                The size of the data of the subblock in bytes.
+/// \param [out]    data_position       If successful, the position of the data in the file.
+///
+/// \returns    True if the position of the data could be determined; false otherwise.
+bool TryGetFilePositionOfSubBlockData(libCZI::IStream* stream, std::uint64_t segment_position, const void* data, std::uint64_t size,
+                                      std::uint64_t& data_position);
@@ -0,0 +1,82 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "subblockprefetcher.h"
+
+#include <utility>
+
+#include "subblockhelpers.h"
+
+SubBlockPrefetcher::SubBlockPrefetcher(std::shared_ptr<libCZI::ICZIReader> reader, std::vector<int> subblock_indices, std::uint32_t depth,
+                                       std::uint64_t max_bytes, std::shared_ptr<Tracer> tracer)
+    : reader_(std::move(reader)),
+      subblock_indices_(std::move(subblock_indices)),
+      tracer_(std::move(tracer)),
+      budget_(max_bytes, depth > 0 ? depth : 1)
+{
+  // the buffer for the events is created here, so that an error doing so is reported to the caller
+  this->trace_buffer_ = this->tracer_ ? this->tracer_->AddThread("prefetch") : nullptr;
+  this->thread_ = std::thread([this]() { this->ThreadFunction(); });
+}
+
+SubBlockPrefetcher::~SubBlockPrefetcher()
+{
+  this->budget_.Abort();
+  this->queue_.CloseAndClear();
+  this->thread_.join();
+}
+
+bool SubBlockPrefetcher::GetNext(std::shared_ptr<libCZI::ISubBlock>& subblock)
+{
+  PrefetchedSubBlock item;
+  if (!this->queue_.Pop(item))
+  {
+    // the queue is closed and drained - either because all subblocks have been read, or because there was an error
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    if (this->exception_)
+    {
+      std::rethrow_exception(this->exception_);
+    }
+
+    return false;
+  }
+
+  this->budget_.Release(item.size_in_memory);
+  subblock = std::move(item.subblock);
+  return true;
+}
+
+void SubBlockPrefetcher::ThreadFunction()
+{
+  try
+  {
+    for (const int subblock_index : this->subblock_indices_)
+    {
+      if (!this->budget_.WaitForAdmission())
+      {
+        break;
+      }
+
+      PrefetchedSubBlock item;
+      {
+        const TraceScope trace_scope(this->trace_buffer_, TraceStage::kRead, subblock_index);
+        item.subblock = this->reader_->ReadSubBlock(subblock_index);
+      }
+
+      item.size_in_memory = GetSizeOfSubBlockInMemory(item.subblock);
+      this->budget_.AddBytes(item.size_in_memory);
+      if (!this->queue_.Push(std::move(item)))
+      {
+        break;
+      }
+    }
+  }
+  catch (...)
+  {
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    this->exception_ = std::current_exception();
+  }
+
+  this->queue_.Close();
+}
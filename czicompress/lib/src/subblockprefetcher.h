@@ -0,0 +1,74 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../inc_libCZI.h"
+#include "../include/tracer.h"
+#include "blockingqueue.h"
+#include "inflightbudget.h"
+
+/// This class is reading subblocks from a reader object on a background thread ahead of their use,
+/// so that the I/O latency can overlap with the processing of the subblocks. The subblocks are read in
+/// the order given by a list of subblock indices, and they are delivered (with 'GetNext') in the same
+/// order. The number of subblocks read ahead and the number of bytes held by them are limited.
+/// The subblocks are delivered to one consumer thread only, i.e. 'GetNext' must not be called concurrently.
+class SubBlockPrefetcher
+{
+private:
+  struct PrefetchedSubBlock
+  {
+    std::uint64_t size_in_memory{0};
+    std::shared_ptr<libCZI::ISubBlock> subblock;
+  };
+
+  std::shared_ptr<libCZI::ICZIReader> reader_;
+  std::vector<int> subblock_indices_;
+  std::shared_ptr<Tracer> tracer_;
+  TraceBuffer* trace_buffer_{nullptr};
+  InFlightBudget budget_;
+  BlockingQueue<PrefetchedSubBlock> queue_;
+  std::thread thread_;
+
+  std::mutex mutex_;
+  std::exception_ptr exception_;  ///< protected by 'mutex_'
+
+public:
+  /// Constructor - the background thread is started immediately.
+  ///
+  /// \param  reader              The reader object.
+  /// \param  subblock_indices    The indices of the subblocks to read, in the order in which they are to be read and delivered.
+  /// \param  depth               The maximum number of subblocks to read ahead (must be greater than zero).
+  /// \param  max_bytes           The maximum number of bytes held by the subblocks read ahead. If zero, the number of bytes is not limited.
+  ///                             At least one subblock is always read ahead, irrespective of its size.
+  /// \param  tracer              If not null, the reads on the background thread are recorded with this tracer.
+  SubBlockPrefetcher(std::shared_ptr<libCZI::ICZIReader> reader, std::vector<int> subblock_indices, std::uint32_t depth,
+                     std::uint64_t max_bytes, std::shared_ptr<Tracer> tracer = nullptr);
+
+  /// Destructor - stops the background thread (if still running) and waits for it to finish.
+  ~SubBlockPrefetcher();
+
+  SubBlockPrefetcher(const SubBlockPrefetcher&) = delete;
+  SubBlockPrefetcher(SubBlockPrefetcher&&) = delete;
+  SubBlockPrefetcher& operator=(const SubBlockPrefetcher&) = delete;
+  SubBlockPrefetcher& operator=(SubBlockPrefetcher&&) = delete;
+
+  /// Gets the next subblock. If it is not yet available, this method blocks until it has been read. In case
+  /// reading the subblock failed on the background thread, the exception is re-thrown here.
+  ///
+  /// \param [out] subblock   If successful, the subblock is put here.
+  ///
+  /// \returns    True if a subblock was retrieved; false if all subblocks have been delivered.
+  bool GetNext(std::shared_ptr<libCZI::ISubBlock>& subblock);
+
+private:
+  void ThreadFunction();
+};
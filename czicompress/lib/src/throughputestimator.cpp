@@ -0,0 +1,65 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "throughputestimator.h"
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// The minimal time span of the samples for which the throughput is reported.
+constexpr std::chrono::milliseconds kMinimalTimeSpan{100};
+
+/// Samples taken within this interval of the previous one replace the previous one - this bounds the number of samples
+/// kept (with many small items, a sample is added for each of them).
+constexpr std::chrono::milliseconds kMinimalSampleInterval{10};
+
+}  // namespace
+
+ThroughputEstimator::ThroughputEstimator(std::chrono::steady_clock::duration window) : window_(window) {}
+
+void ThroughputEstimator::AddSample(std::uint64_t bytes_done, std::chrono::steady_clock::time_point now)
+{
+  if (this->samples_.size() >= 2 && now - this->samples_[this->samples_.size() - 2].first < kMinimalSampleInterval)
+  {
+    this->samples_.back() = std::make_pair(now, bytes_done);
+  }
+  else
+  {
+    this->samples_.emplace_back(now, bytes_done);
+  }
+
+  // we keep one sample which is older than the window, so that the samples span (at least) the whole window
+  while (this->samples_.size() > 2 && now - this->samples_[1].first >= this->window_)
+  {
+    this->samples_.pop_front();
+  }
+}
+
+double ThroughputEstimator::GetBytesPerSecond() const
+{
+  if (this->samples_.size() < 2)
+  {
+    return 0;
+  }
+
+  const std::chrono::duration<double> time_span = this->samples_.back().first - this->samples_.front().first;
+  if (time_span < kMinimalTimeSpan)
+  {
+    return 0;
+  }
+
+  return static_cast<double>(this->samples_.back().second - this->samples_.front().second) / time_span.count();
+}
+
+double ThroughputEstimator::GetEstimatedSecondsRemaining(std::uint64_t bytes_total) const
+{
+  const double bytes_per_second = this->GetBytesPerSecond();
+  if (bytes_per_second <= 0)
+  {
+    return -1;
+  }
+
+  const std::uint64_t bytes_done = this->samples_.back().second;
+  return bytes_done < bytes_total ? static_cast<double>(bytes_total - bytes_done) / bytes_per_second : 0;
+}
@@ -0,0 +1,45 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+/// This class is estimating the current throughput of an operation from the number of bytes done, which is reported
+/// repeatedly - the throughput is averaged over a sliding window (of a few seconds), so that it follows changes of the
+/// throughput, but does not jump with every sample. This class is not thread-safe.
+class ThroughputEstimator
+{
+private:
+  std::chrono::steady_clock::duration window_;
+  std::deque<std::pair<std::chrono::steady_clock::time_point, std::uint64_t>> samples_;
+
+public:
+  /// Constructor.
+  ///
+  /// \param  window  The duration over which the throughput is averaged.
+  explicit ThroughputEstimator(std::chrono::steady_clock::duration window = std::chrono::seconds(3));
+
+  /// Adds a sample, i.e. the number of bytes done at the specified time. The number of bytes done must not decrease
+  /// from one sample to the next.
+  ///
+  /// \param  bytes_done  The number of bytes done.
+  /// \param  now         The time of the sample.
+  void AddSample(std::uint64_t bytes_done, std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+  /// Gets the current throughput.
+  ///
+  /// \returns The throughput in bytes per second, or 0 if it is not known yet (i.e. if the samples span less than 100 ms).
+  double GetBytesPerSecond() const;
+
+  /// Gets the estimated time until the specified number of bytes is done (at the current throughput).
+  ///
+  /// \param  bytes_total The total number of bytes.
+  ///
+  /// \returns The estimated time in seconds, or a negative value if the throughput is not known yet.
+  double GetEstimatedSecondsRemaining(std::uint64_t bytes_total) const;
+};
@@ -0,0 +1,156 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "../include/tracer.h"
+
+#include <array>
+#include <iomanip>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// The process id reported for all events (there is only one process in the trace).
+constexpr int kProcessId = 1;
+
+/// The number of values of the enum 'TraceStage'.
+constexpr size_t kNumberOfTraceStages = 3;
+
+const char* TraceStageToName(TraceStage stage)
+{
+  switch (stage)
+  {
+    case TraceStage::kRead:
+      return "read";
+    case TraceStage::kProcess:
+      return "process";
+    case TraceStage::kWrite:
+      return "write";
+    default:
+      return "unknown";
+  }
+}
+
+void WriteJsonString(std::ostream& stream, const std::string& text)
+{
+  stream << '"';
+  for (const char c : text)
+  {
+    if (c == '"' || c == '\\')
+    {
+      stream << '\\' << c;
+    }
+    else if (static_cast<unsigned char>(c) < 0x20)
+    {
+      stream << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+    }
+    else
+    {
+      stream << c;
+    }
+  }
+
+  stream << '"';
+}
+
+}  // namespace
+
+TraceBuffer::TraceBuffer(std::string thread_name, std::chrono::steady_clock::time_point start_time, size_t number_of_events)
+    : thread_name_(std::move(thread_name)), start_time_(start_time)
+{
+  if (number_of_events == 0)
+  {
+    throw std::invalid_argument("The number of events of a trace buffer must be greater than zero.");
+  }
+
+  this->events_.resize(number_of_events);
+}
+
+std::uint64_t TraceBuffer::GetNumberOfDroppedEvents() const
+{
+  return this->number_of_events_ > this->events_.size() ? this->number_of_events_ - this->events_.size() : 0;
+}
+
+void TraceBuffer::WriteChromeTraceEvents(std::ostream& stream, int thread_id) const
+{
+  stream << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << kProcessId << ",\"tid\":" << thread_id << ",\"args\":{\"name\":";
+  WriteJsonString(stream, this->thread_name_);
+  stream << "}}";
+
+  // the number of stages which have begun (and not yet ended) - an end event without its begin event (which has been
+  //  overwritten) is left out, since the viewers cannot show it anyway
+  std::array<std::uint64_t, kNumberOfTraceStages> number_of_open_stages{};
+  const std::uint64_t first_event = this->GetNumberOfDroppedEvents();
+  for (std::uint64_t i = first_event; i < this->number_of_events_; ++i)
+  {
+    const Event& event = this->events_[i % this->events_.size()];
+    const auto stage_index = static_cast<size_t>(event.stage);
+    if (stage_index >= kNumberOfTraceStages)
+    {
+      continue;
+    }
+
+    if (event.is_begin)
+    {
+      ++number_of_open_stages[stage_index];
+    }
+    else if (number_of_open_stages[stage_index] > 0)
+    {
+      --number_of_open_stages[stage_index];
+    }
+    else
+    {
+      continue;
+    }
+
+    // the timestamps are given in microseconds
+    stream << ",\n{\"name\":\"" << TraceStageToName(event.stage) << "\",\"cat\":\"subblock\",\"ph\":\"" << (event.is_begin ? 'B' : 'E')
+           << "\",\"ts\":" << event.timestamp_in_nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0')
+           << event.timestamp_in_nanoseconds % 1000 << std::setfill(' ') << ",\"pid\":" << kProcessId << ",\"tid\":" << thread_id
+           << ",\"args\":{\"subblock\":" << event.subblock_index << "}}";
+  }
+}
+
+Tracer::Tracer(size_t number_of_events_per_thread)
+    : number_of_events_per_thread_(number_of_events_per_thread), start_time_(std::chrono::steady_clock::now())
+{
+  if (number_of_events_per_thread == 0)
+  {
+    throw std::invalid_argument("The number of events per thread must be greater than zero.");
+  }
+}
+
+TraceBuffer* Tracer::AddThread(const std::string& thread_name)
+{
+  auto buffer = std::make_unique<TraceBuffer>(thread_name, this->start_time_, this->number_of_events_per_thread_);
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  this->buffers_.push_back(std::move(buffer));
+  return this->buffers_.back().get();
+}
+
+void Tracer::WriteChromeTraceJson(std::ostream& stream) const
+{
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << kProcessId << ",\"args\":{\"name\":\"czicompress\"}}";
+  for (size_t i = 0; i < this->buffers_.size(); ++i)
+  {
+    this->buffers_[i]->WriteChromeTraceEvents(stream, static_cast<int>(i) + 1);
+  }
+
+  stream << "\n]}\n";
+}
+
+std::uint64_t Tracer::GetNumberOfDroppedEvents() const
+{
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  std::uint64_t number_of_dropped_events = 0;
+  for (const auto& buffer : this->buffers_)
+  {
+    number_of_dropped_events += buffer->GetNumberOfDroppedEvents();
+  }
+
+  return number_of_dropped_events;
+}
@@ -0,0 +1,30 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "workerthreadscope.h"
+
+#include <CZICompress_Config.h>
+
+#if CZICOMPRESS_WIN32_ENVIRONMENT
+#include <Windows.h>
+#endif
+
+WorkerThreadScope::WorkerThreadScope()
+{
+#if CZICOMPRESS_WIN32_ENVIRONMENT
+  // S_FALSE means "already initialized on this thread", which also has to be balanced with CoUninitialize
+  const HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+  this->com_initialized_ = SUCCEEDED(hr);
+#endif
+}
+
+WorkerThreadScope::~WorkerThreadScope()
+{
+#if CZICOMPRESS_WIN32_ENVIRONMENT
+  if (this->com_initialized_)
+  {
+    CoUninitialize();
+  }
+#endif
+}
@@ -0,0 +1,24 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+/// This RAII-class takes care of the per-thread initialization required for a worker thread which
+/// calls into libCZI. On Windows, COM is initialized for the lifetime of the object - this is
+/// required because subblocks may be decoded with the WIC-based JpgXR-decoder on this thread. On
+/// other platforms, nothing is done.
+class WorkerThreadScope
+{
+private:
+  bool com_initialized_{false};
+
+public:
+  WorkerThreadScope();
+  ~WorkerThreadScope();
+
+  WorkerThreadScope(const WorkerThreadScope&) = delete;
+  WorkerThreadScope(WorkerThreadScope&&) = delete;
+  WorkerThreadScope& operator=(const WorkerThreadScope&) = delete;
+  WorkerThreadScope& operator=(WorkerThreadScope&&) = delete;
+};
@@ -0,0 +1,241 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "writebehindoutputstream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// The alignment of the buffers in memory.
+constexpr std::size_t kAlignmentOfBuffers = 4096;
+
+std::shared_ptr<std::uint8_t> AllocateAlignedBuffer(size_t size)
+{
+  return std::shared_ptr<std::uint8_t>(static_cast<std::uint8_t*>(::operator new(size, std::align_val_t{kAlignmentOfBuffers})),
+                                       [](std::uint8_t* pointer) { ::operator delete(pointer, std::align_val_t{kAlignmentOfBuffers}); });
+}
+
+}  // namespace
+
+WriteBehindOutputStream::WriteBehindOutputStream(std::shared_ptr<libCZI::IOutputStream> underlying_stream, size_t buffer_size,
+                                                 std::uint32_t number_of_buffers)
+    : underlying_stream_(std::move(underlying_stream)), buffer_size_(buffer_size), max_number_of_buffers_(number_of_buffers)
+{
+  if (this->buffer_size_ == 0)
+  {
+    throw std::invalid_argument("The buffer size must be greater than zero.");
+  }
+
+  if (this->max_number_of_buffers_ < 2)
+  {
+    throw std::invalid_argument("The number of buffers must be at least 2.");
+  }
+
+  this->flush_thread_ = std::thread([this]() { this->FlushThreadFunction(); });
+}
+
+WriteBehindOutputStream::~WriteBehindOutputStream()
+{
+  try
+  {
+    this->Close();
+  }
+  catch (...)
+  {
+    // there is no way to report an error here - 'Close' should have been called before
+  }
+}
+
+void WriteBehindOutputStream::Write(std::uint64_t offset, const void* data, std::uint64_t size, std::uint64_t* ptr_bytes_written)
+{
+  const std::lock_guard<std::mutex> write_lock(this->write_mutex_);
+  if (this->closed_)
+  {
+    throw std::logic_error("The stream has already been closed.");
+  }
+
+  this->ThrowIfErrorOccurred();
+
+  auto* current_buffer = this->current_buffer_.get();
+  if (current_buffer != nullptr && offset >= current_buffer->offset && offset + size <= current_buffer->offset + current_buffer->size)
+  {
+    // the data is entirely within the buffer currently being filled, so we can simply overwrite it there
+    auto* destination = current_buffer->data.get() + (offset - current_buffer->offset);  // NOLINT: pointer arithmetic
+    memcpy(destination, data, static_cast<size_t>(size));
+  }
+  else
+  {
+    const auto* source = static_cast<const std::uint8_t*>(data);
+    std::uint64_t size_remaining = size;
+    while (size_remaining > 0)
+    {
+      if (this->current_buffer_ && offset != this->current_buffer_->offset + this->current_buffer_->size)
+      {
+        this->SubmitCurrentBuffer();
+      }
+
+      if (!this->current_buffer_)
+      {
+        this->current_buffer_ = this->AcquireBuffer(offset);
+      }
+
+      current_buffer = this->current_buffer_.get();
+      const size_t size_to_copy =
+          static_cast<size_t>((std::min)(size_remaining, static_cast<std::uint64_t>(current_buffer->capacity - current_buffer->size)));
+      memcpy(current_buffer->data.get() + current_buffer->size, source, size_to_copy);  // NOLINT: pointer arithmetic
+      current_buffer->size += size_to_copy;
+      source += size_to_copy;  // NOLINT: pointer arithmetic
+      offset += size_to_copy;
+      size_remaining -= size_to_copy;
+      if (current_buffer->size == current_buffer->capacity)
+      {
+        this->SubmitCurrentBuffer();
+      }
+    }
+  }
+
+  if (ptr_bytes_written != nullptr)
+  {
+    *ptr_bytes_written = size;
+  }
+}
+
+void WriteBehindOutputStream::Close()
+{
+  const std::lock_guard<std::mutex> write_lock(this->write_mutex_);
+  if (this->closed_)
+  {
+    return;
+  }
+
+  this->closed_ = true;
+  if (this->current_buffer_)
+  {
+    this->SubmitCurrentBuffer();
+  }
+
+  {
+    // the flush thread writes all queued buffers before it terminates
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    this->stop_flush_thread_ = true;
+  }
+
+  this->condition_variable_.notify_all();
+  this->flush_thread_.join();
+  this->ThrowIfErrorOccurred();
+}
+
+void WriteBehindOutputStream::FlushThreadFunction()
+{
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  for (;;)
+  {
+    this->condition_variable_.wait(lock, [this]() { return this->stop_flush_thread_ || !this->queued_buffers_.empty(); });
+    if (this->queued_buffers_.empty())
+    {
+      // we only get here if the thread is to be stopped and all buffers have been written
+      return;
+    }
+
+    auto buffer = std::move(this->queued_buffers_.front());
+    this->queued_buffers_.pop_front();
+    const bool error_occurred = this->error_ != nullptr;
+    lock.unlock();
+
+    // after an error, the remaining data is discarded - the operation has failed anyway
+    if (!error_occurred)
+    {
+      try
+      {
+        std::uint64_t bytes_written = 0;
+        this->underlying_stream_->Write(buffer->offset, buffer->data.get(), buffer->size, &bytes_written);
+        if (bytes_written != buffer->size)
+        {
+          throw std::runtime_error("Error: could only write " + std::to_string(bytes_written) + " of " + std::to_string(buffer->size) +
+                                   " bytes at offset " + std::to_string(buffer->offset));
+        }
+      }
+      catch (...)
+      {
+        lock.lock();
+        this->error_ = std::current_exception();
+        lock.unlock();
+      }
+    }
+
+    lock.lock();
+    this->free_buffers_.push_back(std::move(buffer));
+    this->condition_variable_.notify_all();
+  }
+}
+
+std::unique_ptr<WriteBehindOutputStream::Buffer> WriteBehindOutputStream::AcquireBuffer(std::uint64_t offset)
+{
+  std::unique_ptr<Buffer> buffer;
+  {
+    std::unique_lock<std::mutex> lock(this->mutex_);
+
+    // one buffer (the one being filled) is not in the free-list or in the queue, so we need to wait if all the
+    // other buffers are waiting to be written
+    this->condition_variable_.wait(lock,
+                                   [this]()
+                                   {
+                                     return this->error_ != nullptr || !this->free_buffers_.empty() ||
+                                            this->number_of_buffers_allocated_ < this->max_number_of_buffers_;
+                                   });
+    if (this->error_ != nullptr)
+    {
+      std::rethrow_exception(this->error_);
+    }
+
+    if (!this->free_buffers_.empty())
+    {
+      buffer = std::move(this->free_buffers_.back());
+      this->free_buffers_.pop_back();
+    }
+    else
+    {
+      ++this->number_of_buffers_allocated_;
+    }
+  }
+
+  if (!buffer)
+  {
+    buffer = std::make_unique<Buffer>();
+    buffer->data = AllocateAlignedBuffer(this->buffer_size_);
+  }
+
+  // the buffer ends at a multiple of the buffer size, so that all but the first buffer of a contiguous run of
+  // writes are aligned to the buffer size
+  buffer->offset = offset;
+  buffer->size = 0;
+  buffer->capacity = this->buffer_size_ - static_cast<size_t>(offset % this->buffer_size_);
+  return buffer;
+}
+
+void WriteBehindOutputStream::SubmitCurrentBuffer()
+{
+  {
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    this->queued_buffers_.push_back(std::move(this->current_buffer_));
+  }
+
+  this->condition_variable_.notify_all();
+}
+
+void WriteBehindOutputStream::ThrowIfErrorOccurred()
+{
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  if (this->error_ != nullptr)
+  {
+    std::rethrow_exception(this->error_);
+  }
+}
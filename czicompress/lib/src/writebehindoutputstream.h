@@ -0,0 +1,93 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../inc_libCZI.h"
+
+/// Implementation of libCZI::IOutputStream which merges the write operations into large buffers, and writes those
+/// buffers to an underlying stream on a dedicated thread. So, the caller is only blocked if all buffers are waiting
+/// to be written.
+/// A buffer holds a contiguous range of the file, and (except for the first one after a non-contiguous write) it starts
+/// at a file offset which is a multiple of the buffer size. A write operation which does not continue the current
+/// buffer (e.g. updating a header at the beginning of the file) starts a new buffer; the buffers are written in the
+/// order in which they are filled, so the content of the file is the same as if all write operations were executed
+/// directly.
+/// If writing to the underlying stream fails, the error is reported (as an exception) by the next call to 'Write' or
+/// by 'Close'. 'Close' must be called in order to ensure that all data has been written - the destructor writes
+/// pending data, but it has no way to report an error.
+class WriteBehindOutputStream : public libCZI::IOutputStream
+{
+private:
+  /// A buffer holding the data for a contiguous range of the file.
+  struct Buffer
+  {
+    std::shared_ptr<std::uint8_t> data;
+    std::uint64_t offset{0};  ///< The file offset of the data.
+    size_t size{0};           ///< The number of bytes of data.
+    size_t capacity{0};       ///< The maximal number of bytes for this buffer - this is less than the buffer size if the
+                              ///< buffer does not start at a multiple of the buffer size.
+  };
+
+  std::shared_ptr<libCZI::IOutputStream> underlying_stream_;
+  size_t buffer_size_;
+  std::uint32_t max_number_of_buffers_;
+
+  std::mutex write_mutex_;                  ///< Serializes the calls to 'Write' and 'Close'.
+  std::unique_ptr<Buffer> current_buffer_;  ///< The buffer currently being filled (guarded by write_mutex_).
+  bool closed_{false};                      ///< Whether 'Close' has been called (guarded by write_mutex_).
+
+  std::mutex mutex_;  ///< Protects the state shared with the flush thread.
+  std::condition_variable condition_variable_;
+  std::vector<std::unique_ptr<Buffer>> free_buffers_;
+  std::deque<std::unique_ptr<Buffer>> queued_buffers_;
+  std::uint32_t number_of_buffers_allocated_{0};
+  bool stop_flush_thread_{false};
+  std::exception_ptr error_;
+
+  std::thread flush_thread_;
+
+public:
+  /// The default number of buffers.
+  static constexpr std::uint32_t kDefaultNumberOfBuffers = 2;
+
+  /// Constructor.
+  ///
+  /// \param  underlying_stream   The stream to which the data is written.
+  /// \param  buffer_size         The size of a buffer in bytes, it must be greater than zero.
+  /// \param  number_of_buffers   The maximal number of buffers - i.e. one buffer being filled, and up to (number_of_buffers - 1)
+  ///                             buffers waiting to be written. It must be at least 2.
+  WriteBehindOutputStream(std::shared_ptr<libCZI::IOutputStream> underlying_stream, size_t buffer_size,
+                          std::uint32_t number_of_buffers = kDefaultNumberOfBuffers);
+  ~WriteBehindOutputStream() override;
+
+  WriteBehindOutputStream(const WriteBehindOutputStream&) = delete;
+  WriteBehindOutputStream& operator=(const WriteBehindOutputStream&) = delete;
+
+  void Write(std::uint64_t offset, const void* data, std::uint64_t size, std::uint64_t* ptr_bytes_written) override;
+
+  /// Writes all pending data to the underlying stream, and waits until this is done. If writing to the underlying
+  /// stream failed, an exception is thrown. After this, the stream cannot be written to anymore.
+  void Close();
+
+  /// Gets the stream to which the data is written.
+  ///
+  /// \returns The underlying stream.
+  const std::shared_ptr<libCZI::IOutputStream>& GetUnderlyingStream() const { return this->underlying_stream_; }
+
+private:
+  void FlushThreadFunction();
+  std::unique_ptr<Buffer> AcquireBuffer(std::uint64_t offset);
+  void SubmitCurrentBuffer();
+  void ThrowIfErrorOccurred();
+};
@@ -0,0 +1,370 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "zstdcompressor.h"
+
+#include <zstd.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// The size of the header of a "zstd1"-compressed payload without any chunks.
+constexpr size_t kZStd1HeaderSizeWithoutChunks = 1;
+
+/// The size of the header of a "zstd1"-compressed payload with the "HiLoByteUnpack"-chunk.
+constexpr size_t kZStd1HeaderSizeWithHiLoByteUnpackChunk = 3;
+
+/// The chunk-type of the "HiLoByteUnpack"-chunk in the header of a "zstd1"-compressed payload.
+constexpr std::uint8_t kZStd1ChunkTypeHiLoByteUnpack = 1;
+
+/// Implementation of libCZI::IMemoryBlock holding the compressed data in a buffer from the buffer pool - the
+/// buffer may be larger than the data it contains.
+class CompressedDataMemoryBlock : public libCZI::IMemoryBlock
+{
+private:
+  std::shared_ptr<void> data_;
+  size_t size_of_data_{0};
+
+public:
+  explicit CompressedDataMemoryBlock(std::shared_ptr<void> data) : data_(std::move(data)) {}
+
+  void SetSizeOfData(size_t size) { this->size_of_data_ = size; }
+
+  void* GetPtr() override { return this->data_.get(); }
+
+  size_t GetSizeOfData() const override { return this->size_of_data_; }
+};
+
+/// Parses the header of "zstd1"-compressed data.
+///
+/// \param         data                    The compressed data.
+/// \param         size_of_data            The size of the compressed data in bytes.
+/// \param [out]   size_of_header          The size of the header, i.e. the offset of the zstd-frame.
+/// \param [out]   is_lo_hi_byte_packed    Whether the low- and high-bytes of the pixels are separated.
+///
+/// \returns    True if the header is valid; false otherwise (i.e. if the data is corrupt or contains unknown chunks).
+bool TryParseZStd1Header(const std::uint8_t* data, size_t size_of_data, size_t& size_of_header, bool& is_lo_hi_byte_packed)
+{
+  if (size_of_data < 1 || data[0] < kZStd1HeaderSizeWithoutChunks || data[0] > size_of_data)  // NOLINT: pointer arithmetic
+  {
+    return false;
+  }
+
+  size_of_header = data[0];  // NOLINT: pointer arithmetic
+  is_lo_hi_byte_packed = false;
+  for (size_t offset = 1; offset < size_of_header; offset += 2)
+  {
+    if (data[offset] != kZStd1ChunkTypeHiLoByteUnpack || offset + 1 >= size_of_header)  // NOLINT: pointer arithmetic
+    {
+      return false;
+    }
+
+    is_lo_hi_byte_packed = (data[offset + 1] & 1) != 0;  // NOLINT: pointer arithmetic
+  }
+
+  return true;
+}
+
+void ThrowIfZstdError(size_t return_code, const char* operation)
+{
+  if (ZSTD_isError(return_code))
+  {
+    throw std::runtime_error(std::string("Error: ") + operation + " failed: " + ZSTD_getErrorName(return_code));
+  }
+}
+
+}  // namespace
+
+ZstdCompressor::ZstdCompressor(std::shared_ptr<BufferPool> buffer_pool)
+    : context_(ZSTD_createCCtx()), buffer_pool_(std::move(buffer_pool))
+{
+  if (this->context_ == nullptr)
+  {
+    throw std::runtime_error("Error: could not create zstd compression context");
+  }
+}
+
+ZstdCompressor::~ZstdCompressor()
+{
+  ZSTD_freeCCtx(this->context_);
+  if (this->decompression_context_ != nullptr)
+  {
+    ZSTD_freeDCtx(this->decompression_context_);
+  }
+}
+
+std::shared_ptr<libCZI::IMemoryBlock> ZstdCompressor::Compress(libCZI::CompressionMode compression_mode, std::uint32_t width,
+                                                               std::uint32_t height, std::uint32_t stride, libCZI::PixelType pixel_type,
+                                                               const void* data, const libCZI::ICompressParameters* parameters)
+{
+  int compression_level = 0;
+  bool do_lo_hi_byte_packing = false;
+  ZstdCompressor::GetCompressionParameters(compression_mode, pixel_type, parameters, compression_level, do_lo_hi_byte_packing);
+
+  const std::uint8_t bytes_per_pixel = libCZI::Utils::GetBytesPerPixel(pixel_type);
+  const size_t size_of_source_data = static_cast<size_t>(width) * bytes_per_pixel * height;
+  const std::uint8_t* source_data = this->PrepareSourceData(width, height, stride, bytes_per_pixel, do_lo_hi_byte_packing, data);
+  return this->CompressPreparedData(compression_mode, compression_level, do_lo_hi_byte_packing, source_data, size_of_source_data);
+}
+
+std::shared_ptr<libCZI::IMemoryBlock> ZstdCompressor::Transcode(libCZI::CompressionMode compression_mode,
+                                                                libCZI::CompressionMode source_compression_mode, std::uint32_t width,
+                                                                std::uint32_t height, libCZI::PixelType pixel_type, const void* source_data,
+                                                                size_t size_of_source_data, const libCZI::ICompressParameters* parameters)
+{
+  int compression_level = 0;
+  bool do_lo_hi_byte_packing = false;
+  ZstdCompressor::GetCompressionParameters(compression_mode, pixel_type, parameters, compression_level, do_lo_hi_byte_packing);
+
+  // parse the header of the source data (for "zstd1"), and determine where the zstd-frame starts
+  const auto* source = static_cast<const std::uint8_t*>(source_data);
+  size_t size_of_source_header = 0;
+  bool source_is_lo_hi_byte_packed = false;
+  if (source_compression_mode == libCZI::CompressionMode::Zstd1)
+  {
+    if (!TryParseZStd1Header(source, size_of_source_data, size_of_source_header, source_is_lo_hi_byte_packed))
+    {
+      throw std::runtime_error("Error: invalid header of zstd1-compressed data");
+    }
+  }
+  else if (source_compression_mode != libCZI::CompressionMode::Zstd0)
+  {
+    throw std::runtime_error("Unknown or unsupported compression mode of the source data");
+  }
+
+  const size_t size_of_decompressed_data = static_cast<size_t>(width) * libCZI::Utils::GetBytesPerPixel(pixel_type) * height;
+  if (source_is_lo_hi_byte_packed && size_of_decompressed_data % 2 != 0)
+  {
+    throw std::runtime_error("Error: zstd1-compressed data with low- and high-bytes separated must have an even size");
+  }
+
+  if (this->decompression_context_ == nullptr)
+  {
+    this->decompression_context_ = ZSTD_createDCtx();
+    if (this->decompression_context_ == nullptr)
+    {
+      throw std::runtime_error("Error: could not create zstd decompression context");
+    }
+  }
+
+  this->decompressed_data_.resize(size_of_decompressed_data);
+  const size_t size_decompressed =
+      ZSTD_decompressDCtx(this->decompression_context_, this->decompressed_data_.data(), size_of_decompressed_data,
+                          source + size_of_source_header, size_of_source_data - size_of_source_header);  // NOLINT: pointer arithmetic
+  ThrowIfZstdError(size_decompressed, "ZSTD_decompressDCtx");
+  if (size_decompressed != size_of_decompressed_data)
+  {
+    throw std::runtime_error("Error: the size of the decompressed data does not match the size of the bitmap");
+  }
+
+  if (source_is_lo_hi_byte_packed == do_lo_hi_byte_packing)
+  {
+    // the decompressed data is already arranged as required - this is the case when only the compression level changes
+    return this->CompressPreparedData(compression_mode, compression_level, do_lo_hi_byte_packing, this->decompressed_data_.data(),
+                                      size_of_decompressed_data);
+  }
+
+  const std::uint8_t* prepared_data = nullptr;
+  if (do_lo_hi_byte_packing)
+  {
+    const auto line_length = static_cast<std::uint32_t>(size_of_decompressed_data / height);
+    prepared_data = this->PrepareSourceData(line_length / 2, height, line_length, 2, true, this->decompressed_data_.data());
+  }
+  else
+  {
+    // merge the low- and high-bytes again, i.e. undo the separation done by the source's encoder
+    this->scratch_buffer_.resize(size_of_decompressed_data);
+    const size_t number_of_words = size_of_decompressed_data / 2;
+    const std::uint8_t* low_bytes = this->decompressed_data_.data();
+    const std::uint8_t* high_bytes = low_bytes + number_of_words;  // NOLINT: pointer arithmetic
+    for (size_t i = 0; i < number_of_words; ++i)
+    {
+      this->scratch_buffer_[2 * i] = low_bytes[i];       // NOLINT: pointer arithmetic
+      this->scratch_buffer_[2 * i + 1] = high_bytes[i];  // NOLINT: pointer arithmetic
+    }
+
+    prepared_data = this->scratch_buffer_.data();
+  }
+
+  return this->CompressPreparedData(compression_mode, compression_level, do_lo_hi_byte_packing, prepared_data, size_of_decompressed_data);
+}
+
+/*static*/ bool ZstdCompressor::IsEncodedWith(libCZI::CompressionMode compression_mode, libCZI::PixelType pixel_type,
+                                              const libCZI::ICompressParameters* parameters,
+                                              libCZI::CompressionMode source_compression_mode, const void* source_data,
+                                              size_t size_of_source_data)
+{
+  if (compression_mode != source_compression_mode ||
+      (compression_mode != libCZI::CompressionMode::Zstd0 && compression_mode != libCZI::CompressionMode::Zstd1))
+  {
+    return false;
+  }
+
+  if (compression_mode == libCZI::CompressionMode::Zstd0)
+  {
+    // there are no further parameters for "zstd0" which are visible in the data
+    return true;
+  }
+
+  int compression_level = 0;
+  bool do_lo_hi_byte_packing = false;
+  ZstdCompressor::GetCompressionParameters(compression_mode, pixel_type, parameters, compression_level, do_lo_hi_byte_packing);
+  size_t size_of_source_header = 0;
+  bool source_is_lo_hi_byte_packed = false;
+  return TryParseZStd1Header(static_cast<const std::uint8_t*>(source_data), size_of_source_data, size_of_source_header,
+                             source_is_lo_hi_byte_packed) &&
+         source_is_lo_hi_byte_packed == do_lo_hi_byte_packing;
+}
+
+/*static*/ void ZstdCompressor::GetCompressionParameters(libCZI::CompressionMode compression_mode, libCZI::PixelType pixel_type,
+                                                         const libCZI::ICompressParameters* parameters, int& compression_level,
+                                                         bool& do_lo_hi_byte_packing)
+{
+  if (compression_mode != libCZI::CompressionMode::Zstd0 && compression_mode != libCZI::CompressionMode::Zstd1)
+  {
+    throw std::runtime_error("Unknown or unsupported compression mode");
+  }
+
+  compression_level = 0;  // zero means "zstd's default compression level"
+  do_lo_hi_byte_packing = false;
+  if (parameters != nullptr)
+  {
+    libCZI::CompressParameter parameter;
+    if (parameters->TryGetProperty(libCZI::CompressionParameterKey::ZSTD_RAWCOMPRESSIONLEVEL, &parameter))
+    {
+      compression_level = parameter.GetInt32();
+    }
+
+    if (compression_mode == libCZI::CompressionMode::Zstd1 &&
+        parameters->TryGetProperty(libCZI::CompressionParameterKey::ZSTD_PREPROCESS_DOLOHIBYTEPACKING, &parameter))
+    {
+      do_lo_hi_byte_packing = parameter.GetBoolean();
+    }
+  }
+
+  // the low- and high-bytes are separated only for pixel types with 16 bits per channel
+  do_lo_hi_byte_packing = do_lo_hi_byte_packing && (pixel_type == libCZI::PixelType::Gray16 || pixel_type == libCZI::PixelType::Bgr48);
+}
+
+std::shared_ptr<libCZI::IMemoryBlock> ZstdCompressor::CompressPreparedData(libCZI::CompressionMode compression_mode, int compression_level,
+                                                                           bool do_lo_hi_byte_packing, const std::uint8_t* data,
+                                                                           size_t size_of_data)
+{
+  size_t size_of_header = 0;
+  if (compression_mode == libCZI::CompressionMode::Zstd1)
+  {
+    size_of_header = do_lo_hi_byte_packing ? kZStd1HeaderSizeWithHiLoByteUnpackChunk : kZStd1HeaderSizeWithoutChunks;
+  }
+
+  auto memory_block =
+      std::make_shared<CompressedDataMemoryBlock>(this->buffer_pool_->Allocate(size_of_header + ZSTD_compressBound(size_of_data)));
+  auto* destination = static_cast<std::uint8_t*>(memory_block->GetPtr());
+  if (compression_mode == libCZI::CompressionMode::Zstd1)
+  {
+    // the header starts with its size, followed by the chunks
+    destination[0] = static_cast<std::uint8_t>(size_of_header);  // NOLINT: pointer arithmetic
+    if (do_lo_hi_byte_packing)
+    {
+      destination[1] = kZStd1ChunkTypeHiLoByteUnpack;  // NOLINT: pointer arithmetic
+      destination[2] = 1;                              // NOLINT: pointer arithmetic
+    }
+  }
+
+  ThrowIfZstdError(ZSTD_CCtx_reset(this->context_, ZSTD_reset_session_and_parameters), "ZSTD_CCtx_reset");
+  ThrowIfZstdError(ZSTD_CCtx_setParameter(this->context_, ZSTD_c_compressionLevel, compression_level), "ZSTD_CCtx_setParameter");
+  const size_t size_of_compressed_data = ZSTD_compress2(this->context_, destination + size_of_header,  // NOLINT: pointer arithmetic
+                                                        ZSTD_compressBound(size_of_data), data, size_of_data);
+  ThrowIfZstdError(size_of_compressed_data, "ZSTD_compress2");
+
+  memory_block->SetSizeOfData(size_of_header + size_of_compressed_data);
+  return memory_block;
+}
+
+const std::uint8_t* ZstdCompressor::PrepareSourceData(std::uint32_t width, std::uint32_t height, std::uint32_t stride,
+                                                      std::uint8_t bytes_per_pixel, bool do_lo_hi_byte_packing, const void* data)
+{
+  const size_t line_length = static_cast<size_t>(width) * bytes_per_pixel;
+  const auto* source = static_cast<const std::uint8_t*>(data);
+  if (!do_lo_hi_byte_packing && (stride == line_length || height <= 1))
+  {
+    // the data is contiguous, so we can compress it in place
+    return source;
+  }
+
+  this->scratch_buffer_.resize(line_length * height);
+  std::uint8_t* destination = this->scratch_buffer_.data();
+  if (!do_lo_hi_byte_packing)
+  {
+    for (std::uint32_t y = 0; y < height; ++y)
+    {
+      memcpy(destination + y * line_length, source + static_cast<size_t>(y) * stride, line_length);  // NOLINT: pointer arithmetic
+    }
+
+    return destination;
+  }
+
+  // all the low-bytes of the 16-bit words go into the first half of the buffer, all the high-bytes into the second half
+  const size_t words_per_line = line_length / 2;
+  std::uint8_t* low_bytes = destination;
+  std::uint8_t* high_bytes = destination + words_per_line * height;  // NOLINT: pointer arithmetic
+  for (std::uint32_t y = 0; y < height; ++y)
+  {
+    const std::uint8_t* line = source + static_cast<size_t>(y) * stride;  // NOLINT: pointer arithmetic
+    for (size_t x = 0; x < words_per_line; ++x)
+    {
+      *low_bytes++ = line[2 * x];       // NOLINT: pointer arithmetic
+      *high_bytes++ = line[2 * x + 1];  // NOLINT: pointer arithmetic
+    }
+  }
+
+  return destination;
+}
+
+std::shared_ptr<libCZI::IMemoryBlock> ZstdCompressorPool::Compress(libCZI::CompressionMode compression_mode, std::uint32_t width,
+                                                                   std::uint32_t height, std::uint32_t stride, libCZI::PixelType pixel_type,
+                                                                   const void* data, const libCZI::ICompressParameters* parameters)
+{
+  return this->RunWithCompressor([&](ZstdCompressor& compressor)
+                                 { return compressor.Compress(compression_mode, width, height, stride, pixel_type, data, parameters); });
+}
+
+std::shared_ptr<libCZI::IMemoryBlock> ZstdCompressorPool::Transcode(libCZI::CompressionMode compression_mode,
+                                                                    libCZI::CompressionMode source_compression_mode, std::uint32_t width,
+                                                                    std::uint32_t height, libCZI::PixelType pixel_type,
+                                                                    const void* source_data, size_t size_of_source_data,
+                                                                    const libCZI::ICompressParameters* parameters)
+{
+  return this->RunWithCompressor(
+      [&](ZstdCompressor& compressor)
+      {
+        return compressor.Transcode(compression_mode, source_compression_mode, width, height, pixel_type, source_data, size_of_source_data,
+                                    parameters);
+      });
+}
+
+std::unique_ptr<ZstdCompressor> ZstdCompressorPool::Acquire()
+{
+  {
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    if (!this->compressors_.empty())
+    {
+      auto compressor = std::move(this->compressors_.back());
+      this->compressors_.pop_back();
+      return compressor;
+    }
+  }
+
+  return std::make_unique<ZstdCompressor>(this->buffer_pool_);
+}
+
+void ZstdCompressorPool::Release(std::unique_ptr<ZstdCompressor> compressor)
+{
+  const std::lock_guard<std::mutex> lock(this->mutex_);
+  this->compressors_.push_back(std::move(compressor));
+}
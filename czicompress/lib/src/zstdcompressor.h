@@ -0,0 +1,182 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "../inc_libCZI.h"
+#include "bufferpool.h"
+
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+
+/// This class is compressing bitmaps with the zstd-based compression schemes of CZI ("zstd0" and "zstd1"), producing
+/// the same format as 'libCZI::ZstdCompress::CompressZStd0Alloc' and 'libCZI::ZstdCompress::CompressZStd1Alloc'. In
+/// contrast to those functions, an instance keeps the zstd compression context and its scratch buffer, and reuses them
+/// for all bitmaps it compresses - so the setup cost is paid only once. In addition, it can transcode data which is already
+/// compressed with "zstd0" or "zstd1" (decoding it into a reusable buffer instead of a bitmap object). An instance must not
+/// be used concurrently from multiple threads (see 'ZstdCompressorPool').
+class ZstdCompressor
+{
+private:
+  ZSTD_CCtx_s* context_;
+
+  /// The zstd decompression context (only created when needed, i.e. when transcoding).
+  ZSTD_DCtx_s* decompression_context_{nullptr};
+
+  /// Buffer receiving the decompressed data when transcoding.
+  std::vector<std::uint8_t> decompressed_data_;
+
+  /// Scratch buffer used if the source data has to be rearranged before compressing it (i.e. if the stride is larger
+  /// than the length of a line, or if the low- and high-bytes of the pixels are to be separated).
+  std::vector<std::uint8_t> scratch_buffer_;
+
+  /// The buffer pool from which the buffers for the compressed data are allocated.
+  std::shared_ptr<BufferPool> buffer_pool_;
+
+public:
+  /// Constructor.
+  ///
+  /// \param  buffer_pool The buffer pool from which the buffers for the compressed data are allocated.
+  explicit ZstdCompressor(std::shared_ptr<BufferPool> buffer_pool);
+
+  ZstdCompressor(const ZstdCompressor&) = delete;
+  ZstdCompressor(ZstdCompressor&&) = delete;
+  ZstdCompressor& operator=(const ZstdCompressor&) = delete;
+  ZstdCompressor& operator=(ZstdCompressor&&) = delete;
+  ~ZstdCompressor();
+
+  /// Compresses the specified bitmap. The compression parameters "ZSTD_RAWCOMPRESSIONLEVEL" and (for "zstd1" only)
+  /// "ZSTD_PREPROCESS_DOLOHIBYTEPACKING" are evaluated, other parameters are ignored. In case of an error, an exception
+  /// is thrown.
+  ///
+  /// \param  compression_mode    The compression mode - must be either "Zstd0" or "Zstd1".
+  /// \param  width               The width of the bitmap in pixels.
+  /// \param  height              The height of the bitmap in pixels.
+  /// \param  stride              The stride of the bitmap in bytes.
+  /// \param  pixel_type          The pixel type of the bitmap.
+  /// \param  data                Pointer to the bitmap data.
+  /// \param  parameters          The compression parameters (may be null).
+  ///
+  /// \returns    A memory block containing the compressed data.
+  std::shared_ptr<libCZI::IMemoryBlock> Compress(libCZI::CompressionMode compression_mode, std::uint32_t width, std::uint32_t height,
+                                                 std::uint32_t stride, libCZI::PixelType pixel_type, const void* data,
+                                                 const libCZI::ICompressParameters* parameters);
+
+  /// Transcodes data compressed with "zstd0" or "zstd1" - i.e. decompresses it and compresses it again with the specified
+  /// compression mode and parameters (see 'Compress'). The data is decompressed into a buffer which is reused, and if the
+  /// source data and the result both have the low- and high-bytes separated, they are not merged in between. In case of an
+  /// error (e.g. if the source data is corrupt), an exception is thrown.
+  ///
+  /// \param  compression_mode        The compression mode of the result - must be either "Zstd0" or "Zstd1".
+  /// \param  source_compression_mode The compression mode of the source data - must be either "Zstd0" or "Zstd1".
+  /// \param  width                   The width of the bitmap in pixels.
+  /// \param  height                  The height of the bitmap in pixels.
+  /// \param  pixel_type              The pixel type of the bitmap.
+  /// \param  source_data             Pointer to the compressed source data.
+  /// \param  size_of_source_data     The size of the compressed source data in bytes.
+  /// \param  parameters              The compression parameters (may be null).
+  ///
+  /// \returns    A memory block containing the compressed data.
+  std::shared_ptr<libCZI::IMemoryBlock> Transcode(libCZI::CompressionMode compression_mode, libCZI::CompressionMode source_compression_mode,
+                                                  std::uint32_t width, std::uint32_t height, libCZI::PixelType pixel_type,
+                                                  const void* source_data, size_t size_of_source_data,
+                                                  const libCZI::ICompressParameters* parameters);
+
+  /// Determines whether the specified data (of a subblock) is already compressed as it would be by 'Compress' with the
+  /// specified compression mode and parameters - i.e. whether the compression mode is the same, and (for "zstd1") whether
+  /// the low- and high-bytes are separated as requested. Note that the compression level cannot be determined from the
+  /// compressed data, so it is not taken into account.
+  ///
+  /// \param  compression_mode        The requested compression mode.
+  /// \param  pixel_type              The pixel type of the bitmap.
+  /// \param  parameters              The requested compression parameters (may be null).
+  /// \param  source_compression_mode The compression mode of the data.
+  /// \param  source_data             Pointer to the compressed data.
+  /// \param  size_of_source_data     The size of the compressed data in bytes.
+  ///
+  /// \returns    True if the data is compressed as requested; false otherwise.
+  static bool IsEncodedWith(libCZI::CompressionMode compression_mode, libCZI::PixelType pixel_type,
+                            const libCZI::ICompressParameters* parameters, libCZI::CompressionMode source_compression_mode,
+                            const void* source_data, size_t size_of_source_data);
+
+private:
+  /// Determines the compression level and whether the low- and high-bytes are to be separated from the compression parameters.
+  static void GetCompressionParameters(libCZI::CompressionMode compression_mode, libCZI::PixelType pixel_type,
+                                       const libCZI::ICompressParameters* parameters, int& compression_level, bool& do_lo_hi_byte_packing);
+
+  /// Compresses the data (which is already arranged as required, i.e. contiguous and - if applicable - with the low- and
+  /// high-bytes separated) and adds the header (for "zstd1").
+  std::shared_ptr<libCZI::IMemoryBlock> CompressPreparedData(libCZI::CompressionMode compression_mode, int compression_level,
+                                                             bool do_lo_hi_byte_packing, const std::uint8_t* data, size_t size_of_data);
+
+  const std::uint8_t* PrepareSourceData(std::uint32_t width, std::uint32_t height, std::uint32_t stride, std::uint8_t bytes_per_pixel,
+                                        bool do_lo_hi_byte_packing, const void* data);
+};
+
+/// A pool of 'ZstdCompressor' objects. For compressing a bitmap, a compressor is taken from the pool (or a new one is
+/// created if the pool is empty), and put back into the pool afterwards. So, there are only as many compressors as
+/// there are threads compressing concurrently, and each compressor is used by one thread at a time. All methods are
+/// thread-safe.
+class ZstdCompressorPool
+{
+private:
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<ZstdCompressor>> compressors_;
+  std::shared_ptr<BufferPool> buffer_pool_;
+
+public:
+  /// Constructor.
+  ///
+  /// \param  buffer_pool The buffer pool from which the buffers for the compressed data are allocated.
+  explicit ZstdCompressorPool(std::shared_ptr<BufferPool> buffer_pool) : buffer_pool_(std::move(buffer_pool)) {}
+
+  ZstdCompressorPool(const ZstdCompressorPool&) = delete;
+  ZstdCompressorPool(ZstdCompressorPool&&) = delete;
+  ZstdCompressorPool& operator=(const ZstdCompressorPool&) = delete;
+  ZstdCompressorPool& operator=(ZstdCompressorPool&&) = delete;
+  ~ZstdCompressorPool() = default;
+
+  /// Compresses the specified bitmap - see 'ZstdCompressor::Compress' for the semantics of the arguments.
+  ///
+  /// \returns    A memory block containing the compressed data.
+  std::shared_ptr<libCZI::IMemoryBlock> Compress(libCZI::CompressionMode compression_mode, std::uint32_t width, std::uint32_t height,
+                                                 std::uint32_t stride, libCZI::PixelType pixel_type, const void* data,
+                                                 const libCZI::ICompressParameters* parameters);
+
+  /// Transcodes "zstd0"- or "zstd1"-compressed data - see 'ZstdCompressor::Transcode' for the semantics of the arguments.
+  ///
+  /// \returns    A memory block containing the compressed data.
+  std::shared_ptr<libCZI::IMemoryBlock> Transcode(libCZI::CompressionMode compression_mode, libCZI::CompressionMode source_compression_mode,
+                                                  std::uint32_t width, std::uint32_t height, libCZI::PixelType pixel_type,
+                                                  const void* source_data, size_t size_of_source_data,
+                                                  const libCZI::ICompressParameters* parameters);
+
+private:
+  /// Runs the specified function with a compressor taken from the pool, and puts the compressor back afterwards.
+  template <typename Function>
+  std::shared_ptr<libCZI::IMemoryBlock> RunWithCompressor(const Function& function)
+  {
+    auto compressor = this->Acquire();
+    try
+    {
+      auto compressed_data = function(*compressor);
+      this->Release(std::move(compressor));
+      return compressed_data;
+    }
+    catch (...)
+    {
+      this->Release(std::move(compressor));
+      throw;
+    }
+  }
+
+  std::unique_ptr<ZstdCompressor> Acquire();
+  void Release(std::unique_ptr<ZstdCompressor> compressor);
+};
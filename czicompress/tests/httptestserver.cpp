@@ -0,0 +1,268 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "httptestserver.h"
+
+#ifndef _WIN32
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// The path of the file served.
+constexpr char kPath[] = "/file.czi";  // NOLINT: C-style array
+
+#if defined(MSG_NOSIGNAL)
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+bool SendAll(int socket, const void* data, size_t size)
+{
+  const auto* pointer = static_cast<const char*>(data);
+  while (size > 0)
+  {
+    const ssize_t bytes_sent = send(socket, pointer, size, kSendFlags);
+    if (bytes_sent <= 0)
+    {
+      return false;
+    }
+
+    pointer += bytes_sent;  // NOLINT: pointer arithmetic
+    size -= static_cast<size_t>(bytes_sent);
+  }
+
+  return true;
+}
+
+/// Gets the value of the specified header (the name is compared case-insensitively), or an empty string if the
+/// request does not contain this header.
+std::string GetHeaderValue(const std::string& request, const std::string& name)
+{
+  std::istringstream stream(request);
+  std::string line;
+  while (std::getline(stream, line))
+  {
+    if (line.size() > name.size() && line[name.size()] == ':' &&
+        std::equal(name.begin(), name.end(), line.begin(),
+                   [](char a, char b)
+                   { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); }))
+    {
+      std::string value = line.substr(name.size() + 1);
+      value.erase(0, value.find_first_not_of(' '));
+      value.erase(value.find_last_not_of("\r ") + 1);
+      return value;
+    }
+  }
+
+  return std::string();
+}
+
+}  // namespace
+
+HttpTestServer::HttpTestServer(std::vector<std::uint8_t> data, std::chrono::microseconds latency, bool support_ranges)
+    : data_(std::move(data)), latency_(latency), support_ranges_(support_ranges)
+{
+  this->listening_socket_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (this->listening_socket_ < 0)
+  {
+    throw std::runtime_error("Creating the socket failed.");
+  }
+
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = 0;
+  socklen_t address_length = sizeof(address);
+  if (bind(this->listening_socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||  // NOLINT: reinterpret_cast
+      listen(this->listening_socket_, SOMAXCONN) != 0 ||
+      getsockname(this->listening_socket_, reinterpret_cast<sockaddr*>(&address), &address_length) != 0)  // NOLINT: reinterpret_cast
+  {
+    close(this->listening_socket_);
+    throw std::runtime_error("Setting up the listening socket failed.");
+  }
+
+  this->port_ = ntohs(address.sin_port);
+  this->accept_thread_ = std::thread([this]() { this->AcceptConnections(); });
+}
+
+HttpTestServer::~HttpTestServer()
+{
+  this->stop_ = true;
+  this->accept_thread_.join();
+  close(this->listening_socket_);
+
+  // shutting down the sockets makes the connection threads return from 'recv'
+  std::vector<std::thread> connection_threads;
+  {
+    const std::lock_guard<std::mutex> lock(this->connections_mutex_);
+    for (const int connection_socket : this->connection_sockets_)
+    {
+      shutdown(connection_socket, SHUT_RDWR);
+    }
+
+    connection_threads = std::move(this->connection_threads_);
+  }
+
+  for (auto& thread : connection_threads)
+  {
+    thread.join();
+  }
+
+  for (const int connection_socket : this->connection_sockets_)
+  {
+    close(connection_socket);
+  }
+}
+
+std::string HttpTestServer::GetUrl() const
+{
+  return "http://127.0.0.1:" + std::to_string(this->port_) + kPath;
+}
+
+void HttpTestServer::AcceptConnections()
+{
+  while (!this->stop_)
+  {
+    // we poll with a timeout, so that the stop-flag is checked regularly
+    pollfd poll_fd = {};
+    poll_fd.fd = this->listening_socket_;
+    poll_fd.events = POLLIN;
+    if (poll(&poll_fd, 1, 50) <= 0)
+    {
+      continue;
+    }
+
+    const int connection_socket = accept(this->listening_socket_, nullptr, nullptr);
+    if (connection_socket < 0)
+    {
+      continue;
+    }
+
+    const int no_delay = 1;
+    setsockopt(connection_socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+    const std::lock_guard<std::mutex> lock(this->connections_mutex_);
+    this->connection_sockets_.push_back(connection_socket);
+    this->connection_threads_.emplace_back([this, connection_socket]() { this->ServeConnection(connection_socket); });
+  }
+}
+
+void HttpTestServer::ServeConnection(int connection_socket)
+{
+  std::string received;
+  char buffer[4096];  // NOLINT: C-style array
+  for (;;)
+  {
+    const auto end_of_request = received.find("\r\n\r\n");
+    if (end_of_request == std::string::npos)
+    {
+      const ssize_t bytes_received = recv(connection_socket, buffer, sizeof(buffer), 0);
+      if (bytes_received <= 0)
+      {
+        return;
+      }
+
+      received.append(buffer, static_cast<size_t>(bytes_received));
+      continue;
+    }
+
+    const std::string request = received.substr(0, end_of_request + 4);
+    received.erase(0, end_of_request + 4);
+    ++this->number_of_requests_;
+    const std::uint32_t number_of_requests_in_progress = ++this->number_of_requests_in_progress_;
+    std::uint32_t max_number_of_requests_in_progress = this->max_number_of_requests_in_progress_.load();
+    while (number_of_requests_in_progress > max_number_of_requests_in_progress &&
+           !this->max_number_of_requests_in_progress_.compare_exchange_weak(max_number_of_requests_in_progress,
+                                                                              number_of_requests_in_progress))
+    {
+    }
+
+    if (this->latency_.count() > 0)
+    {
+      std::this_thread::sleep_for(this->latency_);
+    }
+
+    bool is_head_request = false;
+    std::uint64_t body_offset = 0;
+    std::uint64_t body_size = 0;
+    const std::string response = this->CreateResponse(request, is_head_request, body_offset, body_size);
+    const bool success = SendAll(connection_socket, response.data(), response.size()) &&
+                         (is_head_request || SendAll(connection_socket, this->data_.data() + body_offset, static_cast<size_t>(body_size)));
+    --this->number_of_requests_in_progress_;
+    if (!success)
+    {
+      return;
+    }
+  }
+}
+
+std::string HttpTestServer::CreateResponse(const std::string& request, bool& is_head_request, std::uint64_t& body_offset,
+                                           std::uint64_t& body_size) const
+{
+  std::istringstream request_line(request.substr(0, request.find("\r\n")));
+  std::string method;
+  std::string path;
+  request_line >> method >> path;
+  is_head_request = method == "HEAD";
+  body_offset = 0;
+  body_size = 0;
+  const std::uint64_t file_size = this->data_.size();
+  std::ostringstream response;
+  if ((method != "GET" && method != "HEAD") || path != kPath)
+  {
+    response << "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+    return response.str();
+  }
+
+  // we support only a single range of the form "bytes=first-last" or "bytes=first-"
+  const std::string range = this->support_ranges_ ? GetHeaderValue(request, "Range") : std::string();
+  if (range.empty())
+  {
+    body_size = file_size;
+    response << "HTTP/1.1 200 OK\r\nContent-Length: " << file_size << "\r\n\r\n";
+    return response.str();
+  }
+
+  std::uint64_t first = 0;
+  std::uint64_t last = file_size > 0 ? file_size - 1 : 0;
+  const auto position_of_dash = range.find('-');
+  if (range.compare(0, 6, "bytes=") != 0 || position_of_dash == std::string::npos)
+  {
+    response << "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n";
+    return response.str();
+  }
+
+  first = std::stoull(range.substr(6, position_of_dash - 6));
+  if (position_of_dash + 1 < range.size())
+  {
+    last = (std::min)(last, static_cast<std::uint64_t>(std::stoull(range.substr(position_of_dash + 1))));
+  }
+
+  if (first >= file_size || first > last)
+  {
+    response << "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */" << file_size << "\r\nContent-Length: 0\r\n\r\n";
+    return response.str();
+  }
+
+  body_offset = first;
+  body_size = last - first + 1;
+  response << "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes " << first << "-" << last << "/" << file_size
+           << "\r\nContent-Length: " << body_size << "\r\n\r\n";
+  return response.str();
+}
+
+#endif
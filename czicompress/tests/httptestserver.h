@@ -0,0 +1,73 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#ifndef _WIN32
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// A minimal HTTP/1.1 server on the loopback interface (on a port chosen by the operating system), which serves a
+/// file held in memory - for testing and benchmarking reading the source file from an http(s)-URL. GET requests
+/// (with or without a 'Range' header for a single range) and HEAD requests are answered, connections are kept open
+/// between requests, and each connection is served on a thread of its own. Each response can be delayed by a
+/// configurable latency, which emulates a remote server.
+class HttpTestServer
+{
+private:
+  std::vector<std::uint8_t> data_;
+  std::chrono::microseconds latency_;
+  bool support_ranges_;
+  int listening_socket_{-1};
+  std::uint16_t port_{0};
+  std::atomic<bool> stop_{false};
+  std::thread accept_thread_;
+
+  std::mutex connections_mutex_;  ///< Protects the sockets and threads of the connections.
+  std::vector<int> connection_sockets_;
+  std::vector<std::thread> connection_threads_;
+
+  std::atomic<std::uint64_t> number_of_requests_{0};
+  std::atomic<std::uint32_t> number_of_requests_in_progress_{0};
+  std::atomic<std::uint32_t> max_number_of_requests_in_progress_{0};
+
+public:
+  /// Constructor - the server is started (and listening) when the constructor returns.
+  ///
+  /// \param  data            The content of the file which is served.
+  /// \param  latency         The time by which each response is delayed.
+  /// \param  support_ranges  If false, the 'Range' header is ignored (i.e. the whole file is sent with status 200).
+  explicit HttpTestServer(std::vector<std::uint8_t> data, std::chrono::microseconds latency = std::chrono::microseconds(0),
+                          bool support_ranges = true);
+  ~HttpTestServer();
+
+  HttpTestServer(const HttpTestServer&) = delete;
+  HttpTestServer& operator=(const HttpTestServer&) = delete;
+
+  /// Gets the URL of the file served - requests for other paths are answered with status 404.
+  ///
+  /// \returns The URL of the file.
+  std::string GetUrl() const;
+
+  /// Gets the number of requests received so far.
+  std::uint64_t GetNumberOfRequests() const { return this->number_of_requests_.load(); }
+
+  /// Gets the maximum number of requests which have been in progress at the same time.
+  std::uint32_t GetMaxNumberOfConcurrentRequests() const { return this->max_number_of_requests_in_progress_.load(); }
+
+private:
+  void AcceptConnections();
+  void ServeConnection(int connection_socket);
+
+  /// Creates the response for the specified request (request line and header lines).
+  std::string CreateResponse(const std::string& request, bool& is_head_request, std::uint64_t& body_offset, std::uint64_t& body_size) const;
+};
+
+#endif
@@ -7,7 +7,14 @@
 #include <libCZI.h>
 
 #include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 #include <memory>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 CMemOutputStream::CMemOutputStream(size_t initial_size) : ptr_(nullptr), allocated_size_(initial_size), used_size_(0)
 {
@@ -108,6 +115,31 @@ void CMemInputOutputStream::EnsureSize(std::uint64_t newSize)
 
 // ======================================================================================================
 
+TemporaryFile::TemporaryFile(const std::string& name) : path_(std::filesystem::temp_directory_path() / name)
+{
+  std::error_code error_code;
+  std::filesystem::remove(this->path_, error_code);
+}
+
+TemporaryFile::TemporaryFile(const std::string& name, const std::vector<std::uint8_t>& data)
+    : path_(std::filesystem::temp_directory_path() / name)
+{
+  std::ofstream file(this->path_, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));  // NOLINT
+}
+
+TemporaryFile::~TemporaryFile()
+{
+  std::error_code error_code;
+  std::filesystem::remove(this->path_, error_code);
+}
+
+std::vector<std::uint8_t> TemporaryFile::ReadContent() const
+{
+  std::ifstream file(this->path_, std::ios::binary);
+  return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
 class CMemBitmapWrapper : public libCZI::IBitmapData
 {
 private:
@@ -184,6 +216,11 @@ public:
   void Unlock() override {}
 };
 
+std::shared_ptr<libCZI::IBitmapData> CreateBitmap(libCZI::PixelType pixel_type, std::uint32_t width, std::uint32_t height)
+{
+  return std::make_shared<CMemBitmapWrapper>(pixel_type, width, height);
+}
+
 std::shared_ptr<libCZI::IBitmapData> CreateGray8BitmapAndFill(std::uint32_t width, std::uint32_t height, uint8_t value)
 {
   auto bitmap = std::make_shared<CMemBitmapWrapper>(libCZI::PixelType::Gray8, width, height);
@@ -198,3 +235,94 @@ std::shared_ptr<libCZI::IBitmapData> CreateGray8BitmapAndFill(std::uint32_t widt
 
   return bitmap;
 }
+
+std::shared_ptr<libCZI::IBitmapData> CreateBitmapAndFillWithPattern(libCZI::PixelType pixel_type, std::uint32_t width, std::uint32_t height)
+{
+  auto bitmap = std::make_shared<CMemBitmapWrapper>(pixel_type, width, height);
+  const libCZI::ScopedBitmapLockerSP bitmap_locked{bitmap};
+  const size_t line_length = static_cast<size_t>(width) * libCZI::Utils::GetBytesPerPixel(pixel_type);
+  for (uint32_t row = 0; row < height; ++row)
+  {
+    auto* row_start_address = static_cast<uint8_t*>(bitmap_locked.ptrDataRoi) + static_cast<size_t>(bitmap_locked.stride) * row;  // NOLINT
+    for (size_t i = 0; i < line_length; ++i)
+    {
+      row_start_address[i] = static_cast<uint8_t>((i * 7) + (row * 13) + (i / 5));  // NOLINT: pointer arithmetic
+    }
+  }
+
+  return bitmap;
+}
+
+std::shared_ptr<libCZI::IBitmapData> CreateBitmapAndFillWithNoise(libCZI::PixelType pixel_type, std::uint32_t width, std::uint32_t height,
+                                                                  std::uint32_t seed)
+{
+  auto bitmap = std::make_shared<CMemBitmapWrapper>(pixel_type, width, height);
+  const libCZI::ScopedBitmapLockerSP bitmap_locked{bitmap};
+  const size_t line_length = static_cast<size_t>(width) * libCZI::Utils::GetBytesPerPixel(pixel_type);
+  std::mt19937 random_engine(seed);
+  for (uint32_t row = 0; row < height; ++row)
+  {
+    auto* row_start_address = static_cast<uint8_t*>(bitmap_locked.ptrDataRoi) + static_cast<size_t>(bitmap_locked.stride) * row;  // NOLINT
+    for (size_t i = 0; i < line_length; ++i)
+    {
+      row_start_address[i] = static_cast<uint8_t>(random_engine());  // NOLINT: pointer arithmetic
+    }
+  }
+
+  return bitmap;
+}
+
+void ShuffleSubBlockDirectory(void* czi_document, size_t size, std::uint32_t seed)
+{
+  // see the CZI file format specification for the layout of the segments
+  constexpr size_t kSegmentHeaderSize = 32;
+  constexpr size_t kOffsetOfSubBlockDirectoryPosition = kSegmentHeaderSize + 52;
+  constexpr size_t kSizeOfSubBlockDirectoryHeader = 128;
+  constexpr size_t kSizeOfDirectoryEntryDvWithoutDimensions = 32;
+  constexpr size_t kOffsetOfDimensionCountInDirectoryEntryDv = 28;
+  constexpr size_t kSizeOfDimensionEntry = 20;
+
+  auto* data = static_cast<std::uint8_t*>(czi_document);
+  const auto read_from_document = [data, size](size_t offset, void* destination, size_t length)
+  {
+    if (offset > size || length > size - offset)
+    {
+      throw std::runtime_error("malformed CZI document");
+    }
+
+    memcpy(destination, data + offset, length);  // NOLINT: pointer arithmetic
+  };
+
+  std::uint64_t subblock_directory_position = 0;
+  read_from_document(kOffsetOfSubBlockDirectoryPosition, &subblock_directory_position, sizeof(subblock_directory_position));
+  std::int32_t number_of_entries = 0;
+  read_from_document(subblock_directory_position + kSegmentHeaderSize, &number_of_entries, sizeof(number_of_entries));
+
+  const size_t start_of_entries = subblock_directory_position + kSegmentHeaderSize + kSizeOfSubBlockDirectoryHeader;
+  size_t offset = start_of_entries;
+  std::vector<std::vector<std::uint8_t>> entries;
+  for (std::int32_t i = 0; i < number_of_entries; ++i)
+  {
+    std::int32_t dimension_count = 0;
+    read_from_document(offset + kOffsetOfDimensionCountInDirectoryEntryDv, &dimension_count, sizeof(dimension_count));
+    const size_t size_of_entry = kSizeOfDirectoryEntryDvWithoutDimensions + static_cast<size_t>(dimension_count) * kSizeOfDimensionEntry;
+    std::vector<std::uint8_t> entry(size_of_entry);
+    read_from_document(offset, entry.data(), entry.size());
+    offset += entry.size();
+    entries.push_back(std::move(entry));
+  }
+
+  // Fisher-Yates shuffle - we do not use std::shuffle here, because its result is implementation-defined
+  std::mt19937 random_engine(seed);
+  for (size_t i = entries.size(); i > 1; --i)
+  {
+    std::swap(entries[i - 1], entries[random_engine() % i]);
+  }
+
+  offset = start_of_entries;
+  for (const auto& entry : entries)
+  {
+    memcpy(data + offset, entry.data(), entry.size());  // NOLINT: pointer arithmetic
+    offset += entry.size();
+  }
+}
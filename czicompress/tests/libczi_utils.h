@@ -6,7 +6,11 @@
 
 #include <libCZI.h>
 
+#include <cstdint>
+#include <filesystem>
 #include <memory>
+#include <string>
+#include <vector>
 
 /// Implementation of libCZI::IOutputStream which is backed by a memory buffer.
 class CMemOutputStream : public libCZI::IOutputStream
@@ -83,4 +87,78 @@ private:
   void EnsureSize(std::uint64_t newSize);
 };
 
+/// A file in the temp-folder which is deleted when going out of scope.
+class TemporaryFile
+{
+private:
+  std::filesystem::path path_;
+
+public:
+  /// Constructor - no file is created (e.g. if the file is to be created by the code under test), but an
+  /// existing file with this name is deleted.
+  ///
+  /// \param  name    The filename.
+  explicit TemporaryFile(const std::string& name);
+
+  /// Constructor - the file is created with the specified content.
+  ///
+  /// \param  name    The filename.
+  /// \param  data    The content of the file.
+  TemporaryFile(const std::string& name, const std::vector<std::uint8_t>& data);
+  ~TemporaryFile();
+
+  TemporaryFile(const TemporaryFile&) = delete;
+  TemporaryFile& operator=(const TemporaryFile&) = delete;
+
+  std::string GetPath() const { return this->path_.u8string(); }
+
+  /// Reads the content of the file.
+  ///
+  /// \returns The content of the file.
+  std::vector<std::uint8_t> ReadContent() const;
+};
+
 std::shared_ptr<libCZI::IBitmapData> CreateGray8BitmapAndFill(std::uint32_t width, std::uint32_t height, uint8_t value);
+
+/// Creates a bitmap of the specified pixel type and size - the content is not initialized. The supported pixel types
+/// are Gray8, Gray16, Gray32Float, Bgr24 and Bgr48.
+///
+/// \param  pixel_type  The pixel type.
+/// \param  width       The width in pixels.
+/// \param  height      The height in pixels.
+///
+/// \returns The newly created bitmap.
+std::shared_ptr<libCZI::IBitmapData> CreateBitmap(libCZI::PixelType pixel_type, std::uint32_t width, std::uint32_t height);
+
+/// Creates a bitmap of the specified pixel type and size, and fills it with a deterministic pattern (which
+/// is not trivially compressible). The supported pixel types are Gray8, Gray16, Gray32Float, Bgr24 and Bgr48.
+///
+/// \param  pixel_type  The pixel type.
+/// \param  width       The width in pixels.
+/// \param  height      The height in pixels.
+///
+/// \returns The newly created bitmap.
+std::shared_ptr<libCZI::IBitmapData> CreateBitmapAndFillWithPattern(libCZI::PixelType pixel_type, std::uint32_t width,
+                                                                    std::uint32_t height);
+
+/// Creates a bitmap of the specified pixel type and size, and fills it with pseudo-random noise (which is
+/// practically incompressible). The supported pixel types are the same as with 'CreateBitmapAndFillWithPattern'.
+///
+/// \param  pixel_type  The pixel type.
+/// \param  width       The width in pixels.
+/// \param  height      The height in pixels.
+/// \param  seed        The seed for the pseudo-random number generator.
+///
+/// \returns The newly created bitmap.
+std::shared_ptr<libCZI::IBitmapData> CreateBitmapAndFillWithNoise(libCZI::PixelType pixel_type, std::uint32_t width, std::uint32_t height,
+                                                                  std::uint32_t seed);
+
+/// Shuffles the entries of the subblock directory of the specified CZI document (in place). The subblocks themselves
+/// are not moved, so afterwards the order of the subblock directory does not match the order of the subblocks in
+/// the file anymore - which is what we find with "fragmented" documents. The permutation is determined by the given
+/// seed, and it is the same on all platforms.
+///
+/// \param [in,out]    czi_document    The CZI document.
+/// \param             size            The size of the CZI document in bytes.
+/// \param             seed            The seed for the random permutation.
+void ShuffleSubBlockDirectory(void* czi_document, size_t size, std::uint32_t seed);
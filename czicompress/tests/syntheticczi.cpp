@@ -0,0 +1,489 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include "syntheticczi.h"
+
+#include <include/outputstream.h>
+#include <src/bufferpool.h>
+#include <src/zstdcompressor.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include "libczi_utils.h"
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// The fraction of the cells of the grid (with the spacing 'SyntheticCziOptions::blob_spacing') which contain a blob.
+constexpr double kBlobDensity = 0.7;
+
+/// The range of the standard deviation of the blobs, relative to the spacing of the blobs.
+constexpr double kMinimumBlobSigma = 0.1;
+constexpr double kMaximumBlobSigma = 0.3;
+
+/// The range of the peak intensity of the blobs, relative to the maximum pixel value.
+constexpr double kMinimumBlobAmplitude = 0.2;
+constexpr double kMaximumBlobAmplitude = 0.9;
+
+/// The blobs are rendered up to this multiple of their standard deviation.
+constexpr double kBlobExtentInSigmas = 3;
+
+/// The range of the level of the background (which is different for each channel), relative to the maximum pixel value.
+constexpr double kMinimumBackgroundLevel = 0.02;
+constexpr double kMaximumBackgroundLevel = 0.08;
+
+/// The maximum number of significant bits of a pixel value stored as float (i.e. the size of the mantissa).
+constexpr int kMaximumBitsPerPixelForFloat = 24;
+
+/// The maximum number of pyramid levels (in addition to the full resolution).
+constexpr int kMaximumNumberOfPyramidLevels = 16;
+
+/// The description of a subblock of the synthetic document (within a plane, i.e. for one channel and one Z-plane).
+struct TileRectangle
+{
+  int x;                        ///< The x-coordinate of the left edge (in pixels of the full resolution).
+  int y;                        ///< The y-coordinate of the top edge (in pixels of the full resolution).
+  std::uint32_t logical_width;  ///< The width in pixels of the full resolution.
+  std::uint32_t logical_height;
+  std::uint32_t physical_width;  ///< The width of the bitmap of the subblock.
+  std::uint32_t physical_height;
+  int pyramid_level;  ///< The pyramid level (0 is the full resolution).
+  int m_index;        ///< The M-index (only valid for the full resolution).
+};
+
+/// The finalizer of the "splitmix64" pseudo-random number generator - a cheap function whose result looks random.
+std::uint64_t Mix(std::uint64_t value)
+{
+  value += 0x9e3779b97f4a7c15ULL;
+  value = (value ^ (value >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+  value = (value ^ (value >> 27U)) * 0x94d049bb133111ebULL;
+  return value ^ (value >> 31U);
+}
+
+std::uint64_t Hash(std::uint32_t seed, std::initializer_list<std::int64_t> values)
+{
+  std::uint64_t hash = Mix(seed);
+  for (const std::int64_t value : values)
+  {
+    hash = Mix(hash ^ static_cast<std::uint64_t>(value));
+  }
+
+  return hash;
+}
+
+/// Gets a number in the interval [0, 1) derived from the hash value.
+double ToUnitInterval(std::uint64_t hash) { return static_cast<double>(hash >> 11U) * 0x1.0p-53; }
+
+/// Gets a number with (approximately) a standard normal distribution derived from the hash value - the sum of four
+/// uniformly distributed numbers (with 16 bits each), scaled to unit variance.
+double ToNormalDistribution(std::uint64_t hash)
+{
+  constexpr double kScale = 1.7320508075688772 / 65536;  // sqrt(3), since the variance of the sum is 4/12
+  const std::uint64_t sum = (hash & 0xffffU) + ((hash >> 16U) & 0xffffU) + ((hash >> 32U) & 0xffffU) + (hash >> 48U);
+  return (static_cast<double>(sum) - 2 * 65536.0) * kScale;
+}
+
+int GetNumberOfComponents(libCZI::PixelType pixel_type)
+{
+  return pixel_type == libCZI::PixelType::Bgr24 || pixel_type == libCZI::PixelType::Bgr48 ? 3 : 1;
+}
+
+int GetMaximumBitsPerPixel(libCZI::PixelType pixel_type)
+{
+  switch (pixel_type)
+  {
+    case libCZI::PixelType::Gray8:
+    case libCZI::PixelType::Bgr24:
+      return 8;
+    case libCZI::PixelType::Gray16:
+    case libCZI::PixelType::Bgr48:
+      return 16;
+    case libCZI::PixelType::Gray32Float:
+      return kMaximumBitsPerPixelForFloat;
+    default:
+      throw std::invalid_argument("The pixel type is not supported for a synthetic document.");
+  }
+}
+
+void ValidateOptions(const SyntheticCziOptions& options)
+{
+  const int maximum_bits_per_pixel = GetMaximumBitsPerPixel(options.pixel_type);
+  if (options.bits_per_pixel < 1 || options.bits_per_pixel > maximum_bits_per_pixel)
+  {
+    throw std::invalid_argument("The number of bits per pixel is out of range for the pixel type.");
+  }
+
+  if (options.tile_size == 0 || options.tile_overlap >= options.tile_size || options.number_of_tiles_x < 1 ||
+      options.number_of_tiles_y < 1 || options.number_of_channels < 1 || options.number_of_z_planes < 1 ||
+      options.number_of_pyramid_levels < 0 || options.number_of_attachments < 0)
+  {
+    throw std::invalid_argument("The layout of the synthetic document is invalid.");
+  }
+
+  // the coordinates of the subblocks must fit into an int
+  const std::uint64_t step = options.tile_size - options.tile_overlap;
+  const int number_of_tiles = std::max(options.number_of_tiles_x, options.number_of_tiles_y);
+  const std::uint64_t mosaic_extent = step * static_cast<std::uint64_t>(number_of_tiles - 1) + options.tile_size;
+  if (options.number_of_pyramid_levels > kMaximumNumberOfPyramidLevels ||
+      mosaic_extent > static_cast<std::uint64_t>(std::numeric_limits<int>::max()))
+  {
+    throw std::invalid_argument("The synthetic document is too large.");
+  }
+
+  if (!(options.blob_spacing > 0) || !(options.noise_level >= 0))
+  {
+    throw std::invalid_argument("The parameters of the image content are invalid.");
+  }
+
+  for (const auto& compression_option : options.compression_options)
+  {
+    if (compression_option.first != libCZI::CompressionMode::UnCompressed && compression_option.first != libCZI::CompressionMode::Zstd0 &&
+        compression_option.first != libCZI::CompressionMode::Zstd1)
+    {
+      throw std::invalid_argument("The compression mode is not supported for a synthetic document.");
+    }
+  }
+}
+
+/// Calls the function for all subblocks of a plane (i.e. of a channel and a Z-plane) - first the tiles of the mosaic,
+/// then the tiles of the pyramid levels.
+void ForEachTile(const SyntheticCziOptions& options, const std::function<void(const TileRectangle&)>& function)
+{
+  const std::uint32_t step = options.tile_size - options.tile_overlap;
+  for (int row = 0; row < options.number_of_tiles_y; ++row)
+  {
+    for (int column = 0; column < options.number_of_tiles_x; ++column)
+    {
+      function(TileRectangle{column * static_cast<int>(step), row * static_cast<int>(step), options.tile_size, options.tile_size,
+                             options.tile_size, options.tile_size, 0, row * options.number_of_tiles_x + column});
+    }
+  }
+
+  const std::uint64_t mosaic_width = static_cast<std::uint64_t>(step) * (options.number_of_tiles_x - 1) + options.tile_size;
+  const std::uint64_t mosaic_height = static_cast<std::uint64_t>(step) * (options.number_of_tiles_y - 1) + options.tile_size;
+  for (int pyramid_level = 1; pyramid_level <= options.number_of_pyramid_levels; ++pyramid_level)
+  {
+    const std::uint64_t scale = 1ULL << static_cast<unsigned>(pyramid_level);
+    const std::uint64_t extent = options.tile_size * scale;
+    for (std::uint64_t y = 0; y < mosaic_height; y += extent)
+    {
+      for (std::uint64_t x = 0; x < mosaic_width; x += extent)
+      {
+        const std::uint64_t logical_width = std::min(extent, mosaic_width - x);
+        const std::uint64_t logical_height = std::min(extent, mosaic_height - y);
+        function(TileRectangle{static_cast<int>(x), static_cast<int>(y), static_cast<std::uint32_t>(logical_width),
+                               static_cast<std::uint32_t>(logical_height), static_cast<std::uint32_t>((logical_width + scale - 1) / scale),
+                               static_cast<std::uint32_t>((logical_height + scale - 1) / scale), pyramid_level, -1});
+      }
+    }
+  }
+}
+
+/// Adds the Gaussian blobs overlapping the tile to the intensities (which are relative to the maximum pixel value).
+void AddBlobs(const SyntheticCziOptions& options, int x, int y, int channel, int component, int z_plane, double scale,
+              std::uint32_t width, std::uint32_t height, std::vector<float>& intensities)
+{
+  const double spacing = options.blob_spacing;
+  const double margin = kBlobExtentInSigmas * kMaximumBlobSigma * spacing;
+  const auto first_cell_x = static_cast<std::int64_t>(std::floor((x - margin) / spacing));
+  const auto last_cell_x = static_cast<std::int64_t>(std::floor((x + width * scale + margin) / spacing));
+  const auto first_cell_y = static_cast<std::int64_t>(std::floor((y - margin) / spacing));
+  const auto last_cell_y = static_cast<std::int64_t>(std::floor((y + height * scale + margin) / spacing));
+  std::vector<double> profile_x(width);
+  std::vector<double> profile_y(height);
+  for (std::int64_t cell_y = first_cell_y; cell_y <= last_cell_y; ++cell_y)
+  {
+    for (std::int64_t cell_x = first_cell_x; cell_x <= last_cell_x; ++cell_x)
+    {
+      const std::uint64_t hash = Hash(options.seed, {channel, component, cell_x, cell_y});
+      if (ToUnitInterval(Mix(hash)) >= kBlobDensity)
+      {
+        continue;
+      }
+
+      const double center_x = (static_cast<double>(cell_x) + ToUnitInterval(Mix(hash + 1))) * spacing;
+      const double center_y = (static_cast<double>(cell_y) + ToUnitInterval(Mix(hash + 2))) * spacing;
+      const double sigma = spacing * (kMinimumBlobSigma + (kMaximumBlobSigma - kMinimumBlobSigma) * ToUnitInterval(Mix(hash + 3)));
+      double amplitude = kMinimumBlobAmplitude + (kMaximumBlobAmplitude - kMinimumBlobAmplitude) * ToUnitInterval(Mix(hash + 4));
+      if (options.number_of_z_planes > 1)
+      {
+        // each blob is in focus at some Z-plane, and it fades out with the distance from this plane
+        const double center_z = ToUnitInterval(Mix(hash + 5)) * (options.number_of_z_planes - 1);
+        const double sigma_z = 1 + ToUnitInterval(Mix(hash + 6)) * options.number_of_z_planes / 4;
+        amplitude *= std::exp(-(z_plane - center_z) * (z_plane - center_z) / (2 * sigma_z * sigma_z));
+      }
+
+      // the pixel i of the tile covers [x + i * scale, x + (i + 1) * scale), and it is sampled at its center
+      const double extent = kBlobExtentInSigmas * sigma;
+      const auto first_column = static_cast<std::int64_t>(std::max(0.0, std::ceil((center_x - extent - x) / scale - 0.5)));
+      const auto last_column = static_cast<std::int64_t>(std::min(width - 1.0, std::floor((center_x + extent - x) / scale - 0.5)));
+      const auto first_row = static_cast<std::int64_t>(std::max(0.0, std::ceil((center_y - extent - y) / scale - 0.5)));
+      const auto last_row = static_cast<std::int64_t>(std::min(height - 1.0, std::floor((center_y + extent - y) / scale - 0.5)));
+      if (amplitude < 1e-3 || first_column > last_column || first_row > last_row)
+      {
+        continue;
+      }
+
+      for (std::int64_t column = first_column; column <= last_column; ++column)
+      {
+        const double distance = x + (static_cast<double>(column) + 0.5) * scale - center_x;
+        profile_x[column] = std::exp(-distance * distance / (2 * sigma * sigma));
+      }
+
+      for (std::int64_t row = first_row; row <= last_row; ++row)
+      {
+        const double distance = y + (static_cast<double>(row) + 0.5) * scale - center_y;
+        profile_y[row] = amplitude * std::exp(-distance * distance / (2 * sigma * sigma));
+      }
+
+      for (std::int64_t row = first_row; row <= last_row; ++row)
+      {
+        float* intensities_row = intensities.data() + static_cast<size_t>(row) * width;
+        for (std::int64_t column = first_column; column <= last_column; ++column)
+        {
+          intensities_row[column] += static_cast<float>(profile_y[row] * profile_x[column]);  // NOLINT: pointer arithmetic
+        }
+      }
+    }
+  }
+}
+
+/// Stores one component of the pixels of a row (given as values in the range of the pixel type).
+template <typename T>
+void StoreComponents(const std::vector<double>& values, int number_of_components, int component, std::uint8_t* row)
+{
+  for (size_t i = 0; i < values.size(); ++i)
+  {
+    T value;
+    if constexpr (std::is_integral_v<T>)
+    {
+      value = static_cast<T>(std::lround(values[i]));
+    }
+    else
+    {
+      value = static_cast<T>(values[i]);
+    }
+
+    memcpy(row + (i * number_of_components + component) * sizeof(T), &value, sizeof(T));  // NOLINT: pointer arithmetic
+  }
+}
+
+void WriteTile(libCZI::ICziWriter* writer, ZstdCompressor& compressor, const libCZI::Utils::CompressionOption* compression_option,
+               const TileRectangle& tile, int channel, int z_plane, bool has_z_dimension,
+               const std::shared_ptr<libCZI::IBitmapData>& bitmap)
+{
+  const libCZI::ScopedBitmapLockerSP bitmap_locked{bitmap};
+  const auto initialize = [&](libCZI::AddSubBlockInfoBase& add_subblock_info)
+  {
+    add_subblock_info.coordinate.Set(libCZI::DimensionIndex::C, channel);
+    if (has_z_dimension)
+    {
+      add_subblock_info.coordinate.Set(libCZI::DimensionIndex::Z, z_plane);
+    }
+
+    add_subblock_info.mIndexValid = tile.pyramid_level == 0;
+    add_subblock_info.mIndex = tile.m_index;
+    add_subblock_info.x = tile.x;
+    add_subblock_info.y = tile.y;
+    add_subblock_info.logicalWidth = static_cast<int>(tile.logical_width);
+    add_subblock_info.logicalHeight = static_cast<int>(tile.logical_height);
+    add_subblock_info.physicalWidth = static_cast<int>(tile.physical_width);
+    add_subblock_info.physicalHeight = static_cast<int>(tile.physical_height);
+    add_subblock_info.PixelType = bitmap->GetPixelType();
+    add_subblock_info.pyramid_type =
+        tile.pyramid_level == 0 ? libCZI::SubBlockPyramidType::None : libCZI::SubBlockPyramidType::MultiSubBlock;
+  };
+
+  if (compression_option == nullptr || compression_option->first == libCZI::CompressionMode::UnCompressed)
+  {
+    libCZI::AddSubBlockInfoStridedBitmap add_subblock_info;
+    add_subblock_info.Clear();
+    initialize(add_subblock_info);
+    add_subblock_info.ptrBitmap = bitmap_locked.ptrDataRoi;
+    add_subblock_info.strideBitmap = bitmap_locked.stride;
+    writer->SyncAddSubBlock(add_subblock_info);
+    return;
+  }
+
+  const auto compressed_data =
+      compressor.Compress(compression_option->first, tile.physical_width, tile.physical_height, bitmap_locked.stride,
+                          bitmap->GetPixelType(), bitmap_locked.ptrDataRoi, compression_option->second.get());
+  libCZI::AddSubBlockInfoMemPtr add_subblock_info;
+  add_subblock_info.Clear();
+  initialize(add_subblock_info);
+  add_subblock_info.SetCompressionMode(compression_option->first);
+  add_subblock_info.ptrData = compressed_data->GetPtr();
+  add_subblock_info.dataSize = static_cast<std::uint32_t>(compressed_data->GetSizeOfData());
+  writer->SyncAddSubBlock(add_subblock_info);
+}
+
+void WriteAttachment(libCZI::ICziWriter* writer, std::uint32_t seed, int attachment_index, std::vector<std::uint8_t>& data)
+{
+  // the content is random, like the (already compressed) thumbnails and previews found in real documents
+  const std::uint64_t hash = Hash(seed, {attachment_index});
+  for (size_t i = 0; i < data.size(); i += sizeof(std::uint64_t))
+  {
+    const std::uint64_t value = Mix(hash + i);
+    memcpy(data.data() + i, &value, std::min(sizeof(value), data.size() - i));
+  }
+
+  // NOLINTNEXTLINE: uninitialized struct is OK, all fields are set
+  libCZI::AddAttachmentInfo add_attachment_info;
+  const auto data1 = static_cast<std::uint32_t>(attachment_index) + 1;
+  add_attachment_info.contentGuid = libCZI::GUID{data1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}};  // NOLINT
+  add_attachment_info.SetContentFileType("BIN");
+  add_attachment_info.SetName("Synthetic");
+  add_attachment_info.ptrData = data.data();
+  add_attachment_info.dataSize = static_cast<std::uint32_t>(data.size());
+  writer->SyncAddAttachment(add_attachment_info);
+}
+
+}  // namespace
+
+std::uint64_t GetNumberOfSubBlocksOfSyntheticCzi(const SyntheticCziOptions& options)
+{
+  ValidateOptions(options);
+  std::uint64_t number_of_subblocks_per_plane = 0;
+  ForEachTile(options, [&](const TileRectangle&) { ++number_of_subblocks_per_plane; });
+  return number_of_subblocks_per_plane * static_cast<std::uint64_t>(options.number_of_channels) *
+         static_cast<std::uint64_t>(options.number_of_z_planes);
+}
+
+std::uint64_t GetSizeOfPixelDataOfSyntheticCzi(const SyntheticCziOptions& options)
+{
+  ValidateOptions(options);
+  std::uint64_t number_of_pixels_per_plane = 0;
+  ForEachTile(options, [&](const TileRectangle& tile)
+              { number_of_pixels_per_plane += static_cast<std::uint64_t>(tile.physical_width) * tile.physical_height; });
+  return number_of_pixels_per_plane * libCZI::Utils::GetBytesPerPixel(options.pixel_type) *
+         static_cast<std::uint64_t>(options.number_of_channels) * static_cast<std::uint64_t>(options.number_of_z_planes);
+}
+
+void RenderSyntheticTile(const SyntheticCziOptions& options, int x, int y, int channel, int z_plane, int pyramid_level,
+                         const std::shared_ptr<libCZI::IBitmapData>& bitmap)
+{
+  ValidateOptions(options);
+  if (bitmap->GetPixelType() != options.pixel_type)
+  {
+    throw std::invalid_argument("The pixel type of the bitmap does not match the options.");
+  }
+
+  const std::uint32_t width = bitmap->GetWidth();
+  const std::uint32_t height = bitmap->GetHeight();
+  const double scale = std::ldexp(1.0, pyramid_level);
+  const double maximum_value = std::ldexp(1.0, options.bits_per_pixel) - 1;
+
+  // averaging 'scale * scale' pixels (as a pyramid does) reduces the noise by a factor of 'scale'
+  const double noise_level = options.noise_level / scale;
+  const int number_of_components = GetNumberOfComponents(options.pixel_type);
+  const libCZI::ScopedBitmapLockerSP bitmap_locked{bitmap};
+  std::vector<float> intensities(static_cast<size_t>(width) * height);
+  std::vector<double> values(width);
+  for (int component = 0; component < number_of_components; ++component)
+  {
+    const double background_level =
+        kMinimumBackgroundLevel +
+        (kMaximumBackgroundLevel - kMinimumBackgroundLevel) * ToUnitInterval(Hash(options.seed, {channel, component, -1}));
+    std::fill(intensities.begin(), intensities.end(), static_cast<float>(background_level));
+    AddBlobs(options, x, y, channel, component, z_plane, scale, width, height, intensities);
+
+    for (std::uint32_t row = 0; row < height; ++row)
+    {
+      const std::uint64_t row_hash = Hash(options.seed, {channel, component, z_plane, pyramid_level, x, y, row});
+      const float* intensities_row = intensities.data() + static_cast<size_t>(row) * width;
+      for (std::uint32_t column = 0; column < width; ++column)
+      {
+        const double intensity = intensities_row[column] + noise_level * ToNormalDistribution(Mix(row_hash + column));  // NOLINT
+        values[column] = std::clamp(intensity, 0.0, 1.0) * maximum_value;
+      }
+
+      auto* row_address = static_cast<std::uint8_t*>(bitmap_locked.ptrDataRoi) + static_cast<size_t>(bitmap_locked.stride) * row;  // NOLINT
+      switch (options.pixel_type)
+      {
+        case libCZI::PixelType::Gray8:
+        case libCZI::PixelType::Bgr24:
+          StoreComponents<std::uint8_t>(values, number_of_components, component, row_address);
+          break;
+        case libCZI::PixelType::Gray16:
+        case libCZI::PixelType::Bgr48:
+          StoreComponents<std::uint16_t>(values, number_of_components, component, row_address);
+          break;
+        default:
+          StoreComponents<float>(values, number_of_components, component, row_address);
+          break;
+      }
+    }
+  }
+}
+
+void WriteSyntheticCzi(const SyntheticCziOptions& options, const std::shared_ptr<libCZI::IOutputStream>& output_stream)
+{
+  const std::uint64_t number_of_subblocks = GetNumberOfSubBlocksOfSyntheticCzi(options);
+  const auto writer = libCZI::CreateCZIWriter();
+  writer->Create(output_stream,
+                 std::make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+
+  // only one tile (and its compressed data) is in memory at a time, the buffers are reused
+  ZstdCompressor compressor(std::make_shared<BufferPool>());
+  std::shared_ptr<libCZI::IBitmapData> bitmap;
+  std::vector<std::uint8_t> attachment_data(options.attachment_size);
+  std::uint64_t subblock_number = 0;
+  int number_of_attachments_written = 0;
+  for (int channel = 0; channel < options.number_of_channels; ++channel)
+  {
+    for (int z_plane = 0; z_plane < options.number_of_z_planes; ++z_plane)
+    {
+      ForEachTile(options,
+                  [&](const TileRectangle& tile)
+                  {
+                    if (!bitmap || bitmap->GetWidth() != tile.physical_width || bitmap->GetHeight() != tile.physical_height)
+                    {
+                      bitmap = CreateBitmap(options.pixel_type, tile.physical_width, tile.physical_height);
+                    }
+
+                    RenderSyntheticTile(options, tile.x, tile.y, channel, z_plane, tile.pyramid_level, bitmap);
+                    const auto& compression_options = options.compression_options;
+                    const libCZI::Utils::CompressionOption* compression_option =
+                        compression_options.empty() ? nullptr : &compression_options[subblock_number % compression_options.size()];
+                    WriteTile(writer.get(), compressor, compression_option, tile, channel, z_plane, options.number_of_z_planes > 1, bitmap);
+                    ++subblock_number;
+
+                    // the attachments are distributed evenly between the subblocks
+                    while (static_cast<std::uint64_t>(number_of_attachments_written) * number_of_subblocks <
+                           static_cast<std::uint64_t>(options.number_of_attachments) * subblock_number)
+                    {
+                      WriteAttachment(writer.get(), options.seed, number_of_attachments_written++, attachment_data);
+                    }
+                  });
+    }
+  }
+
+  const libCZI::PrepareMetadataInfo prepare_metadata_info;
+  const auto metadata_builder = writer->GetPreparedMetadata(prepare_metadata_info);
+
+  // NOLINTNEXTLINE: uninitialized struct is OK b/o Clear()
+  libCZI::WriteMetadataInfo write_metadata_info;
+  write_metadata_info.Clear();
+  const auto& metadata_xml = metadata_builder->GetXml();
+  write_metadata_info.szMetadata = metadata_xml.c_str();
+  write_metadata_info.szMetadataSize = metadata_xml.size() + 1;
+  writer->SyncWriteMetadata(write_metadata_info);
+  writer->Close();
+}
+
+void WriteSyntheticCziToFile(const SyntheticCziOptions& options, const std::string& file_name)
+{
+  OutputStreamOptions output_stream_options;
+  output_stream_options.overwrite_existing_file = true;
+  const auto output_stream = CreateOutputStreamForFile(file_name, output_stream_options);
+  WriteSyntheticCzi(options, output_stream);
+  CloseOutputStream(output_stream.get());
+}
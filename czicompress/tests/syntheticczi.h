@@ -0,0 +1,112 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <libCZI.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Options describing a synthetic CZI document (see 'WriteSyntheticCzi'). The image content is procedural and
+/// resembles a fluorescence image: a dim background with noise, and Gaussian blobs ("cells") which differ between
+/// the channels and are in focus in some of the Z-planes only - so that the compressibility is similar to that
+/// of real images, unlike constant or random tiles.
+struct SyntheticCziOptions
+{
+  /// The pixel type of the subblocks - the pixel types supported are Gray8, Gray16, Gray32Float, Bgr24 and Bgr48.
+  libCZI::PixelType pixel_type{libCZI::PixelType::Gray16};
+
+  /// The number of significant bits of the pixel values (e.g. 12 for a 12-bit camera whose pixel values are stored in
+  /// 16 bits) - the pixel values are in the range [0, 2^bits_per_pixel - 1]. For Gray8 and Bgr24 this is at most 8,
+  /// for Gray16 and Bgr48 at most 16, and for Gray32Float at most 24.
+  int bits_per_pixel{12};
+
+  /// The width and height of a tile (in pixels).
+  std::uint32_t tile_size{1024};
+
+  /// The number of tiles of the mosaic in x- and y-direction.
+  int number_of_tiles_x{2};
+  int number_of_tiles_y{2};
+
+  /// The overlap of adjacent tiles of the mosaic (in pixels) - must be less than the tile size.
+  std::uint32_t tile_overlap{0};
+
+  /// The number of channels (C-dimension).
+  int number_of_channels{1};
+
+  /// The number of Z-planes (Z-dimension).
+  int number_of_z_planes{1};
+
+  /// The number of pyramid levels in addition to the full resolution - each level has half of the resolution of the
+  /// previous one, and it is made of tiles of the same size as the tiles of the mosaic.
+  int number_of_pyramid_levels{0};
+
+  /// The compression modes of the subblocks, which are used in turn for the subblocks - so that a document with
+  /// mixed compression modes is created. Supported are "uncompressed", "zstd0" and "zstd1" (with their parameters).
+  /// If empty, all subblocks are uncompressed.
+  std::vector<libCZI::Utils::CompressionOption> compression_options;
+
+  /// The number of attachments - they are distributed evenly between the subblocks.
+  int number_of_attachments{0};
+
+  /// The size of an attachment (in bytes).
+  std::uint32_t attachment_size{4096};
+
+  /// The average distance between the centers of the blobs (in pixels of the full resolution).
+  double blob_spacing{48};
+
+  /// The standard deviation of the noise, relative to the maximum pixel value.
+  double noise_level{0.004};
+
+  /// The seed from which the positions of the blobs and the noise are derived - the same options give the same
+  /// document.
+  std::uint32_t seed{0};
+};
+
+/// Gets the number of subblocks of the synthetic document described by the options (including the pyramid tiles).
+///
+/// \param  options The options describing the document.
+///
+/// \returns The number of subblocks.
+std::uint64_t GetNumberOfSubBlocksOfSyntheticCzi(const SyntheticCziOptions& options);
+
+/// Gets the size of the pixel data of the synthetic document described by the options (i.e. the size of all
+/// subblocks when uncompressed, including the pyramid tiles) - which allows to choose the number of tiles for a
+/// document of a given size.
+///
+/// \param  options The options describing the document.
+///
+/// \returns The size of the uncompressed pixel data in bytes.
+std::uint64_t GetSizeOfPixelDataOfSyntheticCzi(const SyntheticCziOptions& options);
+
+/// Renders a tile of the synthetic document into the bitmap - the same function is used for the subblocks written by
+/// 'WriteSyntheticCzi', so this allows to create the image content without creating a document.
+///
+/// \param          options         The options describing the document.
+/// \param          x               The x-coordinate of the left edge of the tile (in pixels of the full resolution).
+/// \param          y               The y-coordinate of the top edge of the tile (in pixels of the full resolution).
+/// \param          channel         The channel (C-index).
+/// \param          z_plane         The Z-plane (Z-index).
+/// \param          pyramid_level   The pyramid level (0 is the full resolution).
+/// \param [in,out] bitmap          The bitmap (of the pixel type given with the options) receiving the tile.
+void RenderSyntheticTile(const SyntheticCziOptions& options, int x, int y, int channel, int z_plane, int pyramid_level,
+                         const std::shared_ptr<libCZI::IBitmapData>& bitmap);
+
+/// Writes a synthetic CZI document to the stream. The subblocks are created and written one after the other, so the
+/// memory used does not depend on the size of the document (apart from the subblock directory kept by the writer),
+/// and documents larger than the main memory can be created. In case of an error (e.g. invalid options), an
+/// exception is thrown.
+///
+/// \param  options         The options describing the document.
+/// \param  output_stream   The stream to write the document to.
+void WriteSyntheticCzi(const SyntheticCziOptions& options, const std::shared_ptr<libCZI::IOutputStream>& output_stream);
+
+/// Writes a synthetic CZI document to a file (see 'WriteSyntheticCzi'). An existing file is overwritten.
+///
+/// \param  options     The options describing the document.
+/// \param  file_name   The UTF8-encoded filename.
+void WriteSyntheticCziToFile(const SyntheticCziOptions& options, const std::string& file_name);
@@ -84,3 +84,300 @@ TEST_CASE("commandlineparser.2: command-line arguments are parsed correctly", "[
   REQUIRE(compression_parameters->TryGetProperty(libCZI::CompressionParameterKey::ZSTD_PREPROCESS_DOLOHIBYTEPACKING, &parameter) == true);
   REQUIRE(parameter.GetBoolean() == true);
 }
+
+TEST_CASE("commandlineparser.3: number of threads is parsed correctly", "[commandlineparser]")
+{
+  auto consoleIo = std::make_shared<ConsoleIoMock>();
+  CommandLineOptions options(consoleIo, true);
+  static const char* const argv[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi", "--threads", "8"};
+
+  const auto parse_result = options.Parse(static_cast<int>(std::size(argv)),
+                                          argv);  // NOLINT: array to pointer decay
+
+  REQUIRE(parse_result == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options.GetNumberOfThreads() == 8);
+}
+
+TEST_CASE("commandlineparser.4: number of threads defaults to one", "[commandlineparser]")
+{
+  auto consoleIo = std::make_shared<ConsoleIoMock>();
+  CommandLineOptions options(consoleIo, true);
+  static const char* const argv[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi"};
+
+  const auto parse_result = options.Parse(static_cast<int>(std::size(argv)),
+                                          argv);  // NOLINT: array to pointer decay
+
+  REQUIRE(parse_result == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options.GetNumberOfThreads() == 1);
+}
+
+TEST_CASE("commandlineparser.5: max-inflight-mb is parsed correctly", "[commandlineparser]")
+{
+  auto consoleIo = std::make_shared<ConsoleIoMock>();
+  CommandLineOptions options(consoleIo, true);
+  static const char* const argv[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi", "--max-inflight-mb", "2048"};
+
+  const auto parse_result = options.Parse(static_cast<int>(std::size(argv)),
+                                          argv);  // NOLINT: array to pointer decay
+
+  REQUIRE(parse_result == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options.GetMaxInflightMegabytes() == 2048);
+}
+
+TEST_CASE("commandlineparser.6: prefetch options are parsed correctly", "[commandlineparser]")
+{
+  auto consoleIo = std::make_shared<ConsoleIoMock>();
+  CommandLineOptions options(consoleIo, true);
+  static const char* const argv[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi",
+       "--prefetch-depth", "16", "--prefetch-mb", "256"};
+
+  const auto parse_result = options.Parse(static_cast<int>(std::size(argv)),
+                                          argv);  // NOLINT: array to pointer decay
+
+  REQUIRE(parse_result == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options.GetPrefetchDepth() == 16);
+  REQUIRE(options.GetPrefetchMegabytes() == 256);
+}
+
+TEST_CASE("commandlineparser.7: subblock order options are parsed correctly", "[commandlineparser]")
+{
+  auto consoleIo = std::make_shared<ConsoleIoMock>();
+  CommandLineOptions options(consoleIo, true);
+  static const char* const argv[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi",
+       "--read-order", "file", "--output-order", "read"};
+
+  const auto parse_result = options.Parse(static_cast<int>(std::size(argv)),
+                                          argv);  // NOLINT: array to pointer decay
+
+  REQUIRE(parse_result == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options.GetReadOrder() == SubBlockReadOrder::kFilePosition);
+  REQUIRE(options.GetOutputOrder() == SubBlockOutputOrder::kRead);
+}
+
+TEST_CASE("commandlineparser.8: subblock order options default to directory order and source order", "[commandlineparser]")
+{
+  auto consoleIo = std::make_shared<ConsoleIoMock>();
+  CommandLineOptions options(consoleIo, true);
+  static const char* const argv[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi"};
+
+  const auto parse_result = options.Parse(static_cast<int>(std::size(argv)),
+                                          argv);  // NOLINT: array to pointer decay
+
+  REQUIRE(parse_result == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options.GetReadOrder() == SubBlockReadOrder::kDirectory);
+  REQUIRE(options.GetOutputOrder() == SubBlockOutputOrder::kSource);
+}
+
+TEST_CASE("commandlineparser.9: strategy 'smallest' is parsed correctly", "[commandlineparser]")
+{
+  auto consoleIo = std::make_shared<ConsoleIoMock>();
+  CommandLineOptions options(consoleIo, true);
+  static const char* const argv[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi", "--strategy", "smallest"};
+
+  const auto parse_result = options.Parse(static_cast<int>(std::size(argv)),
+                                          argv);  // NOLINT: array to pointer decay
+
+  REQUIRE(parse_result == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options.GetCompressionStrategy() == CompressionStrategy::kSmallest);
+}
+
+TEST_CASE("commandlineparser.10: input-io is parsed correctly", "[commandlineparser]")
+{
+  auto consoleIo = std::make_shared<ConsoleIoMock>();
+  CommandLineOptions options(consoleIo, true);
+  static const char* const argv[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi", "--input-io", "mmap"};
+
+  const auto parse_result = options.Parse(static_cast<int>(std::size(argv)),
+                                          argv);  // NOLINT: array to pointer decay
+
+  REQUIRE(parse_result == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options.GetInputIo() == InputIo::kMmap);
+
+  CommandLineOptions options_with_default(consoleIo, true);
+  static const char* const argv_with_default[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi"};
+  const auto parse_result_with_default = options_with_default.Parse(static_cast<int>(std::size(argv_with_default)),
+                                                                    argv_with_default);  // NOLINT: array to pointer decay
+  REQUIRE(parse_result_with_default == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options_with_default.GetInputIo() == InputIo::kPread);
+}
+
+TEST_CASE("commandlineparser.11: write-buffer-mb is parsed correctly", "[commandlineparser]")
+{
+  auto consoleIo = std::make_shared<ConsoleIoMock>();
+  CommandLineOptions options(consoleIo, true);
+  static const char* const argv[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi", "--write-buffer-mb", "16"};
+
+  const auto parse_result = options.Parse(static_cast<int>(std::size(argv)),
+                                          argv);  // NOLINT: array to pointer decay
+
+  REQUIRE(parse_result == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options.GetWriteBufferMegabytes() == 16);
+}
+
+TEST_CASE("commandlineparser.12: copy-file-range is parsed correctly", "[commandlineparser]")
+{
+  auto consoleIo = std::make_shared<ConsoleIoMock>();
+  CommandLineOptions options(consoleIo, true);
+  static const char* const argv[] =  // NOLINT: C-style array
+      {"dummy", "--command", "decompress", "--input", "input.czi", "--output", "output.czi", "--copy-file-range", "yes"};
+
+  const auto parse_result = options.Parse(static_cast<int>(std::size(argv)),
+                                          argv);  // NOLINT: array to pointer decay
+
+  REQUIRE(parse_result == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options.GetUseCopyFileRange() == true);
+
+  CommandLineOptions options_default(consoleIo, true);
+  static const char* const argv_default[] =  // NOLINT: C-style array
+      {"dummy", "--command", "decompress", "--input", "input.czi", "--output", "output.czi"};
+  REQUIRE(options_default.Parse(static_cast<int>(std::size(argv_default)), argv_default) == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options_default.GetUseCopyFileRange() == false);
+}
+
+TEST_CASE("commandlineparser.13: if-unchanged is parsed correctly", "[commandlineparser]")
+{
+  auto consoleIo = std::make_shared<ConsoleIoMock>();
+  CommandLineOptions options(consoleIo, true);
+  static const char* const argv[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi", "--if-unchanged", "Clone"};
+
+  const auto parse_result = options.Parse(static_cast<int>(std::size(argv)),
+                                          argv);  // NOLINT: array to pointer decay
+
+  REQUIRE(parse_result == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options.GetUnchangedFileHandling() == UnchangedFileHandling::kClone);
+
+  CommandLineOptions options_default(consoleIo, true);
+  static const char* const argv_default[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi"};
+  REQUIRE(options_default.Parse(static_cast<int>(std::size(argv_default)), argv_default) == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options_default.GetUnchangedFileHandling() == UnchangedFileHandling::kRewrite);
+
+  CommandLineOptions options_invalid(consoleIo, true);
+  static const char* const argv_invalid[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi", "--if-unchanged", "ignore"};
+  REQUIRE(options_invalid.Parse(static_cast<int>(std::size(argv_invalid)), argv_invalid) == CommandLineOptions::ParseResult::kError);
+}
+
+TEST_CASE("commandlineparser.14: preallocate is parsed correctly", "[commandlineparser]")
+{
+  auto consoleIo = std::make_shared<ConsoleIoMock>();
+  CommandLineOptions options(consoleIo, true);
+  static const char* const argv[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi", "--preallocate", "true"};
+
+  const auto parse_result = options.Parse(static_cast<int>(std::size(argv)),
+                                          argv);  // NOLINT: array to pointer decay
+
+  REQUIRE(parse_result == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options.GetPreallocate() == true);
+
+  CommandLineOptions options_default(consoleIo, true);
+  static const char* const argv_default[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi"};
+  REQUIRE(options_default.Parse(static_cast<int>(std::size(argv_default)), argv_default) == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options_default.GetPreallocate() == false);
+}
+
+TEST_CASE("commandlineparser.15: direct-io is parsed correctly", "[commandlineparser]")
+{
+  auto consoleIo = std::make_shared<ConsoleIoMock>();
+  CommandLineOptions options(consoleIo, true);
+  static const char* const argv[] =  // NOLINT: C-style array
+      {"dummy", "--command", "decompress", "--input", "input.czi", "--output", "output.czi", "--direct-io", "true"};
+
+  const auto parse_result = options.Parse(static_cast<int>(std::size(argv)),
+                                          argv);  // NOLINT: array to pointer decay
+
+  REQUIRE(parse_result == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options.GetUseDirectIo() == true);
+
+  CommandLineOptions options_default(consoleIo, true);
+  static const char* const argv_default[] =  // NOLINT: C-style array
+      {"dummy", "--command", "decompress", "--input", "input.czi", "--output", "output.czi"};
+  REQUIRE(options_default.Parse(static_cast<int>(std::size(argv_default)), argv_default) == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options_default.GetUseDirectIo() == false);
+}
+
+TEST_CASE("commandlineparser.16: input-cache is parsed correctly", "[commandlineparser]")
+{
+  auto consoleIo = std::make_shared<ConsoleIoMock>();
+  CommandLineOptions options(consoleIo, true);
+  static const char* const argv[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi", "--input-cache", "ON"};
+
+  const auto parse_result = options.Parse(static_cast<int>(std::size(argv)),
+                                          argv);  // NOLINT: array to pointer decay
+
+  REQUIRE(parse_result == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options.GetInputCache() == InputCache::kOn);
+
+  CommandLineOptions options_default(consoleIo, true);
+  static const char* const argv_default[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi"};
+  REQUIRE(options_default.Parse(static_cast<int>(std::size(argv_default)), argv_default) == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options_default.GetInputCache() == InputCache::kAuto);
+
+  CommandLineOptions options_invalid(consoleIo, true);
+  static const char* const argv_invalid[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi", "--input-cache", "always"};
+  REQUIRE(options_invalid.Parse(static_cast<int>(std::size(argv_invalid)), argv_invalid) == CommandLineOptions::ParseResult::kError);
+}
+
+TEST_CASE("commandlineparser.17: max-read-mbps and max-write-mbps are parsed correctly", "[commandlineparser]")
+{
+  auto consoleIo = std::make_shared<ConsoleIoMock>();
+  CommandLineOptions options(consoleIo, true);
+  static const char* const argv[] =  // NOLINT: C-style array
+      {"dummy",    "--command",       "compress", "--input", "input.czi", "--output",
+       "output.czi", "--max-read-mbps", "12.5",     "--max-write-mbps", "40"};
+
+  const auto parse_result = options.Parse(static_cast<int>(std::size(argv)),
+                                          argv);  // NOLINT: array to pointer decay
+
+  REQUIRE(parse_result == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options.GetMaxReadMegabytesPerSecond() == 12.5);
+  REQUIRE(options.GetMaxWriteMegabytesPerSecond() == 40);
+
+  CommandLineOptions options_default(consoleIo, true);
+  static const char* const argv_default[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi"};
+  REQUIRE(options_default.Parse(static_cast<int>(std::size(argv_default)), argv_default) == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options_default.GetMaxReadMegabytesPerSecond() == 0);
+  REQUIRE(options_default.GetMaxWriteMegabytesPerSecond() == 0);
+
+  CommandLineOptions options_invalid(consoleIo, true);
+  static const char* const argv_invalid[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi", "--max-write-mbps", "-1"};
+  REQUIRE(options_invalid.Parse(static_cast<int>(std::size(argv_invalid)), argv_invalid) == CommandLineOptions::ParseResult::kError);
+}
+
+TEST_CASE("commandlineparser.18: trace is parsed correctly", "[commandlineparser]")
+{
+  auto consoleIo = std::make_shared<ConsoleIoMock>();
+  CommandLineOptions options(consoleIo, true);
+  static const char* const argv[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi", "--trace", "trace.json"};
+
+  const auto parse_result = options.Parse(static_cast<int>(std::size(argv)),
+                                          argv);  // NOLINT: array to pointer decay
+
+  REQUIRE(parse_result == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options.GetTraceFileName() == "trace.json");
+
+  CommandLineOptions options_default(consoleIo, true);
+  static const char* const argv_default[] =  // NOLINT: C-style array
+      {"dummy", "--command", "compress", "--input", "input.czi", "--output", "output.czi"};
+  REQUIRE(options_default.Parse(static_cast<int>(std::size(argv_default)), argv_default) == CommandLineOptions::ParseResult::kOk);
+  REQUIRE(options_default.GetTraceFileName().empty());
+}
@@ -2,14 +2,33 @@
 //
 // SPDX-License-Identifier: MIT
 
+#include <include/IOperation.h>
+#include <include/inputstream.h>
+#include <include/outputstream.h>
+#include <include/segmentreservation.h>
+#include <include/sourcerangecopy.h>
+#include <include/sourcereadahead.h>
+#include <src/cachinginputstream.h>
 #include <src/copyczi.h>
+#include <src/pooledbitmapsite.h>
 
+#include <algorithm>
 #include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 #include "catch2/catch_all.hpp"
 #include "libczi_utils.h"
+#include "syntheticczi.h"
 
 using std::make_shared, std::tuple, std::shared_ptr, std::size_t;
 
@@ -164,6 +183,237 @@ static tuple<shared_ptr<void>, size_t> CreateCziWithFourSubblockInMosaicArrangem
   return make_tuple(czi_document_data, czi_document_size);
 }
 
+/// Creates a CZI with one (uncompressed) subblock containing the specified bitmap.
+/// \param bitmap The bitmap.
+/// \returns A blob containing a CZI document.
+static tuple<shared_ptr<void>, size_t> CreateCziWithOneSubblock(const shared_ptr<libCZI::IBitmapData>& bitmap)
+{
+  auto writer = libCZI::CreateCZIWriter();
+  auto outStream = make_shared<CMemOutputStream>(0);
+  auto spWriterInfo = make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1234567, 0x89ab, 0xcdef, {1, 2, 3, 4, 5, 6, 7, 8}});  // NOLINT
+  writer->Create(outStream, spWriterInfo);
+
+  libCZI::AddSubBlockInfoStridedBitmap addSbBlkInfo;
+  addSbBlkInfo.Clear();
+  addSbBlkInfo.coordinate.Set(libCZI::DimensionIndex::C, 0);
+  addSbBlkInfo.mIndexValid = true;
+  addSbBlkInfo.mIndex = 0;
+  addSbBlkInfo.x = 0;
+  addSbBlkInfo.y = 0;
+  addSbBlkInfo.logicalWidth = CheckSizeAndCastToInt(bitmap->GetWidth());
+  addSbBlkInfo.logicalHeight = CheckSizeAndCastToInt(bitmap->GetHeight());
+  addSbBlkInfo.physicalWidth = CheckSizeAndCastToInt(bitmap->GetWidth());
+  addSbBlkInfo.physicalHeight = CheckSizeAndCastToInt(bitmap->GetHeight());
+  addSbBlkInfo.PixelType = bitmap->GetPixelType();
+  {
+    const libCZI::ScopedBitmapLockerSP lock_info_bitmap{bitmap};
+    addSbBlkInfo.ptrBitmap = lock_info_bitmap.ptrDataRoi;
+    addSbBlkInfo.strideBitmap = lock_info_bitmap.stride;
+    writer->SyncAddSubBlock(addSbBlkInfo);
+  }
+
+  const libCZI::PrepareMetadataInfo prepare_metadata_info;
+  auto metaDataBuilder = writer->GetPreparedMetadata(prepare_metadata_info);
+
+  // NOLINTNEXTLINE: uninitialized struct is OK b/o Clear()
+  libCZI::WriteMetadataInfo write_metadata_info;
+  write_metadata_info.Clear();
+  const auto& strMetadata = metaDataBuilder->GetXml();
+  write_metadata_info.szMetadata = strMetadata.c_str();
+  write_metadata_info.szMetadataSize = strMetadata.size() + 1;
+  writer->SyncWriteMetadata(write_metadata_info);
+  writer->Close();
+  writer.reset();
+
+  size_t czi_document_size = 0;
+  const shared_ptr<void> czi_document_data = outStream->GetCopy(&czi_document_size);
+  return make_tuple(czi_document_data, czi_document_size);
+}
+
+/// Runs the "compress"-operation on the specified CZI-document (given as a blob) and returns the
+/// resulting CZI-document as a blob. The writer is using a fixed file-GUID, so that the result is
+/// reproducible.
+/// \param czi_document_as_blob The source CZI-document.
+/// \param options              The options for the copy-operation.
+/// \param compression_options  The compression options (in the syntax of the command line).
+/// \returns A blob containing the resulting CZI-document.
+static tuple<shared_ptr<void>, size_t> RunCompressOnBlob(const tuple<shared_ptr<void>, size_t>& czi_document_as_blob,
+                                                         const CopyCziOptions& options, const char* compression_options = "zstd1:")
+{
+  const auto memory_stream = make_shared<CMemInputOutputStream>(std::get<0>(czi_document_as_blob).get(), std::get<1>(czi_document_as_blob));
+  const auto reader = libCZI::CreateCZIReader();
+  reader->Open(memory_stream);
+
+  auto writer = libCZI::CreateCZIWriter();
+  const auto memory_backed_stream_destination_document = make_shared<CMemInputOutputStream>(0);
+  const auto writer_info = make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}});  // NOLINT
+  writer->Create(memory_backed_stream_destination_document, writer_info);
+
+  {
+    CopyCziAndCompress copyCziAndCompress(reader, writer, nullptr, CompressionStrategy::kAll,
+                                          libCZI::Utils::ParseCompressionOptions(compression_options), options);
+    REQUIRE(copyCziAndCompress.Run() == true);
+  }
+
+  writer->Close();
+  writer.reset();
+
+  size_t czi_document_size = 0;
+  const shared_ptr<void> czi_document_data = memory_backed_stream_destination_document->GetCopy(&czi_document_size);
+  return make_tuple(czi_document_data, czi_document_size);
+}
+
+/// Runs the compress operation on the specified CZI-document, where space for the directories and the metadata
+/// is reserved at the start of the destination document.
+/// \param czi_document_as_blob   The CZI-document.
+/// \param metadata_reservation   If non-zero, the size of the reservation for the metadata segment is overridden with this value.
+/// \returns A tuple containing the destination document and the placements of the segments.
+static tuple<shared_ptr<void>, size_t, SegmentPlacements> RunCompressWithReservationsOnBlob(
+    const tuple<shared_ptr<void>, size_t>& czi_document_as_blob, size_t metadata_reservation)
+{
+  const auto memory_stream = make_shared<CMemInputOutputStream>(std::get<0>(czi_document_as_blob).get(), std::get<1>(czi_document_as_blob));
+  const auto reader = libCZI::CreateCZIReader();
+  reader->Open(memory_stream);
+
+  auto writer = libCZI::CreateCZIWriter();
+  const auto memory_backed_stream_destination_document = make_shared<CMemInputOutputStream>(0);
+  const auto writer_info = make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}});  // NOLINT
+  const auto reservations = ReserveSegmentsForCopy(reader.get(), writer_info.get());
+  REQUIRE(reservations.number_of_subblock_directory_entries == 4);
+  REQUIRE(reservations.number_of_attachment_directory_entries == 0);
+  REQUIRE(reservations.metadata_size > 0);
+  if (metadata_reservation > 0)
+  {
+    writer_info->SetReservedSizeForMetadataSegment(true, metadata_reservation);
+  }
+
+  const auto segment_placement_recorder = make_shared<SegmentPlacementRecorder>(memory_backed_stream_destination_document);
+  writer->Create(segment_placement_recorder, writer_info);
+  segment_placement_recorder->SetEndOfReservedSpace();
+
+  {
+    CopyCziAndCompress copyCziAndCompress(reader, writer, nullptr, CompressionStrategy::kAll,
+                                          libCZI::Utils::ParseCompressionOptions("zstd1:"), CopyCziOptions());
+    REQUIRE(copyCziAndCompress.Run() == true);
+  }
+
+  writer->Close();
+  writer.reset();
+
+  size_t czi_document_size = 0;
+  const shared_ptr<void> czi_document_data = memory_backed_stream_destination_document->GetCopy(&czi_document_size);
+  return make_tuple(czi_document_data, czi_document_size, segment_placement_recorder->GetSegmentPlacements());
+}
+
+/// Gets the M-indices of the subblocks of the specified CZI-document - in the order of the subblock directory, and
+/// in the order of the subblocks' positions in the file.
+/// \param czi_document_as_blob The CZI-document.
+/// \returns A tuple containing the M-indices in directory order and the M-indices in file order.
+static tuple<std::vector<int>, std::vector<int>> GetMIndicesInDirectoryOrderAndFileOrder(
+    const tuple<shared_ptr<void>, size_t>& czi_document_as_blob)
+{
+  const auto memory_stream = make_shared<CMemInputOutputStream>(std::get<0>(czi_document_as_blob).get(), std::get<1>(czi_document_as_blob));
+  const auto reader = libCZI::CreateCZIReader();
+  reader->Open(memory_stream);
+
+  std::vector<int> m_indices_in_directory_order;
+  std::vector<std::pair<std::uint64_t, int>> file_positions_and_m_indices;
+  reader->EnumerateSubBlocksEx(
+      [&](int, const libCZI::DirectorySubBlockInfo& info) -> bool
+      {
+        m_indices_in_directory_order.push_back(info.mIndex);
+        file_positions_and_m_indices.emplace_back(info.filePosition, info.mIndex);
+        return true;
+      });
+
+  std::sort(file_positions_and_m_indices.begin(), file_positions_and_m_indices.end());
+  std::vector<int> m_indices_in_file_order;
+  for (const auto& file_position_and_m_index : file_positions_and_m_indices)
+  {
+    m_indices_in_file_order.push_back(file_position_and_m_index.second);
+  }
+
+  return make_tuple(m_indices_in_directory_order, m_indices_in_file_order);
+}
+
+/// Implementation of libCZI::IOutputStream and ISourceRangeCopy which writes to a memory buffer, and which checks
+/// that the announced data is identical to the data found at the announced position of the source document.
+class SourceRangeRecordingOutputStream : public libCZI::IOutputStream, public ISourceRangeCopy
+{
+private:
+  tuple<shared_ptr<void>, size_t> source_document_;
+  shared_ptr<CMemInputOutputStream> destination_stream_;
+  const void* announced_data_{nullptr};
+  std::uint64_t announced_size_{0};
+  std::uint64_t announced_source_offset_{0};
+  std::uint64_t number_of_bytes_copied_from_source_{0};
+
+public:
+  explicit SourceRangeRecordingOutputStream(tuple<shared_ptr<void>, size_t> source_document)
+      : source_document_(std::move(source_document)), destination_stream_(make_shared<CMemInputOutputStream>(0))
+  {
+  }
+
+  const shared_ptr<CMemInputOutputStream>& GetDestinationStream() const { return this->destination_stream_; }
+
+  void Write(std::uint64_t offset, const void* data, std::uint64_t size, std::uint64_t* ptr_bytes_written) override
+  {
+    if (size > 0 && data == this->announced_data_ && size == this->announced_size_)
+    {
+      REQUIRE(this->announced_source_offset_ + size <= std::get<1>(this->source_document_));
+      const auto* source_data = static_cast<const std::uint8_t*>(std::get<0>(this->source_document_).get());
+      REQUIRE(memcmp(source_data + this->announced_source_offset_, data, static_cast<size_t>(size)) == 0);  // NOLINT
+      this->number_of_bytes_copied_from_source_ += size;
+      this->announced_data_ = nullptr;
+    }
+
+    this->destination_stream_->Write(offset, data, size, ptr_bytes_written);
+  }
+
+  void AnnounceSourceRange(const void* data, std::uint64_t size, std::uint64_t source_offset) override
+  {
+    this->announced_data_ = data;
+    this->announced_size_ = size;
+    this->announced_source_offset_ = source_offset;
+  }
+
+  std::uint64_t GetNumberOfBytesCopiedFromSource() const override { return this->number_of_bytes_copied_from_source_; }
+};
+
+/// Implementation of libCZI::IStream and ISourceReadAhead which reads from a memory buffer, and which records the
+/// announced positions and the positions of the read operations.
+class ReadAheadRecordingInputStream : public libCZI::IStream, public ISourceReadAhead
+{
+private:
+  shared_ptr<CMemInputOutputStream> stream_;
+  std::mutex mutex_;
+  std::vector<std::uint64_t> announced_positions_;
+  std::vector<std::uint64_t> read_positions_;
+
+public:
+  explicit ReadAheadRecordingInputStream(shared_ptr<CMemInputOutputStream> stream) : stream_(std::move(stream)) {}
+
+  std::vector<std::uint64_t> GetAnnouncedPositions() const { return this->announced_positions_; }
+
+  std::vector<std::uint64_t> GetReadPositions() const { return this->read_positions_; }
+
+  void Read(std::uint64_t offset, void* data, std::uint64_t size, std::uint64_t* ptr_bytes_read) override
+  {
+    {
+      const std::lock_guard<std::mutex> lock(this->mutex_);
+      this->read_positions_.push_back(offset);
+    }
+
+    this->stream_->Read(offset, data, size, ptr_bytes_read);
+  }
+
+  void AnnounceSubBlockPositions(const std::vector<std::uint64_t>& positions) override
+  {
+    const std::lock_guard<std::mutex> lock(this->mutex_);
+    this->announced_positions_ = positions;
+  }
+};
+
 TEST_CASE("copyczi.1: run compression on simple synthetic document", "[copyczi]")
 {
   // arrange
@@ -362,3 +612,1073 @@ TEST_CASE("copyczi.3: run decompression on simple synthetically compressed docum
 
   CheckOriginalCompressionMetadata(metadata);
 }
+
+TEST_CASE("copyczi.4: multi-threaded compression gives the same result as single-threaded compression", "[copyczi]")
+{
+  // arrange
+  const auto czi_document_as_blob = CreateCziWithFourSubblockInMosaicArrangement();
+
+  // act
+  CopyCziOptions options;
+  options.number_of_threads = 1;
+  const auto result_single_threaded = RunCompressOnBlob(czi_document_as_blob, options);
+  options.number_of_threads = 3;
+  const auto result_multi_threaded = RunCompressOnBlob(czi_document_as_blob, options);
+
+  // assert
+  REQUIRE(std::get<1>(result_single_threaded) == std::get<1>(result_multi_threaded));
+  REQUIRE(memcmp(std::get<0>(result_single_threaded).get(), std::get<0>(result_multi_threaded).get(),
+                 std::get<1>(result_single_threaded)) == 0);
+}
+
+TEST_CASE("copyczi.5: multi-threaded copy operation can be cancelled", "[copyczi]")
+{
+  // arrange
+  auto czi_document_as_blob = CreateCziWithFourSubblockInMosaicArrangement();
+  const auto memory_stream = make_shared<CMemInputOutputStream>(std::get<0>(czi_document_as_blob).get(), std::get<1>(czi_document_as_blob));
+  const auto reader = libCZI::CreateCZIReader();
+  reader->Open(memory_stream);
+  auto writer = libCZI::CreateCZIWriter();
+  const auto memory_backed_stream_destination_document = make_shared<CMemInputOutputStream>(0);
+  const auto writer_info = make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x0, 0x0, 0x0, {0, 0, 0, 0, 0, 0, 0, 0}});
+  writer->Create(memory_backed_stream_destination_document, writer_info);
+
+  int number_of_progress_reports = 0;
+  const auto progress_report = [&number_of_progress_reports](const ProgressInfo& progress_info) -> bool
+  {
+    ++number_of_progress_reports;
+    // cancel the operation after the second subblock
+    return !(progress_info.phase == ProcessingPhase::kCopySubblocks && progress_info.number_of_items_done == 2);
+  };
+
+  // act
+  CopyCziOptions options;
+  options.number_of_threads = 4;
+  CopyCziAndDecompress copyCziAndDecompress(reader, writer, progress_report, options);
+  const bool completed = copyCziAndDecompress.Run();
+
+  // assert
+  REQUIRE(completed == false);
+  REQUIRE(number_of_progress_reports == 2);
+}
+
+TEST_CASE("copyczi.6: multi-threaded compression with a small in-flight budget gives the same result", "[copyczi]")
+{
+  // arrange
+  const auto czi_document_as_blob = CreateCziWithFourSubblockInMosaicArrangement();
+
+  // act
+  CopyCziOptions options;
+  options.number_of_threads = 1;
+  const auto result_single_threaded = RunCompressOnBlob(czi_document_as_blob, options);
+  options.number_of_threads = 4;
+  options.max_bytes_in_flight = 1;  // only one subblock can be in flight at any time
+  const auto result_with_budget = RunCompressOnBlob(czi_document_as_blob, options);
+
+  // assert
+  REQUIRE(std::get<1>(result_single_threaded) == std::get<1>(result_with_budget));
+  REQUIRE(memcmp(std::get<0>(result_single_threaded).get(), std::get<0>(result_with_budget).get(),
+                 std::get<1>(result_single_threaded)) == 0);
+}
+
+TEST_CASE("copyczi.7: peak number of bytes in flight is reported", "[copyczi]")
+{
+  // arrange
+  auto czi_document_as_blob = CreateCziWithFourSubblockInMosaicArrangement();
+  const auto memory_stream = make_shared<CMemInputOutputStream>(std::get<0>(czi_document_as_blob).get(), std::get<1>(czi_document_as_blob));
+  const auto reader = libCZI::CreateCZIReader();
+  reader->Open(memory_stream);
+  auto writer = libCZI::CreateCZIWriter();
+  const auto memory_backed_stream_destination_document = make_shared<CMemInputOutputStream>(0);
+  const auto writer_info = make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x0, 0x0, 0x0, {0, 0, 0, 0, 0, 0, 0, 0}});
+  writer->Create(memory_backed_stream_destination_document, writer_info);
+
+  // act
+  CopyCziOptions options;
+  options.number_of_threads = 2;
+  options.max_bytes_in_flight = 1;
+  CopyCziAndCompress copyCziAndCompress(reader, writer, nullptr, CompressionStrategy::kAll,
+                                        libCZI::Utils::ParseCompressionOptions("zstd1:"), options);
+  REQUIRE(copyCziAndCompress.Run() == true);
+
+  // assert
+  // with a budget of one byte, only one subblock is in flight at any time - so the peak must be at least the
+  // size of the uncompressed data of one subblock (2x2 pixels of Gray8), and at most the size of one subblock's
+  // data plus the compressed data
+  const auto peak_bytes_in_flight = copyCziAndCompress.GetStatistics().GetPeakBytesInFlight();
+  REQUIRE(peak_bytes_in_flight >= 4);
+  REQUIRE(peak_bytes_in_flight < 1024);
+}
+
+TEST_CASE("copyczi.8: single-threaded compression with read-ahead gives the same result", "[copyczi]")
+{
+  // arrange
+  const auto czi_document_as_blob = CreateCziWithFourSubblockInMosaicArrangement();
+
+  // act
+  CopyCziOptions options;
+  const auto result_without_prefetch = RunCompressOnBlob(czi_document_as_blob, options);
+  options.prefetch_depth = 2;
+  options.prefetch_max_bytes = 1;
+  const auto result_with_prefetch = RunCompressOnBlob(czi_document_as_blob, options);
+
+  // assert
+  REQUIRE(std::get<1>(result_without_prefetch) == std::get<1>(result_with_prefetch));
+  REQUIRE(memcmp(std::get<0>(result_without_prefetch).get(), std::get<0>(result_with_prefetch).get(),
+                 std::get<1>(result_without_prefetch)) == 0);
+}
+
+TEST_CASE("copyczi.9: reading in file order and keeping the source order gives the same result as reading in directory order", "[copyczi]")
+{
+  // arrange
+  const auto czi_document_as_blob = CreateCziWithFourSubblockInMosaicArrangement();
+  ShuffleSubBlockDirectory(std::get<0>(czi_document_as_blob).get(), std::get<1>(czi_document_as_blob), 1);
+
+  // act
+  CopyCziOptions options;
+  const auto result_directory_order = RunCompressOnBlob(czi_document_as_blob, options);
+  options.read_order = SubBlockReadOrder::kFilePosition;
+  options.output_order = SubBlockOutputOrder::kSource;
+  const auto result_file_order = RunCompressOnBlob(czi_document_as_blob, options);
+  options.number_of_threads = 3;
+  const auto result_file_order_multi_threaded = RunCompressOnBlob(czi_document_as_blob, options);
+
+  // assert
+  REQUIRE(std::get<1>(result_directory_order) == std::get<1>(result_file_order));
+  REQUIRE(memcmp(std::get<0>(result_directory_order).get(), std::get<0>(result_file_order).get(), std::get<1>(result_directory_order)) ==
+          0);
+  REQUIRE(std::get<1>(result_directory_order) == std::get<1>(result_file_order_multi_threaded));
+  REQUIRE(memcmp(std::get<0>(result_directory_order).get(), std::get<0>(result_file_order_multi_threaded).get(),
+                 std::get<1>(result_directory_order)) == 0);
+}
+
+TEST_CASE("copyczi.10: reading in file order and writing in read order writes the subblocks in the order of the source file", "[copyczi]")
+{
+  // arrange
+  const auto czi_document_as_blob = CreateCziWithFourSubblockInMosaicArrangement();
+  ShuffleSubBlockDirectory(std::get<0>(czi_document_as_blob).get(), std::get<1>(czi_document_as_blob), 1);
+  const auto source_m_indices = GetMIndicesInDirectoryOrderAndFileOrder(czi_document_as_blob);
+  REQUIRE(std::get<0>(source_m_indices) != std::get<1>(source_m_indices));
+
+  // act
+  CopyCziOptions options;
+  options.read_order = SubBlockReadOrder::kFilePosition;
+  options.output_order = SubBlockOutputOrder::kRead;
+  const auto result = RunCompressOnBlob(czi_document_as_blob, options);
+  options.number_of_threads = 3;
+  const auto result_multi_threaded = RunCompressOnBlob(czi_document_as_blob, options);
+
+  // assert
+  const auto result_m_indices = GetMIndicesInDirectoryOrderAndFileOrder(result);
+  REQUIRE(std::get<0>(result_m_indices) == std::get<1>(source_m_indices));
+  REQUIRE(std::get<1>(result_m_indices) == std::get<1>(source_m_indices));
+  REQUIRE(std::get<1>(result) == std::get<1>(result_multi_threaded));
+  REQUIRE(memcmp(std::get<0>(result).get(), std::get<0>(result_multi_threaded).get(), std::get<1>(result)) == 0);
+}
+
+TEST_CASE("copyczi.11: compressed subblocks have the expected format and decode to the original pixels", "[copyczi]")
+{
+  struct TestCase
+  {
+    const char* compression_options;
+    libCZI::CompressionMode expected_compression_mode;
+    std::vector<std::uint8_t> expected_header;
+  };
+
+  const TestCase test_cases[] = {  // NOLINT: C-style array
+      {"zstd0:ExplicitLevel=2", libCZI::CompressionMode::Zstd0, {}},
+      {"zstd1:ExplicitLevel=1", libCZI::CompressionMode::Zstd1, {1}},
+      {"zstd1:ExplicitLevel=1;PreProcess=HiLoByteUnpack", libCZI::CompressionMode::Zstd1, {3, 1, 1}},
+  };
+
+  // arrange
+  const auto source_bitmap = CreateBitmapAndFillWithPattern(libCZI::PixelType::Gray16, 61, 17);
+  const auto czi_document_as_blob = CreateCziWithOneSubblock(source_bitmap);
+
+  for (const auto& test_case : test_cases)
+  {
+    // act
+    const CopyCziOptions options;
+    const auto result = RunCompressOnBlob(czi_document_as_blob, options, test_case.compression_options);
+
+    // assert
+    const auto memory_stream = make_shared<CMemInputOutputStream>(std::get<0>(result).get(), std::get<1>(result));
+    const auto reader = libCZI::CreateCZIReader();
+    reader->Open(memory_stream);
+    const auto subblock = reader->ReadSubBlock(0);
+    REQUIRE(subblock->GetSubBlockInfo().GetCompressionMode() == test_case.expected_compression_mode);
+
+    const void* raw_data = nullptr;
+    size_t size_of_raw_data = 0;
+    subblock->DangerousGetRawData(libCZI::ISubBlock::MemBlkType::Data, raw_data, size_of_raw_data);
+    REQUIRE(size_of_raw_data > test_case.expected_header.size());
+    REQUIRE(std::equal(test_case.expected_header.cbegin(), test_case.expected_header.cend(), static_cast<const std::uint8_t*>(raw_data)));
+
+    const auto decoded_bitmap = subblock->CreateBitmap();
+    REQUIRE(decoded_bitmap->GetPixelType() == libCZI::PixelType::Gray16);
+    REQUIRE(decoded_bitmap->GetWidth() == source_bitmap->GetWidth());
+    REQUIRE(decoded_bitmap->GetHeight() == source_bitmap->GetHeight());
+    const libCZI::ScopedBitmapLockerSP source_locked{source_bitmap};
+    const libCZI::ScopedBitmapLockerSP decoded_locked{decoded_bitmap};
+    for (std::uint32_t y = 0; y < source_bitmap->GetHeight(); ++y)
+    {
+      const auto* source_line =
+          static_cast<const std::uint8_t*>(source_locked.ptrDataRoi) + static_cast<size_t>(y) * source_locked.stride;  // NOLINT
+      const auto* decoded_line =
+          static_cast<const std::uint8_t*>(decoded_locked.ptrDataRoi) + static_cast<size_t>(y) * decoded_locked.stride;  // NOLINT
+      REQUIRE(memcmp(source_line, decoded_line,
+                     2 * static_cast<size_t>(source_bitmap->GetWidth())) == 0);
+    }
+  }
+}
+
+TEST_CASE("copyczi.12: buffers for the compressed data are recycled across subblocks", "[copyczi]")
+{
+  // arrange
+  auto czi_document_as_blob = CreateCziWithFourSubblockInMosaicArrangement();
+  const auto memory_stream = make_shared<CMemInputOutputStream>(std::get<0>(czi_document_as_blob).get(), std::get<1>(czi_document_as_blob));
+  const auto reader = libCZI::CreateCZIReader();
+  reader->Open(memory_stream);
+  auto writer = libCZI::CreateCZIWriter();
+  const auto memory_backed_stream_destination_document = make_shared<CMemInputOutputStream>(0);
+  const auto writer_info = make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x0, 0x0, 0x0, {0, 0, 0, 0, 0, 0, 0, 0}});
+  writer->Create(memory_backed_stream_destination_document, writer_info);
+
+  // act
+  CopyCziOptions options;
+  options.buffer_pool = make_shared<BufferPool>();
+  CopyCziAndCompress copyCziAndCompress(reader, writer, nullptr, CompressionStrategy::kAll,
+                                        libCZI::Utils::ParseCompressionOptions("zstd1:"), options);
+  REQUIRE(copyCziAndCompress.Run() == true);
+
+  // assert
+  // with single-threaded operation, the buffer for the compressed data of a subblock is released before the next
+  // subblock is compressed - so only the first allocation is a miss
+  REQUIRE(copyCziAndCompress.GetStatistics().GetBufferPoolMisses() == 1);
+  REQUIRE(copyCziAndCompress.GetStatistics().GetBufferPoolHits() == 3);
+  REQUIRE(options.buffer_pool->GetNumberOfMisses() == 1);
+  REQUIRE(options.buffer_pool->GetNumberOfHits() == 3);
+}
+
+TEST_CASE("copyczi.13: bitmaps created by the pooled bitmap site are recycled", "[copyczi]")
+{
+  // arrange
+  const auto buffer_pool = make_shared<BufferPool>();
+  PooledBitmapSite pooled_bitmap_site(libCZI::GetDefaultSiteObject(libCZI::SiteObjectType::Default), buffer_pool);
+
+  // act
+  {
+    const auto bitmap = pooled_bitmap_site.CreateBitmap(libCZI::PixelType::Bgr24, 100, 50, 0, 0, 0);
+    REQUIRE(bitmap->GetPixelType() == libCZI::PixelType::Bgr24);
+    REQUIRE(bitmap->GetWidth() == 100);
+    REQUIRE(bitmap->GetHeight() == 50);
+    const libCZI::ScopedBitmapLockerSP bitmap_locked{bitmap};
+    REQUIRE(bitmap_locked.stride == 300);
+    REQUIRE(bitmap_locked.size == 300 * 50);
+  }
+
+  const auto bitmap = pooled_bitmap_site.CreateBitmap(libCZI::PixelType::Gray8, 290, 51, 0, 0, 0);
+
+  // assert
+  // the second bitmap is slightly smaller than the first one, so it falls into the same size class
+  REQUIRE(buffer_pool->GetNumberOfMisses() == 1);
+  REQUIRE(buffer_pool->GetNumberOfHits() == 1);
+}
+
+TEST_CASE("copyczi.14: uncompressed subblocks of all pixel types are compressed correctly", "[copyczi]")
+{
+  for (const auto pixel_type : {libCZI::PixelType::Gray8, libCZI::PixelType::Gray16, libCZI::PixelType::Bgr24, libCZI::PixelType::Bgr48,
+                                libCZI::PixelType::Gray32Float})
+  {
+    // arrange
+    // the odd width makes sure that the lines are not a multiple of four bytes long
+    const auto source_bitmap = CreateBitmapAndFillWithPattern(pixel_type, 33, 9);
+    const auto czi_document_as_blob = CreateCziWithOneSubblock(source_bitmap);
+
+    // act
+    const CopyCziOptions options;
+    const auto result = RunCompressOnBlob(czi_document_as_blob, options, "zstd1:ExplicitLevel=1;PreProcess=HiLoByteUnpack");
+
+    // assert
+    const auto memory_stream = make_shared<CMemInputOutputStream>(std::get<0>(result).get(), std::get<1>(result));
+    const auto reader = libCZI::CreateCZIReader();
+    reader->Open(memory_stream);
+    const auto subblock = reader->ReadSubBlock(0);
+    REQUIRE(subblock->GetSubBlockInfo().GetCompressionMode() == libCZI::CompressionMode::Zstd1);
+
+    const auto decoded_bitmap = subblock->CreateBitmap();
+    REQUIRE(decoded_bitmap->GetPixelType() == pixel_type);
+    const size_t line_length = static_cast<size_t>(source_bitmap->GetWidth()) * libCZI::Utils::GetBytesPerPixel(pixel_type);
+    const libCZI::ScopedBitmapLockerSP source_locked{source_bitmap};
+    const libCZI::ScopedBitmapLockerSP decoded_locked{decoded_bitmap};
+    for (std::uint32_t y = 0; y < source_bitmap->GetHeight(); ++y)
+    {
+      const auto* source_line =
+          static_cast<const std::uint8_t*>(source_locked.ptrDataRoi) + static_cast<size_t>(y) * source_locked.stride;  // NOLINT
+      const auto* decoded_line =
+          static_cast<const std::uint8_t*>(decoded_locked.ptrDataRoi) + static_cast<size_t>(y) * decoded_locked.stride;  // NOLINT
+      REQUIRE(memcmp(source_line, decoded_line,
+                     line_length) == 0);
+    }
+  }
+}
+
+TEST_CASE("copyczi.15: zstd-compressed subblocks are transcoded to the same data as compressing the original pixels", "[copyczi]")
+{
+  const char* const compression_options[] = {  // NOLINT: C-style array
+      "zstd0:ExplicitLevel=1",
+      "zstd1:ExplicitLevel=1",
+      "zstd1:ExplicitLevel=1;PreProcess=HiLoByteUnpack",
+  };
+
+  const auto get_raw_data_of_first_subblock = [](const tuple<shared_ptr<void>, size_t>& czi_document_as_blob)
+  {
+    const auto memory_stream =
+        make_shared<CMemInputOutputStream>(std::get<0>(czi_document_as_blob).get(), std::get<1>(czi_document_as_blob));
+    const auto reader = libCZI::CreateCZIReader();
+    reader->Open(memory_stream);
+    const auto subblock = reader->ReadSubBlock(0);
+    const void* raw_data = nullptr;
+    size_t size_of_raw_data = 0;
+    subblock->DangerousGetRawData(libCZI::ISubBlock::MemBlkType::Data, raw_data, size_of_raw_data);
+    const auto* raw_data_bytes = static_cast<const std::uint8_t*>(raw_data);
+    return std::vector<std::uint8_t>(raw_data_bytes, raw_data_bytes + size_of_raw_data);  // NOLINT: pointer arithmetic
+  };
+
+  // arrange
+  const auto source_bitmap = CreateBitmapAndFillWithPattern(libCZI::PixelType::Gray16, 61, 17);
+  const auto czi_document_as_blob = CreateCziWithOneSubblock(source_bitmap);
+  const CopyCziOptions options;
+
+  for (const char* source_compression_options : compression_options)
+  {
+    const auto zstd_compressed_document = RunCompressOnBlob(czi_document_as_blob, options, source_compression_options);
+    for (const char* target_compression_options : compression_options)
+    {
+      // act
+      const auto transcoded_document = RunCompressOnBlob(zstd_compressed_document, options, target_compression_options);
+
+      // assert
+      const auto directly_compressed_document = RunCompressOnBlob(czi_document_as_blob, options, target_compression_options);
+      REQUIRE(get_raw_data_of_first_subblock(transcoded_document) == get_raw_data_of_first_subblock(directly_compressed_document));
+    }
+  }
+}
+
+TEST_CASE("copyczi.16: subblocks already compressed as requested are copied verbatim", "[copyczi]")
+{
+  struct TestCase
+  {
+    const char* compression_options;
+    bool expect_already_compressed;
+  };
+
+  const TestCase test_cases[] = {  // NOLINT: C-style array
+      {"zstd1:ExplicitLevel=1;PreProcess=HiLoByteUnpack", true},
+      {"zstd1:ExplicitLevel=3;PreProcess=HiLoByteUnpack", true},  // the compression level cannot be determined from the data
+      {"zstd1:ExplicitLevel=1", false},
+      {"zstd0:ExplicitLevel=1", false},
+  };
+
+  // arrange
+  const auto source_bitmap = CreateBitmapAndFillWithPattern(libCZI::PixelType::Gray16, 61, 17);
+  const auto czi_document_as_blob = CreateCziWithOneSubblock(source_bitmap);
+  const CopyCziOptions options;
+  const auto compressed_document = RunCompressOnBlob(czi_document_as_blob, options, "zstd1:ExplicitLevel=1;PreProcess=HiLoByteUnpack");
+
+  for (const auto& test_case : test_cases)
+  {
+    const auto memory_stream = make_shared<CMemInputOutputStream>(std::get<0>(compressed_document).get(), std::get<1>(compressed_document));
+    const auto reader = libCZI::CreateCZIReader();
+    reader->Open(memory_stream);
+    auto writer = libCZI::CreateCZIWriter();
+    const auto memory_backed_stream_destination_document = make_shared<CMemInputOutputStream>(0);
+    const auto writer_info = make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x0, 0x0, 0x0, {0, 0, 0, 0, 0, 0, 0, 0}});
+    writer->Create(memory_backed_stream_destination_document, writer_info);
+
+    // act
+    CopyCziAndCompress copyCziAndCompress(reader, writer, nullptr, CompressionStrategy::kUncompressedAndZStdCompressed,
+                                          libCZI::Utils::ParseCompressionOptions(test_case.compression_options), options);
+    REQUIRE(copyCziAndCompress.Run() == true);
+
+    // assert
+    const auto& statistics = copyCziAndCompress.GetStatistics();
+    REQUIRE(statistics.GetCountOfSubblocksAlreadyCompressed() == (test_case.expect_already_compressed ? 1 : 0));
+    REQUIRE(statistics.GetCountOfSubblocksCompressed() == (test_case.expect_already_compressed ? 0 : 1));
+    REQUIRE(statistics.GetCountOfSubblocksCopiedVerbatim() == 0);
+    REQUIRE(statistics.GetTotalCountOfSubblocksProcessed() == 1);
+  }
+}
+
+TEST_CASE("copyczi.17: with the strategy 'smallest', the original data is kept if compressing does not make it smaller", "[copyczi]")
+{
+  struct TestCase
+  {
+    shared_ptr<libCZI::IBitmapData> bitmap;
+    bool expect_kept_original;
+  };
+
+  const TestCase test_cases[] = {  // NOLINT: C-style array
+      {CreateGray8BitmapAndFill(64, 64, 42), false},
+      {CreateBitmapAndFillWithNoise(libCZI::PixelType::Gray8, 64, 64, 1), true},
+  };
+
+  for (const auto& test_case : test_cases)
+  {
+    // arrange
+    const auto czi_document_as_blob = CreateCziWithOneSubblock(test_case.bitmap);
+    const auto memory_stream =
+        make_shared<CMemInputOutputStream>(std::get<0>(czi_document_as_blob).get(), std::get<1>(czi_document_as_blob));
+    const auto reader = libCZI::CreateCZIReader();
+    reader->Open(memory_stream);
+    auto writer = libCZI::CreateCZIWriter();
+    const auto memory_backed_stream_destination_document = make_shared<CMemInputOutputStream>(0);
+    const auto writer_info = make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x0, 0x0, 0x0, {0, 0, 0, 0, 0, 0, 0, 0}});
+    writer->Create(memory_backed_stream_destination_document, writer_info);
+
+    // act
+    CopyCziAndCompress copyCziAndCompress(reader, writer, nullptr, CompressionStrategy::kSmallest,
+                                          libCZI::Utils::ParseCompressionOptions("zstd1:ExplicitLevel=1"), CopyCziOptions());
+    REQUIRE(copyCziAndCompress.Run() == true);
+    writer->Close();
+
+    // assert
+    const auto& statistics = copyCziAndCompress.GetStatistics();
+    REQUIRE(statistics.GetCountOfSubblocksKeptOriginal() == (test_case.expect_kept_original ? 1 : 0));
+    REQUIRE(statistics.GetCountOfSubblocksCompressed() == (test_case.expect_kept_original ? 0 : 1));
+
+    size_t result_size = 0;
+    const auto result_data = memory_backed_stream_destination_document->GetCopy(&result_size);
+    const auto result_stream = make_shared<CMemInputOutputStream>(result_data.get(), result_size);
+    const auto result_reader = libCZI::CreateCZIReader();
+    result_reader->Open(result_stream);
+    const auto subblock = result_reader->ReadSubBlock(0);
+    REQUIRE(subblock->GetSubBlockInfo().GetCompressionMode() ==
+            (test_case.expect_kept_original ? libCZI::CompressionMode::UnCompressed : libCZI::CompressionMode::Zstd1));
+  }
+}
+
+TEST_CASE("copyczi.18: with reservations, the metadata is placed at the start of the file", "[copyczi]")
+{
+  // arrange
+  const auto czi_document_as_blob = CreateCziWithFourSubblockInMosaicArrangement();
+  const auto expected_czi_document_as_blob = RunCompressOnBlob(czi_document_as_blob, CopyCziOptions());
+
+  // act
+  const auto result = RunCompressWithReservationsOnBlob(czi_document_as_blob, 0);
+
+  // assert
+  const auto& placements = std::get<2>(result);
+  REQUIRE(placements.metadata == SegmentPlacement::kReservedSpace);
+  REQUIRE(placements.subblock_directory != SegmentPlacement::kNotWritten);
+
+  // the document contains the same subblocks as the document written without reservations
+  const auto expected_reader = libCZI::CreateCZIReader();
+  expected_reader->Open(
+      make_shared<CMemInputOutputStream>(std::get<0>(expected_czi_document_as_blob).get(), std::get<1>(expected_czi_document_as_blob)));
+  const auto reader = libCZI::CreateCZIReader();
+  reader->Open(make_shared<CMemInputOutputStream>(std::get<0>(result).get(), std::get<1>(result)));
+  REQUIRE(reader->GetStatistics().subBlockCount == 4);
+  for (int i = 0; i < 4; ++i)
+  {
+    const auto expected_subblock = expected_reader->ReadSubBlock(i);
+    const auto subblock = reader->ReadSubBlock(i);
+    size_t expected_size = 0;
+    size_t size = 0;
+    const auto expected_data = expected_subblock->GetRawData(libCZI::ISubBlock::MemBlkType::Data, &expected_size);
+    const auto data = subblock->GetRawData(libCZI::ISubBlock::MemBlkType::Data, &size);
+    REQUIRE(size == expected_size);
+    REQUIRE(memcmp(data.get(), expected_data.get(), size) == 0);
+  }
+
+  CheckOriginalCompressionMetadata(reader->ReadMetadataSegment()->CreateMetaFromMetadataSegment());
+}
+
+TEST_CASE("copyczi.19: if the reservation for the metadata is too small, the metadata is placed at the end of the file", "[copyczi]")
+{
+  // arrange
+  const auto czi_document_as_blob = CreateCziWithFourSubblockInMosaicArrangement();
+
+  // act
+  const auto result = RunCompressWithReservationsOnBlob(czi_document_as_blob, 16);
+
+  // assert
+  REQUIRE(std::get<2>(result).metadata == SegmentPlacement::kEndOfFile);
+
+  const auto reader = libCZI::CreateCZIReader();
+  reader->Open(make_shared<CMemInputOutputStream>(std::get<0>(result).get(), std::get<1>(result)));
+  REQUIRE(reader->GetStatistics().subBlockCount == 4);
+  CheckOriginalCompressionMetadata(reader->ReadMetadataSegment()->CreateMetaFromMetadataSegment());
+}
+
+TEST_CASE("copyczi.20: the data of subblocks copied verbatim is announced with its position in the source document", "[copyczi]")
+{
+  // arrange - the subblocks of the source document are uncompressed, so they are all copied verbatim with "decompress"
+  const auto czi_document_as_blob = CreateCziWithFourSubblockInMosaicArrangement();
+  const auto memory_stream = make_shared<CMemInputOutputStream>(std::get<0>(czi_document_as_blob).get(), std::get<1>(czi_document_as_blob));
+  const auto reader = libCZI::CreateCZIReader();
+  reader->Open(memory_stream);
+
+  std::uint64_t total_size_of_data = 0;
+  reader->EnumerateSubBlocks(
+      [&](int index, const libCZI::SubBlockInfo&) -> bool
+      {
+        size_t size = 0;
+        reader->ReadSubBlock(index)->GetRawData(libCZI::ISubBlock::MemBlkType::Data, &size);
+        total_size_of_data += size;
+        return true;
+      });
+
+  for (const int number_of_threads : {1, 4})
+  {
+    auto writer = libCZI::CreateCZIWriter();
+    const auto output_stream = make_shared<SourceRangeRecordingOutputStream>(czi_document_as_blob);
+    writer->Create(output_stream, make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+
+    CopyCziOptions options;
+    options.number_of_threads = number_of_threads;
+    options.source_stream = memory_stream;
+    options.source_range_copy = output_stream;
+
+    // act
+    CopyCziAndDecompress copy_czi_and_decompress(reader, writer, nullptr, options);
+    REQUIRE(copy_czi_and_decompress.Run() == true);
+    writer->Close();
+
+    // assert - all data has been announced (and the recording stream checked it against the source document)
+    REQUIRE(copy_czi_and_decompress.GetStatistics().GetCountOfSubblocksCopiedVerbatim() == 4);
+    REQUIRE(output_stream->GetNumberOfBytesCopiedFromSource() == total_size_of_data);
+    const auto destination_reader = libCZI::CreateCZIReader();
+    destination_reader->Open(output_stream->GetDestinationStream());
+    REQUIRE(destination_reader->GetStatistics().subBlockCount == 4);
+  }
+}
+
+TEST_CASE("copyczi.21: the directory tells whether all subblocks are copied verbatim", "[copyczi]")
+{
+  struct TestCase
+  {
+    bool use_compressed_document;
+    bool decompress;
+    CompressionStrategy strategy;
+    bool expect_all_copied_verbatim;
+  };
+
+  const TestCase test_cases[] = {  // NOLINT: C-style array
+      {false, true, CompressionStrategy::kInvalid, true},
+      {true, true, CompressionStrategy::kInvalid, false},
+      {false, false, CompressionStrategy::kOnlyUncompressed, false},
+      {true, false, CompressionStrategy::kOnlyUncompressed, true},
+      {true, false, CompressionStrategy::kUncompressedAndZStdCompressed, false},  // zstd-data may have to be transcoded
+      {true, false, CompressionStrategy::kAll, false},
+  };
+
+  // arrange
+  const auto czi_document_as_blob = CreateCziWithFourSubblockInMosaicArrangement();
+  const CopyCziOptions options;
+  const auto compressed_document = RunCompressOnBlob(czi_document_as_blob, options);
+
+  for (const auto& test_case : test_cases)
+  {
+    const auto& source_document = test_case.use_compressed_document ? compressed_document : czi_document_as_blob;
+    const auto memory_stream = make_shared<CMemInputOutputStream>(std::get<0>(source_document).get(), std::get<1>(source_document));
+    const auto reader = libCZI::CreateCZIReader();
+    reader->Open(memory_stream);
+    auto writer = libCZI::CreateCZIWriter();
+    writer->Create(make_shared<CMemInputOutputStream>(0),
+                   make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+
+    std::unique_ptr<CopyCziBase> copy_czi;
+    if (test_case.decompress)
+    {
+      copy_czi = std::make_unique<CopyCziAndDecompress>(reader, writer, nullptr, options);
+    }
+    else
+    {
+      copy_czi = std::make_unique<CopyCziAndCompress>(reader, writer, nullptr, test_case.strategy,
+                                                      libCZI::Utils::ParseCompressionOptions("zstd1:"), options);
+    }
+
+    // act
+    const bool all_copied_verbatim = copy_czi->AreAllSubBlocksCopiedVerbatim();
+
+    // assert - and if all subblocks are expected to be copied verbatim, this is what the operation must do
+    REQUIRE(all_copied_verbatim == test_case.expect_all_copied_verbatim);
+    REQUIRE(copy_czi->Run() == true);
+    const auto& statistics = copy_czi->GetStatistics();
+    REQUIRE((statistics.GetCountOfSubblocksCopiedVerbatim() == statistics.GetTotalCountOfSubblocksProcessed()) ==
+            test_case.expect_all_copied_verbatim);
+  }
+
+  // a document with a single subblock is not reported as unchanged, although the subblock is copied verbatim - since
+  //  the operation updates the compression stated in the metadata in this case
+  const auto single_subblock_document = CreateCziWithOneSubblock(CreateGray8BitmapAndFill(4, 4, 1));
+  const auto reader = libCZI::CreateCZIReader();
+  reader->Open(make_shared<CMemInputOutputStream>(std::get<0>(single_subblock_document).get(), std::get<1>(single_subblock_document)));
+  REQUIRE(reader->ReadMetadataSegment()->CreateMetaFromMetadataSegment()->GetXml().find("CurrentCompressionParameters") ==
+          std::string::npos);
+  auto writer = libCZI::CreateCZIWriter();
+  const auto destination_stream = make_shared<CMemInputOutputStream>(0);
+  writer->Create(destination_stream,
+                 make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+  CopyCziAndDecompress copy_czi_and_decompress(reader, writer, nullptr, options);
+
+  REQUIRE_FALSE(copy_czi_and_decompress.AreAllSubBlocksCopiedVerbatim());
+  REQUIRE(copy_czi_and_decompress.Run() == true);
+  writer->Close();
+  REQUIRE(copy_czi_and_decompress.GetStatistics().GetCountOfSubblocksCopiedVerbatim() == 1);
+  const auto destination_reader = libCZI::CreateCZIReader();
+  destination_reader->Open(destination_stream);
+  const auto destination_metadata = destination_reader->ReadMetadataSegment()->CreateMetaFromMetadataSegment();
+  REQUIRE(destination_metadata->GetXml().find("CurrentCompressionParameters") != std::string::npos);
+}
+
+TEST_CASE("copyczi.22: the estimated size of the destination document is close to the actual size", "[copyczi]")
+{
+  // arrange - the subblock is uncompressed, so it is copied verbatim with "decompress", and its size is known exactly
+  const auto source_bitmap = CreateBitmapAndFillWithNoise(libCZI::PixelType::Gray16, 512, 384, 22);
+  const auto czi_document_as_blob = CreateCziWithOneSubblock(source_bitmap);
+  const auto memory_stream = make_shared<CMemInputOutputStream>(std::get<0>(czi_document_as_blob).get(), std::get<1>(czi_document_as_blob));
+  const auto reader = libCZI::CreateCZIReader();
+  reader->Open(memory_stream);
+  auto writer = libCZI::CreateCZIWriter();
+  const auto memory_backed_stream_destination_document = make_shared<CMemInputOutputStream>(0);
+  writer->Create(memory_backed_stream_destination_document,
+                 make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+  const CopyCziOptions options;
+  CopyCziAndDecompress copy_czi_and_decompress(reader, writer, nullptr, options);
+  const CopyCziAndCompress copy_czi_and_compress(reader, nullptr, nullptr, CompressionStrategy::kAll,
+                                                 libCZI::Utils::ParseCompressionOptions("zstd1:"), options);
+
+  // act
+  const std::uint64_t estimated_size = copy_czi_and_decompress.EstimateSizeOfDestinationDocument();
+  const std::uint64_t estimated_size_compressed = copy_czi_and_compress.EstimateSizeOfDestinationDocument();
+  REQUIRE(copy_czi_and_decompress.Run() == true);
+  writer->Close();
+  size_t actual_size = 0;
+  memory_backed_stream_destination_document->GetCopy(&actual_size);
+
+  // assert
+  REQUIRE(estimated_size >= actual_size - actual_size / 20);
+  REQUIRE(estimated_size <= actual_size + actual_size / 20);
+  REQUIRE(estimated_size_compressed < estimated_size);
+  REQUIRE(estimated_size_compressed > static_cast<std::uint64_t>(512) * 384 * 2 / 2);
+}
+
+TEST_CASE("copyczi.23: an operation reading through the block cache reports the cache statistics", "[copyczi]")
+{
+  // arrange - small blocks, so that the subblock data is spread over many of them
+  const auto source_bitmap = CreateBitmapAndFillWithNoise(libCZI::PixelType::Gray8, 256, 256, 23);
+  const auto czi_document_as_blob = CreateCziWithOneSubblock(source_bitmap);
+  const auto memory_stream = make_shared<CMemInputOutputStream>(std::get<0>(czi_document_as_blob).get(), std::get<1>(czi_document_as_blob));
+  const auto caching_stream = make_shared<CachingInputStream>(memory_stream, 512, 1024);
+  const auto reader = libCZI::CreateCZIReader();
+  reader->Open(caching_stream);
+  auto writer = libCZI::CreateCZIWriter();
+  const auto memory_backed_stream_destination_document = make_shared<CMemInputOutputStream>(0);
+  writer->Create(memory_backed_stream_destination_document,
+                 make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+
+  OperationDescription operation_description;
+  operation_description.reader = reader;
+  operation_description.writer = writer;
+  operation_description.command = Command::kCompress;
+  operation_description.compression_strategy = CompressionStrategy::kAll;
+  operation_description.compression_option = libCZI::Utils::ParseCompressionOptions("zstd1:");
+  operation_description.source_stream = caching_stream;
+  auto operation = CreateOperationUp();
+  operation->SetParameters(operation_description);
+
+  // act
+  operation->DoOperation(nullptr);
+  const auto statistics = operation->GetStatistics();
+  operation.reset();
+  writer->Close();
+
+  // assert
+  REQUIRE(statistics.number_of_subblocks_compressed == 1);
+  REQUIRE(statistics.input_cache_used == true);
+  REQUIRE(statistics.input_cache_hits > 0);
+  REQUIRE(statistics.input_cache_misses > 0);
+  REQUIRE(statistics.input_cache_reads == caching_stream->GetStatistics().number_of_reads);
+  REQUIRE(statistics.input_cache_reads < statistics.input_cache_misses + statistics.input_cache_hits);
+
+  size_t size_of_destination_document = 0;
+  const auto destination_document = memory_backed_stream_destination_document->GetCopy(&size_of_destination_document);
+  const auto destination_reader = libCZI::CreateCZIReader();
+  destination_reader->Open(make_shared<CMemInputOutputStream>(destination_document.get(), size_of_destination_document));
+  REQUIRE(destination_reader->GetStatistics().subBlockCount == 1);
+}
+
+TEST_CASE("copyczi.24: the positions of the subblocks are announced in the order in which they are read", "[copyczi]")
+{
+  // arrange - with a shuffled directory, reading in file order differs from the directory order
+  const auto czi_document_as_blob = CreateCziWithFourSubblockInMosaicArrangement();
+  ShuffleSubBlockDirectory(std::get<0>(czi_document_as_blob).get(), std::get<1>(czi_document_as_blob), 1);
+  for (const auto read_order : {SubBlockReadOrder::kDirectory, SubBlockReadOrder::kFilePosition})
+  {
+    for (const int number_of_threads : {1, 4})
+    {
+      const auto source_stream = make_shared<ReadAheadRecordingInputStream>(
+          make_shared<CMemInputOutputStream>(std::get<0>(czi_document_as_blob).get(), std::get<1>(czi_document_as_blob)));
+      const auto reader = libCZI::CreateCZIReader();
+      reader->Open(source_stream);
+      auto writer = libCZI::CreateCZIWriter();
+      writer->Create(make_shared<CMemInputOutputStream>(0),
+                     make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+
+      CopyCziOptions options;
+      options.number_of_threads = number_of_threads;
+      options.read_order = read_order;
+      options.source_read_ahead = source_stream;
+
+      // act
+      CopyCziAndCompress copy_czi_and_compress(reader, writer, nullptr, CompressionStrategy::kAll,
+                                               libCZI::Utils::ParseCompressionOptions("zstd1:"), options);
+      REQUIRE(copy_czi_and_compress.Run() == true);
+      writer->Close();
+
+      // assert - the announced positions are those of the subblocks, and the subblocks are read in this order
+      const auto announced_positions = source_stream->GetAnnouncedPositions();
+      std::vector<std::uint64_t> subblock_positions;
+      reader->EnumerateSubBlocksEx(
+          [&](int, const libCZI::DirectorySubBlockInfo& info) -> bool
+          {
+            subblock_positions.push_back(info.filePosition);
+            return true;
+          });
+
+      REQUIRE(announced_positions.size() == 4);
+      REQUIRE(std::is_permutation(announced_positions.cbegin(), announced_positions.cend(), subblock_positions.cbegin()));
+      if (read_order == SubBlockReadOrder::kFilePosition)
+      {
+        REQUIRE(std::is_sorted(announced_positions.cbegin(), announced_positions.cend()));
+      }
+      else
+      {
+        REQUIRE(announced_positions == subblock_positions);
+      }
+
+      std::vector<std::uint64_t> subblock_positions_in_read_order;
+      for (const auto position : source_stream->GetReadPositions())
+      {
+        if (std::find(announced_positions.cbegin(), announced_positions.cend(), position) != announced_positions.cend())
+        {
+          subblock_positions_in_read_order.push_back(position);
+        }
+      }
+
+      REQUIRE(subblock_positions_in_read_order == announced_positions);
+    }
+  }
+}
+
+TEST_CASE("copyczi.25: the bytes read and written are reported by pixel type, source compression mode and action", "[copyczi]")
+{
+  // arrange
+  const auto source_bitmap = CreateBitmapAndFillWithPattern(libCZI::PixelType::Gray16, 61, 17);
+  const std::uint64_t size_of_uncompressed_data = 61 * 17 * 2;
+  const auto czi_document_as_blob = CreateCziWithOneSubblock(source_bitmap);
+  const auto run_copy_operation =
+      [](const tuple<shared_ptr<void>, size_t>& document, bool decompress) -> std::vector<SubBlockByteStatistics>
+  {
+    const auto memory_stream = make_shared<CMemInputOutputStream>(std::get<0>(document).get(), std::get<1>(document));
+    const auto reader = libCZI::CreateCZIReader();
+    reader->Open(memory_stream);
+    auto writer = libCZI::CreateCZIWriter();
+    writer->Create(make_shared<CMemInputOutputStream>(0),
+                   make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x0, 0x0, 0x0, {0, 0, 0, 0, 0, 0, 0, 0}}));
+    std::unique_ptr<CopyCziBase> copy_czi;
+    if (decompress)
+    {
+      copy_czi = std::make_unique<CopyCziAndDecompress>(reader, writer, nullptr);
+    }
+    else
+    {
+      copy_czi = std::make_unique<CopyCziAndCompress>(reader, writer, nullptr, CompressionStrategy::kOnlyUncompressed,
+                                                      libCZI::Utils::ParseCompressionOptions("zstd1:ExplicitLevel=1"));
+    }
+
+    REQUIRE(copy_czi->Run() == true);
+    return copy_czi->GetStatistics().GetByteStatistics();
+  };
+
+  // act
+  const auto compressed_document = RunCompressOnBlob(czi_document_as_blob, CopyCziOptions(), "zstd1:ExplicitLevel=1");
+  const auto statistics_compress = run_copy_operation(czi_document_as_blob, false);
+  const auto statistics_copy = run_copy_operation(compressed_document, false);
+  const auto statistics_decompress = run_copy_operation(compressed_document, true);
+
+  // assert
+  REQUIRE(statistics_compress.size() == 1);
+  REQUIRE(statistics_compress[0].pixel_type == libCZI::PixelType::Gray16);
+  REQUIRE(statistics_compress[0].pyramid_type == libCZI::SubBlockPyramidType::None);
+  REQUIRE(statistics_compress[0].source_compression_mode == libCZI::CompressionMode::UnCompressed);
+  REQUIRE(statistics_compress[0].action == SubBlockAction::kCompressed);
+  REQUIRE(statistics_compress[0].number_of_subblocks == 1);
+  REQUIRE(statistics_compress[0].input_bytes == size_of_uncompressed_data);
+  REQUIRE(statistics_compress[0].output_bytes > 0);
+  REQUIRE(statistics_compress[0].output_bytes < size_of_uncompressed_data);
+
+  // the subblock compressed before is copied verbatim - its size is the size of the compressed data written before
+  REQUIRE(statistics_copy.size() == 1);
+  REQUIRE(statistics_copy[0].source_compression_mode == libCZI::CompressionMode::Zstd1);
+  REQUIRE(statistics_copy[0].action == SubBlockAction::kCopiedVerbatim);
+  REQUIRE(statistics_copy[0].input_bytes == statistics_compress[0].output_bytes);
+  REQUIRE(statistics_copy[0].output_bytes == statistics_copy[0].input_bytes);
+
+  REQUIRE(statistics_decompress.size() == 1);
+  REQUIRE(statistics_decompress[0].source_compression_mode == libCZI::CompressionMode::Zstd1);
+  REQUIRE(statistics_decompress[0].action == SubBlockAction::kDecompressed);
+  REQUIRE(statistics_decompress[0].input_bytes == statistics_compress[0].output_bytes);
+  REQUIRE(statistics_decompress[0].output_bytes == size_of_uncompressed_data);
+}
+
+TEST_CASE("copyczi.26: the progress reports the bytes done and the number of attachments", "[copyczi]")
+{
+  // arrange - a document with four subblocks and three attachments
+  const auto source_document = CreateCziWithFourSubblockInMosaicArrangement();
+  const auto source_reader = libCZI::CreateCZIReader();
+  source_reader->Open(make_shared<CMemInputOutputStream>(std::get<0>(source_document).get(), std::get<1>(source_document)));
+  auto source_writer = libCZI::CreateCZIWriter();
+  const auto memory_backed_stream_source_document = make_shared<CMemInputOutputStream>(0);
+  source_writer->Create(memory_backed_stream_source_document,
+                        make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+  CopyCziAndDecompress copy_czi_with_attachments(source_reader, source_writer, nullptr);
+  const std::vector<std::uint8_t> attachment_data(100, 0x42);
+  for (int i = 0; i < 3; ++i)
+  {
+    // NOLINTNEXTLINE: uninitialized struct is OK, all fields are set
+    libCZI::AddAttachmentInfo add_attachment_info;
+    add_attachment_info.contentGuid = libCZI::GUID{static_cast<std::uint32_t>(i + 1), 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}};  // NOLINT
+    add_attachment_info.SetContentFileType("BIN");
+    add_attachment_info.SetName("Test");
+    add_attachment_info.ptrData = attachment_data.data();
+    add_attachment_info.dataSize = static_cast<std::uint32_t>(attachment_data.size());
+    source_writer->SyncAddAttachment(add_attachment_info);
+  }
+
+  REQUIRE(copy_czi_with_attachments.Run() == true);
+  source_writer->Close();
+  size_t size_of_source_document = 0;
+  const auto source_document_data = memory_backed_stream_source_document->GetCopy(&size_of_source_document);
+
+  for (const int number_of_threads : {1, 4})
+  {
+    const auto reader = libCZI::CreateCZIReader();
+    reader->Open(make_shared<CMemInputOutputStream>(source_document_data.get(), size_of_source_document));
+    auto writer = libCZI::CreateCZIWriter();
+    writer->Create(make_shared<CMemInputOutputStream>(0),
+                   make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+    std::vector<ProgressInfo> progress_infos;
+    CopyCziOptions options;
+    options.number_of_threads = number_of_threads;
+
+    // act
+    CopyCziAndCompress copy_czi_and_compress(
+        reader, writer,
+        [&progress_infos](const ProgressInfo& progress_info) -> bool
+        {
+          progress_infos.push_back(progress_info);
+          return true;
+        },
+        CompressionStrategy::kAll, libCZI::Utils::ParseCompressionOptions("zstd1:"), options);
+    REQUIRE(copy_czi_and_compress.Run() == true);
+    writer->Close();
+
+    // assert - the input bytes increase with each subblock and sum up to the total
+    std::vector<ProgressInfo> subblock_progress_infos;
+    std::copy_if(progress_infos.cbegin(), progress_infos.cend(), std::back_inserter(subblock_progress_infos),
+                 [](const ProgressInfo& progress_info) -> bool { return progress_info.phase == ProcessingPhase::kCopySubblocks; });
+    REQUIRE(subblock_progress_infos.size() == 4);
+    REQUIRE(subblock_progress_infos[0].input_bytes_total > static_cast<std::uint64_t>(4) * 2 * 2);
+    for (size_t i = 1; i < subblock_progress_infos.size(); ++i)
+    {
+      REQUIRE(subblock_progress_infos[i].input_bytes_done > subblock_progress_infos[i - 1].input_bytes_done);
+      REQUIRE(subblock_progress_infos[i].output_bytes_done > subblock_progress_infos[i - 1].output_bytes_done);
+      REQUIRE(subblock_progress_infos[i].input_bytes_total == subblock_progress_infos[0].input_bytes_total);
+    }
+
+    const auto& last_subblock_progress_info = subblock_progress_infos.back();
+    REQUIRE(last_subblock_progress_info.input_bytes_done == last_subblock_progress_info.input_bytes_total);
+    REQUIRE(last_subblock_progress_info.output_bytes_done == copy_czi_and_compress.GetStatistics().GetTotalOutputBytes());
+    REQUIRE(last_subblock_progress_info.output_bytes_total > 0);
+
+    // the number of attachments is known up front, and the byte counts are kept
+    std::vector<ProgressInfo> attachment_progress_infos;
+    std::copy_if(progress_infos.cbegin(), progress_infos.cend(), std::back_inserter(attachment_progress_infos),
+                 [](const ProgressInfo& progress_info) -> bool { return progress_info.phase == ProcessingPhase::kCopyAttachments; });
+    REQUIRE(attachment_progress_infos.size() == 3);
+    for (size_t i = 0; i < attachment_progress_infos.size(); ++i)
+    {
+      REQUIRE(attachment_progress_infos[i].number_of_items_done == static_cast<int>(i) + 1);
+      REQUIRE(attachment_progress_infos[i].number_of_items_todo == 3);
+      REQUIRE(attachment_progress_infos[i].input_bytes_done == last_subblock_progress_info.input_bytes_total);
+    }
+
+    REQUIRE(progress_infos.back().phase == ProcessingPhase::kWriteXmlMetadata);
+    REQUIRE(progress_infos.back().output_bytes_done == last_subblock_progress_info.output_bytes_done);
+  }
+}
+
+TEST_CASE("copyczi.27: with a tracer, the stages of each subblock are recorded on the threads doing them", "[copyczi]")
+{
+  // arrange
+  const auto czi_document_as_blob = CreateCziWithFourSubblockInMosaicArrangement();
+  struct TestCase
+  {
+    int number_of_threads;
+    std::uint32_t prefetch_depth;
+    const char* reading_thread_name;
+    const char* writing_thread_name;
+  };
+
+  for (const auto& test_case : {TestCase{1, 0, "main", "main"}, TestCase{1, 2, "prefetch", "main"}, TestCase{2, 0, "reader", "writer"}})
+  {
+    const auto reader = libCZI::CreateCZIReader();
+    reader->Open(make_shared<CMemInputOutputStream>(std::get<0>(czi_document_as_blob).get(), std::get<1>(czi_document_as_blob)));
+    auto writer = libCZI::CreateCZIWriter();
+    writer->Create(make_shared<CMemInputOutputStream>(0),
+                   make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+    CopyCziOptions options;
+    options.number_of_threads = test_case.number_of_threads;
+    options.prefetch_depth = test_case.prefetch_depth;
+    options.tracer = make_shared<Tracer>();
+
+    // act
+    CopyCziAndCompress copy_czi_and_compress(reader, writer, nullptr, CompressionStrategy::kAll,
+                                             libCZI::Utils::ParseCompressionOptions("zstd1:"), options);
+    REQUIRE(copy_czi_and_compress.Run() == true);
+    writer->Close();
+    std::stringstream stream;
+    options.tracer->WriteChromeTraceJson(stream);
+    const std::string json = stream.str();
+
+    // assert - each stage begins and ends once for each of the four subblocks
+    for (const char* stage : {"read", "process", "write"})
+    {
+      for (const char* phase : {"B", "E"})
+      {
+        const std::string pattern = std::string("\"name\":\"") + stage + "\",\"cat\":\"subblock\",\"ph\":\"" + phase + "\"";
+        size_t count = 0;
+        for (size_t position = json.find(pattern); position != std::string::npos; position = json.find(pattern, position + 1))
+        {
+          ++count;
+        }
+
+        REQUIRE(count == 4);
+      }
+    }
+
+    REQUIRE(json.find(std::string("\"args\":{\"name\":\"") + test_case.reading_thread_name + "\"}") != std::string::npos);
+    REQUIRE(json.find(std::string("\"args\":{\"name\":\"") + test_case.writing_thread_name + "\"}") != std::string::npos);
+    REQUIRE(options.tracer->GetNumberOfDroppedEvents() == 0);
+  }
+}
+
+TEST_CASE("copyczi.28: with reordering, the bytes in flight stay within the budget for large subblocks", "[copyczi]")
+{
+  // arrange - 24 subblocks of 256x256 pixels of Gray16 (i.e. 128 KiB each), with the subblock directory shuffled
+  SyntheticCziOptions synthetic_czi_options;
+  synthetic_czi_options.pixel_type = libCZI::PixelType::Gray16;
+  synthetic_czi_options.tile_size = 256;
+  synthetic_czi_options.number_of_tiles_x = 6;
+  synthetic_czi_options.number_of_tiles_y = 4;
+  const auto source_stream = make_shared<CMemInputOutputStream>(0);
+  WriteSyntheticCzi(synthetic_czi_options, source_stream);
+  size_t source_size = 0;
+  const auto source_data = source_stream->GetCopy(&source_size);
+  ShuffleSubBlockDirectory(source_data.get(), source_size, 1);
+
+  const auto reader = libCZI::CreateCZIReader();
+  reader->Open(make_shared<CMemInputOutputStream>(source_data.get(), source_size));
+  auto writer = libCZI::CreateCZIWriter();
+  writer->Create(make_shared<CMemInputOutputStream>(0),
+                 make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+
+  // with 4 threads, up to 16 subblocks (i.e. 2 MiB) may be in flight - the budget allows for less than 5 subblocks
+  constexpr std::uint64_t kMaxBytesInFlight = 600000;
+  CopyCziOptions options;
+  options.number_of_threads = 4;
+  options.max_bytes_in_flight = kMaxBytesInFlight;
+  options.read_order = SubBlockReadOrder::kFilePosition;
+  options.output_order = SubBlockOutputOrder::kSource;
+
+  // act - the subblocks are uncompressed, so they are copied and no data is created by processing them
+  CopyCziAndDecompress copy_czi_and_decompress(reader, writer, nullptr, options);
+  REQUIRE(copy_czi_and_decompress.Run() == true);
+  writer->Close();
+
+  // assert
+  const auto peak_bytes_in_flight = copy_czi_and_decompress.GetStatistics().GetPeakBytesInFlight();
+  REQUIRE(peak_bytes_in_flight >= 256 * 256 * 2);
+  REQUIRE(peak_bytes_in_flight < kMaxBytesInFlight);
+}
+
+#ifndef _WIN32
+
+TEST_CASE("copyczi.29: the data of subblocks copied verbatim is copied from the source file into the destination file", "[copyczi]")
+{
+  // arrange - the subblocks of the source document are uncompressed, so they are all copied verbatim with "decompress"
+  const TemporaryFile source_file("czicompress_copyczi_29_source.czi");
+  const TemporaryFile destination_file("czicompress_copyczi_29_destination.czi");
+  SyntheticCziOptions synthetic_czi_options;
+  synthetic_czi_options.tile_size = 256;
+  synthetic_czi_options.number_of_tiles_x = 3;
+  synthetic_czi_options.number_of_tiles_y = 2;
+  WriteSyntheticCziToFile(synthetic_czi_options, source_file.GetPath());
+
+  const auto source_stream = CreateInputStreamForFile(source_file.GetPath(), InputIo::kPread);
+  const auto reader = libCZI::CreateCZIReader();
+  reader->Open(source_stream);
+
+  OutputStreamOptions output_stream_options;
+  output_stream_options.copy_file_range_source_file_name = source_file.GetPath();
+  const auto output_stream = CreateOutputStreamForFile(destination_file.GetPath(), output_stream_options);
+  auto writer = libCZI::CreateCZIWriter();
+  writer->Create(output_stream, make_shared<libCZI::CCziWriterInfo>(libCZI::GUID{0x1, 0x2, 0x3, {4, 5, 6, 7, 8, 9, 10, 11}}));  // NOLINT
+
+  CopyCziOptions options;
+  options.source_stream = source_stream;
+  options.source_range_copy = GetSourceRangeCopy(output_stream);
+  REQUIRE(options.source_range_copy);
+
+  // act
+  CopyCziAndDecompress copy_czi_and_decompress(reader, writer, nullptr, options);
+  REQUIRE(copy_czi_and_decompress.Run() == true);
+  writer->Close();
+  CloseOutputStream(output_stream.get());
+
+  // assert - the data has been copied by the kernel (unless the file system of the temp-folder does not allow for
+  //  this), and the destination document has the same subblocks as the source document
+  REQUIRE(copy_czi_and_decompress.GetStatistics().GetCountOfSubblocksCopiedVerbatim() == 6);
+#if defined(__linux__)
+  REQUIRE(options.source_range_copy->GetNumberOfBytesCopiedFromSource() > 0);
+#endif
+
+  const auto get_data_of_subblocks = [](const std::shared_ptr<libCZI::ICZIReader>& czi_reader)
+  {
+    std::map<std::pair<int, int>, std::vector<std::uint8_t>> data_of_subblocks;
+    czi_reader->EnumerateSubBlocks(
+        [&](int index, const libCZI::SubBlockInfo& info) -> bool
+        {
+          size_t size = 0;
+          const auto data = czi_reader->ReadSubBlock(index)->GetRawData(libCZI::ISubBlock::MemBlkType::Data, &size);
+          const auto* data_as_bytes = static_cast<const std::uint8_t*>(data.get());
+          data_of_subblocks[std::make_pair(info.logicalRect.x, info.logicalRect.y)].assign(data_as_bytes, data_as_bytes + size);  // NOLINT
+          return true;
+        });
+
+    return data_of_subblocks;
+  };
+
+  const auto destination_content = destination_file.ReadContent();
+  const auto destination_reader = libCZI::CreateCZIReader();
+  destination_reader->Open(make_shared<CMemInputOutputStream>(destination_content.data(), destination_content.size()));
+  const auto data_of_destination_subblocks = get_data_of_subblocks(destination_reader);
+  REQUIRE(data_of_destination_subblocks.size() == 6);
+  REQUIRE(data_of_destination_subblocks == get_data_of_subblocks(reader));
+  reader->Close();
+}
+
+#endif
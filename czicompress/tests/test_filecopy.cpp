@@ -0,0 +1,91 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include <include/filecopy.h>
+#include <include/ratelimiter.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+#include "libczi_utils.h"
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+std::vector<std::uint8_t> CreateTestData(size_t size)
+{
+  std::vector<std::uint8_t> data(size);
+  for (size_t i = 0; i < size; ++i)
+  {
+    data[i] = static_cast<std::uint8_t>((i * 13) + (i / 509));
+  }
+
+  return data;
+}
+
+}  // namespace
+
+TEST_CASE("filecopy.1: the copy has the same content as the source file", "[filecopy]")
+{
+  for (const size_t size : {static_cast<size_t>(0), static_cast<size_t>(1), static_cast<size_t>(3 * 1024 * 1024 + 17)})
+  {
+    const auto data = CreateTestData(size);
+    const TemporaryFile source_file("czicompress_filecopy_1_source.bin", data);
+    const TemporaryFile destination_file("czicompress_filecopy_1_destination.bin");
+
+    const FileCopyMethod file_copy_method = CopyFileContent(source_file.GetPath(), destination_file.GetPath(), false);
+
+    REQUIRE(file_copy_method != FileCopyMethod::kInvalid);
+    REQUIRE(destination_file.ReadContent() == data);
+  }
+}
+
+TEST_CASE("filecopy.2: an existing file is only overwritten if requested, and a file cannot be copied onto itself", "[filecopy]")
+{
+  const auto data = CreateTestData(1000);
+  const TemporaryFile source_file("czicompress_filecopy_2_source.bin", data);
+  const TemporaryFile destination_file("czicompress_filecopy_2_destination.bin", CreateTestData(5000));
+
+  REQUIRE_THROWS_AS(CopyFileContent(source_file.GetPath(), destination_file.GetPath(), false), std::runtime_error);
+  REQUIRE(destination_file.ReadContent() == CreateTestData(5000));
+
+  CopyFileContent(source_file.GetPath(), destination_file.GetPath(), true);
+  REQUIRE(destination_file.ReadContent() == data);
+
+  REQUIRE_THROWS_AS(CopyFileContent(source_file.GetPath(), source_file.GetPath(), true), std::invalid_argument);
+  REQUIRE(source_file.ReadContent() == data);
+}
+
+TEST_CASE("filecopy.3: copying the data is limited by the rate limiters, unless the file is cloned", "[filecopy]")
+{
+  const auto data = CreateTestData(3 * 1024 * 1024);
+  const TemporaryFile source_file("czicompress_filecopy_3_source.bin", data);
+
+  // the limit for reading and the limit for writing are checked separately (with both at the same rate, the time
+  //  spent waiting for one of them makes up for the other one)
+  for (const bool limit_reading : {true, false})
+  {
+    const TemporaryFile destination_file("czicompress_filecopy_3_destination.bin");
+    const auto rate_limiter = std::make_shared<RateLimiter>(20);
+
+    // 3 MB at 20 MB/s take 0.15 s (the bucket starts empty)
+    const auto start = std::chrono::steady_clock::now();
+    const FileCopyMethod file_copy_method =
+        CopyFileContent(source_file.GetPath(), destination_file.GetPath(), false, limit_reading ? rate_limiter : nullptr,
+                        limit_reading ? nullptr : rate_limiter);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    REQUIRE(destination_file.ReadContent() == data);
+    if (file_copy_method != FileCopyMethod::kReflink)
+    {
+      REQUIRE(seconds >= 0.1);
+      REQUIRE(rate_limiter->GetThrottledTime() > std::chrono::nanoseconds::zero());
+    }
+  }
+}
@@ -0,0 +1,400 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include <include/inputstream.h>
+#include <src/cachinginputstream.h>
+#include <src/memorymappedinputstream.h>
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+#include "httptestserver.h"
+#include "libczi_utils.h"
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+std::vector<std::uint8_t> CreateTestData(size_t size)
+{
+  std::vector<std::uint8_t> data(size);
+  for (size_t i = 0; i < size; ++i)
+  {
+    data[i] = static_cast<std::uint8_t>((i * 7) + (i / 251));
+  }
+
+  return data;
+}
+
+std::vector<std::uint8_t> ReadFromStream(libCZI::IStream* stream, std::uint64_t offset, std::uint64_t size, std::uint64_t* bytes_read)
+{
+  std::vector<std::uint8_t> data(static_cast<size_t>(size));
+  stream->Read(offset, data.data(), size, bytes_read);
+  data.resize(static_cast<size_t>(*bytes_read));
+  return data;
+}
+
+/// Implementation of libCZI::IStream which is backed by a memory buffer, and which counts the read operations.
+class CountingInputStream : public libCZI::IStream
+{
+private:
+  std::vector<std::uint8_t> data_;
+  std::uint64_t number_of_reads_{0};
+
+public:
+  explicit CountingInputStream(std::vector<std::uint8_t> data) : data_(std::move(data)) {}
+
+  std::uint64_t GetNumberOfReads() const { return this->number_of_reads_; }
+
+  void Read(std::uint64_t offset, void* data, std::uint64_t size, std::uint64_t* ptr_bytes_read) override
+  {
+    ++this->number_of_reads_;
+    const std::uint64_t size_available = offset < this->data_.size() ? (std::min)(size, this->data_.size() - offset) : 0;
+    std::copy_n(this->data_.cbegin() + static_cast<std::ptrdiff_t>(offset), static_cast<size_t>(size_available),
+                static_cast<std::uint8_t*>(data));
+    if (ptr_bytes_read != nullptr)
+    {
+      *ptr_bytes_read = size_available;
+    }
+  }
+};
+
+}  // namespace
+
+TEST_CASE("inputstream.1: mmap and pread give the same data", "[inputstream]")
+{
+  // the data is larger than the read-ahead of the memory-mapped stream, so that sequential access is also exercised
+  const auto data = CreateTestData(20 * 1024 * 1024 + 123);
+  const TemporaryFile file("czicompress_inputstream_1.bin", data);
+
+  const auto pread_stream = CreateInputStreamForFile(file.GetPath(), InputIo::kPread);
+  const auto mmap_stream = CreateInputStreamForFile(file.GetPath(), InputIo::kMmap);
+
+  // sequential reads, followed by reads at random positions
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> reads;
+  for (std::uint64_t offset = 0; offset < data.size(); offset += 1024 * 1024)
+  {
+    reads.emplace_back(offset, 1024 * 1024);
+  }
+
+  reads.emplace_back(17, 1000);
+  reads.emplace_back(10 * 1024 * 1024 + 5, 512 * 1024);
+  reads.emplace_back(3, 1);
+
+  for (const auto& read : reads)
+  {
+    std::uint64_t bytes_read_pread = 0;
+    std::uint64_t bytes_read_mmap = 0;
+    const auto data_pread = ReadFromStream(pread_stream.get(), read.first, read.second, &bytes_read_pread);
+    const auto data_mmap = ReadFromStream(mmap_stream.get(), read.first, read.second, &bytes_read_mmap);
+    REQUIRE(bytes_read_mmap == bytes_read_pread);
+    REQUIRE(data_mmap == data_pread);
+    REQUIRE(std::equal(data_mmap.cbegin(), data_mmap.cend(), data.cbegin() + static_cast<std::ptrdiff_t>(read.first)));
+  }
+}
+
+TEST_CASE("inputstream.2: mmap stream reports short reads at the end of the file", "[inputstream]")
+{
+  const auto data = CreateTestData(1000);
+  const TemporaryFile file("czicompress_inputstream_2.bin", data);
+
+  MemoryMappedInputStream stream(file.GetPath());
+  REQUIRE(stream.GetSize() == data.size());
+
+  std::uint64_t bytes_read = 0;
+  const auto data_at_end = ReadFromStream(&stream, 990, 100, &bytes_read);
+  REQUIRE(bytes_read == 10);
+  REQUIRE(std::equal(data_at_end.cbegin(), data_at_end.cend(), data.cbegin() + 990));
+
+  ReadFromStream(&stream, 2000, 100, &bytes_read);
+  REQUIRE(bytes_read == 0);
+}
+
+TEST_CASE("inputstream.3: mmap stream can map an empty file", "[inputstream]")
+{
+  const TemporaryFile file("czicompress_inputstream_3.bin", std::vector<std::uint8_t>());
+
+  MemoryMappedInputStream stream(file.GetPath());
+  REQUIRE(stream.GetSize() == 0);
+
+  std::uint64_t bytes_read = 1;
+  std::uint8_t buffer[4];  // NOLINT: C-style array
+  stream.Read(0, buffer, sizeof(buffer), &bytes_read);
+  REQUIRE(bytes_read == 0);
+}
+
+TEST_CASE("inputstream.4: mmap stream throws for a file which does not exist", "[inputstream]")
+{
+  REQUIRE_THROWS(CreateInputStreamForFile((std::filesystem::temp_directory_path() / "czicompress_does_not_exist.bin").u8string(),
+                                          InputIo::kMmap));
+}
+
+TEST_CASE("inputstream.5: caching stream gives the same data as the underlying stream", "[inputstream]")
+{
+  const auto data = CreateTestData(3 * 1024 * 1024 + 123);
+  const auto counting_stream = std::make_shared<CountingInputStream>(data);
+
+  // a small cache, so that blocks are evicted
+  CachingInputStream caching_stream(counting_stream, 4096, 16);
+  std::mt19937 random_engine(42);  // NOLINT: fixed seed for reproducibility
+  std::uniform_int_distribution<std::uint64_t> offset_distribution(0, data.size() + 100);
+  std::uniform_int_distribution<std::uint64_t> size_distribution(1, 200 * 1024);
+  for (int i = 0; i < 1000; ++i)
+  {
+    const std::uint64_t offset = offset_distribution(random_engine);
+    const std::uint64_t size = i % 10 == 0 ? size_distribution(random_engine) : size_distribution(random_engine) % 300 + 1;
+    std::uint64_t bytes_read = 0;
+    const auto data_read = ReadFromStream(&caching_stream, offset, size, &bytes_read);
+    const std::uint64_t expected_size = offset < data.size() ? (std::min)(size, data.size() - offset) : 0;
+    REQUIRE(bytes_read == expected_size);
+    REQUIRE(std::equal(data_read.cbegin(), data_read.cend(), data.cbegin() + static_cast<std::ptrdiff_t>(offset)));
+  }
+
+  const auto statistics = caching_stream.GetStatistics();
+  REQUIRE(statistics.hits > 0);
+  REQUIRE(statistics.misses > 0);
+  REQUIRE(statistics.number_of_reads == counting_stream->GetNumberOfReads());
+}
+
+TEST_CASE("inputstream.6: caching stream merges small read operations", "[inputstream]")
+{
+  const auto data = CreateTestData(1024 * 1024);
+  const auto counting_stream = std::make_shared<CountingInputStream>(data);
+  CachingInputStream caching_stream(counting_stream, 4096, 64);
+
+  // a segment header, followed by the data behind it - this is served with one read operation
+  std::uint64_t bytes_read = 0;
+  ReadFromStream(&caching_stream, 100000, 32, &bytes_read);
+  ReadFromStream(&caching_stream, 100032, 256, &bytes_read);
+  ReadFromStream(&caching_stream, 100288, 2000, &bytes_read);
+  REQUIRE(counting_stream->GetNumberOfReads() == 1);
+  auto statistics = caching_stream.GetStatistics();
+  REQUIRE(statistics.misses == 1);
+  REQUIRE(statistics.hits == 2);
+
+  // a read operation for which some blocks are cached, but the ones around them are not
+  ReadFromStream(&caching_stream, 90000, 20000, &bytes_read);
+  REQUIRE(bytes_read == 20000);
+  REQUIRE(counting_stream->GetNumberOfReads() == 3);
+
+  // sequential read operations are served with a growing read-ahead
+  const std::uint64_t number_of_reads_before = counting_stream->GetNumberOfReads();
+  for (std::uint64_t offset = 500000; offset < 500000 + 64 * 4096; offset += 1000)
+  {
+    ReadFromStream(&caching_stream, offset, 1000, &bytes_read);
+    REQUIRE(bytes_read == 1000);
+  }
+
+  REQUIRE(counting_stream->GetNumberOfReads() - number_of_reads_before < 10);
+
+  // large read operations are passed on directly
+  const std::uint64_t size_of_large_read = (CachingInputStream::kMaxNumberOfBlocksToReadAhead + 1) * 4096;
+  const auto data_read = ReadFromStream(&caching_stream, 800000, size_of_large_read, &bytes_read);
+  REQUIRE(bytes_read == size_of_large_read);
+  REQUIRE(std::equal(data_read.cbegin(), data_read.cend(), data.cbegin() + 800000));
+  statistics = caching_stream.GetStatistics();
+  REQUIRE(statistics.number_of_reads == counting_stream->GetNumberOfReads());
+}
+
+TEST_CASE("inputstream.7: the block cache is used as requested", "[inputstream]")
+{
+  const auto data = CreateTestData(100000);
+  const TemporaryFile file("czicompress_inputstream_7.bin", data);
+
+  const auto cached_stream = CreateInputStreamForFile(file.GetPath(), InputIo::kPread, InputCache::kOn);
+  std::uint64_t bytes_read = 0;
+  const auto data_read = ReadFromStream(cached_stream.get(), 0, data.size() + 10, &bytes_read);
+  REQUIRE(data_read == data);
+  InputCacheStatistics statistics;
+  REQUIRE(TryGetInputCacheStatistics(cached_stream.get(), statistics));
+  REQUIRE(statistics.bytes_read == data.size());
+
+  const auto uncached_stream = CreateInputStreamForFile(file.GetPath(), InputIo::kPread, InputCache::kOff);
+  REQUIRE_FALSE(TryGetInputCacheStatistics(uncached_stream.get(), statistics));
+
+  // the temp-folder is not expected to be on a network file system
+  REQUIRE(IsFileOnNetworkFileSystem(file.GetPath()) == false);
+  const auto auto_stream = CreateInputStreamForFile(file.GetPath(), InputIo::kPread, InputCache::kAuto);
+  REQUIRE_FALSE(TryGetInputCacheStatistics(auto_stream.get(), statistics));
+}
+
+TEST_CASE("inputstream.8: http(s)-URLs are recognized", "[inputstream]")
+{
+  REQUIRE(IsHttpUrl("http://example.com/file.czi"));
+  REQUIRE(IsHttpUrl("HTTPS://example.com/file.czi"));
+  REQUIRE_FALSE(IsHttpUrl("http://"));
+  REQUIRE_FALSE(IsHttpUrl("file.czi"));
+  REQUIRE_FALSE(IsHttpUrl("/data/http://file.czi"));
+  REQUIRE_FALSE(IsHttpUrl("ftp://example.com/file.czi"));
+}
+
+#ifndef _WIN32
+
+TEST_CASE("inputstream.9: a file on an HTTP server is read with range requests", "[inputstream]")
+{
+  if (!IsHttpInputAvailable())
+  {
+    SKIP("czicompress was built without libcurl");
+  }
+
+  const auto data = CreateTestData(5 * 1024 * 1024 + 77);
+  const HttpTestServer server(data, std::chrono::milliseconds(2));
+  const auto stream = CreateInputStreamForFile(server.GetUrl(), InputIo::kPread);
+
+  // small reads at random positions
+  std::mt19937 random_engine(9);
+  std::uniform_int_distribution<std::uint64_t> offset_distribution(0, data.size() - 1);
+  for (int i = 0; i < 20; ++i)
+  {
+    const std::uint64_t offset = offset_distribution(random_engine);
+    std::uint64_t bytes_read = 0;
+    const auto data_read = ReadFromStream(stream.get(), offset, 1000, &bytes_read);
+    REQUIRE(bytes_read == (std::min)(static_cast<std::uint64_t>(1000), data.size() - offset));
+    REQUIRE(std::equal(data_read.cbegin(), data_read.cend(), data.cbegin() + static_cast<std::ptrdiff_t>(offset)));
+  }
+
+  // a large read is split into concurrent requests
+  std::uint64_t bytes_read = 0;
+  auto data_read = ReadFromStream(stream.get(), 100, 4 * 1024 * 1024, &bytes_read);
+  REQUIRE(bytes_read == 4 * 1024 * 1024);
+  REQUIRE(std::equal(data_read.cbegin(), data_read.cend(), data.cbegin() + 100));
+  REQUIRE(server.GetMaxNumberOfConcurrentRequests() > 1);
+
+  // a read beyond the end of the file is a short read
+  data_read = ReadFromStream(stream.get(), data.size() - 10, 100, &bytes_read);
+  REQUIRE(bytes_read == 10);
+  REQUIRE(std::equal(data_read.cbegin(), data_read.cend(), data.cend() - 10));
+  data_read = ReadFromStream(stream.get(), data.size() + 10, 100, &bytes_read);
+  REQUIRE(bytes_read == 0);
+}
+
+TEST_CASE("inputstream.10: announced subblock ranges are fetched ahead with concurrent requests", "[inputstream]")
+{
+  if (!IsHttpInputAvailable())
+  {
+    SKIP("czicompress was built without libcurl");
+  }
+
+  const auto data = CreateTestData(2 * 1024 * 1024);
+  const HttpTestServer server(data, std::chrono::milliseconds(5));
+  const auto stream = CreateInputStreamForFile(server.GetUrl(), InputIo::kPread);
+  const auto source_read_ahead = GetSourceReadAhead(stream);
+  REQUIRE(source_read_ahead);
+
+  // the "subblocks" are 16 KB each, and they are read in an order different from the file order
+  constexpr std::uint64_t kSizeOfSubBlock = 16 * 1024;
+  std::vector<std::uint64_t> positions;
+  for (std::uint64_t position = 0; position < data.size(); position += kSizeOfSubBlock)
+  {
+    positions.push_back(position);
+  }
+
+  std::shuffle(positions.begin(), positions.end(), std::mt19937(10));
+  const std::uint64_t number_of_requests_at_start = server.GetNumberOfRequests();
+  source_read_ahead->AnnounceSubBlockPositions(positions);
+
+  // like libCZI, we read the segment header first and then the remainder of the subblock
+  for (const auto position : positions)
+  {
+    std::uint64_t bytes_read = 0;
+    auto data_read = ReadFromStream(stream.get(), position, 32, &bytes_read);
+    REQUIRE(std::equal(data_read.cbegin(), data_read.cend(), data.cbegin() + static_cast<std::ptrdiff_t>(position)));
+    data_read = ReadFromStream(stream.get(), position + 32, kSizeOfSubBlock - 32, &bytes_read);
+    REQUIRE(bytes_read == kSizeOfSubBlock - 32);
+    REQUIRE(std::equal(data_read.cbegin(), data_read.cend(), data.cbegin() + static_cast<std::ptrdiff_t>(position + 32)));
+  }
+
+  // each subblock is fetched with one request, and the requests overlap
+  REQUIRE(server.GetNumberOfRequests() - number_of_requests_at_start == positions.size());
+  REQUIRE(server.GetMaxNumberOfConcurrentRequests() > 1);
+
+  // a read which is not covered by the announced ranges is carried out directly
+  std::uint64_t bytes_read = 0;
+  const auto data_read = ReadFromStream(stream.get(), 100, 1000, &bytes_read);
+  REQUIRE(std::equal(data_read.cbegin(), data_read.cend(), data.cbegin() + 100));
+}
+
+TEST_CASE("inputstream.11: opening an http(s)-URL fails if the file cannot be read with range requests", "[inputstream]")
+{
+  if (!IsHttpInputAvailable())
+  {
+    SKIP("czicompress was built without libcurl");
+  }
+
+  const auto data = CreateTestData(1000);
+  const HttpTestServer server_without_ranges(data, std::chrono::microseconds(0), false);
+  REQUIRE_THROWS(CreateInputStreamForFile(server_without_ranges.GetUrl(), InputIo::kPread));
+
+  const HttpTestServer server(data);
+  REQUIRE_THROWS(CreateInputStreamForFile(server.GetUrl() + ".missing", InputIo::kPread));
+  REQUIRE_THROWS_AS(CreateInputStreamForFile(server.GetUrl(), InputIo::kMmap), std::invalid_argument);
+  REQUIRE(CreateInputStreamForFile(server.GetUrl(), InputIo::kPread));
+}
+
+#endif
+
+TEST_CASE("inputstream.12: with the block cache, announced subblock ranges are still fetched ahead", "[inputstream]")
+{
+  if (!IsHttpInputAvailable())
+  {
+    SKIP("czicompress was built without libcurl");
+  }
+
+  const auto data = CreateTestData(2 * 1024 * 1024);
+  const HttpTestServer server(data, std::chrono::milliseconds(5));
+  const auto stream = CreateInputStreamForFile(server.GetUrl(), InputIo::kPread, InputCache::kOn);
+  const auto source_read_ahead = GetSourceReadAhead(stream);
+  REQUIRE(source_read_ahead);
+
+  // the "subblocks" are 16 KB each, they start after the first 64 KB (like the subblocks start after the file header
+  //  and the reserved space), and they are read in an order different from the file order
+  constexpr std::uint64_t kSizeOfSubBlock = 16 * 1024;
+  constexpr std::uint64_t kStartOfSubBlocks = 64 * 1024;
+  std::vector<std::uint64_t> positions;
+  for (std::uint64_t position = kStartOfSubBlocks; position < data.size(); position += kSizeOfSubBlock)
+  {
+    positions.push_back(position);
+  }
+
+  std::shuffle(positions.begin(), positions.end(), std::mt19937(11));
+  const std::uint64_t number_of_requests_at_start = server.GetNumberOfRequests();
+  source_read_ahead->AnnounceSubBlockPositions(positions);
+
+  // like libCZI, we read the segment header first and then the remainder of the subblock
+  for (const auto position : positions)
+  {
+    std::uint64_t bytes_read = 0;
+    auto data_read = ReadFromStream(stream.get(), position, 32, &bytes_read);
+    REQUIRE(std::equal(data_read.cbegin(), data_read.cend(), data.cbegin() + static_cast<std::ptrdiff_t>(position)));
+    data_read = ReadFromStream(stream.get(), position + 32, kSizeOfSubBlock - 32, &bytes_read);
+    REQUIRE(bytes_read == kSizeOfSubBlock - 32);
+    REQUIRE(std::equal(data_read.cbegin(), data_read.cend(), data.cbegin() + static_cast<std::ptrdiff_t>(position + 32)));
+  }
+
+  // each subblock is fetched with one request (i.e. the reads of the subblocks bypass the cache), and the requests overlap
+  REQUIRE(server.GetNumberOfRequests() - number_of_requests_at_start == positions.size());
+  REQUIRE(server.GetMaxNumberOfConcurrentRequests() > 1);
+
+  // a read which is not covered by the announced ranges goes through the cache
+  InputCacheStatistics statistics_before;
+  REQUIRE(TryGetInputCacheStatistics(stream.get(), statistics_before));
+  std::uint64_t bytes_read = 0;
+  auto data_read = ReadFromStream(stream.get(), 100, 1000, &bytes_read);
+  REQUIRE(std::equal(data_read.cbegin(), data_read.cend(), data.cbegin() + 100));
+  data_read = ReadFromStream(stream.get(), 2000, 1000, &bytes_read);
+  REQUIRE(std::equal(data_read.cbegin(), data_read.cend(), data.cbegin() + 2000));
+  InputCacheStatistics statistics_after;
+  REQUIRE(TryGetInputCacheStatistics(stream.get(), statistics_after));
+  REQUIRE(statistics_after.misses > statistics_before.misses);
+  REQUIRE(statistics_after.hits > statistics_before.hits);
+}
@@ -0,0 +1,406 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include <include/outputstream.h>
+#include <src/directiooutputstream.h>
+#include <src/writebehindoutputstream.h>
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+#include "libczi_utils.h"
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// Implementation of libCZI::IOutputStream which fails once more than the specified number of bytes are written.
+class FailingOutputStream : public libCZI::IOutputStream
+{
+private:
+  std::uint64_t number_of_bytes_until_failure_;
+
+public:
+  explicit FailingOutputStream(std::uint64_t number_of_bytes_until_failure)
+      : number_of_bytes_until_failure_(number_of_bytes_until_failure)
+  {
+  }
+
+  void Write(std::uint64_t /*offset*/, const void* /*data*/, std::uint64_t size, std::uint64_t* ptr_bytes_written) override
+  {
+    if (size > this->number_of_bytes_until_failure_)
+    {
+      throw std::runtime_error("disk full");
+    }
+
+    this->number_of_bytes_until_failure_ -= size;
+    if (ptr_bytes_written != nullptr)
+    {
+      *ptr_bytes_written = size;
+    }
+  }
+};
+
+/// Writes a sequence of chunks of random size, and every now and then overwrites some data at a random position
+/// (which is what the CZI-writer does when updating the file header or a directory).
+void WriteTestSequence(libCZI::IOutputStream* output_stream, std::uint32_t seed)
+{
+  std::mt19937 random_engine(seed);
+  std::vector<std::uint8_t> data;
+  std::uint64_t offset = 0;
+  for (int i = 0; i < 500; ++i)
+  {
+    data.resize(random_engine() % 3000);
+    for (auto& value : data)
+    {
+      value = static_cast<std::uint8_t>(random_engine());
+    }
+
+    std::uint64_t bytes_written = 0;
+    if (i % 10 == 9 && offset > data.size())
+    {
+      output_stream->Write(random_engine() % (offset - data.size()), data.data(), data.size(), &bytes_written);
+    }
+    else if (i % 10 == 5 && offset > 0)
+    {
+      // overwrite the most recently written data, which may still be in the current buffer
+      const std::uint64_t size = (std::min)(offset, static_cast<std::uint64_t>(data.size()));
+      output_stream->Write(offset - size, data.data(), size, &bytes_written);
+      data.resize(static_cast<size_t>(size));
+    }
+    else
+    {
+      output_stream->Write(offset, data.data(), data.size(), &bytes_written);
+      offset += data.size();
+    }
+
+    REQUIRE(bytes_written == data.size());
+  }
+}
+
+}  // namespace
+
+TEST_CASE("outputstream.1: write-behind stream gives the same result as writing directly", "[outputstream]")
+{
+  const auto expected_output_stream = std::make_shared<CMemOutputStream>(0);
+  WriteTestSequence(expected_output_stream.get(), 42);
+
+  for (const size_t buffer_size : {1000, 4096, 65536})
+  {
+    for (const std::uint32_t number_of_buffers : {2, 5})
+    {
+      const auto output_stream = std::make_shared<CMemOutputStream>(0);
+      WriteBehindOutputStream write_behind_output_stream(output_stream, buffer_size, number_of_buffers);
+      WriteTestSequence(&write_behind_output_stream, 42);
+      write_behind_output_stream.Close();
+
+      REQUIRE(output_stream->GetDataSize() == expected_output_stream->GetDataSize());
+      REQUIRE(memcmp(output_stream->GetDataC(), expected_output_stream->GetDataC(), expected_output_stream->GetDataSize()) == 0);
+    }
+  }
+}
+
+TEST_CASE("outputstream.2: write-behind stream reports an error of the underlying stream", "[outputstream]")
+{
+  const auto failing_output_stream = std::make_shared<FailingOutputStream>(10000);
+  WriteBehindOutputStream write_behind_output_stream(failing_output_stream, 4096);
+
+  // the error may be reported by a subsequent write operation or by the close operation, but it must be reported
+  bool error_reported = false;
+  try
+  {
+    WriteTestSequence(&write_behind_output_stream, 1);
+  }
+  catch (const std::runtime_error&)
+  {
+    error_reported = true;
+  }
+
+  if (!error_reported)
+  {
+    REQUIRE_THROWS_AS(write_behind_output_stream.Close(), std::runtime_error);
+  }
+}
+
+TEST_CASE("outputstream.3: write-behind stream reports an error which occurs when writing the last buffer", "[outputstream]")
+{
+  const auto failing_output_stream = std::make_shared<FailingOutputStream>(100);
+  WriteBehindOutputStream write_behind_output_stream(failing_output_stream, 4096);
+
+  const std::vector<std::uint8_t> data(1000);
+  write_behind_output_stream.Write(0, data.data(), data.size(), nullptr);
+  REQUIRE_THROWS_AS(write_behind_output_stream.Close(), std::runtime_error);
+
+  // closing again does not throw anymore, and writing is not possible
+  REQUIRE_NOTHROW(write_behind_output_stream.Close());
+  REQUIRE_THROWS_AS(write_behind_output_stream.Write(0, data.data(), data.size(), nullptr), std::logic_error);
+}
+
+#ifndef _WIN32
+
+TEST_CASE("outputstream.4: announced ranges of the source file are copied into the destination file", "[outputstream]")
+{
+  std::vector<std::uint8_t> source_data(3 * 1024 * 1024 + 17);
+  std::mt19937 random_engine(4);
+  for (auto& value : source_data)
+  {
+    value = static_cast<std::uint8_t>(random_engine());
+  }
+
+  const TemporaryFile source_file("czicompress_outputstream_4_source.bin", source_data);
+  const TemporaryFile destination_file("czicompress_outputstream_4_destination.bin");
+
+  OutputStreamOptions options;
+  options.copy_file_range_source_file_name = source_file.GetPath();
+  const auto output_stream = CreateOutputStreamForFile(destination_file.GetPath(), options);
+  const auto source_range_copy = GetSourceRangeCopy(output_stream);
+  REQUIRE(source_range_copy);
+
+  // a header (written from memory), followed by two ranges of the source file (copied, or written from memory if
+  // copying is not possible with the file system of the temp-folder)
+  const std::vector<std::uint8_t> header(100, 0xab);
+  output_stream->Write(0, header.data(), header.size(), nullptr);
+  const std::uint64_t size_of_first_range = 1024 * 1024;
+  source_range_copy->AnnounceSourceRange(source_data.data() + 4096, size_of_first_range, 4096);
+  output_stream->Write(header.size(), source_data.data() + 4096, size_of_first_range, nullptr);
+  const std::uint64_t size_of_second_range = source_data.size() - 5;
+  source_range_copy->AnnounceSourceRange(source_data.data() + 5, size_of_second_range, 5);
+  output_stream->Write(header.size() + size_of_first_range, source_data.data() + 5, size_of_second_range, nullptr);
+  CloseOutputStream(output_stream.get());
+
+  std::vector<std::uint8_t> expected_content(header);
+  expected_content.insert(expected_content.end(), source_data.begin() + 4096, source_data.begin() + 4096 + size_of_first_range);
+  expected_content.insert(expected_content.end(), source_data.begin() + 5, source_data.end());
+  REQUIRE(destination_file.ReadContent() == expected_content);
+
+  const std::uint64_t bytes_copied = source_range_copy->GetNumberOfBytesCopiedFromSource();
+  REQUIRE((bytes_copied == 0 || bytes_copied == size_of_first_range + size_of_second_range));
+}
+
+TEST_CASE("outputstream.5: a write operation not matching the announcement is written from memory", "[outputstream]")
+{
+  const std::vector<std::uint8_t> source_data(10000, 1);
+  const TemporaryFile source_file("czicompress_outputstream_5_source.bin", source_data);
+  const TemporaryFile destination_file("czicompress_outputstream_5_destination.bin");
+
+  OutputStreamOptions options;
+  options.copy_file_range_source_file_name = source_file.GetPath();
+  const auto output_stream = CreateOutputStreamForFile(destination_file.GetPath(), options);
+  const auto source_range_copy = GetSourceRangeCopy(output_stream);
+  REQUIRE(source_range_copy);
+
+  // a different pointer, a different size, and a second write after a matching one must not be copied
+  const std::vector<std::uint8_t> data(1000, 2);
+  source_range_copy->AnnounceSourceRange(source_data.data(), data.size(), 0);
+  output_stream->Write(0, data.data(), data.size(), nullptr);
+  source_range_copy->AnnounceSourceRange(data.data(), data.size() - 1, 0);
+  output_stream->Write(1000, data.data(), data.size(), nullptr);
+  source_range_copy->AnnounceSourceRange(data.data(), data.size(), 0);
+  output_stream->Write(2000, data.data(), data.size(), nullptr);
+  output_stream->Write(3000, data.data(), data.size(), nullptr);
+  CloseOutputStream(output_stream.get());
+
+  std::vector<std::uint8_t> expected_content(4000, 2);
+  const std::uint64_t bytes_copied = source_range_copy->GetNumberOfBytesCopiedFromSource();
+  if (bytes_copied > 0)
+  {
+    // the third write operation matched the announcement (and the source file contains different data at this position)
+    REQUIRE(bytes_copied == data.size());
+    std::fill(expected_content.begin() + 2000, expected_content.begin() + 3000, 1);
+  }
+
+  REQUIRE(destination_file.ReadContent() == expected_content);
+}
+
+TEST_CASE("outputstream.6: copying ranges of the source file cannot be combined with a write buffer", "[outputstream]")
+{
+  const TemporaryFile destination_file("czicompress_outputstream_6_destination.bin");
+  OutputStreamOptions options;
+  options.copy_file_range_source_file_name = destination_file.GetPath();
+  options.write_buffer_size = 4096;
+  REQUIRE_THROWS_AS(CreateOutputStreamForFile(destination_file.GetPath(), options), std::invalid_argument);
+}
+
+TEST_CASE("outputstream.7: a preallocated file is truncated to the size of the data written", "[outputstream]")
+{
+  struct TestCase
+  {
+    std::uint64_t preallocation_size;
+    std::uint64_t write_buffer_size;
+    bool use_copy_file_range;
+  };
+
+  const TestCase test_cases[] = {  // NOLINT: C-style array
+      {10 * 1024 * 1024, 0, false},
+      {10 * 1024 * 1024, 64 * 1024, false},
+      {10 * 1024 * 1024, 0, true},
+      {1000, 0, false},  // the file grows beyond the preallocated size
+  };
+
+  const std::vector<std::uint8_t> source_data(300 * 1024, 0x5a);
+  const TemporaryFile source_file("czicompress_outputstream_7_source.bin", source_data);
+  for (const auto& test_case : test_cases)
+  {
+    const TemporaryFile destination_file("czicompress_outputstream_7_destination.bin");
+    OutputStreamOptions options;
+    options.preallocation_size = test_case.preallocation_size;
+    options.write_buffer_size = test_case.write_buffer_size;
+    if (test_case.use_copy_file_range)
+    {
+      options.copy_file_range_source_file_name = source_file.GetPath();
+    }
+
+    const auto output_stream = CreateOutputStreamForFile(destination_file.GetPath(), options);
+
+    // the last write operation is not the one ending at the end of the file (as is the case with the CZI-writer,
+    // which updates the file header at the end)
+    const std::vector<std::uint8_t> header(512, 0x11);
+    output_stream->Write(0, header.data(), header.size(), nullptr);
+    output_stream->Write(header.size(), source_data.data(), source_data.size(), nullptr);
+    const std::vector<std::uint8_t> updated_header(32, 0x22);
+    output_stream->Write(0, updated_header.data(), updated_header.size(), nullptr);
+    CloseOutputStream(output_stream.get());
+
+    std::vector<std::uint8_t> expected_content(updated_header);
+    expected_content.insert(expected_content.end(), header.begin() + updated_header.size(), header.end());
+    expected_content.insert(expected_content.end(), source_data.begin(), source_data.end());
+    REQUIRE(destination_file.ReadContent() == expected_content);
+  }
+}
+
+TEST_CASE("outputstream.8: the direct I/O output stream writes unaligned data correctly", "[outputstream]")
+{
+  const TemporaryFile destination_file("czicompress_outputstream_8_destination.bin");
+
+  // a small staging buffer, so that the write operations cross its boundaries
+  std::mt19937 random_engine(42);  // NOLINT: fixed seed for reproducibility
+  std::vector<std::uint8_t> expected_content;
+  {
+    DirectIoOutputStream output_stream(destination_file.GetPath(), true, 0, 2 * DirectIoOutputStream::kAlignment);
+    const auto write = [&](std::uint64_t offset, std::uint64_t size)
+    {
+      std::vector<std::uint8_t> data(size);
+      std::generate(data.begin(), data.end(), [&]() { return static_cast<std::uint8_t>(random_engine()); });
+      std::uint64_t bytes_written = 0;
+      output_stream.Write(offset, data.data(), data.size(), &bytes_written);
+      REQUIRE(bytes_written == size);
+      if (expected_content.size() < offset + size)
+      {
+        expected_content.resize(offset + size, 0);
+      }
+
+      std::copy(data.begin(), data.end(), expected_content.begin() + static_cast<std::ptrdiff_t>(offset));
+    };
+
+    write(0, 100);                          // header (partial block)
+    write(100, 5000);                       // continues the header, crosses a block boundary
+    write(5100, 20000);                     // crosses the staging buffer several times
+    write(30000, 3);                        // leaves a gap (which must be zero)
+    write(0, 32);                           // updates the header
+    write(4090, 10);                        // overwrites data across a block boundary (already written to the file)
+    write(30003, 4096 * 3 - 30003 % 4096);  // ends at a block boundary
+    write(4096 * 10 + 17, 1);               // a single byte
+    output_stream.Close();
+  }
+
+  REQUIRE(destination_file.ReadContent() == expected_content);
+}
+
+TEST_CASE("outputstream.9: direct I/O can be combined with a write buffer and preallocation", "[outputstream]")
+{
+  const TemporaryFile destination_file("czicompress_outputstream_9_destination.bin");
+  OutputStreamOptions options;
+  options.overwrite_existing_file = true;
+  options.direct_io = true;
+  options.write_buffer_size = 64 * 1024;
+  options.preallocation_size = 10 * 1024 * 1024;
+  const auto output_stream = CreateOutputStreamForFile(destination_file.GetPath(), options);
+
+  const std::vector<std::uint8_t> header(512, 0x11);
+  const std::vector<std::uint8_t> data(300 * 1024 + 7, 0x5a);
+  output_stream->Write(0, header.data(), header.size(), nullptr);
+  output_stream->Write(header.size(), data.data(), data.size(), nullptr);
+  const std::vector<std::uint8_t> updated_header(32, 0x22);
+  output_stream->Write(0, updated_header.data(), updated_header.size(), nullptr);
+  CloseOutputStream(output_stream.get());
+
+  std::vector<std::uint8_t> expected_content(updated_header);
+  expected_content.insert(expected_content.end(), header.begin() + updated_header.size(), header.end());
+  expected_content.insert(expected_content.end(), data.begin(), data.end());
+  REQUIRE(destination_file.ReadContent() == expected_content);
+
+  // direct I/O cannot be combined with copying ranges of the source file
+  OutputStreamOptions options_invalid;
+  options_invalid.overwrite_existing_file = true;
+  options_invalid.direct_io = true;
+  options_invalid.copy_file_range_source_file_name = destination_file.GetPath();
+  REQUIRE_THROWS_AS(CreateOutputStreamForFile(destination_file.GetPath(), options_invalid), std::invalid_argument);
+}
+
+TEST_CASE("outputstream.10: an announcement is kept across write operations which do not match it", "[outputstream]")
+{
+  std::vector<std::uint8_t> source_data(256 * 1024);
+  std::mt19937 random_engine(10);
+  for (auto& value : source_data)
+  {
+    value = static_cast<std::uint8_t>(random_engine());
+  }
+
+  const TemporaryFile source_file("czicompress_outputstream_10_source.bin", source_data);
+  const TemporaryFile destination_file("czicompress_outputstream_10_destination.bin");
+
+  OutputStreamOptions options;
+  options.copy_file_range_source_file_name = source_file.GetPath();
+  const auto output_stream = CreateOutputStreamForFile(destination_file.GetPath(), options);
+  const auto source_range_copy = GetSourceRangeCopy(output_stream);
+  REQUIRE(source_range_copy);
+
+  // like the CZI-writer, the segment header and the metadata are written after the announcement and before the data
+  const std::vector<std::uint8_t> segment_header(288, 0xab);
+  const std::vector<std::uint8_t> metadata(100, 0xcd);
+  const std::uint64_t size_of_range = 128 * 1024;
+  source_range_copy->AnnounceSourceRange(source_data.data() + 4096, size_of_range, 4096);
+  output_stream->Write(0, segment_header.data(), segment_header.size(), nullptr);
+  output_stream->Write(segment_header.size(), metadata.data(), metadata.size(), nullptr);
+  const std::uint64_t offset_of_data = segment_header.size() + metadata.size();
+  output_stream->Write(offset_of_data, source_data.data() + 4096, size_of_range, nullptr);
+
+  // after the matching write operation, the announcement is used up
+  output_stream->Write(offset_of_data + size_of_range, source_data.data() + 4096, size_of_range, nullptr);
+  CloseOutputStream(output_stream.get());
+
+  std::vector<std::uint8_t> expected_content(segment_header);
+  expected_content.insert(expected_content.end(), metadata.begin(), metadata.end());
+  expected_content.insert(expected_content.end(), source_data.begin() + 4096, source_data.begin() + 4096 + size_of_range);
+  expected_content.insert(expected_content.end(), source_data.begin() + 4096, source_data.begin() + 4096 + size_of_range);
+  REQUIRE(destination_file.ReadContent() == expected_content);
+
+  const std::uint64_t bytes_copied = source_range_copy->GetNumberOfBytesCopiedFromSource();
+  REQUIRE((bytes_copied == 0 || bytes_copied == size_of_range));
+#if defined(__linux__)
+  REQUIRE(bytes_copied == size_of_range);
+#endif
+}
+
+#endif
+
+TEST_CASE("outputstream.11: the preallocation size is a hint which is ignored where it is not supported", "[outputstream]")
+{
+  const TemporaryFile destination_file("czicompress_outputstream_11_destination.bin");
+  OutputStreamOptions options;
+  options.preallocation_size = 1024 * 1024;
+  const auto output_stream = CreateOutputStreamForFile(destination_file.GetPath(), options);
+
+  const std::vector<std::uint8_t> data(1000, 0x5a);
+  output_stream->Write(0, data.data(), data.size(), nullptr);
+  CloseOutputStream(output_stream.get());
+
+  REQUIRE(destination_file.ReadContent() == data);
+}
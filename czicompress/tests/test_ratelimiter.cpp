@@ -0,0 +1,143 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include <include/ratelimiter.h>
+#include <src/ratelimitedinputstream.h>
+#include <src/ratelimitedoutputstream.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+#include "libczi_utils.h"
+
+using std::chrono::duration, std::chrono::milliseconds, std::chrono::steady_clock;
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+constexpr std::uint64_t kMegabyte = 1024 * 1024;
+
+/// Acquires the specified number of bytes in chunks of 64 KB and returns the time this took (in seconds).
+double AcquireInChunks(RateLimiter& rate_limiter, std::uint64_t number_of_bytes)
+{
+  constexpr std::uint64_t kChunkSize = 64 * 1024;
+  const auto start = steady_clock::now();
+  for (std::uint64_t bytes_acquired = 0; bytes_acquired < number_of_bytes; bytes_acquired += kChunkSize)
+  {
+    rate_limiter.Acquire(kChunkSize);
+  }
+
+  return duration<double>(steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+TEST_CASE("ratelimiter.1: the rate is limited to the specified number of megabytes per second", "[ratelimiter]")
+{
+  RateLimiter rate_limiter(20);
+
+  // 10 MB at 20 MB/s take 0.5 s (the bucket starts empty, so there is no initial burst)
+  const double seconds = AcquireInChunks(rate_limiter, 10 * kMegabyte);
+  REQUIRE(seconds >= 0.45);
+  REQUIRE(seconds < 2.0);
+  REQUIRE(duration<double>(rate_limiter.GetThrottledTime()).count() >= 0.4);
+}
+
+TEST_CASE("ratelimiter.2: a rate of zero means that the rate is not limited", "[ratelimiter]")
+{
+  RateLimiter rate_limiter;
+  REQUIRE(rate_limiter.GetMaxMegabytesPerSecond() == 0);
+
+  const double seconds = AcquireInChunks(rate_limiter, 1024 * kMegabyte);
+  REQUIRE(seconds < 0.5);
+  REQUIRE(rate_limiter.GetThrottledTime().count() == 0);
+}
+
+TEST_CASE("ratelimiter.3: an operation larger than the burst is admitted, and the following operations wait", "[ratelimiter]")
+{
+  RateLimiter rate_limiter(10);
+
+  // the first operation leaves a debt of 5 MB, which is paid off at 10 MB/s
+  const auto start = steady_clock::now();
+  rate_limiter.Acquire(5 * kMegabyte);
+  REQUIRE(duration<double>(steady_clock::now() - start).count() < 0.25);
+  rate_limiter.Acquire(1);
+  REQUIRE(duration<double>(steady_clock::now() - start).count() >= 0.45);
+}
+
+TEST_CASE("ratelimiter.4: changing the rate takes effect for an operation which is waiting", "[ratelimiter]")
+{
+  RateLimiter rate_limiter(1);
+
+  // at 1 MB/s the second operation would wait for 100 s - lifting the limit must wake it up
+  rate_limiter.Acquire(100 * kMegabyte);
+  const auto start = steady_clock::now();
+  std::thread thread([&rate_limiter]() { rate_limiter.Acquire(1); });
+  std::this_thread::sleep_for(milliseconds(100));
+  rate_limiter.SetMaxMegabytesPerSecond(0);
+  thread.join();
+  REQUIRE(duration<double>(steady_clock::now() - start).count() < 5.0);
+  REQUIRE(duration<double>(rate_limiter.GetThrottledTime()).count() >= 0.09);
+
+  // raising the limit while waiting shortens the wait accordingly
+  rate_limiter.SetMaxMegabytesPerSecond(1);
+  rate_limiter.Acquire(10 * kMegabyte);
+  const auto start_of_second_wait = steady_clock::now();
+  std::thread second_thread([&rate_limiter]() { rate_limiter.Acquire(1); });
+  std::this_thread::sleep_for(milliseconds(100));
+  rate_limiter.SetMaxMegabytesPerSecond(1000);
+  second_thread.join();
+  REQUIRE(duration<double>(steady_clock::now() - start_of_second_wait).count() < 2.0);
+}
+
+TEST_CASE("ratelimiter.5: invalid rates are rejected", "[ratelimiter]")
+{
+  REQUIRE_THROWS_AS(RateLimiter(-1), std::invalid_argument);
+
+  RateLimiter rate_limiter(5);
+  REQUIRE_THROWS_AS(rate_limiter.SetMaxMegabytesPerSecond(-0.5), std::invalid_argument);
+  REQUIRE_THROWS_AS(rate_limiter.SetMaxMegabytesPerSecond(std::numeric_limits<double>::quiet_NaN()), std::invalid_argument);
+  REQUIRE_THROWS_AS(rate_limiter.SetMaxMegabytesPerSecond(std::numeric_limits<double>::infinity()), std::invalid_argument);
+  REQUIRE(rate_limiter.GetMaxMegabytesPerSecond() == 5);
+}
+
+TEST_CASE("ratelimiter.6: the rate-limited streams pass the data on unchanged and acquire the bytes transferred", "[ratelimiter]")
+{
+  std::vector<std::uint8_t> data(kMegabyte);
+  for (size_t i = 0; i < data.size(); ++i)
+  {
+    data[i] = static_cast<std::uint8_t>(i * 7);
+  }
+
+  // writing and reading 1 MB each at 4 MB/s takes 0.5 s in total (the time is measured from the creation of the rate
+  //  limiter, as the bucket is filled from then on)
+  const auto start = steady_clock::now();
+  const auto rate_limiter = std::make_shared<RateLimiter>(4);
+  const auto memory_stream = std::make_shared<CMemInputOutputStream>(0);
+  RateLimitedOutputStream output_stream(memory_stream, rate_limiter);
+  std::uint64_t bytes_written = 0;
+  output_stream.Write(0, data.data(), data.size(), &bytes_written);
+  REQUIRE(bytes_written == data.size());
+
+  RateLimitedInputStream input_stream(memory_stream, rate_limiter);
+  std::vector<std::uint8_t> data_read(data.size());
+  std::uint64_t bytes_read = 0;
+  input_stream.Read(0, data_read.data(), data_read.size(), &bytes_read);
+  REQUIRE(bytes_read == data.size());
+  REQUIRE(data_read == data);
+  rate_limiter->Acquire(1);
+  REQUIRE(duration<double>(steady_clock::now() - start).count() >= 0.45);
+
+  REQUIRE(input_stream.GetUnderlyingStream() == memory_stream);
+  REQUIRE(output_stream.GetUnderlyingStream() == memory_stream);
+  REQUIRE_THROWS_AS(RateLimitedInputStream(memory_stream, nullptr), std::invalid_argument);
+}
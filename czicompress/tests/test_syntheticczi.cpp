@@ -0,0 +1,232 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include <src/bufferpool.h>
+#include <src/zstdcompressor.h>
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+#include "libczi_utils.h"
+#include "syntheticczi.h"
+
+using std::make_shared;
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// Gets the pixel values of a Gray16 bitmap.
+std::vector<std::uint16_t> GetGray16PixelValues(const std::shared_ptr<libCZI::IBitmapData>& bitmap)
+{
+  const libCZI::ScopedBitmapLockerSP bitmap_locked{bitmap};
+  std::vector<std::uint16_t> pixel_values(static_cast<size_t>(bitmap->GetWidth()) * bitmap->GetHeight());
+  for (std::uint32_t row = 0; row < bitmap->GetHeight(); ++row)
+  {
+    memcpy(pixel_values.data() + static_cast<size_t>(row) * bitmap->GetWidth(),
+           static_cast<const std::uint8_t*>(bitmap_locked.ptrDataRoi) + static_cast<size_t>(bitmap_locked.stride) * row,  // NOLINT
+           static_cast<size_t>(bitmap->GetWidth()) * sizeof(std::uint16_t));
+  }
+
+  return pixel_values;
+}
+
+}  // namespace
+
+TEST_CASE("syntheticczi.1: a tile has 12 significant bits, blobs on a background, and it is reproducible", "[syntheticczi]")
+{
+  // arrange
+  SyntheticCziOptions options;
+  options.pixel_type = libCZI::PixelType::Gray16;
+  options.bits_per_pixel = 12;
+  const auto bitmap = CreateBitmap(libCZI::PixelType::Gray16, 256, 256);
+  const auto bitmap_same_options = CreateBitmap(libCZI::PixelType::Gray16, 256, 256);
+  const auto bitmap_other_seed = CreateBitmap(libCZI::PixelType::Gray16, 256, 256);
+
+  // act
+  RenderSyntheticTile(options, 512, 256, 0, 0, 0, bitmap);
+  RenderSyntheticTile(options, 512, 256, 0, 0, 0, bitmap_same_options);
+  options.seed = 1;
+  RenderSyntheticTile(options, 512, 256, 0, 0, 0, bitmap_other_seed);
+
+  // assert
+  const auto pixel_values = GetGray16PixelValues(bitmap);
+  REQUIRE(*std::max_element(pixel_values.cbegin(), pixel_values.cend()) <= 4095);
+  REQUIRE(*std::max_element(pixel_values.cbegin(), pixel_values.cend()) > 1000);
+
+  // most of the image is background (i.e. at most 10% of the maximum value)
+  const auto number_of_background_pixels =
+      std::count_if(pixel_values.cbegin(), pixel_values.cend(), [](std::uint16_t value) { return value < 410; });
+  REQUIRE(number_of_background_pixels > static_cast<std::int64_t>(pixel_values.size() / 4));
+  REQUIRE(number_of_background_pixels < static_cast<std::int64_t>(pixel_values.size()));
+
+  REQUIRE(GetGray16PixelValues(bitmap_same_options) == pixel_values);
+  REQUIRE(GetGray16PixelValues(bitmap_other_seed) != pixel_values);
+}
+
+TEST_CASE("syntheticczi.2: the tiles are compressible, but not trivially", "[syntheticczi]")
+{
+  for (const auto pixel_type : {libCZI::PixelType::Gray8, libCZI::PixelType::Gray16, libCZI::PixelType::Gray32Float,
+                                libCZI::PixelType::Bgr24, libCZI::PixelType::Bgr48})
+  {
+    // arrange
+    SyntheticCziOptions options;
+    options.pixel_type = pixel_type;
+    options.bits_per_pixel = pixel_type == libCZI::PixelType::Gray8 || pixel_type == libCZI::PixelType::Bgr24 ? 8 : 12;
+    const auto bitmap = CreateBitmap(pixel_type, 512, 512);
+    RenderSyntheticTile(options, 0, 0, 0, 0, 0, bitmap);
+
+    // act
+    ZstdCompressor compressor(make_shared<BufferPool>());
+    const libCZI::ScopedBitmapLockerSP bitmap_locked{bitmap};
+    const auto compressed_data = compressor.Compress(libCZI::CompressionMode::Zstd1, 512, 512, bitmap_locked.stride, pixel_type,
+                                                     bitmap_locked.ptrDataRoi, nullptr);
+
+    // assert
+    const double size_of_pixel_data = 512.0 * 512.0 * libCZI::Utils::GetBytesPerPixel(pixel_type);
+    const double compression_ratio = size_of_pixel_data / static_cast<double>(compressed_data->GetSizeOfData());
+    // (with 12 bits in 16 bits, the ratio is about 1.5 - with floats, it is lower, since the noise ends up in the
+    //  low bits of the mantissa)
+    REQUIRE(compression_ratio > 1.1);
+    REQUIRE(compression_ratio < 20);
+  }
+}
+
+TEST_CASE("syntheticczi.3: the number of subblocks and the size of the pixel data include the pyramid", "[syntheticczi]")
+{
+  // arrange - a mosaic of 768x512 pixels, so the first pyramid level has two tiles (the second one of 128x256 pixels),
+  //  and the second pyramid level has one tile of 192x128 pixels
+  SyntheticCziOptions options;
+  options.pixel_type = libCZI::PixelType::Gray16;
+  options.tile_size = 256;
+  options.number_of_tiles_x = 3;
+  options.number_of_tiles_y = 2;
+  options.number_of_pyramid_levels = 2;
+  options.number_of_channels = 2;
+  options.number_of_z_planes = 3;
+
+  // act
+  const auto number_of_subblocks = GetNumberOfSubBlocksOfSyntheticCzi(options);
+  const auto size_of_pixel_data = GetSizeOfPixelDataOfSyntheticCzi(options);
+
+  // assert
+  REQUIRE(number_of_subblocks == (6 + 2 + 1) * 2 * 3);
+  REQUIRE(size_of_pixel_data == (6 * 256 * 256 + 256 * 256 + 128 * 256 + 192 * 128) * 2 * 2 * 3);
+}
+
+TEST_CASE("syntheticczi.4: invalid options are rejected", "[syntheticczi]")
+{
+  SyntheticCziOptions options;
+  options.pixel_type = libCZI::PixelType::Gray8;
+  options.bits_per_pixel = 12;
+  REQUIRE_THROWS_AS(GetNumberOfSubBlocksOfSyntheticCzi(options), std::invalid_argument);
+
+  options = SyntheticCziOptions();
+  options.tile_overlap = options.tile_size;
+  REQUIRE_THROWS_AS(GetNumberOfSubBlocksOfSyntheticCzi(options), std::invalid_argument);
+
+  options = SyntheticCziOptions();
+  options.number_of_channels = 0;
+  REQUIRE_THROWS_AS(GetNumberOfSubBlocksOfSyntheticCzi(options), std::invalid_argument);
+
+  options = SyntheticCziOptions();
+  options.compression_options.push_back(libCZI::Utils::CompressionOption{libCZI::CompressionMode::JpgXr, nullptr});
+  REQUIRE_THROWS_AS(GetNumberOfSubBlocksOfSyntheticCzi(options), std::invalid_argument);
+
+  options = SyntheticCziOptions();
+  const auto bitmap = CreateBitmap(libCZI::PixelType::Gray8, 16, 16);
+  REQUIRE_THROWS_AS(RenderSyntheticTile(options, 0, 0, 0, 0, 0, bitmap), std::invalid_argument);
+}
+
+TEST_CASE("syntheticczi.5: a document with mixed compression, pyramid and attachments is written", "[syntheticczi]")
+{
+  // arrange
+  SyntheticCziOptions options;
+  options.pixel_type = libCZI::PixelType::Gray16;
+  options.tile_size = 128;
+  options.tile_overlap = 16;
+  options.number_of_tiles_x = 3;
+  options.number_of_tiles_y = 2;
+  options.number_of_channels = 2;
+  options.number_of_z_planes = 2;
+  options.number_of_pyramid_levels = 1;
+  options.number_of_attachments = 5;
+  options.attachment_size = 1000;
+  options.compression_options = {libCZI::Utils::ParseCompressionOptions("zstd1:ExplicitLevel=1;PreProcess=HiLoByteUnpack"),
+                                 libCZI::Utils::ParseCompressionOptions("zstd0:ExplicitLevel=1"),
+                                 libCZI::Utils::CompressionOption{libCZI::CompressionMode::UnCompressed, nullptr}};
+  const auto output_stream = make_shared<CMemInputOutputStream>(0);
+
+  // act
+  WriteSyntheticCzi(options, output_stream);
+
+  // assert
+  const auto reader = libCZI::CreateCZIReader();
+  reader->Open(output_stream);
+  REQUIRE(static_cast<std::uint64_t>(reader->GetStatistics().subBlockCount) == GetNumberOfSubBlocksOfSyntheticCzi(options));
+
+  std::map<libCZI::CompressionMode, int> number_of_subblocks_per_compression_mode;
+  int number_of_pyramid_subblocks = 0;
+  reader->EnumerateSubBlocksEx(
+      [&](int, const libCZI::DirectorySubBlockInfo& info) -> bool
+      {
+        ++number_of_subblocks_per_compression_mode[info.GetCompressionMode()];
+        if (info.pyramidType == libCZI::SubBlockPyramidType::MultiSubBlock)
+        {
+          ++number_of_pyramid_subblocks;
+        }
+
+        return true;
+      });
+
+  // the mosaic has 3x2 tiles, the pyramid level 2x1 tiles - and this for 2 channels and 2 Z-planes
+  REQUIRE(number_of_subblocks_per_compression_mode.size() == 3);
+  REQUIRE(number_of_subblocks_per_compression_mode[libCZI::CompressionMode::Zstd1] == 11);
+  REQUIRE(number_of_subblocks_per_compression_mode[libCZI::CompressionMode::Zstd0] == 11);
+  REQUIRE(number_of_subblocks_per_compression_mode[libCZI::CompressionMode::UnCompressed] == 10);
+  REQUIRE(number_of_pyramid_subblocks == 2 * 2 * 2);
+
+  int number_of_attachments = 0;
+  reader->EnumerateAttachments(
+      [&](int, const libCZI::AttachmentInfo&) -> bool
+      {
+        ++number_of_attachments;
+        return true;
+      });
+  REQUIRE(number_of_attachments == 5);
+
+  // the first subblock is the top left tile of the first channel and Z-plane
+  const auto subblock = reader->ReadSubBlock(0);
+  REQUIRE(subblock->GetSubBlockInfo().logicalRect.x == 0);
+  REQUIRE(subblock->GetSubBlockInfo().logicalRect.y == 0);
+  const auto expected_bitmap = CreateBitmap(libCZI::PixelType::Gray16, 128, 128);
+  RenderSyntheticTile(options, 0, 0, 0, 0, 0, expected_bitmap);
+  REQUIRE(GetGray16PixelValues(subblock->CreateBitmap()) == GetGray16PixelValues(expected_bitmap));
+}
+
+TEST_CASE("syntheticczi.6: a document is written to a file", "[syntheticczi]")
+{
+  // arrange
+  const TemporaryFile destination_file("syntheticczi_6.czi");
+  SyntheticCziOptions options;
+  options.tile_size = 64;
+  options.number_of_tiles_x = 4;
+  options.number_of_tiles_y = 4;
+
+  // act
+  WriteSyntheticCziToFile(options, destination_file.GetPath());
+
+  // assert - the document is uncompressed, so it is larger than the pixel data
+  const auto content = destination_file.ReadContent();
+  REQUIRE(content.size() > GetSizeOfPixelDataOfSyntheticCzi(options));
+  const auto reader = libCZI::CreateCZIReader();
+  reader->Open(make_shared<CMemInputOutputStream>(content.data(), content.size()));
+  REQUIRE(reader->GetStatistics().subBlockCount == 16);
+}
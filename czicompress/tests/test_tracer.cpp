@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include <include/tracer.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "catch2/catch_all.hpp"
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// Counts the (non-overlapping) occurrences of the specified text.
+size_t CountOccurrences(const std::string& text, const std::string& pattern)
+{
+  size_t count = 0;
+  for (size_t position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + pattern.size()))
+  {
+    ++count;
+  }
+
+  return count;
+}
+
+}  // namespace
+
+TEST_CASE("tracer.1: the events of all threads are written as Chrome trace events", "[tracer]")
+{
+  // arrange
+  Tracer tracer;
+  TraceBuffer* const main_buffer = tracer.AddThread("main");
+  TraceBuffer* const worker_buffer = tracer.AddThread("worker \"1\"");
+
+  // act
+  {
+    const TraceScope trace_scope(main_buffer, TraceStage::kRead, 7);
+  }
+
+  std::thread worker_thread(
+      [worker_buffer]()
+      {
+        const TraceScope trace_scope(worker_buffer, TraceStage::kProcess, 7);
+        const TraceScope nested_trace_scope(worker_buffer, TraceStage::kWrite, 8);
+      });
+  worker_thread.join();
+
+  // a null buffer (i.e. tracing disabled) records nothing
+  {
+    const TraceScope trace_scope(nullptr, TraceStage::kRead, 9);
+  }
+
+  std::stringstream stream;
+  tracer.WriteChromeTraceJson(stream);
+  const std::string json = stream.str();
+
+  // assert
+  REQUIRE(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") == 0);
+  REQUIRE(json.find("]}") != std::string::npos);
+  REQUIRE(json.find("\"args\":{\"name\":\"main\"}") != std::string::npos);
+  REQUIRE(json.find("\"args\":{\"name\":\"worker \\\"1\\\"\"}") != std::string::npos);
+  REQUIRE(CountOccurrences(json, "\"ph\":\"B\"") == 3);
+  REQUIRE(CountOccurrences(json, "\"ph\":\"E\"") == 3);
+  REQUIRE(CountOccurrences(json, "\"name\":\"read\",\"cat\":\"subblock\",\"ph\":\"B\"") == 1);
+  REQUIRE(CountOccurrences(json, "\"name\":\"process\",\"cat\":\"subblock\",\"ph\":\"E\"") == 1);
+  REQUIRE(CountOccurrences(json, "\"name\":\"write\",\"cat\":\"subblock\",\"ph\":\"B\"") == 1);
+  REQUIRE(CountOccurrences(json, "\"tid\":1,\"args\":{\"subblock\":7}") == 2);
+  REQUIRE(CountOccurrences(json, "\"tid\":2,\"args\":{\"subblock\":7}") == 2);
+  REQUIRE(CountOccurrences(json, "\"tid\":2,\"args\":{\"subblock\":8}") == 2);
+  REQUIRE(json.find("\"subblock\":9") == std::string::npos);
+  REQUIRE(tracer.GetNumberOfDroppedEvents() == 0);
+}
+
+TEST_CASE("tracer.2: if the ring buffer is full, the oldest events are overwritten", "[tracer]")
+{
+  // arrange - the buffer holds 5 events, so the begin event of the first stage is overwritten by the sixth event
+  Tracer tracer(5);
+  TraceBuffer* const buffer = tracer.AddThread("main");
+
+  // act
+  for (int i = 0; i < 3; ++i)
+  {
+    const TraceScope trace_scope(buffer, TraceStage::kRead, i);
+  }
+
+  std::stringstream stream;
+  tracer.WriteChromeTraceJson(stream);
+  const std::string json = stream.str();
+
+  // assert - the end event of subblock 0 has lost its begin event, so it is left out
+  REQUIRE(tracer.GetNumberOfDroppedEvents() == 1);
+  REQUIRE(buffer->GetNumberOfDroppedEvents() == 1);
+  REQUIRE(json.find("\"subblock\":0") == std::string::npos);
+  REQUIRE(CountOccurrences(json, "\"args\":{\"subblock\":1}") == 2);
+  REQUIRE(CountOccurrences(json, "\"args\":{\"subblock\":2}") == 2);
+}
+
+TEST_CASE("tracer.3: a tracer without room for events cannot be created", "[tracer]")
+{
+  REQUIRE_THROWS_AS(Tracer(0), std::invalid_argument);
+}
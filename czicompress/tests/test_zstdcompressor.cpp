@@ -0,0 +1,88 @@
+// SPDX-FileCopyrightText: 2023 Carl Zeiss Microscopy GmbH
+//
+// SPDX-License-Identifier: MIT
+
+#include <src/bufferpool.h>
+#include <src/zstdcompressor.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+#include "libczi_utils.h"
+
+namespace
+{  // unnamed namespace makes functions only accessible from this file
+
+/// Gets the content of the memory block.
+std::vector<std::uint8_t> GetContent(const std::shared_ptr<libCZI::IMemoryBlock>& memory_block)
+{
+  const auto* data = static_cast<const std::uint8_t*>(memory_block->GetPtr());
+  return {data, data + memory_block->GetSizeOfData()};  // NOLINT: pointer arithmetic
+}
+
+}  // namespace
+
+TEST_CASE("zstdcompressor.1: the compressed data is identical to the data compressed by libCZI", "[zstdcompressor]")
+{
+  const char* const compression_options[] = {  // NOLINT: C-style array
+      "zstd0:",
+      "zstd0:ExplicitLevel=1",
+      "zstd0:ExplicitLevel=9",
+      "zstd1:",
+      "zstd1:ExplicitLevel=1",
+      "zstd1:ExplicitLevel=9",
+      "zstd1:ExplicitLevel=1;PreProcess=HiLoByteUnpack",
+      "zstd1:ExplicitLevel=3;PreProcess=HiLoByteUnpack",
+      "zstd1:ExplicitLevel=9;PreProcess=HiLoByteUnpack",
+  };
+
+  constexpr std::uint32_t kWidth = 61;
+  constexpr std::uint32_t kHeight = 17;
+
+  // the same instance is used for all bitmaps, so that reusing the compression context is covered as well
+  ZstdCompressor compressor(std::make_shared<BufferPool>());
+  std::uint32_t seed = 0;
+  for (const auto pixel_type : {libCZI::PixelType::Gray8, libCZI::PixelType::Gray16, libCZI::PixelType::Bgr24,
+                                libCZI::PixelType::Bgr48, libCZI::PixelType::Gray32Float})
+  {
+    // arrange - the bitmap is copied into a buffer with a stride larger than the length of a line, so that both a
+    //  contiguous and a non-contiguous bitmap are compressed
+    const auto bitmap = CreateBitmapAndFillWithNoise(pixel_type, kWidth, kHeight, seed++);
+    const libCZI::ScopedBitmapLockerSP bitmap_locked{bitmap};
+    const std::uint32_t line_length = kWidth * libCZI::Utils::GetBytesPerPixel(pixel_type);
+    const std::uint32_t padded_stride = line_length + 13;
+    std::vector<std::uint8_t> padded_bitmap(static_cast<size_t>(padded_stride) * kHeight, 0xcd);
+    for (std::uint32_t y = 0; y < kHeight; ++y)
+    {
+      memcpy(padded_bitmap.data() + static_cast<size_t>(y) * padded_stride,                                              // NOLINT
+             static_cast<const std::uint8_t*>(bitmap_locked.ptrDataRoi) + static_cast<size_t>(y) * bitmap_locked.stride,  // NOLINT
+             line_length);
+    }
+
+    for (const char* compression_option_text : compression_options)
+    {
+      const auto compression_option = libCZI::Utils::ParseCompressionOptions(compression_option_text);
+      for (const auto& [stride, data] : {std::make_pair(bitmap_locked.stride, static_cast<const void*>(bitmap_locked.ptrDataRoi)),
+                                         std::make_pair(padded_stride, static_cast<const void*>(padded_bitmap.data()))})
+      {
+        INFO("pixel type: " << static_cast<int>(pixel_type) << ", options: " << compression_option_text << ", stride: " << stride);
+
+        // act
+        const auto compressed_data = compressor.Compress(compression_option.first, kWidth, kHeight, stride, pixel_type, data,
+                                                         compression_option.second.get());
+
+        // assert
+        const auto compressed_data_libczi =
+            compression_option.first == libCZI::CompressionMode::Zstd0
+                ? libCZI::ZstdCompress::CompressZStd0Alloc(kWidth, kHeight, stride, pixel_type, data, compression_option.second.get())
+                : libCZI::ZstdCompress::CompressZStd1Alloc(kWidth, kHeight, stride, pixel_type, data, compression_option.second.get());
+        REQUIRE(GetContent(compressed_data) == GetContent(compressed_data_libczi));
+      }
+    }
+  }
+}